@@ -286,6 +286,46 @@ struct slow5_rec {
 };
 typedef struct slow5_rec slow5_rec_t;
 
+/**
+* @struct slow5_rec_view
+* Read-only view of a BLOW5 record. read_id, raw_signal and auxiliary fields point into the record buffer
+* and are valid until the view is filled again or freed. read_id is not null terminated.
+*/
+struct slow5_rec_view {
+    slow5_rid_len_t read_id_len;        ///< length of the read ID
+    const char *read_id;                ///< read ID (not null terminated)
+    uint32_t read_group;
+    double digitisation;
+    double offset;
+    double range;
+    double sampling_rate;
+    uint64_t len_raw_signal;
+    const int16_t *raw_signal;          ///< points into the record when stored uncompressed and aligned, otherwise into sig
+
+    /* the following are not to be directly accessed, use slow5_rec_view_aux_get instead */
+    const slow5_aux_meta_t *aux_meta;   ///< auxiliary meta of the file the view was filled from
+    const void **aux_data;              ///< auxiliary field position -> start of its data in the record
+    uint64_t *aux_len;                  ///< auxiliary field position -> number of elements
+    uint32_t aux_cap;                   ///< capacity of aux_data and aux_len
+    slow5_decode_ctx_t *ctx;            ///< buffers the record is read and decompressed into
+    int16_t *sig;                       ///< decoded raw signal
+    uint64_t sig_cap;                   ///< capacity of sig in samples
+};
+typedef struct slow5_rec_view slow5_rec_view_t;
+
+/**
+* @struct slow5_stats
+* Summary statistics of the records of a file or of one of its read groups, kept in the index (see slow5_get_stats).
+*/
+struct slow5_stats {
+    uint64_t num_reads;
+    uint64_t num_samples;               ///< sum of len_raw_signal
+    uint64_t min_len_raw_signal;        ///< 0 if there are no reads
+    uint64_t max_len_raw_signal;
+};
+typedef struct slow5_stats slow5_stats_t;
+#define SLOW5_STATS_ALL (-1) // read_group of slow5_get_stats for all the read groups
+
 /*** SLOW5 file handler ***************************************************************************/
 
 /**
@@ -298,6 +338,13 @@ struct slow5_file_meta {
     uint64_t start_rec_offset;  ///< offset (in bytes) of the first SLOW5 record (skipping the SLOW5 header; used for indexing)
     char *fread_buffer;         ///< buffer for fread
     const char *mode;           ///< file mode
+    struct slow5_readahead *readahead; ///< background read-ahead state (NULL if not enabled)
+    void *mmap_addr;            ///< read-only mapping of the whole file in mode "rm" (NULL otherwise)
+    size_t mmap_size;           ///< size of the mapping in bytes
+    struct slow5_decode_ctx *decode_ctx; ///< scratch buffers reused by slow5_get_next (NULL until first use)
+    struct slow5_idx *idx_footer; ///< index of the records written, put in a footer by slow5_close (NULL if not enabled, see slow5_set_idx_footer)
+    struct slow5_block *block;  ///< records being compressed together and the block being read (NULL unless block-compressed, see slow5_set_block)
+    uint8_t idx_v2;             ///< index files made for this file are written in the v2 format (see slow5_set_idx_v2)
 };
 typedef struct slow5_file_meta slow5_file_meta_t;
 
@@ -339,7 +386,7 @@ newer functions can be added while keeping the existing ones intact
  *
  *
  * @param   pathname    relative or absolute path to slow5 file
- * @param   mode        "r" for reading, "w" for writing a new file, "a" for appending to an existing file
+ * @param   mode        "r" for reading, "rm" for reading with the file memory-mapped, "w" for writing a new file, "a" for appending to an existing file
  * @return              slow5 file structure
  */
 slow5_file_t *slow5_open(const char *pathname, const char *mode);
@@ -611,6 +658,10 @@ int slow5_write(slow5_rec_t *read, slow5_file_t *s5p);
 //should be immediately done after opening a blow5 for writing (mode 'w')
 int slow5_set_press(slow5_file_t *s5p, enum slow5_press_method rec_press, enum slow5_press_method sig_press);
 
+//same as slow5_set_press with options for the record compression (zlib or zstd): level, and for zstd window size, long distance matching and threads
+//0 in an option keeps its default; opt can be NULL
+int slow5_set_press_opt(slow5_file_t *s5p, enum slow5_press_method rec_press, enum slow5_press_method sig_press, const slow5_press_opt_t *opt);
+
 
 /**************************************************************************************************
  ***  Low-level API *******************************************************************************
@@ -659,6 +710,96 @@ int slow5_encode(void **mem, size_t *bytes, slow5_rec_t *read, slow5_file_t *s5p
 
 int slow5_write_bytes(void *mem, size_t bytes, slow5_file_t *s5p);
 
+//start (depth > 0) or stop (depth 0) a background thread that reads up to depth raw records ahead for slow5_get_next, slow5_get_next_bytes and slow5_get_next_mem
+//while it is running nothing else should use the file pointer of s5p (e.g. creating an index); slow5_get (which uses pread) is fine
+//records already read ahead are still returned in order after stopping
+//returns 0 on success, <0 on error
+int slow5_set_readahead(slow5_file_t *s5p, uint32_t depth);
+
+//enable (1) or disable (0) writing the index of the records as a footer of a BLOW5 file opened with mode "w", before any record is written
+//slow5_close then appends the index before the end of file marker and slow5_idx_load uses it instead of a separate index file
+//appending to such a file (mode "a") keeps its footer up to date
+//returns 0 on success, <0 on error
+int slow5_set_idx_footer(slow5_file_t *s5p, int enable);
+
+//enable (1) or disable (0) the v2 format for the index files written for s5p, set before the index is loaded or created
+//v2 indexes are memory-mapped by slow5_idx_load, keep the statistics of slow5_get_stats and index appended records on load
+//but cannot be read by earlier slow5lib releases (SLOW5_ERR_MAGIC); by default indexes are written in the v1 format, unless already in v2 or with columns or blocks
+//returns 0 on success, <0 on error
+int slow5_set_idx_v2(slow5_file_t *s5p, int enable);
+
+//compress the records of a BLOW5 file opened with mode "w", before any record is written, with its record compression method (zlib or zstd)
+//in blocks of up to max_recs records or max_bytes bytes (0 for no limit) instead of one at a time; the last block is written by slow5_close
+//with mode "a", change the limits of a block-compressed file
+//returns 0 on success, <0 on error
+int slow5_set_block(slow5_file_t *s5p, uint32_t max_recs, uint64_t max_bytes);
+
+//compress the records of a BLOW5 file opened with mode "w" with the zstd dictionary dict of size bytes (copied), which is stored after the header
+//the record compression method must be zstd (not in blocks) and the header not yet written; files opened for reading or appending load it
+//returns 0 on success, <0 on error
+int slow5_set_press_dict(slow5_file_t *s5p, const void *dict, size_t size);
+
+//same as slow5_set_press_dict with a dictionary of at most cap bytes trained from the records recs[0..num_recs-1] (e.g. read from another file)
+//the records are left unchanged and their signals are not used for training
+//returns 0 on success, <0 on error
+int slow5_train_press_dict(slow5_file_t *s5p, slow5_rec_t **recs, uint32_t num_recs, size_t cap);
+
+//get the zstd dictionary of the records of s5p and set *size to its size in bytes, valid until slow5_close and not to be freed
+//returns NULL if s5p has no dictionary
+const void *slow5_get_press_dict(const slow5_file_t *s5p, size_t *size);
+
+//get a pointer to the record with read_id exactly as it is stored in a file opened with mode "rm", without copying
+//*n is set to the length of the record (for SLOW5 the newline is excluded and the record is not null terminated)
+//the pointer is into the read-only mapping, valid until slow5_close and must not be freed
+//the index must be loaded; returns NULL on error and sets slow5_errno
+const void *slow5_get_mem_map(const char *read_id, size_t *n, const slow5_file_t *s5p);
+
+//fill *view with the next BLOW5 record without copying the read ID or auxiliary fields; *view is allocated if NULL and reused otherwise
+//returns 0 on success, SLOW5_ERR_EOF at the end of file, other <0 on error
+int slow5_get_next_view(slow5_rec_view_t **view, slow5_file_t *s5p);
+//same as slow5_get_next_view for the record with read_id (index must be loaded); with mode "rm" uncompressed records are viewed in the mapping
+int slow5_get_view(const char *read_id, slow5_rec_view_t **view, slow5_file_t *s5p);
+//pointer to the data of auxiliary field in view, *len set to the number of elements (1 for primitive types), *type to its type (len and type can be NULL)
+//the data may be unaligned (copy it out with memcpy) and strings are not null terminated; returns NULL on error and sets slow5_errno
+const void *slow5_rec_view_aux_get(const slow5_rec_view_t *view, const char *field, uint64_t *len, enum slow5_aux_type *type);
+void slow5_rec_view_free(slow5_rec_view_t *view);
+
+//same as slow5_get but reads, decompresses and decodes with the scratch buffers of ctx (see slow5_decode_ctx_init in slow5_press.h)
+//which are reused across calls instead of being allocated for every record; use one ctx per thread
+int slow5_get_ctx(const char *read_id, slow5_rec_t **read, slow5_file_t *s5p, slow5_decode_ctx_t *ctx);
+
+//get the records of read_ids[0..n-1] into reads[0..n-1] using num_thread threads (index must be loaded)
+//records are fetched in file order and records close together in the file are read with a single read
+//each reads[i] is allocated if NULL and overwritten otherwise (as in slow5_get); free each with slow5_rec_free
+//returns 0 on success, <0 on error (as in slow5_get)
+int slow5_get_many(char **read_ids, size_t n, slow5_rec_t **reads, int num_thread, slow5_file_t *s5p);
+
+//same as slow5_idx_create but a BLOW5 file is indexed using num_thread threads
+//(slow5_idx_create and slow5_idx_load use one thread per online processor, up to 16)
+//returns 0 on success, -1 on error
+int slow5_idx_create_mt(slow5_file_t *s5p, int num_thread);
+
+//same as slow5_idx_create for a BLOW5 file, but the values of the fields cols[0..num_cols-1] of each record are also kept in the index
+//a field is a primary field other than read_id and raw_signal (e.g. len_raw_signal, read_group)
+//or an auxiliary field of a primitive type or a string of up to 8 characters (e.g. channel_number, start_time)
+//returns 0 on success, <0 on error and sets slow5_errno
+int slow5_idx_create_cols(slow5_file_t *s5p, const char **cols, uint32_t num_cols);
+//pointer to the value of column col of the record with read_id in the loaded index (see slow5_idx_create_cols), without reading the record
+//*len set to the number of elements (1, or the length of a string), *type to its type (len and type can be NULL)
+//strings are not null terminated; valid until the index is unloaded or a record is written; returns NULL on error and sets slow5_errno
+const void *slow5_get_idx_col(const char *read_id, const char *col, uint64_t *len, enum slow5_aux_type *type, const slow5_file_t *s5p);
+
+//get the number of reads, total number of samples and shortest and longest read of read_group (SLOW5_STATS_ALL for the whole file) into *stats
+//from the loaded index, without reading any record; these are recorded when the index is created or records are written with it
+//returns 0 on success, <0 on error and sets slow5_errno (SLOW5_ERR_NOIDX if the index was created by an older slow5lib without them)
+int slow5_get_stats(const slow5_file_t *s5p, int64_t read_group, slow5_stats_t *stats);
+
+//concatenate the BLOW5 files in_pathnames[0..num_in-1] into a new BLOW5 file at pathname and create its index
+//the inputs must have identical headers (compression included): records are copied as they are without decompressing
+//and the index is made by combining the indexes of the inputs (loaded, or created if missing) with their offsets shifted
+//returns 0 on success, <0 on error (the output is removed)
+int slow5_cat(const char *pathname, const char **in_pathnames, uint32_t num_in);
+
 /*
 IMPORTANT: The following low-level API functions are not yet finalised or documented, until someone requests.
 If anyone is interested, please open a GitHub issue, rather than trying to figure out from the code.
@@ -46,19 +46,27 @@ The API documentation is available at https://hasindu2008.github.io/slow5tools/
 // library version
 #define SLOW5_LIB_VERSION "0.6.0"
 
-// maximum file version supported by this library - independent of slow5 library version above
+// file version written by this library - independent of slow5 library version above
 // if updating change all 4 below
 #define SLOW5_VERSION_MAJOR (0)
 #define SLOW5_VERSION_MINOR (2)
 #define SLOW5_VERSION_PATCH (0)
 #define SLOW5_VERSION_STRING "0.2.0"
 
+// maximum file version supported by this library, written instead when a file uses what older ones cannot read (e.g. an index footer)
+// if updating change all 4 below
+#define SLOW5_VERSION_MAX_MAJOR (0)
+#define SLOW5_VERSION_MAX_MINOR (3)
+#define SLOW5_VERSION_MAX_PATCH (0)
+#define SLOW5_VERSION_MAX_STRING "0.3.0"
+
 // file version helpers
 #define SLOW5_VERSION_STRING_FORMAT \
     "%" PRIu8 SLOW5_HDR_FILE_VERSION_SEP \
     "%" PRIu8 SLOW5_HDR_FILE_VERSION_SEP \
     "%" PRIu8
 #define SLOW5_VERSION_ARRAY { .major = SLOW5_VERSION_MAJOR, .minor = SLOW5_VERSION_MINOR, .patch = SLOW5_VERSION_PATCH }
+#define SLOW5_VERSION_MAX_ARRAY { .major = SLOW5_VERSION_MAX_MAJOR, .minor = SLOW5_VERSION_MAX_MINOR, .patch = SLOW5_VERSION_MAX_PATCH }
 
 // SLOW5 format specs
 #define SLOW5_HDR_PREFIX            "#"
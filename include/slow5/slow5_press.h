@@ -45,6 +45,7 @@ SOFTWARE.
 
 #include <zlib.h>
 #include <stdio.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,6 +58,8 @@ extern "C" {
 
 #define SLOW5_ZSTD_COMPRESS_LEVEL (1)
 
+#define SLOW5_PRESS_SIZE_HDR_LEN (18) /* bytes holding the decompressed size of a raw signal -- at most a zstd frame header */
+
 /* (de)compression methods */
 enum slow5_press_method {
     SLOW5_COMPRESS_NONE,
@@ -67,8 +70,18 @@ enum slow5_press_method {
 typedef struct{
     enum slow5_press_method record_method;
     enum slow5_press_method signal_method;
+    enum slow5_press_method block_method; /* records compressed together in blocks (see slow5_set_block), record_method is then none */
+    uint8_t record_dict;    /* records compressed with the zstd dictionary stored after the header (see slow5_set_press_dict) */
 } slow5_press_method_t;
 
+/* options of the record (and block) compression, 0 for the defaults (see slow5_set_press_opt) */
+typedef struct slow5_press_opt {
+    int level;                  /* zlib 1 to 9 (default Z_DEFAULT_COMPRESSION), zstd ZSTD_minCLevel() to ZSTD_maxCLevel() but 0 (default SLOW5_ZSTD_COMPRESS_LEVEL) */
+    int zstd_window_log;        /* log2 of the largest distance zstd looks back for matches (ZSTD_c_windowLog), default set by the level */
+    int zstd_long;              /* non-zero for zstd long distance matching (ZSTD_c_enableLongDistanceMatching) */
+    int zstd_workers;           /* zstd threads compressing each record or block (ZSTD_c_nbWorkers), libzstd must be built with threads */
+} slow5_press_opt_t;
+
 /* zlib stream */
 struct slow5_zlib_stream {
     z_stream strm_inflate;
@@ -76,33 +89,94 @@ struct slow5_zlib_stream {
     int flush;
 };
 
+/* zstd contexts reused across (de)compressions, ZSTD_CCtx and ZSTD_DCtx (void so that zstd.h is not needed here) */
+struct slow5_zstd_stream {
+    void *cctx;
+    void *dctx;
+};
+
 /* (de)compression streams */
 union slow5_press_stream {
     struct slow5_zlib_stream *zlib;
+    struct slow5_zstd_stream *zstd;
+};
+
+/* zstd dictionary of the records, shared by the presses that use it */
+struct slow5_press_dict {
+    void *buf;                  /* the dictionary as stored in the file */
+    size_t size;
+    void *cdict;                /* ZSTD_CDict, compresses at the level of the dictionary */
+    void *ddict;                /* ZSTD_DDict */
+    int refs;
 };
 
 /* (de)compression object */
 struct __slow5_press {
     enum slow5_press_method method;
     union slow5_press_stream *stream;
+    struct slow5_press_dict *dict;  /* zstd only, NULL if none */
 };
 
 typedef struct slow5_press {
     struct __slow5_press *record_press;
     struct __slow5_press *signal_press;
+    struct __slow5_press *block_press;
+    slow5_press_opt_t opt;      /* of record_press and block_press */
 } slow5_press_t;
 
+/* scratch buffers reused across record decodes, use one per thread */
+typedef struct slow5_decode_ctx {
+    char *raw;                  /* record as read from the file */
+    size_t raw_cap;
+    uint8_t *rec;               /* decompressed record */
+    size_t rec_cap;
+    z_stream *zlib_strm;        /* inflate stream reset for each record (NULL until needed) */
+    void *zstd_dstream;         /* ZSTD_DStream (a ZSTD_DCtx) for whole and partial decompression (NULL until needed) */
+    char *blk;                  /* decompressed block of a block-compressed file */
+    size_t blk_cap;
+    size_t blk_len;
+    uint64_t blk_offset;        /* of the block in its file */
+    uint64_t blk_id;            /* id of the block of the file the block is from, 0 if blk holds none */
+} slow5_decode_ctx_t;
+
 /* init or free for multiple (de)compress calls */
 struct slow5_press *slow5_press_init(slow5_press_method_t method);
+struct slow5_press *slow5_press_init_opt(slow5_press_method_t method, const struct slow5_press_opt *opt);
 struct __slow5_press *__slow5_press_init(enum slow5_press_method method);
+struct __slow5_press *__slow5_press_init_opt(enum slow5_press_method method, const struct slow5_press_opt *opt);
 void slow5_press_free(struct slow5_press *comp);
 void __slow5_press_free(struct __slow5_press *comp);
+/* zstd dictionary of size bytes (copied) compressing at level (0 for the default), with one reference */
+struct slow5_press_dict *slow5_press_dict_init(const void *buf, size_t size, int level);
+void slow5_press_dict_free(struct slow5_press_dict *dict);
+/* make the zstd press comp use dict (a new reference), or no dictionary if NULL */
+int __slow5_press_set_dict(struct __slow5_press *comp, struct slow5_press_dict *dict);
+/* train a zstd dictionary of at most cap bytes from num samples concatenated in buf, returns its size */
+size_t slow5_press_dict_train(void *dict, size_t cap, const void *buf, const size_t *sizes, uint32_t num);
+struct slow5_decode_ctx *slow5_decode_ctx_init(void);
+void slow5_decode_ctx_free(struct slow5_decode_ctx *ctx);
+void __slow5_decode_ctx_free_bufs(struct slow5_decode_ctx *ctx);
+/* decode context of the calling thread (used by slow5_get), freed when the thread exits, NULL on error */
+struct slow5_decode_ctx *slow5_decode_ctx_thread(void);
 
 /* (de)compress ptr */
 void *slow5_ptr_compress(struct __slow5_press *comp, const void *ptr, size_t count, size_t *n);
 void *slow5_ptr_compress_solo(enum slow5_press_method method, const void *ptr, size_t count, size_t *n);
 void *slow5_ptr_depress(struct __slow5_press *comp, const void *ptr, size_t count, size_t *n);
 void *slow5_ptr_depress_solo(enum slow5_press_method method, const void *ptr, size_t count, size_t *n);
+/* decompress into ctx->rec, returns ctx->rec (not to be freed, valid until the next call with ctx) */
+void *slow5_ptr_depress_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ptr, size_t count, size_t *n);
+void *slow5_block_depress_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ptr, size_t count, size_t *n);
+/* same as slow5_ptr_depress_ctx but ptr may hold only the start of the compressed data, stops once at least min_out bytes are out */
+void *slow5_ptr_depress_part_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ptr, size_t count, size_t min_out, size_t *n);
+/* same as the above with the method and zstd dictionary of a record press comp (no compression if NULL) */
+void *slow5_rec_depress_solo(const struct __slow5_press *comp, const void *ptr, size_t count, size_t *n);
+void *slow5_rec_depress_ctx(struct slow5_decode_ctx *ctx, const struct __slow5_press *comp, const void *ptr, size_t count, size_t *n);
+void *slow5_rec_depress_part_ctx(struct slow5_decode_ctx *ctx, const struct __slow5_press *comp, const void *ptr, size_t count, size_t min_out, size_t *n);
+/* decompress a raw signal into sig holding cap samples, reallocated if needed, returns sig and sets *len to the number of samples */
+int16_t *slow5_sig_depress_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ptr, size_t count, int16_t *sig, uint64_t cap, uint64_t *len);
+/* get the decompressed size of a raw signal from its first (at most SLOW5_PRESS_SIZE_HDR_LEN) bytes, returns 1 if it is not stored */
+int slow5_ptr_depress_size(enum slow5_press_method method, const void *ptr, size_t count, size_t *n);
 static inline void *slow5_str_compress(struct __slow5_press *comp, const char *str, size_t *n);
 
 /* (de)compress ptr and write */
@@ -144,6 +218,10 @@ uint8_t slow5_encode_record_press(enum slow5_press_method method);
 enum slow5_press_method slow5_decode_record_press(uint8_t method);
 uint8_t slow5_encode_signal_press(enum slow5_press_method method);
 enum slow5_press_method slow5_decode_signal_press(uint8_t method);
+uint8_t slow5_encode_block_press(enum slow5_press_method method);
+enum slow5_press_method slow5_decode_block_press(uint8_t method);
+uint8_t slow5_encode_dict_press(enum slow5_press_method method);
+enum slow5_press_method slow5_decode_dict_press(uint8_t method);
 
 #ifdef __cplusplus
 }
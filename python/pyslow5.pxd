@@ -44,6 +44,11 @@ cdef extern from "pyslow5.h":
 
     ctypedef struct slow5_press_t:
         pass
+    ctypedef struct slow5_press_opt_t:
+        int level
+        int zstd_window_log
+        int zstd_long
+        int zstd_workers
     ctypedef struct slow5_hdr_t:
         slow5_version version;
         uint32_t num_read_groups;
@@ -125,6 +130,7 @@ cdef extern from "pyslow5.h":
 
     # from slow5.h
     int slow5_set_press(slow5_file_t *s5p, int rec_press, int sig_press);
+    int slow5_set_press_opt(slow5_file_t *s5p, int rec_press, int sig_press, const slow5_press_opt_t *opt);
     int slow5_hdr_add_attr(const char *attr, slow5_hdr_t *header);
     int slow5_hdr_set(const char *attr, const char *value, uint32_t read_group, slow5_hdr_t *header);
     int64_t slow5_hdr_add_rg(slow5_hdr_t *header);
@@ -140,7 +146,12 @@ cdef extern from "pyslow5.h":
 
 cdef extern from "slow5threads.h":
 
-    int slow5_get_batch(slow5_rec_t ***read, slow5_file_t *s5p, char **rid, int num_rid, int num_threads);
-    int slow5_get_next_batch(slow5_rec_t ***read, slow5_file_t *s5p, int batch_size, int num_threads);
-    int slow5_write_batch(slow5_rec_t **read, slow5_file_t *s5p, int batch_size, int num_threads);
+    ctypedef struct slow5_mt_t:
+        pass
+
+    slow5_mt_t *slow5_init_mt(int num_thread, slow5_file_t *s5p);
+    void slow5_free_mt(slow5_mt_t *mt);
+    int slow5_get_batch(slow5_rec_t ***read, slow5_mt_t *mt, char **rid, int num_rid);
+    int slow5_get_next_batch(slow5_rec_t ***read, slow5_mt_t *mt, int batch_size);
+    int slow5_write_batch(slow5_rec_t **read, slow5_mt_t *mt, int batch_size);
     void slow5_free_batch(slow5_rec_t ***read, int num_rec);
@@ -24,6 +24,8 @@ np.import_array()
 
 cdef class Open:
     cdef pyslow5.slow5_file_t *s5
+    cdef pyslow5.slow5_mt_t *mt
+    cdef int mt_threads
     cdef pyslow5.slow5_rec_t *rec
     cdef pyslow5.slow5_rec_t *read
     cdef pyslow5.slow5_rec_t *write
@@ -102,9 +104,12 @@ cdef class Open:
     cdef pyslow5.float total_multi_write_signal_time
     cdef pyslow5.float total_multi_write_time
 
-    def __cinit__(self, pathname, mode, rec_press="zlib", sig_press="svb_zd", DEBUG=0):
+    def __cinit__(self, pathname, mode, rec_press="zlib", sig_press="svb_zd", DEBUG=0, rec_press_opt=None):
+        cdef pyslow5.slow5_press_opt_t press_opt
         # Set to default NULL type
         self.s5 = NULL
+        self.mt = NULL
+        self.mt_threads = 0
         self.rec = NULL
         self.read = NULL
         self.write = NULL
@@ -251,14 +256,26 @@ cdef class Open:
                 self.logger.error("File '{}' could not be opened for writing.".format(self.path))
             if "blow5" in self.path.split(".")[-1]:
                 if self.rec_press in self.slow5_press_method.keys() and self.sig_press in self.slow5_press_method.keys():
-                    ret = pyslow5.slow5_set_press(self.s5, self.slow5_press_method[self.rec_press], self.slow5_press_method[self.sig_press])
+                    if rec_press_opt is None:
+                        ret = pyslow5.slow5_set_press(self.s5, self.slow5_press_method[self.rec_press], self.slow5_press_method[self.sig_press])
+                    else:
+                        unknown = [key for key in rec_press_opt if key not in ["level", "zstd_window_log", "zstd_long", "zstd_workers"]]
+                        if unknown:
+                            self.logger.error("Unknown rec_press_opt keys: {}".format(",".join(unknown)))
+                            raise KeyError("Unknown rec_press_opt keys: {}".format(",".join(unknown)))
+                        press_opt.level = int(rec_press_opt.get("level", 0))
+                        press_opt.zstd_window_log = int(rec_press_opt.get("zstd_window_log", 0))
+                        press_opt.zstd_long = int(bool(rec_press_opt.get("zstd_long", False)))
+                        press_opt.zstd_workers = int(rec_press_opt.get("zstd_workers", 0))
+                        ret = pyslow5.slow5_set_press_opt(self.s5, self.slow5_press_method[self.rec_press], self.slow5_press_method[self.sig_press], &press_opt)
                     if ret != 0:
                         self.logger.error("slow5_set_press return not 0: {}".format(ret))
                         raise RuntimeError("Unable to set compression")
                 else:
                     self.logger.error("Compression type rec_press: {}, sig_press: {} could not be found.".format(self.rec_press, self.sig_press))
                     self.logger.error("Please use only the following: {}".format(",".join(press for press in self.slow5_press_method.keys())))
-                    raise KeyError
+                    unknown = [press for press in [self.rec_press, self.sig_press] if press not in self.slow5_press_method.keys()]
+                    raise KeyError("Unknown compression types: {}".format(",".join(unknown)))
             else:
                 self.logger.debug("Not writing blow5, skipping compression steps")
         elif self.state == 2:
@@ -272,12 +289,13 @@ cdef class Open:
             raise MemoryError()
 
 
-    def __init__(self, pathname, mode, rec_press="zlib", sig_press="svb_zd", DEBUG=0):
+    def __init__(self, pathname, mode, rec_press="zlib", sig_press="svb_zd", DEBUG=0, rec_press_opt=None):
         self.aux_names = []
         self.aux_types = []
 
 
     def __dealloc__(self):
+        self._free_mt()
         if self.p is not NULL:
             free(self.p)
         if self.m is not NULL:
@@ -319,6 +337,29 @@ cdef class Open:
         self.logger.debug("total_multi_write_time: {} seconds".format(self.total_multi_write_time))
 
 
+    def _init_mt(self, threads):
+        '''
+        (re)start the worker pool used by the batch functions
+        threads are kept alive between batches and only restarted if the thread count changes
+        '''
+        if self.mt is not NULL and self.mt_threads == threads:
+            return
+        self._free_mt()
+        self.mt = slow5_init_mt(threads, self.s5)
+        if self.mt is NULL:
+            raise MemoryError()
+        self.mt_threads = threads
+        self.logger.debug("worker pool started with {} threads".format(threads))
+
+    def _free_mt(self):
+        '''
+        stop the worker pool, must happen before the file is closed
+        '''
+        if self.mt is not NULL:
+            slow5_free_mt(self.mt)
+            self.mt = NULL
+            self.mt_threads = 0
+
     def _convert_to_pA(self, d):
         '''
         convert raw signal data to pA using digitisation, offset, and range
@@ -484,7 +525,8 @@ cdef class Open:
 
 
             self.logger.debug("slow5_get_batch: num_reads: {}".format(batch_len))
-            ret = slow5_get_batch(&self.trec, self.s5, self.rid, batch_len, threads);
+            self._init_mt(threads)
+            ret = slow5_get_batch(&self.trec, self.mt, self.rid, batch_len);
             self.logger.debug("get_read_multi slow5_get_batch ret: {}".format(ret))
             if ret < 0:
                 self.logger.error("slow5_get_next error code: {}: {}".format(ret, self.error_codes[ret]))
@@ -1154,7 +1196,8 @@ cdef class Open:
         # While loops check ret of previous read for errors as fail safe
         while ret > 0:
             start_slow5_get_next = time.time()
-            ret = slow5_get_next_batch(&self.trec, self.s5, batchsize, threads)
+            self._init_mt(threads)
+            ret = slow5_get_next_batch(&self.trec, self.mt, batchsize)
             self.total_time_slow5_get_next = self.total_time_slow5_get_next + (time.time() - start_slow5_get_next)
             self.logger.debug("slow5_get_next_multi return: {}".format(ret))
             # check for EOF or other errors
@@ -1985,7 +2028,8 @@ cdef class Open:
                 self.logger.debug("write_record_batch: batch_len 0 or less")
                 break
 
-            ret = slow5_write_batch(self.twrite, self.s5, batch_len, threads)
+            self._init_mt(threads)
+            ret = slow5_write_batch(self.twrite, self.mt, batch_len)
             if ret < batch_len:
                 self.logger.error("write_record_batch: write failed")
                 return -1
@@ -2018,6 +2062,7 @@ cdef class Open:
         '''
         close file so EOF is written
         '''
+        self._free_mt()
         if self.state in [1,2]:
             if not self.close_state:
                 if self.s5 is not NULL:
@@ -11,6 +11,7 @@
 #include <string.h>
 #include <slow5/slow5.h>
 #include "../src/slow5_extra.h"
+#include "slow5threads.h"
 
 
 #define SLOW5_WORK_STEAL 1 //simple work stealing enabled or not (no work stealing mean no load balancing)
@@ -36,48 +37,133 @@ typedef struct {
 
     slow5_rec_t **slow5_rec;
     char **rid; //only used in get()
+    struct slow5_get_plan *plan; //only used in get()
 
 } slow5_db_t;
 
 
+/* argument wrapper for the multithreaded framework used for data processing */
+typedef struct slow5_pt_arg slow5_pt_arg_t;
+
 /* core data structure (mostly static data throughout the program lifetime) */
-typedef struct {
+struct slow5_mt {
     //slow5
     slow5_file_t *sf;
     int num_thread;
     int batch_size;
-} slow5_core_t;
-
-
-/* argument wrapper for the multithreaded framework used for data processing */
-typedef struct {
+    slow5_decode_ctx_t **ctx; //per-thread scratch buffers for decoding, reused across batches
+
+    //persistent worker pool (only used when num_thread > 1)
+    pthread_t *tids;
+    slow5_pt_arg_t *pt_args;
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond; //signalled when a batch is posted or on shutdown
+    pthread_cond_t done_cond; //signalled when the last worker finishes a batch
+    uint64_t generation; //incremented for every posted batch
+    int32_t num_done;
+    int8_t shutdown;
+};
+typedef struct slow5_mt slow5_core_t;
+
+
+struct slow5_pt_arg {
     slow5_core_t* core;
     slow5_db_t* db;
     int32_t starti;
     int32_t endi;
-    void (*func)(slow5_core_t*,slow5_db_t*,int);
+    void (*func)(slow5_core_t*,slow5_db_t*,int,slow5_decode_ctx_t*);
     int32_t thread_index;
 #ifdef SLOW5_WORK_STEAL
     void *all_pthread_args;
 #endif
-} slow5_pt_arg_t;
+};
 
+static void* slow5_pthread_worker(void* voidargs);
 
-/* initialise the core data structure */
-static slow5_core_t* slow5_init_core(slow5_file_t *s5p, int batch_size, int num_thread) {
+/* initialise the core data structure and start the worker pool */
+slow5_mt_t *slow5_init_mt(int num_thread, slow5_file_t *s5p) {
 
-    slow5_core_t* core = (slow5_core_t*)malloc(sizeof(slow5_core_t));
+    slow5_core_t* core = (slow5_core_t*)calloc(1, sizeof(slow5_core_t));
     SLOW5_MALLOC_CHK_LAZY_EXIT(core);
 
     core->sf = s5p;
-    core->batch_size = batch_size;
-    core->num_thread = num_thread;
+    core->batch_size = 0;
+    core->num_thread = num_thread > 1 ? num_thread : 1;
+
+    core->ctx = (slow5_decode_ctx_t**)malloc(core->num_thread * sizeof *core->ctx);
+    SLOW5_MALLOC_CHK_LAZY_EXIT(core->ctx);
+    int32_t t;
+    for (t = 0; t < core->num_thread; t++) {
+        core->ctx[t] = slow5_decode_ctx_init();
+        SLOW5_MALLOC_CHK_LAZY_EXIT(core->ctx[t]);
+    }
+
+    if (core->num_thread == 1) {
+        return core;
+    }
+
+    core->tids = (pthread_t*)malloc(core->num_thread * sizeof *core->tids);
+    SLOW5_MALLOC_CHK_LAZY_EXIT(core->tids);
+    core->pt_args = (slow5_pt_arg_t*)calloc(core->num_thread, sizeof *core->pt_args);
+    SLOW5_MALLOC_CHK_LAZY_EXIT(core->pt_args);
+
+    pthread_mutex_init(&core->lock, NULL);
+    pthread_cond_init(&core->work_cond, NULL);
+    pthread_cond_init(&core->done_cond, NULL);
+
+    SLOW5_LOG_DEBUG("Creating %d threads\n",core->num_thread);
+    for (t = 0; t < core->num_thread; t++) {
+        core->pt_args[t].core = core;
+        core->pt_args[t].thread_index = t;
+    #ifdef SLOW5_WORK_STEAL
+        core->pt_args[t].all_pthread_args = (void *)core->pt_args;
+    #endif
+        int ret = pthread_create(&core->tids[t], NULL, slow5_pthread_worker,
+                                (void*)(&core->pt_args[t]));
+        if(ret != 0){
+            SLOW5_ERROR("Error creating thread %d\n",t);
+            exit(EXIT_FAILURE);
+        }
+    }
 
     return core;
 }
 
-/* free the core data structure */
-static void slow5_free_core(slow5_core_t* core) {
+/* stop the worker pool and free the core data structure */
+void slow5_free_mt(slow5_mt_t *mt) {
+
+    slow5_core_t* core = mt;
+    if (core == NULL) {
+        return;
+    }
+
+    if (core->num_thread > 1) {
+        pthread_mutex_lock(&core->lock);
+        core->shutdown = 1;
+        pthread_cond_broadcast(&core->work_cond);
+        pthread_mutex_unlock(&core->lock);
+
+        int32_t t;
+        for (t = 0; t < core->num_thread; t++) {
+            int ret = pthread_join(core->tids[t], NULL);
+            if(ret != 0){
+                SLOW5_ERROR("Error joining thread %d\n",t);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        pthread_cond_destroy(&core->done_cond);
+        pthread_cond_destroy(&core->work_cond);
+        pthread_mutex_destroy(&core->lock);
+        free(core->pt_args);
+        free(core->tids);
+    }
+
+    int32_t t;
+    for (t = 0; t < core->num_thread; t++) {
+        slow5_decode_ctx_free(core->ctx[t]);
+    }
+    free(core->ctx);
     free(core);
 }
 
@@ -97,6 +183,9 @@ static slow5_db_t* slow5_init_db(slow5_core_t* core) {
     db->slow5_rec = (slow5_rec_t**)calloc(db->capacity_rec,sizeof(slow5_rec_t*));
     SLOW5_MALLOC_CHK_LAZY_EXIT(db->slow5_rec);
 
+    db->rid = NULL;
+    db->plan = NULL;
+
     return db;
 }
 
@@ -146,11 +235,11 @@ static int slow5_write_db(slow5_core_t* core, slow5_db_t* db) {
 }
 
 
-static void slow5_parse_single(slow5_core_t* core,slow5_db_t* db, int32_t i){
+static void slow5_parse_single(slow5_core_t* core,slow5_db_t* db, int32_t i, slow5_decode_ctx_t *ctx){
 
     assert(db->mem_bytes[i]>0);
     assert(db->mem_records[i]!=NULL);
-    int ret=slow5_rec_depress_parse(&db->mem_records[i], &db->mem_bytes[i], NULL, &db->slow5_rec[i], core->sf);
+    int ret=slow5_rec_depress_parse_ctx(db->mem_records[i], db->mem_bytes[i], NULL, &db->slow5_rec[i], core->sf, ctx);
     if(ret!=0){
         SLOW5_ERROR("Error parsing the record %s",db->slow5_rec[i]->read_id);
         exit(EXIT_FAILURE);
@@ -159,22 +248,22 @@ static void slow5_parse_single(slow5_core_t* core,slow5_db_t* db, int32_t i){
 }
 
 
-static void slow5_work_per_single_read(slow5_core_t* core,slow5_db_t* db, int32_t i){
-    slow5_parse_single(core,db,i);
+static void slow5_work_per_single_read(slow5_core_t* core,slow5_db_t* db, int32_t i, slow5_decode_ctx_t *ctx){
+    slow5_parse_single(core,db,i,ctx);
 }
 
-static void slow5_work_per_single_read2(slow5_core_t* core,slow5_db_t* db, int32_t i){
-    assert(db->rid[i]!=NULL);
-    int ret = slow5_get(db->rid[i],&db->slow5_rec[i], core->sf);
+static void slow5_work_per_group(slow5_core_t* core,slow5_db_t* db, int32_t i, slow5_decode_ctx_t *ctx){
+    assert(db->plan!=NULL);
+    int ret = slow5_get_plan_fetch(db->plan, i, db->slow5_rec, core->sf, ctx);
     if(ret<0){
-        SLOW5_ERROR("Error when fetching the read %s\n",db->rid[i]);
+        SLOW5_ERROR("Error when fetching the read group %d\n",i);
         exit(EXIT_FAILURE);
     }
-    db->mem_bytes[i]=ret;
 
 }
 
-static void slow5_work_per_single_read3(slow5_core_t* core,slow5_db_t* db, int32_t i){
+static void slow5_work_per_single_read3(slow5_core_t* core,slow5_db_t* db, int32_t i, slow5_decode_ctx_t *ctx){
+    (void)ctx;
     assert(db->slow5_rec[i]!=NULL);
     slow5_file_t *sf = core->sf;
     //fprintf(stderr,"Here %d\n",i);
@@ -235,15 +324,15 @@ static inline int32_t steal_work(slow5_pt_arg_t* all_args, int32_t num_thread) {
 }
 
 
-static void* slow5_pthread_single(void* voidargs) {
+static void slow5_pthread_single(slow5_pt_arg_t* args) {
     int32_t i;
-    slow5_pt_arg_t* args = (slow5_pt_arg_t*)voidargs;
     slow5_db_t* db = args->db;
     slow5_core_t* core = args->core;
+    slow5_decode_ctx_t *ctx = core->ctx[args->thread_index];
 
 #ifndef SLOW5_WORK_STEAL
     for (i = args->starti; i < args->endi; i++) {
-        args->func(core,db,i);
+        args->func(core,db,i,ctx);
     }
 #else
     slow5_pt_arg_t* all_args = (slow5_pt_arg_t*)(args->all_pthread_args);
@@ -253,32 +342,55 @@ static void* slow5_pthread_single(void* voidargs) {
 		if (i >= args->endi) {
             break;
         }
-		args->func(core,db,i);
+		args->func(core,db,i,ctx);
 	}
 	while ((i = steal_work(all_args,core->num_thread)) >= 0){
-		args->func(core,db,i);
+		args->func(core,db,i,ctx);
     }
 #endif
+}
+
+/* worker thread body: sleep until a batch is posted, process its share, repeat until shutdown */
+static void* slow5_pthread_worker(void* voidargs) {
+    slow5_pt_arg_t* args = (slow5_pt_arg_t*)voidargs;
+    slow5_core_t* core = args->core;
+    uint64_t seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&core->lock);
+        while (core->generation == seen && !core->shutdown) {
+            pthread_cond_wait(&core->work_cond, &core->lock);
+        }
+        if (core->shutdown) {
+            pthread_mutex_unlock(&core->lock);
+            break;
+        }
+        seen = core->generation;
+        pthread_mutex_unlock(&core->lock);
+
+        slow5_pthread_single(args);
+
+        pthread_mutex_lock(&core->lock);
+        if (++core->num_done == core->num_thread) {
+            pthread_cond_signal(&core->done_cond);
+        }
+        pthread_mutex_unlock(&core->lock);
+    }
 
-    //fprintf(stderr,"Thread %d done\n",(myargs->position)/THREADS);
-    pthread_exit(0);
+    return NULL;
 }
 
-static void slow5_pthread_db(slow5_core_t* core, slow5_db_t* db, void (*func)(slow5_core_t*,slow5_db_t*,int)){
-    //create threads
-    pthread_t tids[core->num_thread];
-    slow5_pt_arg_t pt_args[core->num_thread];
-    int32_t t, ret;
+/* hand a batch to the worker pool and wait until all workers are done with it */
+static void slow5_pthread_db(slow5_core_t* core, slow5_db_t* db, void (*func)(slow5_core_t*,slow5_db_t*,int,slow5_decode_ctx_t*)){
+    slow5_pt_arg_t *pt_args = core->pt_args;
+    int32_t t;
     int32_t i = 0;
     int32_t num_thread = core->num_thread;
     int32_t step = (db->n_rec + num_thread - 1) / num_thread;
-    //todo : check for higher num of threads than the data
-    //current works but many threads are created despite
 
-    SLOW5_LOG_DEBUG("Creating %d threads\n",num_thread);
     //set the data structures
+    pthread_mutex_lock(&core->lock);
     for (t = 0; t < num_thread; t++) {
-        pt_args[t].core = core;
         pt_args[t].db = db;
         pt_args[t].starti = i;
         i += step;
@@ -288,40 +400,26 @@ static void slow5_pthread_db(slow5_core_t* core, slow5_db_t* db, void (*func)(sl
             pt_args[t].endi = i;
         }
         pt_args[t].func=func;
-    #ifdef SLOW5_WORK_STEAL
-        pt_args[t].all_pthread_args =  (void *)pt_args;
-    #endif
         //fprintf(stderr,"t%d : %d-%d\n",t,pt_args[t].starti,pt_args[t].endi);
-
-    }
-
-    //create threads
-    for(t = 0; t < core->num_thread; t++){
-        ret = pthread_create(&tids[t], NULL, slow5_pthread_single,
-                                (void*)(&pt_args[t]));
-        if(ret < 0){
-            SLOW5_ERROR("Error creating thread %d\n",t);
-            exit(EXIT_FAILURE);
-        }
     }
 
-    //pthread joining
-    for (t = 0; t < core->num_thread; t++) {
-        int ret = pthread_join(tids[t], NULL);
-        if(ret < 0){
-            SLOW5_ERROR("Error creating thread %d\n",t);
-            exit(EXIT_FAILURE);
-        }
+    //wake the workers and wait for the batch to be finished
+    core->num_done = 0;
+    core->generation++;
+    pthread_cond_broadcast(&core->work_cond);
+    while (core->num_done < num_thread) {
+        pthread_cond_wait(&core->done_cond, &core->lock);
     }
+    pthread_mutex_unlock(&core->lock);
 }
 
 /* process all reads in the given batch db */
-static void slow5_work_db(slow5_core_t* core, slow5_db_t* db, void (*func)(slow5_core_t*,slow5_db_t*,int)){
+static void slow5_work_db(slow5_core_t* core, slow5_db_t* db, void (*func)(slow5_core_t*,slow5_db_t*,int,slow5_decode_ctx_t*)){
 
-    if (core->num_thread == 1) {
+    if (core->num_thread == 1 || db->n_rec <= 1) {
         int32_t i=0;
         for (i = 0; i < db->n_rec; i++) {
-            func(core,db,i);
+            func(core,db,i,core->ctx[0]);
         }
 
     }
@@ -331,29 +429,35 @@ static void slow5_work_db(slow5_core_t* core, slow5_db_t* db, void (*func)(slow5
     }
 }
 
-int slow5_get_batch(slow5_rec_t ***read, slow5_file_t *s5p, char **rid, int num_rid, int num_threads){
+int slow5_get_batch(slow5_rec_t ***read, slow5_mt_t *mt, char **rid, int num_rid){
 
-    slow5_core_t *core = slow5_init_core(s5p,num_rid,num_threads);
+    slow5_core_t *core = mt;
+    core->batch_size = num_rid;
     slow5_db_t* db = slow5_init_db(core);
 
     db->rid = rid;
-    db->n_rec = num_rid;
-    slow5_work_db(core,db,slow5_work_per_single_read2);
-    SLOW5_LOG_DEBUG("loaded and parsed %d recs\n",num_rid);
+    db->plan = slow5_get_plan_init(rid, num_rid, core->sf);
+    SLOW5_MALLOC_CHK_LAZY_EXIT(db->plan);
+    db->n_rec = slow5_get_plan_len(db->plan); //one work item per group of nearby records
+    slow5_work_db(core,db,slow5_work_per_group);
+    SLOW5_LOG_DEBUG("loaded and parsed %d recs in %d groups\n",num_rid,db->n_rec);
 
     *read = db->slow5_rec;
 
+    slow5_get_plan_free(db->plan);
+    db->plan = NULL;
+
     slow5_free_db_tmp(db);
     slow5_free_db(db);
-    slow5_free_core(core);
 
     return num_rid;
 }
 
 
-int slow5_get_next_batch(slow5_rec_t ***read, slow5_file_t *s5p, int batch_size, int num_threads){
+int slow5_get_next_batch(slow5_rec_t ***read, slow5_mt_t *mt, int batch_size){
 
-    slow5_core_t *core = slow5_init_core(s5p,batch_size,num_threads);
+    slow5_core_t *core = mt;
+    core->batch_size = batch_size;
     slow5_db_t* db = slow5_init_db(core);
 
     int num_read=slow5_load_db(core,db);
@@ -365,15 +469,15 @@ int slow5_get_next_batch(slow5_rec_t ***read, slow5_file_t *s5p, int batch_size,
 
     slow5_free_db_tmp(db);
     slow5_free_db(db);
-    slow5_free_core(core);
 
     return num_read;
 }
 
 
-int slow5_write_batch(slow5_rec_t **read, slow5_file_t *s5p, int batch_size, int num_threads){
+int slow5_write_batch(slow5_rec_t **read, slow5_mt_t *mt, int batch_size){
 
-    slow5_core_t *core = slow5_init_core(s5p,batch_size,num_threads);
+    slow5_core_t *core = mt;
+    core->batch_size = batch_size;
     slow5_db_t* db = slow5_init_db(core);
 
     db->n_rec = batch_size;
@@ -388,7 +492,6 @@ int slow5_write_batch(slow5_rec_t **read, slow5_file_t *s5p, int batch_size, int
     db->slow5_rec = NULL;
     slow5_free_db_tmp(db);
     slow5_free_db(db);
-    slow5_free_core(core);
 
     return num_wr;
 }
@@ -423,7 +526,8 @@ int read_func(){
     int ret=0;
     int batch_size = 4096;
     int num_thread = 8;
-    while((ret = slow5_get_next_batch(&rec,sp,batch_size,num_thread)) > 0){
+    slow5_mt_t *mt = slow5_init_mt(num_thread,sp);
+    while((ret = slow5_get_next_batch(&rec,mt,batch_size)) > 0){
 
         for(int i=0;i<ret;i++){
             uint64_t len_raw_signal = rec[i]->len_raw_signal;
@@ -436,6 +540,7 @@ int read_func(){
         }
     }
 
+    slow5_free_mt(mt);
     slow5_close(sp);
 
 
@@ -461,7 +566,8 @@ int read_func(){
     rid[2]="read_id_0";
     rid[3]="read_id_4";
 
-    ret = slow5_get_batch(&rec, sp, rid, num_rid, num_thread);
+    mt = slow5_init_mt(num_thread,sp);
+    ret = slow5_get_batch(&rec, mt, rid, num_rid);
     assert(ret==num_rid);
     for(int i=0;i<ret;i++){
         uint64_t len_raw_signal = rec[i]->len_raw_signal;
@@ -469,6 +575,7 @@ int read_func(){
     }
     slow5_free_batch(&rec,ret);
 
+    slow5_free_mt(mt);
     slow5_idx_unload(sp);
     slow5_close(sp);
 
@@ -616,7 +723,9 @@ int write_func(){
     }
     //end of record setup
 
-    ret = slow5_write_batch(rec,sf,batch_size,num_thread);
+    slow5_mt_t *mt = slow5_init_mt(num_thread,sf);
+    ret = slow5_write_batch(rec,mt,batch_size);
+    slow5_free_mt(mt);
 
     if(ret<batch_size){
         fprintf(stderr,"Writing failed\n");
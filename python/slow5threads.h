@@ -8,10 +8,16 @@
 //these functions will lazily exit on error (need to do proper error handling, but a bit too much work at the moment)
 //also these functions are not optimised for cases that are unlikely to be bottlenecks
 //that is they do superfluous mallocs and free and computations in cases which are unlikely to be bottlenecks
-//also each batch call will create and destruct threads rather than using a thread pool
-int slow5_get_batch(slow5_rec_t ***read, slow5_file_t *s5p, char **rid, int num_rid, int num_threads);
-int slow5_get_next_batch(slow5_rec_t ***read, slow5_file_t *s5p, int batch_size, int num_threads);
-int slow5_write_batch(slow5_rec_t **read, slow5_file_t *s5p, int batch_size, int num_threads);
+
+/* worker pool bound to a slow5 file. threads are started in slow5_init_mt, reused by every batch call and joined in slow5_free_mt */
+typedef struct slow5_mt slow5_mt_t;
+
+slow5_mt_t *slow5_init_mt(int num_thread, slow5_file_t *s5p);
+void slow5_free_mt(slow5_mt_t *mt);
+
+int slow5_get_batch(slow5_rec_t ***read, slow5_mt_t *mt, char **rid, int num_rid);
+int slow5_get_next_batch(slow5_rec_t ***read, slow5_mt_t *mt, int batch_size);
+int slow5_write_batch(slow5_rec_t **read, slow5_mt_t *mt, int batch_size);
 void slow5_free_batch(slow5_rec_t ***read, int num_rec);
 
 #endif
@@ -36,15 +36,16 @@ except ImportError:
 
 #adapted from https://github.com/lh3/minimap2/blob/master/setup.py
 
-sources=['python/pyslow5.pyx', 'src/slow5.c', 'src/slow5_press.c', 'src/slow5_misc.c', 'src/slow5_idx.c',
+sources=['python/pyslow5.pyx', 'src/slow5.c', 'src/slow5_press.c', 'src/slow5_misc.c', 'src/slow5_idx.c', 'src/slow5_aio.c',
             'python/slow5threads.c',
             'thirdparty/streamvbyte/src/streamvbyte_zigzag.c', 'thirdparty/streamvbyte/src/streamvbyte_decode.c', 'thirdparty/streamvbyte/src/streamvbyte_encode.c']
 depends=['python/pyslow5.pxd', 'python/pyslow5.h',
             'python/slow5threads.h',
             'slow5/slow5.h', 'slow5/slow5_defs.h', 'slow5/slow5_error.h', 'slow5/slow5_press.h',
             'slow5/klib/khash.h', 'slow5/klib/kvec.h',
-            'src/slow5_extra.h', 'src/slow5_idx.h', 'src/slow5_misc.h', 'src/klib/ksort.h',
-            'thirdparty/streamvbyte/include/streamvbyte.h', 'thirdparty/streamvbyte/include/streamvbyte_zigzag.h']
+            'src/slow5_extra.h', 'src/slow5_aio.h', 'src/slow5_idx.h', 'src/slow5_misc.h', 'src/klib/ksort.h',
+            'thirdparty/streamvbyte/include/streamvbyte.h', 'thirdparty/streamvbyte/include/streamvbyte_zigzag.h',
+            'thirdparty/streamvbyte/src/streamvbyte_isadetection.h']
 extra_compile_args = ['-g', '-Wall', '-O2', '-std=c99']
 # extra_compile_args = []
 # os.environ["CFLAGS"] = '-g -Wall -O2 -std=c99'
@@ -55,11 +56,11 @@ if arch in ["aarch64", "arm64"]:
 elif arch in ["aarch64"]:
 	extra_compile_args.append('-mfpu=neon')
 elif arch in ["x86_64"]:
-    extra_compile_args.extend(['-DSTREAMVBYTE_SSSE3=1', '-mssse3'])   # WARNING: ancient x86_64 CPUs don't have SSSE3
+    extra_compile_args.extend(['-DSTREAMVBYTE_SSSE3=1'])   # simd kernels are picked at runtime based on the CPU
 
 
 # include_dirs = ['include/', np.get_include(), 'thirdparty/streamvbyte/include']
-libraries = ['m', 'z']
+libraries = ['m', 'z', 'pthread']
 library_dirs = ['.']
 
 # a nasty hack to provide option to build with zstd
@@ -73,6 +74,16 @@ if zstd=="1":
     extra_compile_args.append('-DSLOW5_USE_ZSTD=1')
     libraries.append('zstd')
 
+# same for io_uring
+iouring=0
+try:
+    iouring=os.environ["PYSLOW5_IOURING"]
+except:
+    iouring=0
+
+if iouring=="1":
+    extra_compile_args.append('-DSLOW5_USE_IOURING=1')
+
 extensions = [Extension('pyslow5',
                   sources = sources,
                   depends = depends,
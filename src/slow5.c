@@ -37,8 +37,12 @@ SOFTWARE.
 #include <stdio.h>
 #include <string.h>
 #include <float.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <slow5/slow5.h>
 #include "slow5_extra.h"
+#include "slow5_aio.h"
 #include "slow5_idx.h"
 #include "slow5_misc.h"
 #include "klib/ksort.h"
@@ -73,6 +77,51 @@ KSORT_INIT(str_slow5, ksstr_t, ks_lt_str)
 
 #define SLOW5_FSTREAM_BUFF_SIZE (131072)  /* buffer size for freads and fwrites */
 
+#define SLOW5_GET_MANY_MAX_GAP (65536) /* slow5_get_many reads records at most this many bytes apart together: 2^16 */
+#define SLOW5_GET_MANY_MAX_SPAN (4194304) /* up to this many bytes in a single read: 2^22 */
+#define SLOW5_GET_MANY_AIO_DEPTH (256) /* slow5_get_many keeps up to this many reads in flight */
+#define SLOW5_GET_MANY_AIO_MAX_BUF (134217728) /* and up to this many bytes read but not yet parsed: 2^27 */
+
+#define SLOW5_CAT_BUF_SIZE (4194304) /* slow5_cat copies records this many bytes at a time: 2^22 */
+
+#define SLOW5_BLOCK_MAX_BYTES (1048576) /* records appended to a block-compressed file are compressed together up to this many bytes: 2^20 */
+
+/* background read-ahead of raw records for slow5_get_next_mem (see slow5_set_readahead) */
+struct slow5_readahead {
+    pthread_t tid;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;   /* signalled when a record is added or the reader thread exits */
+    pthread_cond_t not_full;    /* signalled when a record is removed or a stop is requested */
+    char **mem;                 /* ring of raw records as returned by slow5_get_next_mem */
+    size_t *bytes;
+    uint32_t cap;
+    uint32_t head;              /* index of the oldest record */
+    uint32_t count;             /* number of records in the ring */
+    int8_t stop;                /* set by the caller to stop the reader thread */
+    int8_t done;                /* set by the reader thread when it exits */
+    int err;                    /* slow5_errno of the reader thread when it exits (SLOW5_ERR_EOF at end of file), 0 if stopped */
+};
+
+/*
+ * records of a block-compressed blow5 file (see slow5_set_block)
+ * a block is stored as a record: its size, then the compressed records, each with its size
+ */
+struct slow5_block {
+    uint64_t id;                /* unique among the files opened, to know which file a block decompressed into a slow5_decode_ctx is from */
+    char *buf;                  /* records written but not yet compressed */
+    size_t len;
+    size_t cap;
+    uint32_t num_recs;          /* records in buf */
+    uint32_t max_recs;          /* buf is compressed once it has this many records (0 for no limit) */
+    uint64_t max_bytes;         /* or this many bytes (0 for no limit) */
+    uint64_t idx_first;         /* offset in the pool of the write index of the first record in buf */
+    char *mem;                  /* decompressed block slow5_get_next takes records from */
+    size_t mem_len;
+    size_t mem_pos;             /* of the next record in mem */
+};
+
+static uint64_t slow5_block_ids = 0;
+
 static inline void slow5_free(struct slow5_file *s5p);
 static int slow5_rec_aux_parse(char *tok, char *read_mem, uint64_t offset, size_t read_size, struct slow5_rec *read, enum slow5_fmt format, struct slow5_aux_meta *aux_meta);
 static inline khash_t(slow5_s2a) *slow5_rec_aux_init(void);
@@ -80,9 +129,24 @@ static inline void slow5_rec_set_aux_map(khash_t(slow5_s2a) *aux_map, const char
 static char *get_missing_str(size_t *len);
 static int slow5_version_sanity(struct slow5_hdr *hdr);
 static struct slow5_version slow5_press_version_bump(struct slow5_version current, slow5_press_method_t method);
+static struct slow5_version slow5_footer_version_bump(struct slow5_version current);
+static int slow5_hdr_version_rewrite(struct slow5_file *s5p, struct slow5_version version);
 
 static inline slow5_file_t *slow5_open_write(const char *filename);
 static inline slow5_file_t *slow5_open_append(const char *filename,  enum slow5_fmt format);
+static void *slow5_get_next_mem_fp(size_t *n, const struct slow5_file *s5p, char **buf, size_t *cap);
+static void *slow5_get_next_mem_buf(size_t *n, const struct slow5_file *s5p, char **buf, size_t *cap);
+static void *slow5_get_mem_buf(const char *read_id, size_t *n, const struct slow5_file *s5p, char **buf, size_t *cap);
+static void *slow5_readahead_pop(size_t *n, struct slow5_readahead *ra);
+static int slow5_readahead_drained(struct slow5_readahead *ra);
+static void *slow5_block_next(size_t *n, const struct slow5_file *s5p, char **buf, size_t *cap);
+static void slow5_readahead_stop(struct slow5_readahead *ra);
+static void slow5_readahead_free(struct slow5_readahead *ra);
+static int slow5_mmap_init(struct slow5_file *s5p);
+static struct slow5_block *slow5_block_init(uint32_t max_recs, uint64_t max_bytes);
+static void slow5_block_free(struct slow5_block *blk);
+static int slow5_block_flush(struct slow5_file *s5p);
+static int slow5_dict_fread(FILE *fp, struct slow5_press *compress);
 
 enum slow5_log_level_opt slow5_log_level = SLOW5_LOG_INFO;
 enum slow5_exit_condition_opt slow5_exit_condition = SLOW5_EXIT_OFF;
@@ -177,6 +241,15 @@ struct slow5_file *slow5_init(FILE *fp, const char *pathname, enum slow5_fmt for
         return NULL;
     }
 
+    if (method.record_dict && slow5_dict_fread(fp, s5p->compress) != 0) {
+        SLOW5_ERROR("Reading the zstd dictionary of file '%s' failed.", pathname);
+        free(fread_buff);
+        slow5_press_free(s5p->compress);
+        slow5_hdr_free(header);
+        free(s5p);
+        return NULL;
+    }
+
     if ((s5p->meta.fd = fileno(fp)) == -1) {
         SLOW5_ERROR("Obtaining file descriptor with fileno() failed: %s.", strerror(errno));
         free(fread_buff);
@@ -198,6 +271,14 @@ struct slow5_file *slow5_init(FILE *fp, const char *pathname, enum slow5_fmt for
         return NULL;
     }
 
+    if (method.block_method != SLOW5_COMPRESS_NONE && !(s5p->meta.block = slow5_block_init(0, SLOW5_BLOCK_MAX_BYTES))) {
+        free(fread_buff);
+        slow5_press_free(s5p->compress);
+        slow5_hdr_free(header);
+        free(s5p);
+        return NULL;
+    }
+
     return s5p;
 }
 
@@ -283,7 +364,7 @@ struct slow5_file *slow5_init_empty(FILE *fp, const char *pathname, enum slow5_f
  *
  *
  * @param   pathname    relative or absolute path to slow5 file
- * @param   mode        "r" for reading, "w" for writing a new file, "a" for appending to an existing file
+ * @param   mode        "r" for reading, "rm" for reading with the file memory-mapped, "w" for writing a new file, "a" for appending to an existing file
  * @return              slow5 file structure
  */
 struct slow5_file *slow5_open(const char *pathname, const char *mode) {
@@ -347,11 +428,12 @@ struct slow5_file *slow5_open_with(const char *pathname, const char *mode, enum
         }
         return s5p;
     }
-    else if (strcmp(mode, "r") != 0){
-        SLOW5_WARNING("Currently, the only supported modes are 'r', 'w' and 'a'. You entered '%s'.", mode);
+    int map = strcmp(mode, "rm") == 0;
+    if (strcmp(mode, "r") != 0 && !map){
+        SLOW5_WARNING("Currently, the only supported modes are 'r', 'rm', 'w' and 'a'. You entered '%s'.", mode);
     }
 
-    FILE *fp = fopen(pathname, mode);
+    FILE *fp = fopen(pathname, map ? "r" : mode);
     if (!fp) {
         SLOW5_ERROR_EXIT("Error opening file '%s': %s.", pathname, strerror(errno));
         slow5_errno = SLOW5_ERR_IO;
@@ -366,11 +448,44 @@ struct slow5_file *slow5_open_with(const char *pathname, const char *mode, enum
         SLOW5_EXIT_IF_ON_ERR();
     } else {
         s5p->meta.mode = mode;
+        if (map && slow5_mmap_init(s5p) != 0) {
+            slow5_close(s5p);
+            s5p = NULL;
+            SLOW5_EXIT_IF_ON_ERR();
+        }
     }
 
     return s5p;
 }
 
+/*
+ * map the whole slow5 file read-only for mode "rm"
+ * records that lie past the mapping (appended after opening) are still read with pread
+ * return 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_IO     fstat or mmap failed
+ */
+static int slow5_mmap_init(struct slow5_file *s5p) {
+    struct stat st;
+    if (fstat(s5p->meta.fd, &st) == -1) {
+        SLOW5_ERROR("Obtaining the size of file '%s' with fstat() failed: %s.", s5p->meta.pathname, strerror(errno));
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, s5p->meta.fd, 0);
+    if (addr == MAP_FAILED) {
+        SLOW5_ERROR("Memory-mapping file '%s' failed: %s.", s5p->meta.pathname, strerror(errno));
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+    /* lookups jump around the file, do not read ahead around each one */
+    (void) posix_madvise(addr, st.st_size, POSIX_MADV_RANDOM);
+
+    s5p->meta.mmap_addr = addr;
+    s5p->meta.mmap_size = st.st_size;
+    SLOW5_LOG_DEBUG("Memory-mapped '%zu' bytes of file '%s'.", s5p->meta.mmap_size, s5p->meta.pathname);
+
+    return 0;
+}
+
 /* Creates an empty SLOW5 file with the given pathname,
 *  initialise SLOW5 file structure with space for a single read group
 *  errors
@@ -466,7 +581,26 @@ static inline slow5_file_t *slow5_open_append(const char *filename, enum slow5_f
         }
     }
 
-    if(s5p->format==SLOW5_FORMAT_BINARY){
+    uint64_t footer = 0;
+    int has_footer = 0;
+    if(s5p->format==SLOW5_FORMAT_BINARY && (has_footer = slow5_idx_footer_offset(s5p->meta.fd, &footer)) < 0){
+        slow5_close(s5p);
+        return NULL;
+    }
+
+    if(has_footer){
+        // new records overwrite the index footer, which is written again with them by slow5_close
+        if(!(s5p->meta.idx_footer = slow5_idx_footer_init(s5p, footer, 1))){
+            slow5_close(s5p);
+            return NULL;
+        }
+        if(fseeko(s5p->fp, footer, SEEK_SET) != 0){
+            SLOW5_ERROR("Fseek to the index footer failed '%s': %s.", filename, strerror(errno));
+            slow5_errno = SLOW5_ERR_IO;
+            slow5_close(s5p);
+            return NULL;
+        }
+    } else if(s5p->format==SLOW5_FORMAT_BINARY){
         const char eof[] = SLOW5_BINARY_EOF;
         if(fseek(s5p->fp, - (sizeof *eof) * (sizeof eof) , SEEK_END) != 0){
             SLOW5_ERROR("Fseek to the end of file (SEEK_END-eof_marker_size) failed '%s': %s.", filename, strerror(errno));
@@ -513,14 +647,42 @@ int slow5_close(struct slow5_file *s5p) {
         ret = EOF;
     } else {
 
+        slow5_readahead_stop(s5p->meta.readahead);
+
         if(s5p->meta.mode && (strcmp(s5p->meta.mode, "w") == 0 || strcmp(s5p->meta.mode, "a") == 0)){
             if(s5p->format == SLOW5_FORMAT_BINARY){
+                if(slow5_block_flush(s5p) != 0){
+                    SLOW5_ERROR("Writing the last block of records to '%s' failed.", s5p->meta.pathname);
+                    ret = EOF;
+                }
+                if(s5p->meta.idx_footer){
+                    // the header may have been written before the footer was enabled (or by an older slow5lib when appending)
+                    struct slow5_version version = slow5_footer_version_bump(s5p->header->version);
+                    if(slow5_version_cmp(version, s5p->header->version) != 0 && slow5_hdr_version_rewrite(s5p, version) != 0){
+                        SLOW5_ERROR("Updating the version of '%s' for its index footer failed.", s5p->meta.pathname);
+                        ret = EOF;
+                    }
+                    SLOW5_LOG_DEBUG("Writing index footer to file '%s'", s5p->meta.pathname);
+                    int err = slow5_idx_footer_write(s5p->meta.idx_footer, s5p->header->version, s5p->fp);
+                    if(err != 0){
+                        SLOW5_ERROR("Writing the index footer to '%s' failed.", s5p->meta.pathname);
+                        slow5_errno = err;
+                        ret = EOF;
+                    }
+                }
                 SLOW5_LOG_DEBUG("Writing EOF marker to file '%s'", s5p->meta.pathname);
                 if(slow5_eof_fwrite(s5p->fp) < 0){
                     SLOW5_ERROR_EXIT("%s","Error writing EOF!\n");
                     slow5_errno = SLOW5_ERR_IO;
                     ret = EOF;
                 }
+                // an appended footer can be shorter than the one it overwrote
+                if(s5p->meta.idx_footer && strcmp(s5p->meta.mode, "a") == 0 &&
+                        (fflush(s5p->fp) == EOF || ftruncate(s5p->meta.fd, ftello(s5p->fp)) == -1)){
+                    SLOW5_ERROR("Failed to truncate slow5 file '%s': %s.", s5p->meta.pathname, strerror(errno));
+                    slow5_errno = SLOW5_ERR_IO;
+                    ret = EOF;
+                }
             }
         }
 
@@ -531,18 +693,12 @@ int slow5_close(struct slow5_file *s5p) {
         }
 
         // TODO slow5_index_close
-        if (s5p->index && s5p->index->fp && s5p->index->dirty) { // if the index has been changed, write it back
-            if (fseek(s5p->index->fp, 0L, SEEK_SET) != 0) {
-                SLOW5_ERROR("Failed to fseek() to start of index file '%s': %s.", s5p->index->pathname, strerror(errno));
-                slow5_errno = SLOW5_ERR_IO;
+        if (s5p->index && s5p->index->pathname && s5p->index->dirty) { // if the index has been changed, write it back
+            int err = slow5_idx_write(s5p->index, s5p->header->version);
+            if (err != 0) {
+                SLOW5_ERROR("Writing index file to '%s' failed.", s5p->index->pathname);
+                slow5_errno = err;
                 ret = EOF;
-            } else {
-                int err = slow5_idx_write(s5p->index, s5p->header->version);
-                if (err != 0) {
-                    SLOW5_ERROR("Writing index file to '%s' failed.", s5p->index->pathname);
-                    slow5_errno = err;
-                    ret = EOF;
-                }
             }
         }
 
@@ -557,12 +713,27 @@ static inline void slow5_free(struct slow5_file *s5p) {
         slow5_press_free(s5p->compress);
         slow5_hdr_free(s5p->header);
         slow5_idx_free(s5p->index);
+        slow5_idx_free(s5p->meta.idx_footer);
+        slow5_readahead_free(s5p->meta.readahead);
+        if (s5p->meta.mmap_addr) {
+            munmap(s5p->meta.mmap_addr, s5p->meta.mmap_size);
+        }
+        slow5_decode_ctx_free(s5p->meta.decode_ctx);
+        slow5_block_free(s5p->meta.block);
         free(s5p->meta.fread_buffer);
         free(s5p);
     }
 }
 
 int slow5_set_press(slow5_file_t *s5p, enum slow5_press_method rec_press, enum slow5_press_method sig_press){
+    return slow5_set_press_opt(s5p, rec_press, sig_press, NULL);
+}
+
+/*
+ * same as slow5_set_press with the options opt (if not NULL) for the record compression, which must be zlib or zstd
+ * returns 0 on success, -1 on error and sets slow5_errno
+ */
+int slow5_set_press_opt(slow5_file_t *s5p, enum slow5_press_method rec_press, enum slow5_press_method sig_press, const slow5_press_opt_t *opt){
 
     if(s5p==NULL){
         SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
@@ -583,15 +754,29 @@ int slow5_set_press(slow5_file_t *s5p, enum slow5_press_method rec_press, enum s
     }
 
 
-    //free the existing press if any
+    const slow5_press_opt_t opt_default = {0};
+    if(opt && memcmp(opt, &opt_default, sizeof *opt) != 0 && rec_press != SLOW5_COMPRESS_ZLIB && rec_press != SLOW5_COMPRESS_ZSTD){
+        SLOW5_ERROR_EXIT("Compression options are only for zlib or zstd, not record compression method '%d'.", rec_press);
+        slow5_errno = SLOW5_ERR_ARG;
+        return -1;
+    }
+
+    //free the existing press if any, records are then compressed one at a time again
     slow5_press_free(s5p->compress);
+    slow5_block_free(s5p->meta.block);
+    s5p->meta.block = NULL;
+    if (s5p->meta.idx_footer) {
+        s5p->meta.idx_footer->block = 0;
+    }
 
     //this structure is only to be used in single threaded writes
     if(s5p->format == SLOW5_FORMAT_BINARY){
         slow5_press_method_t press_out = {rec_press,sig_press};
-        s5p->compress = slow5_press_init(press_out);
+        s5p->compress = slow5_press_init_opt(press_out, opt);
         if(!s5p->compress){
-            slow5_errno = SLOW5_ERR_PRESS;
+            if (slow5_errno != SLOW5_ERR_ARG) {
+                slow5_errno = SLOW5_ERR_PRESS;
+            }
             SLOW5_ERROR_EXIT("Could not initialise the slow5 compression method. %s","");
             return -1;
         }
@@ -601,6 +786,261 @@ int slow5_set_press(slow5_file_t *s5p, enum slow5_press_method rec_press, enum s
 
 }
 
+/*
+ * enable (1) or disable (0) the index footer of a blow5 file opened for writing
+ * records written after enabling are indexed and slow5_close writes the index as a footer
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+int slow5_set_idx_footer(slow5_file_t *s5p, int enable) {
+
+    if (!s5p) {
+        SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (!(s5p->meta.mode && strcmp(s5p->meta.mode, "w") == 0)) {
+        SLOW5_ERROR_EXIT("%s", "File must have been opened for writing.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (s5p->format != SLOW5_FORMAT_BINARY) {
+        SLOW5_ERROR_EXIT("%s", "File should be in binary format (blow5).");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    if (!enable) {
+        slow5_idx_free(s5p->meta.idx_footer);
+        s5p->meta.idx_footer = NULL;
+    } else if (!s5p->meta.idx_footer) {
+        s5p->meta.idx_footer = (struct slow5_idx *) calloc(1, sizeof *s5p->meta.idx_footer);
+        if (!s5p->meta.idx_footer) {
+            SLOW5_MALLOC_ERROR();
+            SLOW5_EXIT_IF_ON_ERR();
+            return slow5_errno = SLOW5_ERR_MEM;
+        }
+        s5p->meta.idx_footer->block = s5p->meta.block != NULL;
+    }
+
+    return 0;
+}
+
+/*
+ * enable (1) or disable (0) the v2 format for the index files of s5p loaded or created from now on
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+int slow5_set_idx_v2(slow5_file_t *s5p, int enable) {
+
+    if (!s5p) {
+        SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    s5p->meta.idx_v2 = enable != 0;
+
+    return 0;
+}
+
+/*
+ * compress the records written to a blow5 file opened with mode "w" with its record compression method
+ * in blocks of up to max_recs records or max_bytes bytes (0 for no limit), or change the limits of a block-compressed file opened with mode "a"
+ * must be called before the header is written
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+int slow5_set_block(slow5_file_t *s5p, uint32_t max_recs, uint64_t max_bytes) {
+
+    if (!s5p) {
+        SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (!(s5p->meta.mode && (strcmp(s5p->meta.mode, "w") == 0 || (strcmp(s5p->meta.mode, "a") == 0 && s5p->meta.block)))) {
+        SLOW5_ERROR_EXIT("%s", "File must have been opened for writing, or for appending to a block-compressed file.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (s5p->format != SLOW5_FORMAT_BINARY) {
+        SLOW5_ERROR_EXIT("%s", "File should be in binary format (blow5).");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (!max_recs && !max_bytes) {
+        SLOW5_ERROR_EXIT("%s", "Blocks must be limited to a number of records or bytes.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    if (s5p->meta.block) {
+        s5p->meta.block->max_recs = max_recs;
+        s5p->meta.block->max_bytes = max_bytes;
+        return 0;
+    }
+
+    enum slow5_press_method method = s5p->compress->record_press->method;
+    if (method != SLOW5_COMPRESS_ZLIB && method != SLOW5_COMPRESS_ZSTD) {
+        SLOW5_ERROR_EXIT("Blocks can only be compressed with zlib or zstd, not record compression method '%d'.", method);
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (s5p->compress->record_press->dict) {
+        SLOW5_ERROR_EXIT("%s", "Blocks cannot be compressed with a zstd dictionary.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    slow5_press_method_t press_out = {SLOW5_COMPRESS_NONE, s5p->compress->signal_press->method, method};
+    struct slow5_press *compress = slow5_press_init_opt(press_out, &s5p->compress->opt);
+    struct slow5_block *blk = compress ? slow5_block_init(max_recs, max_bytes) : NULL;
+    if (!blk) {
+        slow5_press_free(compress);
+        SLOW5_EXIT_IF_ON_ERR();
+        return slow5_errno;
+    }
+    slow5_press_free(s5p->compress);
+    s5p->compress = compress;
+    s5p->meta.block = blk;
+    if (s5p->meta.idx_footer) {
+        s5p->meta.idx_footer->block = 1;
+    }
+
+    return 0;
+}
+
+/* check that the zstd dictionary of s5p can be set, returns 0 if so, <0 otherwise and sets slow5_errno */
+static int slow5_press_dict_check(slow5_file_t *s5p) {
+    if (!s5p) {
+        SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (!(s5p->meta.mode && strcmp(s5p->meta.mode, "w") == 0) || s5p->format != SLOW5_FORMAT_BINARY) {
+        SLOW5_ERROR_EXIT("%s", "File must be a BLOW5 file opened for writing.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (s5p->compress->record_press->method != SLOW5_COMPRESS_ZSTD || s5p->meta.block) {
+        SLOW5_ERROR_EXIT("%s", "A dictionary can only be used with zstd record compression, not in blocks.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (ftello(s5p->fp) != 0) {
+        SLOW5_ERROR_EXIT("%s", "The dictionary must be set before the header is written.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    return 0;
+}
+
+/*
+ * compress the records of s5p with the zstd dictionary dict of size bytes, stored after the header by slow5_hdr_write
+ * returns 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_ARG    bad argument, not zstd, in blocks or the header is written
+ * SLOW5_ERR_PRESS  zstd could not use the dictionary
+ */
+int slow5_set_press_dict(slow5_file_t *s5p, const void *dict, size_t size) {
+
+    if (slow5_press_dict_check(s5p) != 0) {
+        return slow5_errno;
+    }
+    if (!dict || size == 0 || size > UINT32_MAX) {
+        SLOW5_ERROR_EXIT("Invalid dictionary of %zu bytes.", size);
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    struct slow5_press_dict *press_dict = slow5_press_dict_init(dict, size, s5p->compress->opt.level);
+    int ret = press_dict ? __slow5_press_set_dict(s5p->compress->record_press, press_dict) : slow5_errno;
+    slow5_press_dict_free(press_dict); // the press keeps its own reference
+    if (ret != 0) {
+        SLOW5_EXIT_IF_ON_ERR();
+    }
+    return ret;
+}
+
+/*
+ * same as slow5_set_press_dict with a dictionary of at most cap bytes trained from num_recs records recs
+ * each record is encoded as it is stored without its raw signal, which does not repeat between records
+ * returns 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_PRESS  also if the training fails, e.g. the records are too few
+ */
+int slow5_train_press_dict(slow5_file_t *s5p, slow5_rec_t **recs, uint32_t num_recs, size_t cap) {
+
+    if (slow5_press_dict_check(s5p) != 0) {
+        return slow5_errno;
+    }
+    if (!recs || !num_recs || !cap || cap > UINT32_MAX) {
+        SLOW5_ERROR_EXIT("Invalid arguments to train a dictionary of %zu bytes from %" PRIu32 " records.", cap, num_recs);
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    int ret = 0;
+    char *samples = NULL;
+    size_t samples_len = 0;
+    size_t samples_cap = 0;
+    size_t *sizes = (size_t *) malloc(num_recs * sizeof *sizes);
+    void *dict = malloc(cap);
+    if (!sizes || !dict) {
+        SLOW5_MALLOC_ERROR();
+        ret = slow5_errno = SLOW5_ERR_MEM;
+    }
+
+    for (uint32_t i = 0; ret == 0 && i < num_recs; ++ i) {
+        size_t bytes;
+        char *mem = recs[i] ? (char *) slow5_rec_to_mem(recs[i], s5p->header->aux_meta, SLOW5_FORMAT_BINARY, NULL, &bytes) : NULL;
+        if (!mem) {
+            SLOW5_ERROR("Encoding record %" PRIu32 " to train the dictionary failed.", i);
+            ret = slow5_errno = SLOW5_ERR_ARG;
+            break;
+        }
+        // skip the record size, and the raw signal after len_raw_signal
+        const char *rec = mem + sizeof (slow5_rec_size_t);
+        size_t len = bytes - sizeof (slow5_rec_size_t);
+        size_t sig_pos = sizeof (slow5_rid_len_t) + recs[i]->read_id_len + sizeof recs[i]->read_group + 4 * sizeof (double) + sizeof recs[i]->len_raw_signal;
+        size_t sig_bytes = recs[i]->len_raw_signal * sizeof *recs[i]->raw_signal;
+        if (slow5_buf_reserve((void **) &samples, &samples_cap, samples_len + len - sig_bytes) != 0) {
+            free(mem);
+            ret = slow5_errno;
+            break;
+        }
+        memcpy(samples + samples_len, rec, sig_pos);
+        memcpy(samples + samples_len + sig_pos, rec + sig_pos + sig_bytes, len - sig_pos - sig_bytes);
+        sizes[i] = len - sig_bytes;
+        samples_len += sizes[i];
+        free(mem);
+    }
+
+    if (ret == 0) {
+        size_t size = slow5_press_dict_train(dict, cap, samples, sizes, num_recs);
+        ret = size ? slow5_set_press_dict(s5p, dict, size) : slow5_errno;
+    }
+
+    free(samples);
+    free(sizes);
+    free(dict);
+    if (ret != 0) {
+        SLOW5_EXIT_IF_ON_ERR();
+    }
+    return ret;
+}
+
+const void *slow5_get_press_dict(const slow5_file_t *s5p, size_t *size) {
+    const struct slow5_press_dict *dict = s5p && s5p->compress ? s5p->compress->record_press->dict : NULL;
+    if (size) {
+        *size = dict ? dict->size : 0;
+    }
+    return dict ? dict->buf : NULL;
+}
+
+/*
+ * init the block state of a block-compressed file
+ * returns NULL on error and sets slow5_errno
+ */
+static struct slow5_block *slow5_block_init(uint32_t max_recs, uint64_t max_bytes) {
+    struct slow5_block *blk = (struct slow5_block *) calloc(1, sizeof *blk);
+    if (!blk) {
+        SLOW5_MALLOC_ERROR();
+        slow5_errno = SLOW5_ERR_MEM;
+        return NULL;
+    }
+    blk->id = __sync_add_and_fetch(&slow5_block_ids, 1);
+    blk->max_recs = max_recs;
+    blk->max_bytes = max_bytes;
+    return blk;
+}
+
+static void slow5_block_free(struct slow5_block *blk) {
+    if (blk) {
+        free(blk->buf);
+        free(blk->mem);
+        free(blk);
+    }
+}
+
 // slow5 header
 
 struct slow5_hdr *slow5_hdr_init_empty(void) {
@@ -650,7 +1090,9 @@ struct slow5_hdr *slow5_hdr_init(FILE *fp, enum slow5_fmt format, slow5_press_me
     }
 
     method->signal_method = SLOW5_COMPRESS_NONE;
-    struct slow5_version max_supported = SLOW5_VERSION_ARRAY;
+    method->block_method = SLOW5_COMPRESS_NONE;
+    method->record_dict = 0;
+    struct slow5_version max_supported = SLOW5_VERSION_MAX_ARRAY;
 
     char *buf = NULL;
 
@@ -738,7 +1180,7 @@ struct slow5_hdr *slow5_hdr_init(FILE *fp, enum slow5_fmt format, slow5_press_me
         }
 
         if (slow5_is_version_compatible(header->version, max_supported) == 0) {
-            SLOW5_ERROR("File version '" SLOW5_VERSION_STRING_FORMAT "' is higher than the max slow5 version '" SLOW5_VERSION_STRING "' supported by this slow5lib! Please use a newer version of slow5lib.",
+            SLOW5_ERROR("File version '" SLOW5_VERSION_STRING_FORMAT "' is higher than the max slow5 version '" SLOW5_VERSION_MAX_STRING "' supported by this slow5lib! Please use a newer version of slow5lib.",
                     header->version.major, header->version.minor, header->version.patch);
             slow5_errno = SLOW5_ERR_VERSION;
             goto err;
@@ -831,14 +1273,18 @@ struct slow5_hdr *slow5_hdr_init(FILE *fp, enum slow5_fmt format, slow5_press_me
         }
 
         if (slow5_is_version_compatible(header->version, max_supported) == 0) {
-            SLOW5_ERROR("File version '" SLOW5_VERSION_STRING_FORMAT "' is higher than the max slow5 version '" SLOW5_VERSION_STRING "' supported by this slow5lib! Please use a newer version of slow5lib.",
+            SLOW5_ERROR("File version '" SLOW5_VERSION_STRING_FORMAT "' is higher than the max slow5 version '" SLOW5_VERSION_MAX_STRING "' supported by this slow5lib! Please use a newer version of slow5lib.",
                     header->version.major, header->version.minor, header->version.patch);
             free(header);
             slow5_errno = SLOW5_ERR_VERSION;
             return NULL;
         }
 
-        method->record_method = slow5_decode_record_press(record_method);
+        method->block_method = slow5_decode_block_press(record_method);
+        enum slow5_press_method dict_method = slow5_decode_dict_press(record_method);
+        method->record_dict = dict_method != SLOW5_COMPRESS_NONE;
+        method->record_method = method->block_method != SLOW5_COMPRESS_NONE ? SLOW5_COMPRESS_NONE
+                : method->record_dict ? dict_method : slow5_decode_record_press(record_method);
         method->signal_method = slow5_decode_signal_press(signal_method);
 
         size_t cap = SLOW5_HDR_DATA_BUF_INIT_CAP;
@@ -980,7 +1426,8 @@ void *slow5_hdr_to_mem(struct slow5_hdr *header, enum slow5_fmt format, slow5_pr
         struct slow5_version version_tmp = slow5_press_version_bump(header->version,comp);
         struct slow5_version *version = &version_tmp;
 
-        uint8_t record_comp = slow5_encode_record_press(comp.record_method);
+        uint8_t record_comp = comp.block_method != SLOW5_COMPRESS_NONE ? slow5_encode_block_press(comp.block_method)
+                : comp.record_dict ? slow5_encode_dict_press(comp.record_method) : slow5_encode_record_press(comp.record_method);
         uint8_t signal_comp = slow5_encode_signal_press(comp.signal_method);
 
         // Relies on SLOW5_HDR_DATA_BUF_INIT_CAP
@@ -1339,8 +1786,52 @@ int slow5_hdr_write(slow5_file_t *s5p){
     if (s5p->format == SLOW5_FORMAT_BINARY){
         method.record_method = s5p->compress->record_press->method;
         method.signal_method = s5p->compress->signal_press->method;
+        method.block_method = s5p->compress->block_press->method;
+        method.record_dict = s5p->compress->record_press->dict != NULL;
+    }
+    if (s5p->format == SLOW5_FORMAT_BINARY) {
+        // written with the version of what it uses, so that index files get it too
+        s5p->header->version = slow5_press_version_bump(s5p->header->version, method);
+        if (s5p->meta.idx_footer) {
+            s5p->header->version = slow5_footer_version_bump(s5p->header->version);
+        }
     }
     int ret = slow5_hdr_fwrite(s5p->fp, s5p->header, s5p->format, method);
+    if (ret != -1 && method.record_dict) { // the dictionary follows the header
+        const struct slow5_press_dict *dict = s5p->compress->record_press->dict;
+        uint32_t size = dict->size;
+        if (fwrite(&size, sizeof size, 1, s5p->fp) != 1 || fwrite(dict->buf, dict->size, 1, s5p->fp) != 1) {
+            return -1;
+        }
+        ret += sizeof size + dict->size;
+    }
+    return ret;
+}
+
+/*
+ * read the zstd dictionary that follows the header of a BLOW5 file from fp into the record press of compress
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_dict_fread(FILE *fp, struct slow5_press *compress) {
+    uint32_t size;
+    if (fread(&size, sizeof size, 1, fp) != 1) {
+        SLOW5_ERROR("Malformed blow5 header. Failed to read the dictionary size.%s", feof(fp) ? " EOF reached." : "");
+        return slow5_errno = feof(fp) ? SLOW5_ERR_TRUNC : SLOW5_ERR_IO;
+    }
+    void *buf = malloc(size ? size : 1);
+    if (!buf) {
+        SLOW5_MALLOC_ERROR();
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+    if (size && fread(buf, size, 1, fp) != 1) {
+        SLOW5_ERROR("Malformed blow5 header. Failed to read the dictionary.%s", feof(fp) ? " EOF reached." : "");
+        free(buf);
+        return slow5_errno = feof(fp) ? SLOW5_ERR_TRUNC : SLOW5_ERR_IO;
+    }
+    struct slow5_press_dict *dict = slow5_press_dict_init(buf, size, compress->opt.level);
+    free(buf);
+    int ret = dict ? __slow5_press_set_dict(compress->record_press, dict) : slow5_errno;
+    slow5_press_dict_free(dict); // the press keeps its own reference
     return ret;
 }
 
@@ -2389,17 +2880,18 @@ void slow5_hdr_data_free(struct slow5_hdr *header) {
 // slow5 record
 
 /*
- * get slow5 record with read_id as it is stored in the file s5p with length *n
- * on error returns NULL, sets *n=0 if possible, and sets slow5_errno
+ * look up read_id in the index of s5p and get the file offset and length of the record as it is stored
+ * for blow5 the record size prefix is skipped, for slow5 the newline is included in *bytes
+ * for a block file these are of the compressed block holding the record and *pos (if not NULL) is set to
+ * the position of the record (with its size) in the decompressed block
+ * return 0 on success, <0 on error and sets slow5_errno
  * slow5_errno errors:
  * SLOW5_ERR_ARG
  * SLOW5_ERR_NOIDX
  * SLOW5_ERR_NOTFOUND
  * SLOW5_ERR_UNK
- * SLOW5_ERR_MEM
- * SLOW5_ERR_IO
  */
-void *slow5_get_mem(const char *read_id, size_t *n, const struct slow5_file *s5p) {
+static int slow5_get_mem_loc(const char *read_id, const struct slow5_file *s5p, uint64_t *offset, size_t *bytes, uint64_t *pos) {
     if (!read_id || !s5p) {
         if (!read_id) {
             SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(read_id));
@@ -2407,67 +2899,240 @@ void *slow5_get_mem(const char *read_id, size_t *n, const struct slow5_file *s5p
         if (!s5p) {
             SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
         }
-        slow5_errno = SLOW5_ERR_ARG;
-        goto err;
+        return slow5_errno = SLOW5_ERR_ARG;
     }
 
     if (!s5p->index) {
         /* index not loaded */
         SLOW5_ERROR("%s", "No slow5 index has been loaded.");
-        slow5_errno = SLOW5_ERR_NOIDX;
-        goto err;
+        return slow5_errno = SLOW5_ERR_NOIDX;
     }
 
     /* get index record */
     struct slow5_rec_idx read_index;
     if (slow5_idx_get(s5p->index, read_id, &read_index) == -1) {
         /* read_id not found in index */
-        slow5_errno = SLOW5_ERR_NOTFOUND;
-        goto err;
+        return slow5_errno = SLOW5_ERR_NOTFOUND;
     }
 
-    size_t bytes;
-    off_t offset;
     if (s5p->format == SLOW5_FORMAT_BINARY) {
-        bytes = read_index.size - sizeof (slow5_rec_size_t);
-        offset = read_index.offset + sizeof (slow5_rec_size_t);
+        *bytes = read_index.size - sizeof (slow5_rec_size_t);
+        *offset = read_index.offset + sizeof (slow5_rec_size_t);
     } else if (s5p->format == SLOW5_FORMAT_ASCII) {
-        bytes = read_index.size;
-        offset = read_index.offset;
+        *bytes = read_index.size;
+        *offset = read_index.offset;
     } else {
         SLOW5_ERROR("Unknown slow5 format '%d'.", s5p->format);
-        slow5_errno = SLOW5_ERR_UNK;
-        goto err;
+        return slow5_errno = SLOW5_ERR_UNK;
     }
-
-    uint8_t *mem = (uint8_t *) malloc(bytes);
-    if (!mem) {
-        SLOW5_MALLOC_ERROR();
-        slow5_errno = SLOW5_ERR_MEM;
-        goto err;
-    }
-
-    if (s5p->format == SLOW5_FORMAT_ASCII) {
-        bytes -= 1;
-        /* null terminate */
-        mem[bytes] = '\0';
+    if (pos) {
+        *pos = read_index.block_pos;
     }
 
-    if (pread(s5p->meta.fd, mem, bytes, offset) != bytes) {
-        SLOW5_ERROR("Failed to pread '%zu' bytes at offset '%zu' from slow5 file '%s'.",
-                bytes, offset, s5p->meta.pathname);
-        free(mem);
-        slow5_errno = SLOW5_ERR_IO;
-        goto err;
-    }
+    return 0;
+}
 
-    if (n) {
-        *n = bytes;
-    }
-    return mem;
+/* true if the bytes at offset are inside the mapping of a file opened in mode "rm" */
+static inline int slow5_is_mapped(const struct slow5_file *s5p, uint64_t offset, size_t bytes) {
+    return s5p->meta.mmap_addr && offset <= s5p->meta.mmap_size && bytes <= s5p->meta.mmap_size - offset;
+}
 
-    err:
-        if (n) {
+/*
+ * get the record at pos of the compressed block at offset with bytes of the block file s5p
+ * the block is decompressed into ctx unless it is already there, from comp if not NULL, otherwise from the mapping or with pread
+ * returns a pointer into ctx->blk to the record without its size, valid until the next block is decompressed with ctx
+ * on error returns NULL, sets *n=0 and sets slow5_errno
+ * slow5_errno errors:
+ * SLOW5_ERR_MEM
+ * SLOW5_ERR_IO
+ * SLOW5_ERR_PRESS
+ * SLOW5_ERR_RECPARSE   pos is not the position of a record in the block
+ */
+static char *slow5_block_rec(const struct slow5_file *s5p, uint64_t offset, size_t bytes, uint64_t pos, const char *comp, struct slow5_decode_ctx *ctx, size_t *n) {
+    const struct slow5_block *blk = s5p->meta.block;
+    *n = 0;
+
+    if (ctx->blk_id != blk->id || ctx->blk_offset != offset) {
+        if (!comp && slow5_is_mapped(s5p, offset, bytes)) {
+            comp = (const char *) s5p->meta.mmap_addr + offset;
+        } else if (!comp) {
+            if (slow5_buf_reserve((void **) &ctx->raw, &ctx->raw_cap, bytes) != 0) {
+                return NULL;
+            }
+            if (pread(s5p->meta.fd, ctx->raw, bytes, offset) != bytes) {
+                SLOW5_ERROR("Failed to pread '%zu' bytes at offset '%" PRIu64 "' from slow5 file '%s'.",
+                        bytes, offset, s5p->meta.pathname);
+                slow5_errno = SLOW5_ERR_IO;
+                return NULL;
+            }
+            comp = ctx->raw;
+        }
+        ctx->blk_id = 0;
+        if (!slow5_block_depress_ctx(ctx, s5p->compress->block_press->method, comp, bytes, &ctx->blk_len)) {
+            SLOW5_ERROR("Failed to decompress the block at offset '%" PRIu64 "' of slow5 file '%s'.", offset, s5p->meta.pathname);
+            slow5_errno = SLOW5_ERR_PRESS;
+            return NULL;
+        }
+        ctx->blk_id = blk->id;
+        ctx->blk_offset = offset;
+    }
+
+    slow5_rec_size_t size;
+    if (pos > ctx->blk_len || ctx->blk_len - pos < sizeof size ||
+            (memcpy(&size, ctx->blk + pos, sizeof size), size > ctx->blk_len - pos - sizeof size)) {
+        SLOW5_ERROR("No record at position '%" PRIu64 "' of the block at offset '%" PRIu64 "' of slow5 file '%s'.",
+                pos, offset, s5p->meta.pathname);
+        slow5_errno = SLOW5_ERR_RECPARSE;
+        return NULL;
+    }
+    *n = size;
+    return ctx->blk + pos + sizeof size;
+}
+
+/* same as slow5_block_rec but looks up read_id in the index of s5p first */
+static char *slow5_block_get(const char *read_id, size_t *n, const struct slow5_file *s5p, struct slow5_decode_ctx *ctx) {
+    uint64_t offset;
+    size_t bytes;
+    uint64_t pos;
+    if (slow5_get_mem_loc(read_id, s5p, &offset, &bytes, &pos) != 0) {
+        *n = 0;
+        return NULL;
+    }
+    return slow5_block_rec(s5p, offset, bytes, pos, NULL, ctx, n);
+}
+
+/*
+ * get slow5 record with read_id as it is stored in the file s5p with length *n
+ * the record is copied out of the mapping if the file was opened in mode "rm", otherwise read with pread
+ * on error returns NULL, sets *n=0 if possible, and sets slow5_errno
+ * slow5_errno errors:
+ * SLOW5_ERR_ARG
+ * SLOW5_ERR_NOIDX
+ * SLOW5_ERR_NOTFOUND
+ * SLOW5_ERR_UNK
+ * SLOW5_ERR_MEM
+ * SLOW5_ERR_IO
+ */
+void *slow5_get_mem(const char *read_id, size_t *n, const struct slow5_file *s5p) {
+    char *mem = NULL;
+    size_t cap = 0;
+    if (!slow5_get_mem_buf(read_id, n, s5p, &mem, &cap)) {
+        free(mem);
+        return NULL;
+    }
+    return mem;
+}
+
+/*
+ * same as slow5_get_mem but reads into *buf of capacity *cap, which is grown as needed and stays owned by the caller
+ * returns *buf on success
+ */
+static void *slow5_get_mem_buf(const char *read_id, size_t *n, const struct slow5_file *s5p, char **buf, size_t *cap) {
+
+    size_t bytes;
+    uint64_t offset;
+    if (s5p && s5p->meta.block) {
+        /* the record is copied out of its decompressed block */
+        struct slow5_decode_ctx ctx = { 0 };
+        const char *rec = slow5_block_get(read_id, &bytes, s5p, &ctx);
+        if (rec && slow5_buf_reserve((void **) buf, cap, bytes) == 0) {
+            memcpy(*buf, rec, bytes);
+        } else {
+            rec = NULL;
+        }
+        __slow5_decode_ctx_free_bufs(&ctx);
+        if (!rec) {
+            goto err;
+        }
+        if (n) {
+            *n = bytes;
+        }
+        return *buf;
+    }
+    if (slow5_get_mem_loc(read_id, s5p, &offset, &bytes, NULL) != 0) {
+        goto err;
+    }
+
+    if (slow5_buf_reserve((void **) buf, cap, bytes) != 0) {
+        goto err;
+    }
+    char *mem = *buf;
+
+    if (s5p->format == SLOW5_FORMAT_ASCII) {
+        bytes -= 1;
+        /* null terminate */
+        mem[bytes] = '\0';
+    }
+
+    if (slow5_is_mapped(s5p, offset, bytes)) {
+        memcpy(mem, (const uint8_t *) s5p->meta.mmap_addr + offset, bytes);
+    } else if (pread(s5p->meta.fd, mem, bytes, offset) != bytes) {
+        SLOW5_ERROR("Failed to pread '%zu' bytes at offset '%" PRIu64 "' from slow5 file '%s'.",
+                bytes, offset, s5p->meta.pathname);
+        slow5_errno = SLOW5_ERR_IO;
+        goto err;
+    }
+
+    if (n) {
+        *n = bytes;
+    }
+    return mem;
+
+    err:
+        if (n) {
+            *n = 0;
+        }
+        return NULL;
+}
+
+/*
+ * get a pointer to slow5 record with read_id as it is stored in the mapping of s5p with length *n
+ * s5p must have been opened in mode "rm", nothing is allocated or copied
+ * the pointer is valid until s5p is closed and must not be freed or written to
+ * for slow5 (ASCII) the record is not null terminated, *n excludes the newline
+ * on error returns NULL, sets *n=0 if possible, and sets slow5_errno
+ * slow5_errno errors:
+ * SLOW5_ERR_ARG        s5p is not memory-mapped, or is a block file whose records are only stored compressed
+ * SLOW5_ERR_NOIDX
+ * SLOW5_ERR_NOTFOUND
+ * SLOW5_ERR_UNK
+ * SLOW5_ERR_IO         the record lies past the mapping (appended after opening)
+ */
+const void *slow5_get_mem_map(const char *read_id, size_t *n, const struct slow5_file *s5p) {
+
+    size_t bytes;
+    uint64_t offset;
+    if (slow5_get_mem_loc(read_id, s5p, &offset, &bytes, NULL) != 0) {
+        goto err;
+    }
+    if (s5p->meta.block) {
+        SLOW5_ERROR("The records of block file '%s' cannot be mapped.", s5p->meta.pathname);
+        slow5_errno = SLOW5_ERR_ARG;
+        goto err;
+    }
+
+    if (!s5p->meta.mmap_addr) {
+        SLOW5_ERROR("Slow5 file '%s' was not opened with mode 'rm'.", s5p->meta.pathname);
+        slow5_errno = SLOW5_ERR_ARG;
+        goto err;
+    }
+    if (s5p->format == SLOW5_FORMAT_ASCII) {
+        bytes -= 1;
+    }
+    if (!slow5_is_mapped(s5p, offset, bytes)) {
+        SLOW5_ERROR("Record '%s' at offset '%" PRIu64 "' is past the end of the memory-mapped file '%s'.",
+                read_id, offset, s5p->meta.pathname);
+        slow5_errno = SLOW5_ERR_IO;
+        goto err;
+    }
+
+    if (n) {
+        *n = bytes;
+    }
+    return (const uint8_t *) s5p->meta.mmap_addr + offset;
+
+    err:
+        if (n) {
             *n = 0;
         }
         return NULL;
@@ -2504,30 +3169,578 @@ void *slow5_get_mem(const char *read_id, size_t *n, const struct slow5_file *s5p
  * @return  error code described above
  */
 int slow5_get(const char *read_id, struct slow5_rec **read, struct slow5_file *s5p) {
+    // the buffers and streams of the thread are reused across calls, also with other files
+    struct slow5_decode_ctx *ctx = slow5_decode_ctx_thread();
+    if (!ctx) {
+        return slow5_errno;
+    }
+    return slow5_get_ctx(read_id, read, s5p, ctx);
+}
 
-    if (!read) {
-        SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(read));
+/*
+ * same as slow5_get but the record is read, decompressed and decoded with the scratch buffers of ctx
+ * ctx must not be used by another thread at the same time
+ */
+int slow5_get_ctx(const char *read_id, struct slow5_rec **read, struct slow5_file *s5p, struct slow5_decode_ctx *ctx) {
+
+    if (!read || !ctx) {
+        if (!read) {
+            SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(read));
+        }
+        if (!ctx) {
+            SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(ctx));
+        }
         return slow5_errno = SLOW5_ERR_ARG;
     }
 
     size_t bytes;
     char *mem;
-    if (!(mem = slow5_get_mem(read_id, &bytes, s5p))) {
+
+    if (s5p && s5p->meta.block) {
+        /* decode straight from the decompressed block */
+        if (!(mem = slow5_block_get(read_id, &bytes, s5p, ctx)) ||
+                slow5_rec_depress_parse_ctx(mem, bytes, read_id, read, s5p, ctx) != 0) {
+            SLOW5_EXIT_IF_ON_ERR();
+            return slow5_errno;
+        }
+        return 0;
+    }
+
+    if (s5p && s5p->meta.mmap_addr && s5p->format == SLOW5_FORMAT_BINARY) {
+        /* decode straight from the mapping, binary parsing only reads from the record */
+        const char *map_mem = (const char *) slow5_get_mem_map(read_id, &bytes, s5p);
+        if (map_mem) {
+            if (slow5_rec_depress_parse_ctx((char *) map_mem, bytes, read_id, read, s5p, ctx) != 0) {
+                SLOW5_EXIT_IF_ON_ERR();
+                return slow5_errno;
+            }
+            return 0;
+        } else if (slow5_errno != SLOW5_ERR_IO) {
+            SLOW5_EXIT_IF_ON_ERR();
+            return slow5_errno;
+        }
+        /* record appended after the file was mapped, fall back to pread */
+    }
+
+    if (!(mem = slow5_get_mem_buf(read_id, &bytes, s5p, &ctx->raw, &ctx->raw_cap))) {
         SLOW5_EXIT_IF_ON_ERR();
         return slow5_errno;
     }
 
-    if (slow5_rec_depress_parse(&mem, &bytes, read_id, read, s5p) != 0) {
+    if (slow5_rec_depress_parse_ctx(mem, bytes, read_id, read, s5p, ctx) != 0) {
         SLOW5_EXIT_IF_ON_ERR();
-        free(mem);
         return slow5_errno;
     }
 
-    free(mem);
     return 0;
 }
 
 
+/* a record to fetch for slow5_get_many */
+struct slow5_get_ent {
+    uint64_t offset;            /* as in slow5_get_mem_loc */
+    size_t bytes;
+    uint64_t pos;
+    size_t i;                   /* index into read_ids and reads */
+};
+
+/* records sorted by offset and split into groups, each of which is read with a single read */
+struct slow5_get_plan {
+    char **read_ids;
+    struct slow5_get_ent *ents;
+    size_t *groups;             /* ents[groups[g]] to ents[groups[g + 1] - 1] are in group g */
+    size_t num_groups;
+};
+
+static int slow5_get_ent_cmp(const void *a, const void *b) {
+    const struct slow5_get_ent *x = (const struct slow5_get_ent *) a;
+    const struct slow5_get_ent *y = (const struct slow5_get_ent *) b;
+    if (x->offset != y->offset) {
+        return x->offset < y->offset ? -1 : 1;
+    }
+    return x->i < y->i ? -1 : (x->i > y->i);
+}
+
+/*
+ * look up read_ids[0..n-1] in the index, sort them by offset and group records that are at most
+ * SLOW5_GET_MANY_MAX_GAP bytes apart into ranges of up to SLOW5_GET_MANY_MAX_SPAN bytes (larger records are alone)
+ * read_ids must stay valid until slow5_get_plan_free
+ * returns NULL on error and sets slow5_errno
+ * slow5_errno errors:
+ * SLOW5_ERR_ARG
+ * SLOW5_ERR_NOIDX
+ * SLOW5_ERR_NOTFOUND
+ * SLOW5_ERR_UNK
+ * SLOW5_ERR_MEM
+ */
+struct slow5_get_plan *slow5_get_plan_init(char **read_ids, size_t n, const struct slow5_file *s5p) {
+    if (!read_ids || !s5p) {
+        if (!read_ids) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(read_ids));
+        }
+        if (!s5p) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
+        }
+        slow5_errno = SLOW5_ERR_ARG;
+        return NULL;
+    }
+
+    struct slow5_get_plan *plan = (struct slow5_get_plan *) calloc(1, sizeof *plan);
+    struct slow5_get_ent *ents = (struct slow5_get_ent *) malloc((n ? n : 1) * sizeof *ents);
+    size_t *groups = (size_t *) malloc((n + 1) * sizeof *groups);
+    if (!plan || !ents || !groups) {
+        SLOW5_MALLOC_ERROR();
+        free(plan);
+        free(ents);
+        free(groups);
+        slow5_errno = SLOW5_ERR_MEM;
+        return NULL;
+    }
+    plan->read_ids = read_ids;
+    plan->ents = ents;
+    plan->groups = groups;
+
+    for (size_t i = 0; i < n; ++ i) {
+        if (slow5_get_mem_loc(read_ids[i], s5p, &ents[i].offset, &ents[i].bytes, &ents[i].pos) != 0) {
+            if (slow5_errno == SLOW5_ERR_NOTFOUND) {
+                SLOW5_ERROR("Read ID '%s' was not found in the index of slow5 file '%s'.", read_ids[i], s5p->meta.pathname);
+            }
+            slow5_get_plan_free(plan);
+            return NULL;
+        }
+        ents[i].i = i;
+    }
+    qsort(ents, n, sizeof *ents, slow5_get_ent_cmp);
+
+    uint64_t start = 0;
+    uint64_t end = 0;
+    for (size_t i = 0; i < n; ++ i) {
+        uint64_t ent_end = ents[i].offset + ents[i].bytes;
+        if (i == 0 || ents[i].offset > end + SLOW5_GET_MANY_MAX_GAP ||
+                (ent_end > end ? ent_end : end) - start > SLOW5_GET_MANY_MAX_SPAN) {
+            groups[plan->num_groups ++] = i;
+            start = ents[i].offset;
+            end = ent_end;
+        } else if (ent_end > end) {
+            end = ent_end;
+        }
+    }
+    groups[plan->num_groups] = n;
+
+    return plan;
+}
+
+/* number of groups in plan */
+size_t slow5_get_plan_len(const struct slow5_get_plan *plan) {
+    return plan->num_groups;
+}
+
+void slow5_get_plan_free(struct slow5_get_plan *plan) {
+    if (plan) {
+        free(plan->ents);
+        free(plan->groups);
+        free(plan);
+    }
+}
+
+/* byte range of group g of plan */
+static void slow5_get_plan_range(const struct slow5_get_plan *plan, size_t g, uint64_t *start, size_t *bytes) {
+    const struct slow5_get_ent *first = plan->ents + plan->groups[g];
+    const struct slow5_get_ent *last = plan->ents + plan->groups[g + 1];
+    uint64_t end = first->offset;
+    for (const struct slow5_get_ent *e = first; e != last; ++ e) {
+        if (e->offset + e->bytes > end) {
+            end = e->offset + e->bytes;
+        }
+    }
+    *start = first->offset;
+    *bytes = end - first->offset;
+}
+
+/*
+ * decompress and parse each record of group g of plan from mem, which holds the group's byte range,
+ * into reads[i] as slow5_get_ctx does
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_get_plan_parse(const struct slow5_get_plan *plan, size_t g, char *mem, struct slow5_rec **reads, struct slow5_file *s5p, struct slow5_decode_ctx *ctx) {
+    const struct slow5_get_ent *first = plan->ents + plan->groups[g];
+    const struct slow5_get_ent *last = plan->ents + plan->groups[g + 1];
+
+    for (const struct slow5_get_ent *e = first; e != last; ++ e) {
+        char *rec_mem = mem + (e->offset - first->offset);
+        size_t rec_bytes = e->bytes;
+        if (s5p->meta.block) {
+            /* records of the same block are next to each other, so it is decompressed once */
+            if (!(rec_mem = slow5_block_rec(s5p, e->offset, e->bytes, e->pos, rec_mem, ctx, &rec_bytes))) {
+                return slow5_errno;
+            }
+        } else if (s5p->format == SLOW5_FORMAT_ASCII) {
+            /* null terminate over the newline */
+            rec_bytes -= 1;
+            rec_mem[rec_bytes] = '\0';
+            if (e + 1 != last && e[1].offset == e->offset) {
+                /* ascii parsing is in place so parse a copy if the same record is requested again */
+                if (slow5_buf_reserve((void **) &ctx->rec, &ctx->rec_cap, rec_bytes + 1) != 0) {
+                    return slow5_errno;
+                }
+                memcpy(ctx->rec, rec_mem, rec_bytes + 1);
+                rec_mem = (char *) ctx->rec;
+            }
+        }
+        const char *read_id = plan->read_ids[e->i];
+        if (slow5_rec_depress_parse_ctx(rec_mem, rec_bytes, read_id, &reads[e->i], s5p, ctx) != 0) {
+            return slow5_errno;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * read group g of plan with a single read (or from the mapping with mode "rm")
+ * and decompress and parse each of its records into reads[i] as slow5_get_ctx does
+ * distinct groups can be fetched by different threads at the same time, each with its own ctx
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+int slow5_get_plan_fetch(const struct slow5_get_plan *plan, size_t g, struct slow5_rec **reads, struct slow5_file *s5p, struct slow5_decode_ctx *ctx) {
+    if (!plan || !reads || !s5p || !ctx || g >= plan->num_groups) {
+        SLOW5_ERROR("%s", "Invalid arguments to fetch a group of records.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    uint64_t start;
+    size_t bytes;
+    slow5_get_plan_range(plan, g, &start, &bytes);
+
+    char *mem;
+    if (s5p->format == SLOW5_FORMAT_BINARY && slow5_is_mapped(s5p, start, bytes)) {
+        /* binary parsing only reads from the record */
+        mem = (char *) s5p->meta.mmap_addr + start;
+    } else {
+        if (slow5_buf_reserve((void **) &ctx->raw, &ctx->raw_cap, bytes) != 0) {
+            return slow5_errno;
+        }
+        mem = ctx->raw;
+        if (slow5_is_mapped(s5p, start, bytes)) {
+            memcpy(mem, (const uint8_t *) s5p->meta.mmap_addr + start, bytes);
+        } else {
+            size_t done = 0;
+            while (done < bytes) {
+                ssize_t ret = pread(s5p->meta.fd, mem + done, bytes - done, start + done);
+                if (ret <= 0) {
+                    SLOW5_ERROR("Failed to pread '%zu' bytes at offset '%" PRIu64 "' from slow5 file '%s'.",
+                            bytes, start, s5p->meta.pathname);
+                    return slow5_errno = SLOW5_ERR_IO;
+                }
+                done += ret;
+            }
+        }
+    }
+
+    return slow5_get_plan_parse(plan, g, mem, reads, s5p, ctx);
+}
+
+/* shared state of the threads of slow5_get_many */
+struct slow5_get_many_arg {
+    const struct slow5_get_plan *plan;
+    struct slow5_rec **reads;
+    struct slow5_file *s5p;
+    size_t next;                /* next group to fetch, taken with __sync_fetch_and_add */
+    int err;                    /* first error, 0 if none */
+};
+
+static void *slow5_get_many_worker(void *voidarg) {
+    struct slow5_get_many_arg *arg = (struct slow5_get_many_arg *) voidarg;
+    struct slow5_decode_ctx ctx = { 0 };
+    size_t num_groups = slow5_get_plan_len(arg->plan);
+
+    for (;;) {
+        size_t g = __sync_fetch_and_add(&arg->next, 1);
+        if (g >= num_groups || arg->err) {
+            break;
+        }
+        int ret = slow5_get_plan_fetch(arg->plan, g, arg->reads, arg->s5p, &ctx);
+        if (ret != 0) {
+            __sync_bool_compare_and_swap(&arg->err, 0, ret);
+            break;
+        }
+    }
+
+    __slow5_decode_ctx_free_bufs(&ctx);
+    return NULL;
+}
+
+/* a group of slow5_get_many_aio, being read or read in full and waiting to be parsed */
+struct slow5_get_many_buf {
+    size_t g;
+    uint64_t start;
+    size_t bytes;
+    char *mem;
+};
+
+/* shared state of slow5_get_many_aio: the calling thread reads groups and the parser threads parse them */
+struct slow5_get_many_aio_arg {
+    const struct slow5_get_plan *plan;
+    struct slow5_rec **reads;
+    struct slow5_file *s5p;
+    pthread_mutex_t lock;
+    pthread_cond_t ready_cond;              /* a group was read or reading has ended */
+    pthread_cond_t space_cond;              /* a group was parsed and its buffer freed */
+    struct slow5_get_many_buf *ready;       /* groups read in full, ready[ready_head] to ready[ready_tail - 1] are to be parsed */
+    size_t ready_head;
+    size_t ready_tail;
+    size_t buffered;                        /* bytes of groups being read or waiting to be parsed */
+    int reading;                            /* 0 once no more groups will be added to ready */
+    int err;                                /* first parsing error, 0 if none */
+};
+
+static void *slow5_get_many_parser(void *voidarg) {
+    struct slow5_get_many_aio_arg *arg = (struct slow5_get_many_aio_arg *) voidarg;
+    struct slow5_decode_ctx ctx = { 0 };
+
+    pthread_mutex_lock(&arg->lock);
+    for (;;) {
+        while (arg->ready_head == arg->ready_tail && arg->reading) {
+            pthread_cond_wait(&arg->ready_cond, &arg->lock);
+        }
+        if (arg->ready_head == arg->ready_tail) {
+            break;
+        }
+        struct slow5_get_many_buf buf = arg->ready[arg->ready_head ++];
+        int ret = arg->err;
+        pthread_mutex_unlock(&arg->lock);
+
+        if (!ret) {
+            ret = slow5_get_plan_parse(arg->plan, buf.g, buf.mem, arg->reads, arg->s5p, &ctx);
+        }
+        free(buf.mem);
+
+        pthread_mutex_lock(&arg->lock);
+        if (ret && !arg->err) {
+            arg->err = ret;
+        }
+        arg->buffered -= buf.bytes;
+        pthread_cond_signal(&arg->space_cond);
+    }
+    pthread_mutex_unlock(&arg->lock);
+
+    __slow5_decode_ctx_free_bufs(&ctx);
+    return NULL;
+}
+
+/*
+ * fetch all groups of plan by keeping up to SLOW5_GET_MANY_AIO_DEPTH reads in flight on aio from the calling thread
+ * and handing each group read in full to num_thread - 1 parser threads (parsed in the calling thread if num_thread <= 1)
+ * reads and their unparsed groups are limited to SLOW5_GET_MANY_AIO_MAX_BUF bytes (a larger group is read alone)
+ * aio is freed
+ * returns 0 on success, otherwise the first error and sets slow5_errno
+ */
+static int slow5_get_many_aio(const struct slow5_get_plan *plan, struct slow5_rec **reads, int num_thread, struct slow5_file *s5p, struct slow5_aio *aio) {
+    size_t num_groups = slow5_get_plan_len(plan);
+    struct slow5_get_many_buf *bufs = (struct slow5_get_many_buf *) malloc(num_groups * sizeof *bufs);
+    struct slow5_get_many_aio_arg arg = { plan, reads, s5p };
+    arg.ready = (struct slow5_get_many_buf *) malloc(num_groups * sizeof *arg.ready);
+    if (!bufs || !arg.ready) {
+        SLOW5_MALLOC_ERROR();
+        free(bufs);
+        free(arg.ready);
+        slow5_aio_free(aio);
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+    for (size_t g = 0; g < num_groups; ++ g) {
+        bufs[g].g = g;
+        bufs[g].mem = NULL;
+        slow5_get_plan_range(plan, g, &bufs[g].start, &bufs[g].bytes);
+    }
+    pthread_mutex_init(&arg.lock, NULL);
+    pthread_cond_init(&arg.ready_cond, NULL);
+    pthread_cond_init(&arg.space_cond, NULL);
+    arg.reading = 1;
+
+    int32_t num_tids = num_thread > 1 ? num_thread - 1 : 0;
+    if ((size_t) num_tids > num_groups) {
+        num_tids = num_groups;
+    }
+    pthread_t *tids = NULL;
+    int32_t started = 0;
+    if (num_tids > 0 && !(tids = (pthread_t *) malloc(num_tids * sizeof *tids))) {
+        SLOW5_MALLOC_ERROR();
+        num_tids = 0;
+    }
+    for (; started < num_tids; ++ started) {
+        if (pthread_create(&tids[started], NULL, slow5_get_many_parser, &arg) != 0) {
+            SLOW5_WARNING("Failed to create thread %d of %d, continuing with fewer.", started + 1, num_tids);
+            break;
+        }
+    }
+    struct slow5_decode_ctx ctx = { 0 }; /* for parsing in the calling thread if no thread started */
+
+    size_t next = 0;
+    uint32_t inflight = 0;
+    int err = 0;
+    for (;;) {
+        while (next < num_groups && inflight < SLOW5_GET_MANY_AIO_DEPTH && !err) {
+            struct slow5_get_many_buf *buf = &bufs[next];
+            pthread_mutex_lock(&arg.lock);
+            while (arg.buffered && arg.buffered + buf->bytes > SLOW5_GET_MANY_AIO_MAX_BUF && !inflight && !arg.err) {
+                pthread_cond_wait(&arg.space_cond, &arg.lock);
+            }
+            int full = arg.buffered && arg.buffered + buf->bytes > SLOW5_GET_MANY_AIO_MAX_BUF;
+            if (!full) {
+                arg.buffered += buf->bytes;
+            }
+            err = arg.err;
+            pthread_mutex_unlock(&arg.lock);
+            if (full || err) {
+                break;
+            }
+
+            if (!(buf->mem = (char *) malloc(buf->bytes))) {
+                SLOW5_MALLOC_ERROR();
+                err = slow5_errno = SLOW5_ERR_MEM;
+            } else if (slow5_aio_submit(aio, buf->mem, buf->bytes, buf->start, buf) != 0) {
+                err = slow5_errno;
+                free(buf->mem);
+                buf->mem = NULL;
+            }
+            if (err) {
+                pthread_mutex_lock(&arg.lock);
+                arg.buffered -= buf->bytes;
+                pthread_mutex_unlock(&arg.lock);
+                break;
+            }
+            ++ next;
+            ++ inflight;
+        }
+        if (!inflight) {
+            break;
+        }
+
+        struct slow5_get_many_buf *buf;
+        int ret = slow5_aio_wait(aio, (void **) &buf);
+        if (ret != 0 && ret != SLOW5_ERR_IO) {
+            err = ret; /* what is still in flight is waited for by slow5_aio_free */
+            break;
+        }
+        -- inflight;
+        if (ret == 0 && !started && !err) {
+            ret = slow5_get_plan_parse(plan, buf->g, buf->mem, reads, s5p, &ctx);
+        }
+        if (ret != 0 || !started || err) {
+            if (ret && !err) {
+                err = ret;
+            }
+            free(buf->mem);
+            buf->mem = NULL;
+            pthread_mutex_lock(&arg.lock);
+            arg.buffered -= buf->bytes;
+            pthread_mutex_unlock(&arg.lock);
+            continue;
+        }
+
+        pthread_mutex_lock(&arg.lock);
+        arg.ready[arg.ready_tail ++] = *buf;
+        buf->mem = NULL;
+        pthread_cond_signal(&arg.ready_cond);
+        pthread_mutex_unlock(&arg.lock);
+    }
+
+    pthread_mutex_lock(&arg.lock);
+    arg.reading = 0;
+    pthread_cond_broadcast(&arg.ready_cond);
+    pthread_mutex_unlock(&arg.lock);
+    for (int32_t t = 0; t < started; ++ t) {
+        pthread_join(tids[t], NULL);
+    }
+    slow5_aio_free(aio);
+
+    for (size_t g = 0; g < next; ++ g) {
+        free(bufs[g].mem);
+    }
+    free(bufs);
+    free(arg.ready);
+    free(tids);
+    __slow5_decode_ctx_free_bufs(&ctx);
+    pthread_mutex_destroy(&arg.lock);
+    pthread_cond_destroy(&arg.ready_cond);
+    pthread_cond_destroy(&arg.space_cond);
+
+    if (!err) {
+        err = arg.err;
+    }
+    return err ? slow5_errno = err : 0;
+}
+
+/*
+ * get the records of read_ids[0..n-1] into reads[0..n-1] using num_thread threads
+ * records are read in order of offset with nearby records coalesced into a single read (see slow5_get_plan_init)
+ * unless the file is memory-mapped, many of these reads are kept in flight at once (see slow5_aio.h) while parsing in other threads
+ * each reads[i] is allocated if NULL, otherwise it is freed and overwritten as in slow5_get
+ * returns 0 on success, otherwise the first error as in slow5_get; reads not yet fetched are then left unchanged
+ */
+int slow5_get_many(char **read_ids, size_t n, struct slow5_rec **reads, int num_thread, struct slow5_file *s5p) {
+    if (!reads) {
+        SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(reads));
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    struct slow5_get_plan *plan = slow5_get_plan_init(read_ids, n, s5p);
+    if (!plan) {
+        SLOW5_EXIT_IF_ON_ERR();
+        return slow5_errno;
+    }
+
+    size_t num_groups = slow5_get_plan_len(plan);
+    if (num_groups > 1 && !s5p->meta.mmap_addr) {
+        /* keep many reads in flight, separately from parsing */
+        struct slow5_aio *aio = slow5_aio_init(s5p->meta.fd, num_groups < SLOW5_GET_MANY_AIO_DEPTH ? num_groups : SLOW5_GET_MANY_AIO_DEPTH);
+        if (aio) {
+            int ret = slow5_get_many_aio(plan, reads, num_thread, s5p, aio);
+            slow5_get_plan_free(plan);
+            if (ret) {
+                SLOW5_EXIT_IF_ON_ERR();
+            }
+            return ret;
+        }
+        SLOW5_WARNING("%s", "Failed to start asynchronous reads, reading from each thread instead.");
+    }
+
+    struct slow5_get_many_arg arg = { plan, reads, s5p, 0, 0 };
+    int32_t num_tids = num_thread > 1 ? num_thread - 1 : 0; /* the calling thread works too */
+    if ((size_t) num_tids >= num_groups) {
+        num_tids = num_groups ? num_groups - 1 : 0;
+    }
+
+    pthread_t *tids = NULL;
+    int32_t started = 0;
+    if (num_tids > 0) {
+        tids = (pthread_t *) malloc(num_tids * sizeof *tids);
+        if (!tids) {
+            SLOW5_MALLOC_ERROR();
+            num_tids = 0;
+        }
+    }
+    for (; started < num_tids; ++ started) {
+        if (pthread_create(&tids[started], NULL, slow5_get_many_worker, &arg) != 0) {
+            SLOW5_WARNING("Failed to create thread %d of %d, continuing with fewer.", started + 1, num_tids);
+            break;
+        }
+    }
+    slow5_get_many_worker(&arg);
+    for (int32_t t = 0; t < started; ++ t) {
+        pthread_join(tids[t], NULL);
+    }
+    free(tids);
+    slow5_get_plan_free(plan);
+
+    if (arg.err) {
+        slow5_errno = arg.err;
+        SLOW5_EXIT_IF_ON_ERR();
+        return arg.err;
+    }
+    return 0;
+}
+
 //gets the list of read ids from the SLOW5 index
 //the list of read is is a pointer and must not be freed by user
 //*len will have the number of read ids
@@ -2542,7 +3755,8 @@ char **slow5_get_rids(const slow5_file_t *s5p, uint64_t *len) {
         *len=0;
     }
 
-    if(!s5p->index->ids){
+    char **ids = slow5_idx_ids(s5p->index);
+    if(!ids){
         SLOW5_ERROR("%s", "No read ID list in the index.");
         slow5_errno = SLOW5_ERR_OTH;
         return NULL;
@@ -2550,7 +3764,7 @@ char **slow5_get_rids(const slow5_file_t *s5p, uint64_t *len) {
     }
 
     *len = s5p->index->num_ids;
-    return s5p->index->ids;
+    return ids;
 
 }
 
@@ -2569,7 +3783,7 @@ int slow5_rec_depress_parse(char **mem, size_t *bytes, const char *read_id, stru
     if (s5p->compress && s5p->compress->record_press->method != SLOW5_COMPRESS_NONE) {
         size_t new_bytes;
         char *new_mem;
-        if (!(new_mem = slow5_ptr_depress_solo(s5p->compress->record_press->method, *mem, *bytes, &new_bytes)) || new_bytes == 0) {
+        if (!(new_mem = slow5_rec_depress_solo(s5p->compress->record_press, *mem, *bytes, &new_bytes)) || new_bytes == 0) {
             if (read_id) {
                 SLOW5_ERROR("Failed to decompress read with ID '%s' from slow5 file '%s'.",
                         read_id, s5p->meta.pathname);
@@ -2596,6 +3810,42 @@ int slow5_rec_depress_parse(char **mem, size_t *bytes, const char *read_id, stru
     return 0;
 }
 
+/*
+ * same as slow5_rec_depress_parse but with the scratch buffers of ctx and mem is left untouched
+ * a compressed record is decompressed into ctx, an uncompressed one is parsed in place
+ * mem is only read from for binary records (so it can be e.g. the mapping of a file opened in mode "rm")
+ * but is modified for ascii records
+ * return 0 on success
+ * return a SLOW5_ERR_* and set slow5_errno on failure
+ */
+int slow5_rec_depress_parse_ctx(char *mem, size_t bytes, const char *read_id, struct slow5_rec **read, struct slow5_file *s5p, struct slow5_decode_ctx *ctx) {
+
+    /* assuming that if compress is initialised so is record_press */
+    if (s5p->compress && s5p->compress->record_press->method != SLOW5_COMPRESS_NONE) {
+        if (!(mem = slow5_rec_depress_ctx(ctx, s5p->compress->record_press, mem, bytes, &bytes)) || bytes == 0) {
+            if (read_id) {
+                SLOW5_ERROR("Failed to decompress read with ID '%s' from slow5 file '%s'.",
+                        read_id, s5p->meta.pathname);
+            } else {
+                SLOW5_ERROR("Failed to decompress read from slow5 file '%s'.", s5p->meta.pathname);
+            }
+            return slow5_errno = SLOW5_ERR_PRESS;
+        }
+    }
+
+    enum slow5_press_method signal_comp = SLOW5_COMPRESS_NONE;
+    if (s5p->compress) {
+        signal_comp = s5p->compress->signal_press->method;
+    }
+
+    if (slow5_rec_parse_ctx(mem, bytes, read_id, read, s5p->format, s5p->header->aux_meta, signal_comp, ctx) == -1) {
+        SLOW5_ERROR("%s", "Record parsing failed.");
+        return slow5_errno = SLOW5_ERR_RECPARSE;
+    }
+
+    return 0;
+}
+
 int slow_decode(void **mem, size_t *bytes, slow5_rec_t **read, slow5_file_t *s5p){
     return slow5_rec_depress_parse((char **)mem, bytes, NULL, read, s5p);
 }
@@ -2608,6 +3858,18 @@ int slow_decode(void **mem, size_t *bytes, slow5_rec_t **read, slow5_file_t *s5p
  * returns -1 on error, 0 on success
  */
 int slow5_rec_parse(char *read_mem, size_t read_size, const char *read_id, struct slow5_rec **readp, enum slow5_fmt format, struct slow5_aux_meta *aux_meta, enum slow5_press_method signal_method) {
+    struct slow5_decode_ctx ctx = { 0 };
+    int ret = slow5_rec_parse_ctx(read_mem, read_size, read_id, readp, format, aux_meta, signal_method, &ctx);
+    __slow5_decode_ctx_free_bufs(&ctx);
+    return ret;
+}
+
+/*
+ * same as slow5_rec_parse but a compressed raw signal is decoded with the scratch buffers of ctx
+ * straight into the read's raw_signal, which is only reallocated when it grows
+ * binary read_mem is only read from
+ */
+int slow5_rec_parse_ctx(char *read_mem, size_t read_size, const char *read_id, struct slow5_rec **readp, enum slow5_fmt format, struct slow5_aux_meta *aux_meta, enum slow5_press_method signal_method, struct slow5_decode_ctx *ctx) {
 
     if (!*readp) {
         /* allocate memory for read */
@@ -2868,11 +4130,30 @@ int slow5_rec_parse(char *read_mem, size_t read_size, const char *read_id, struc
                     break;
 
                 case COL_raw_signal: {
-                    if (signal_method == SLOW5_COMPRESS_NONE) {
-                        size = read->len_raw_signal * sizeof *(read->raw_signal);
-                    } else { /* integer encoding */
+                    if (signal_method != SLOW5_COMPRESS_NONE) { /* integer encoding */
                         size = read->len_raw_signal;
+                        if (offset + size > read_size) {
+                            SLOW5_ERROR("Encoded raw signal of '%zu' bytes at offset '%" PRIu64 "' exceeds the record size '%zu'.", size, offset, read_size);
+                            read->len_raw_signal = prev_len_raw_signal;
+                            ret = -1;
+                            break;
+                        }
+                        uint64_t len;
+                        int16_t *raw_signal = slow5_sig_depress_ctx(ctx, signal_method, read_mem + offset, size,
+                                read->raw_signal, read->raw_signal ? prev_len_raw_signal : 0, &len);
+                        if (!raw_signal) {
+                            SLOW5_ERROR("%s", "Decompressing raw signal failed.");
+                            read->len_raw_signal = prev_len_raw_signal;
+                            ret = -1;
+                            break;
+                        }
+                        read->raw_signal = raw_signal;
+                        read->len_raw_signal = len;
+                        offset += size;
+                        break;
                     }
+
+                    size = read->len_raw_signal * sizeof *(read->raw_signal);
                     if (read->raw_signal == NULL) {
                         read->raw_signal = (int16_t *) malloc(size+16);
                         SLOW5_MALLOC_CHK(read->raw_signal);
@@ -2895,20 +4176,6 @@ int slow5_rec_parse(char *read_mem, size_t read_size, const char *read_id, struc
                     memcpy(read->raw_signal, read_mem + offset, size);
                     offset += size;
 
-                    if (signal_method != SLOW5_COMPRESS_NONE) {
-                        size_t raw_sig_depress_bytes;
-                        int16_t *raw_sig_depress = slow5_ptr_depress_solo(signal_method, read->raw_signal, read->len_raw_signal, &raw_sig_depress_bytes);
-                        if (!raw_sig_depress) {
-                            SLOW5_ERROR("%s", "Decompressing raw signal failed.");
-                            ret = -1;
-                            break;
-                        }
-
-                        free(read->raw_signal);
-                        read->raw_signal = raw_sig_depress;
-                        read->len_raw_signal = raw_sig_depress_bytes / sizeof *read->raw_signal;
-                    }
-
                  } break;
 
                 default: /* All columns parsed */
@@ -3169,6 +4436,7 @@ void slow5_rec_aux_free(khash_t(slow5_s2a) *aux_map) {
 
 /*
  * get next slow5 record from current file pointer as it is stored in s5p with length *n
+ * if read-ahead is enabled the record is taken from the read-ahead ring instead
  * on error returns NULL, sets *n=0 if possible, and sets slow5_errno
  * slow5_errno errors:
  * SLOW5_ERR_ARG
@@ -3183,26 +4451,133 @@ void *slow5_get_next_mem(size_t *n, const struct slow5_file *s5p) {
     if (!s5p) {
         SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
         slow5_errno = SLOW5_ERR_ARG;
+        if (n) {
+            *n = 0;
+        }
+        return NULL;
+    }
+
+    char *mem = NULL;
+    size_t cap = 0;
+    if (!slow5_get_next_mem_buf(n, s5p, &mem, &cap)) {
+        free(mem);
+        return NULL;
+    }
+    return mem;
+}
+
+/* true if read-ahead was stopped by the caller and the ring is empty, so reading goes back to the file pointer */
+static int slow5_readahead_drained(struct slow5_readahead *ra) {
+    pthread_mutex_lock(&ra->lock);
+    int drained = ra->count == 0 && ra->done && ra->err == 0;
+    pthread_mutex_unlock(&ra->lock);
+    return drained;
+}
+
+/*
+ * get the next record of the block file s5p into *buf of capacity *cap, as slow5_get_next_mem_buf
+ * records are taken from the current decompressed block, the next one is read once it is used up
+ * (already decompressed by the read-ahead thread if it is enabled)
+ */
+static void *slow5_block_next(size_t *n, const struct slow5_file *s5p, char **buf, size_t *cap) {
+    struct slow5_block *blk = s5p->meta.block;
+    struct slow5_readahead *ra = s5p->meta.readahead;
+    slow5_rec_size_t size;
+
+    while (blk->mem_pos >= blk->mem_len) {
+        size_t bytes;
+        char *mem;
+        if (ra && !slow5_readahead_drained(ra)) {
+            mem = slow5_readahead_pop(&bytes, ra);
+        } else if ((mem = slow5_get_next_mem_fp(&bytes, s5p, buf, cap)) &&
+                !(mem = slow5_ptr_depress_solo(s5p->compress->block_press->method, mem, bytes, &bytes))) {
+            SLOW5_ERROR("Failed to decompress a block of slow5 file '%s'.", s5p->meta.pathname);
+            slow5_errno = SLOW5_ERR_PRESS;
+        }
+        if (!mem) {
+            goto err;
+        }
+        free(blk->mem);
+        blk->mem = mem;
+        blk->mem_len = bytes;
+        blk->mem_pos = 0;
+    }
+
+    if (blk->mem_len - blk->mem_pos < sizeof size ||
+            (memcpy(&size, blk->mem + blk->mem_pos, sizeof size), size > blk->mem_len - blk->mem_pos - sizeof size)) {
+        SLOW5_ERROR("Malformed blow5 block. A record of slow5 file '%s' is truncated.", s5p->meta.pathname);
+        slow5_errno = SLOW5_ERR_TRUNC;
+        goto err;
+    }
+    if (slow5_buf_reserve((void **) buf, cap, size) != 0) {
         goto err;
     }
+    memcpy(*buf, blk->mem + blk->mem_pos + sizeof size, size);
+    blk->mem_pos += sizeof size + size;
+
+    if (n) {
+        *n = size;
+    }
+    return *buf;
+
+    err:
+        if (n) {
+            *n = 0;
+        }
+        return NULL;
+}
+
+/*
+ * same as slow5_get_next_mem but reads into *buf of capacity *cap, which is grown as needed and stays owned by the caller
+ * a record popped from the read-ahead ring replaces *buf instead of being copied
+ * returns *buf on success
+ */
+static void *slow5_get_next_mem_buf(size_t *n, const struct slow5_file *s5p, char **buf, size_t *cap) {
+    if (s5p->meta.block) {
+        return slow5_block_next(n, s5p, buf, cap);
+    }
+    struct slow5_readahead *ra = s5p->meta.readahead;
+    if (ra) {
+        if (!slow5_readahead_drained(ra)) {
+            size_t bytes;
+            char *mem = slow5_readahead_pop(&bytes, ra);
+            if (n) {
+                *n = bytes;
+            }
+            if (mem) {
+                free(*buf);
+                *buf = mem;
+                /* ascii records are null terminated */
+                *cap = s5p->format == SLOW5_FORMAT_ASCII ? bytes + 1 : bytes;
+            }
+            return mem;
+        }
+        /* read-ahead was stopped by the caller and the ring is empty: back to the file pointer */
+    }
 
+    return slow5_get_next_mem_fp(n, s5p, buf, cap);
+}
+
+/*
+ * read the next slow5 record directly from the file pointer into *buf of capacity *cap
+ * same as slow5_get_next_mem_buf without the read-ahead check
+ */
+static void *slow5_get_next_mem_fp(size_t *n, const struct slow5_file *s5p, char **buf, size_t *cap) {
     char *mem = NULL;
     size_t bytes;
 
     if (s5p->format == SLOW5_FORMAT_ASCII) {
-        size_t cap = 0;
-        ssize_t bytes_tmp = getline(&mem, &cap, s5p->fp);
+        ssize_t bytes_tmp = getline(buf, cap, s5p->fp);
         if (bytes_tmp == -1) { /* getline failed */
             if (feof(s5p->fp)) {
-                free(mem);
                 slow5_errno = SLOW5_ERR_EOF;
                 goto err;
             }
             SLOW5_ERROR("Reading the next slow5 record until newline failed: %s", strerror(errno));
-            free(mem);
             slow5_errno = SLOW5_ERR_IO;
             goto err;
         }
+        mem = *buf;
         bytes = bytes_tmp;
         mem[-- bytes] = '\0'; /* remove newline for parsing */
 
@@ -3234,14 +4609,35 @@ void *slow5_get_next_mem(size_t *n, const struct slow5_file *s5p) {
             }
             goto err;
         }
+        const char footer[] = SLOW5_INDEX_FOOTER_MAGIC;
+        if (memcmp(&bytes_tmp, footer, sizeof footer) == 0) { /* an index footer, which ends the records unless an older slow5lib appended after it */
+            struct stat st;
+            off_t offset = ftello(s5p->fp);
+            uint64_t next;
+            if (offset == -1 || fstat(s5p->meta.fd, &st) == -1) {
+                SLOW5_ERROR("Failed to get the position of the index footer: %s.", strerror(errno));
+                slow5_errno = SLOW5_ERR_IO;
+                goto err;
+            }
+            int skip = slow5_idx_footer_skip(s5p->meta.fd, offset - sizeof bytes_tmp, st.st_size, &next);
+            if (skip == 1) {
+                slow5_errno = SLOW5_ERR_EOF;
+                goto err;
+            } else if (skip < 0) {
+                goto err;
+            } else if (fseeko(s5p->fp, next, SEEK_SET) != 0) {
+                SLOW5_ERROR("Fseek past the index footer failed: %s.", strerror(errno));
+                slow5_errno = SLOW5_ERR_IO;
+                goto err;
+            }
+            return slow5_get_next_mem_fp(n, s5p, buf, cap);
+        }
         bytes = bytes_tmp;
 
-        mem = (char *) malloc(bytes);
-        if (!mem) {
-            SLOW5_MALLOC_ERROR();
-            slow5_errno = SLOW5_ERR_MEM;
+        if (slow5_buf_reserve((void **) buf, cap, bytes) != 0) {
             goto err;
         }
+        mem = *buf;
 
         if (fread(mem, bytes, 1, s5p->fp) != 1) {
             SLOW5_ERROR("Malformed blow5 record. Failed to read '%zu' bytes from blow5 file '%s'.%s",
@@ -3251,7 +4647,6 @@ void *slow5_get_next_mem(size_t *n, const struct slow5_file *s5p) {
             } else {
                 slow5_errno = SLOW5_ERR_IO;
             }
-            free(mem);
             goto err;
         }
 
@@ -3274,6 +4669,216 @@ void *slow5_get_next_mem(size_t *n, const struct slow5_file *s5p) {
 }
 
 
+/*
+ * read-ahead thread: read raw records with slow5_get_next_mem_fp into the ring until the end of file, an error or a stop request
+ * the blocks of a block file are decompressed before they go into the ring
+ * a slot is reserved before each read so that a record that has been read is never dropped on a stop request
+ */
+static void *slow5_readahead_worker(void *arg) {
+    const struct slow5_file *s5p = (const struct slow5_file *) arg;
+    struct slow5_readahead *ra = s5p->meta.readahead;
+
+    int err = 0;
+    for (;;) {
+        pthread_mutex_lock(&ra->lock);
+        while (ra->count == ra->cap && !ra->stop) {
+            pthread_cond_wait(&ra->not_full, &ra->lock);
+        }
+        int stop = ra->stop;
+        pthread_mutex_unlock(&ra->lock);
+        if (stop) {
+            break;
+        }
+
+        size_t bytes;
+        char *mem = NULL;
+        size_t cap = 0;
+        if (!slow5_get_next_mem_fp(&bytes, s5p, &mem, &cap)) {
+            free(mem);
+            err = slow5_errno;
+            break;
+        }
+        if (s5p->meta.block) {
+            char *blk = (char *) slow5_ptr_depress_solo(s5p->compress->block_press->method, mem, bytes, &bytes);
+            free(mem);
+            if (!(mem = blk)) {
+                SLOW5_ERROR("Failed to decompress a block of slow5 file '%s'.", s5p->meta.pathname);
+                err = slow5_errno = SLOW5_ERR_PRESS;
+                break;
+            }
+        }
+
+        pthread_mutex_lock(&ra->lock);
+        uint32_t tail = (ra->head + ra->count) % ra->cap;
+        ra->mem[tail] = mem;
+        ra->bytes[tail] = bytes;
+        ++ ra->count;
+        pthread_cond_signal(&ra->not_empty);
+        pthread_mutex_unlock(&ra->lock);
+    }
+
+    pthread_mutex_lock(&ra->lock);
+    ra->err = err;
+    ra->done = 1;
+    pthread_cond_broadcast(&ra->not_empty);
+    pthread_mutex_unlock(&ra->lock);
+
+    return NULL;
+}
+
+/*
+ * take the oldest record out of the read-ahead ring, waiting for the reader thread if the ring is empty
+ * once the reader thread has exited and the ring is empty, returns NULL and sets slow5_errno to the reader thread's error
+ */
+static void *slow5_readahead_pop(size_t *n, struct slow5_readahead *ra) {
+    char *mem = NULL;
+    size_t bytes = 0;
+
+    pthread_mutex_lock(&ra->lock);
+    while (ra->count == 0 && !ra->done) {
+        pthread_cond_wait(&ra->not_empty, &ra->lock);
+    }
+    if (ra->count > 0) {
+        mem = ra->mem[ra->head];
+        bytes = ra->bytes[ra->head];
+        ra->mem[ra->head] = NULL;
+        ra->head = (ra->head + 1) % ra->cap;
+        -- ra->count;
+        pthread_cond_signal(&ra->not_full);
+    } else {
+        slow5_errno = ra->err;
+    }
+    pthread_mutex_unlock(&ra->lock);
+
+    if (n) {
+        *n = bytes;
+    }
+    return mem;
+}
+
+/* ask the read-ahead thread to stop and wait for it, the records already in the ring are kept */
+static void slow5_readahead_stop(struct slow5_readahead *ra) {
+    if (!ra) {
+        return;
+    }
+    pthread_mutex_lock(&ra->lock);
+    int joined = ra->stop;
+    ra->stop = 1;
+    pthread_cond_signal(&ra->not_full);
+    pthread_mutex_unlock(&ra->lock);
+
+    if (!joined) {
+        int ret = pthread_join(ra->tid, NULL);
+        if (ret != 0) {
+            SLOW5_ERROR("Joining the read-ahead thread failed: %s.", strerror(ret));
+        }
+    }
+}
+
+/* free the read-ahead ring, the thread must have been stopped */
+static void slow5_readahead_free(struct slow5_readahead *ra) {
+    if (!ra) {
+        return;
+    }
+    for (uint32_t i = 0; i < ra->count; ++ i) {
+        free(ra->mem[(ra->head + i) % ra->cap]);
+    }
+    pthread_cond_destroy(&ra->not_full);
+    pthread_cond_destroy(&ra->not_empty);
+    pthread_mutex_destroy(&ra->lock);
+    free(ra->mem);
+    free(ra->bytes);
+    free(ra);
+}
+
+/*
+ * start (depth > 0) or stop (depth == 0) background read-ahead for sequential reading
+ * a thread reads up to depth raw records ahead into a ring which slow5_get_next_mem (and so slow5_get_next) takes them from
+ * stopping keeps the records already read ahead, they are returned before reading continues from the file pointer
+ * restarting after a stop keeps them too
+ *
+ * return 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_ARG    s5p is NULL, not opened for reading or read-ahead is already running
+ * SLOW5_ERR_MEM    memory allocation failed
+ * SLOW5_ERR_OTH    the thread could not be created
+ */
+int slow5_set_readahead(slow5_file_t *s5p, uint32_t depth) {
+    if (!s5p) {
+        SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (s5p->meta.mode && s5p->meta.mode[0] != 'r') {
+        SLOW5_ERROR("Read-ahead is only available for files opened for reading, not in mode '%s'.", s5p->meta.mode);
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    struct slow5_readahead *old = s5p->meta.readahead;
+
+    if (depth == 0) {
+        slow5_readahead_stop(old);
+        return 0;
+    }
+
+    if (old) {
+        /* the thread of old has exited if stop is set, so the ring can be read without the lock */
+        pthread_mutex_lock(&old->lock);
+        int running = !old->stop;
+        pthread_mutex_unlock(&old->lock);
+        if (running) {
+            SLOW5_ERROR("%s", "Read-ahead is already running.");
+            return slow5_errno = SLOW5_ERR_ARG;
+        }
+        if (old->err != 0) { /* the end of file (or an error) was already reached, nothing left to read ahead */
+            return 0;
+        }
+        if (depth < old->count) {
+            depth = old->count;
+        }
+    }
+
+    struct slow5_readahead *ra = (struct slow5_readahead *) calloc(1, sizeof *ra);
+    if (!ra) {
+        SLOW5_MALLOC_ERROR();
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+    ra->cap = depth;
+    ra->mem = (char **) calloc(depth, sizeof *ra->mem);
+    ra->bytes = (size_t *) calloc(depth, sizeof *ra->bytes);
+    if (!ra->mem || !ra->bytes) {
+        SLOW5_MALLOC_ERROR();
+        free(ra->mem);
+        free(ra->bytes);
+        free(ra);
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+    pthread_mutex_init(&ra->lock, NULL);
+    pthread_cond_init(&ra->not_empty, NULL);
+    pthread_cond_init(&ra->not_full, NULL);
+
+    if (old) { /* carry over the records read ahead before the stop */
+        for (uint32_t i = 0; i < old->count; ++ i) {
+            uint32_t j = (old->head + i) % old->cap;
+            ra->mem[i] = old->mem[j];
+            ra->bytes[i] = old->bytes[j];
+        }
+        ra->count = old->count;
+        old->count = 0;
+        slow5_readahead_free(old);
+    }
+
+    s5p->meta.readahead = ra;
+    int ret = pthread_create(&ra->tid, NULL, slow5_readahead_worker, s5p);
+    if (ret != 0) {
+        SLOW5_ERROR("Creating the read-ahead thread failed: %s.", strerror(ret));
+        /* keep the ring so that no records are lost, slow5_get_next_mem drains it before using the file pointer */
+        ra->stop = 1;
+        ra->done = 1;
+        return slow5_errno = SLOW5_ERR_OTH;
+    }
+
+    return 0;
+}
+
 int slow5_get_next_bytes(void **mem, size_t *bytes, slow5_file_t *s5p){
     *mem = slow5_get_next_mem(bytes, s5p);
     if (*mem == NULL) {
@@ -3317,25 +4922,381 @@ int slow5_get_next(struct slow5_rec **read, struct slow5_file *s5p) {
         return slow5_errno = SLOW5_ERR_ARG;
     }
 
+    if (!s5p) {
+        SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    /* records are read one after another, so s5p can keep its own scratch buffers */
+    if (!s5p->meta.decode_ctx && !(s5p->meta.decode_ctx = slow5_decode_ctx_init())) {
+        SLOW5_EXIT_IF_ON_ERR();
+        return slow5_errno;
+    }
+    struct slow5_decode_ctx *ctx = s5p->meta.decode_ctx;
+
+    size_t bytes;
+    char *mem;
+    if (!(mem = slow5_get_next_mem_buf(&bytes, s5p, &ctx->raw, &ctx->raw_cap))) {
+        if (slow5_errno != SLOW5_ERR_EOF) {
+            SLOW5_EXIT_IF_ON_ERR();
+        }
+        return slow5_errno;
+    }
+
+    if (slow5_rec_depress_parse_ctx(mem, bytes, NULL, read, s5p, ctx) != 0) {
+        SLOW5_EXIT_IF_ON_ERR();
+        return slow5_errno;
+    }
+
+    return 0;
+}
+
+/*
+ * fill view from the binary record mem with bytes, which must stay valid while the view is used
+ * read_id, aux_data and (uncompressed, aligned) raw_signal point into mem
+ * a compressed raw signal is decoded into view->sig with the scratch buffers of view->ctx
+ * return 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_MEM
+ * SLOW5_ERR_PRESS
+ * SLOW5_ERR_RECPARSE
+ */
+static int slow5_rec_view_parse(const char *mem, size_t bytes, const char *read_id, struct slow5_rec_view *view, const struct slow5_file *s5p) {
+
+    const char *p = mem;
+    const char *end = mem + bytes;
+
+#define SLOW5_VIEW_READ(dst) \
+    if (end - p < (ptrdiff_t) sizeof (dst)) { \
+        goto trunc; \
+    } \
+    memcpy(&(dst), p, sizeof (dst)); \
+    p += sizeof (dst);
+
+    SLOW5_VIEW_READ(view->read_id_len);
+    if (end - p < view->read_id_len) {
+        goto trunc;
+    }
+    view->read_id = p;
+    p += view->read_id_len;
+    if (read_id && (strlen(read_id) != view->read_id_len || memcmp(read_id, view->read_id, view->read_id_len) != 0)) {
+        SLOW5_ERROR("Requested read ID '%s' does not match the read ID '%.*s' in fetched record.",
+                read_id, (int) view->read_id_len, view->read_id);
+        return slow5_errno = SLOW5_ERR_RECPARSE;
+    }
+    SLOW5_VIEW_READ(view->read_group);
+    SLOW5_VIEW_READ(view->digitisation);
+    SLOW5_VIEW_READ(view->offset);
+    SLOW5_VIEW_READ(view->range);
+    SLOW5_VIEW_READ(view->sampling_rate);
+    SLOW5_VIEW_READ(view->len_raw_signal);
+
+#undef SLOW5_VIEW_READ
+
+    enum slow5_press_method signal_method = s5p->compress ? s5p->compress->signal_press->method : SLOW5_COMPRESS_NONE;
+    if (signal_method == SLOW5_COMPRESS_NONE) {
+        size_t size = view->len_raw_signal * sizeof *view->raw_signal;
+        if ((uint64_t) (end - p) < size) {
+            goto trunc;
+        }
+        if ((uintptr_t) p % sizeof *view->raw_signal == 0) {
+            view->raw_signal = (const int16_t *) p;
+        } else {
+            if (!view->sig || view->sig_cap < view->len_raw_signal) {
+                int16_t *sig = (int16_t *) realloc(view->sig, size ? size : 1);
+                if (!sig) {
+                    SLOW5_MALLOC_ERROR();
+                    return slow5_errno = SLOW5_ERR_MEM;
+                }
+                view->sig = sig;
+                view->sig_cap = view->len_raw_signal;
+            }
+            memcpy(view->sig, p, size);
+            view->raw_signal = view->sig;
+        }
+        p += size;
+    } else {
+        /* len_raw_signal holds the compressed size in bytes */
+        size_t size = view->len_raw_signal;
+        if ((uint64_t) (end - p) < size) {
+            goto trunc;
+        }
+        uint64_t len;
+        int16_t *sig = slow5_sig_depress_ctx(view->ctx, signal_method, p, size, view->sig, view->sig ? view->sig_cap : 0, &len);
+        if (!sig) {
+            SLOW5_ERROR("%s", "Decompressing raw signal failed.");
+            return slow5_errno;
+        }
+        p += size;
+        view->sig = sig;
+        if (view->sig_cap < len) {
+            view->sig_cap = len;
+        }
+        view->len_raw_signal = len;
+        view->raw_signal = view->sig;
+    }
+
+    const struct slow5_aux_meta *aux_meta = s5p->header->aux_meta;
+    view->aux_meta = aux_meta;
+    if (!aux_meta) {
+        if (p != end) {
+            SLOW5_ERROR("No auxiliary meta data but more data in record. At offset '%zu' but record size is '%zu'.", (size_t) (p - mem), bytes);
+            return slow5_errno = SLOW5_ERR_RECPARSE;
+        }
+        return 0;
+    }
+
+    if (view->aux_cap < aux_meta->num) {
+        const void **aux_data = (const void **) realloc(view->aux_data, aux_meta->num * sizeof *aux_data);
+        if (!aux_data) {
+            SLOW5_MALLOC_ERROR();
+            return slow5_errno = SLOW5_ERR_MEM;
+        }
+        view->aux_data = aux_data;
+        uint64_t *aux_len = (uint64_t *) realloc(view->aux_len, aux_meta->num * sizeof *aux_len);
+        if (!aux_len) {
+            SLOW5_MALLOC_ERROR();
+            return slow5_errno = SLOW5_ERR_MEM;
+        }
+        view->aux_len = aux_len;
+        view->aux_cap = aux_meta->num;
+    }
+
+    for (uint32_t i = 0; i < aux_meta->num; ++ i) {
+        uint64_t len = 1;
+        if (SLOW5_IS_PTR(aux_meta->types[i])) {
+            if (end - p < (ptrdiff_t) sizeof len) {
+                goto trunc;
+            }
+            memcpy(&len, p, sizeof len);
+            p += sizeof len;
+        }
+        uint64_t size = len * aux_meta->sizes[i];
+        if ((uint64_t) (end - p) < size) {
+            goto trunc;
+        }
+        view->aux_data[i] = p;
+        view->aux_len[i] = len;
+        p += size;
+    }
+    if (p != end) {
+        SLOW5_ERROR("More record data exists but all auxiliary columns were parsed. At offset '%zu' but record size is '%zu'.", (size_t) (p - mem), bytes);
+        return slow5_errno = SLOW5_ERR_RECPARSE;
+    }
+
+    return 0;
+
+    trunc:
+        SLOW5_ERROR("Record is truncated. At offset '%zu' and record size is '%zu'.", (size_t) (p - mem), bytes);
+        return slow5_errno = SLOW5_ERR_RECPARSE;
+}
+
+/* allocate *viewp with its decode context if NULL, return 0 on success, <0 on error and sets slow5_errno */
+static int slow5_rec_view_init(struct slow5_rec_view **viewp) {
+    if (!*viewp) {
+        struct slow5_rec_view *view = (struct slow5_rec_view *) calloc(1, sizeof *view);
+        if (!view) {
+            SLOW5_MALLOC_ERROR();
+            return slow5_errno = SLOW5_ERR_MEM;
+        }
+        if (!(view->ctx = slow5_decode_ctx_init())) {
+            free(view);
+            return slow5_errno;
+        }
+        *viewp = view;
+    }
+    return 0;
+}
+
+/*
+ * decompress record mem with bytes into the view's context if needed and fill view from it
+ * return 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_rec_view_depress_parse(const char *mem, size_t bytes, const char *read_id, struct slow5_rec_view *view, const struct slow5_file *s5p) {
+
+    if (s5p->compress && s5p->compress->record_press->method != SLOW5_COMPRESS_NONE) {
+        if (!(mem = slow5_rec_depress_ctx(view->ctx, s5p->compress->record_press, mem, bytes, &bytes)) || bytes == 0) {
+            SLOW5_ERROR("Failed to decompress read with ID '%s' from slow5 file '%s'.",
+                    read_id ? read_id : "", s5p->meta.pathname);
+            return slow5_errno = SLOW5_ERR_PRESS;
+        }
+    }
+
+    int ret = slow5_rec_view_parse(mem, bytes, read_id, view, s5p);
+    if (ret != 0) {
+        SLOW5_ERROR("%s", "Record parsing failed.");
+    }
+    return ret;
+}
+
+/*
+ * fill *view (allocated if NULL) from the blow5 record in mem of bytes, without its record size
+ * return 0 on success, <0 on error and sets slow5_errno
+ */
+int slow5_rec_view_mem(const void *mem, size_t bytes, struct slow5_rec_view **view, const struct slow5_file *s5p) {
+    if (slow5_rec_view_init(view) != 0) {
+        return slow5_errno;
+    }
+    return slow5_rec_view_depress_parse((const char *) mem, bytes, NULL, *view, s5p);
+}
+
+/*
+ * view the next record of the binary file s5p in *view without copying the read ID or auxiliary fields
+ * *view is allocated if NULL and reused otherwise, its pointers are valid until it is filled again or freed
+ * return 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_ARG    view or s5p NULL, or s5p is not a binary file
+ * SLOW5_ERR_EOF    end of file reached
+ * errors of slow5_get_next_mem and slow5_rec_view_depress_parse
+ */
+int slow5_get_next_view(struct slow5_rec_view **view, struct slow5_file *s5p) {
+    if (!view || !s5p) {
+        if (!view) {
+            SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(view));
+        }
+        if (!s5p) {
+            SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
+        }
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (s5p->format != SLOW5_FORMAT_BINARY) {
+        SLOW5_ERROR_EXIT("Record views are only available for BLOW5 files, not '%s'.", s5p->meta.pathname);
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    if (slow5_rec_view_init(view) != 0) {
+        SLOW5_EXIT_IF_ON_ERR();
+        return slow5_errno;
+    }
+    struct slow5_decode_ctx *ctx = (*view)->ctx;
+
     size_t bytes;
     char *mem;
-    if (!(mem = slow5_get_next_mem(&bytes, s5p))) {
+    if (!(mem = slow5_get_next_mem_buf(&bytes, s5p, &ctx->raw, &ctx->raw_cap))) {
         if (slow5_errno != SLOW5_ERR_EOF) {
             SLOW5_EXIT_IF_ON_ERR();
         }
         return slow5_errno;
     }
 
-    if (slow5_rec_depress_parse(&mem, &bytes, NULL, read, s5p) != 0) {
+    if (slow5_rec_view_depress_parse(mem, bytes, NULL, *view, s5p) != 0) {
+        SLOW5_EXIT_IF_ON_ERR();
+        return slow5_errno;
+    }
+
+    return 0;
+}
+
+/*
+ * view the record with read_id of the binary file s5p in *view, see slow5_get_next_view
+ * with mode "rm" an uncompressed record is viewed directly in the mapping
+ * return 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_ARG    read_id, view or s5p NULL, or s5p is not a binary file
+ * errors of slow5_get_mem and slow5_rec_view_depress_parse
+ */
+int slow5_get_view(const char *read_id, struct slow5_rec_view **view, struct slow5_file *s5p) {
+    if (!read_id || !view || !s5p) {
+        if (!read_id) {
+            SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(read_id));
+        }
+        if (!view) {
+            SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(view));
+        }
+        if (!s5p) {
+            SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(s5p));
+        }
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (s5p->format != SLOW5_FORMAT_BINARY) {
+        SLOW5_ERROR_EXIT("Record views are only available for BLOW5 files, not '%s'.", s5p->meta.pathname);
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    if (slow5_rec_view_init(view) != 0) {
+        SLOW5_EXIT_IF_ON_ERR();
+        return slow5_errno;
+    }
+    struct slow5_decode_ctx *ctx = (*view)->ctx;
+
+    size_t bytes;
+    const char *mem = NULL;
+    if (s5p->meta.block) {
+        if (!(mem = slow5_block_get(read_id, &bytes, s5p, ctx))) {
+            SLOW5_EXIT_IF_ON_ERR();
+            return slow5_errno;
+        }
+    } else if (s5p->meta.mmap_addr) {
+        mem = (const char *) slow5_get_mem_map(read_id, &bytes, s5p);
+        if (!mem && slow5_errno != SLOW5_ERR_IO) {
+            SLOW5_EXIT_IF_ON_ERR();
+            return slow5_errno;
+        }
+    }
+    if (!mem && !(mem = slow5_get_mem_buf(read_id, &bytes, s5p, &ctx->raw, &ctx->raw_cap))) {
+        SLOW5_EXIT_IF_ON_ERR();
+        return slow5_errno;
+    }
+
+    if (slow5_rec_view_depress_parse(mem, bytes, read_id, *view, s5p) != 0) {
         SLOW5_EXIT_IF_ON_ERR();
-        free(mem);
         return slow5_errno;
     }
 
-    free(mem);
     return 0;
 }
 
+/*
+ * get a pointer to the data of auxiliary field in view
+ * *len is set to the number of elements (1 for primitive types) and *type to the field type if not NULL
+ * the data points into the record and may be unaligned, strings are not null terminated
+ * return NULL on error and sets slow5_errno
+ * SLOW5_ERR_ARG    view or field NULL
+ * SLOW5_ERR_NOAUX  the file has no auxiliary fields
+ * SLOW5_ERR_NOFLD  the auxiliary field was not found
+ */
+const void *slow5_rec_view_aux_get(const struct slow5_rec_view *view, const char *field, uint64_t *len, enum slow5_aux_type *type) {
+    if (!view || !field) {
+        if (!view) {
+            SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(view));
+        }
+        if (!field) {
+            SLOW5_ERROR_EXIT("Argument '%s' cannot be NULL.", SLOW5_TO_STR(field));
+        }
+        slow5_errno = SLOW5_ERR_ARG;
+        return NULL;
+    }
+
+    if (!view->aux_meta) {
+        SLOW5_ERROR_EXIT("%s", "Missing auxiliary hash map.");
+        slow5_errno = SLOW5_ERR_NOAUX;
+        return NULL;
+    }
+
+    khint_t pos = kh_get(slow5_s2ui32, view->aux_meta->attr_to_pos, field);
+    if (pos == kh_end(view->aux_meta->attr_to_pos)) {
+        SLOW5_ERROR_EXIT("Field '%s' not found.", field);
+        slow5_errno = SLOW5_ERR_NOFLD;
+        return NULL;
+    }
+    uint32_t i = kh_val(view->aux_meta->attr_to_pos, pos);
+
+    if (len) {
+        *len = view->aux_len[i];
+    }
+    if (type) {
+        *type = view->aux_meta->types[i];
+    }
+    return view->aux_data[i];
+}
+
+void slow5_rec_view_free(struct slow5_rec_view *view) {
+    if (view) {
+        free(view->aux_data);
+        free(view->aux_len);
+        slow5_decode_ctx_free(view->ctx);
+        free(view->sig);
+        free(view);
+    }
+}
+
 // For non-array types
 // Return
 // -1   input invalid
@@ -3648,6 +5609,9 @@ int slow5_add_rec(struct slow5_rec *read, struct slow5_file *s5p) {
     if (read == NULL || read->read_id == NULL || s5p == NULL) {
         return -1;
     }
+    if (s5p->meta.block) { // records are added to blocks with slow5_write
+        return -4;
+    }
 
     // Create index if NULL
     if (s5p->index == NULL && (s5p->index = slow5_idx_init(s5p)) == NULL) {
@@ -3663,6 +5627,7 @@ int slow5_add_rec(struct slow5_rec *read, struct slow5_file *s5p) {
     // Append record to file
     void *mem = NULL;
     size_t bytes;
+    uint64_t len_raw_signal = read->len_raw_signal; // changed by signal compression
     if ((mem = slow5_rec_to_mem(read, s5p->header->aux_meta, s5p->format, s5p->compress, &bytes)) == NULL) {
         return -4;
     }
@@ -3678,7 +5643,7 @@ int slow5_add_rec(struct slow5_rec *read, struct slow5_file *s5p) {
     free(mem);
 
     // Update index
-    slow5_idx_insert(s5p->index, strdup(read->read_id), offset, bytes);
+    slow5_idx_insert_read(s5p->index, read->read_id, read->read_group, len_raw_signal, offset, bytes);
 
     //after updating mark dirty
     s5p->index->dirty = 1;
@@ -3757,7 +5722,120 @@ int slow5_rec_fwrite(FILE *fp, struct slow5_rec *read, struct slow5_aux_meta *au
     return ret;
 }
 
+/*
+ * the index kept up to date with the records written to s5p: the index footer being written,
+ * or an index loaded while appending, which is written back by slow5_close
+ * NULL if there is none
+ */
+static inline struct slow5_idx *slow5_write_idx(struct slow5_file *s5p) {
+    if (s5p->meta.idx_footer) {
+        return s5p->meta.idx_footer;
+    } else if (s5p->index && s5p->meta.mode && strcmp(s5p->meta.mode, "a") == 0) {
+        s5p->index->dirty = 1;
+        return s5p->index;
+    }
+    return NULL;
+}
+
+/*
+ * compress the records waiting in the block of s5p into one block and write it after its size
+ * the records of the write index get the offset and size of the block
+ * returns 0 on success (also if no records are waiting), <0 on error and sets slow5_errno
+ */
+static int slow5_block_flush(struct slow5_file *s5p) {
+    struct slow5_block *blk = s5p->meta.block;
+    if (!blk || !blk->num_recs) {
+        return 0;
+    }
+
+    off_t offset = ftello(s5p->fp);
+    if (offset == -1) {
+        SLOW5_ERROR("Failed to get the position of the block in '%s': %s.", s5p->meta.pathname, strerror(errno));
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+    size_t n;
+    slow5_compress_footer_next(s5p->compress->block_press);
+    void *comp = slow5_ptr_compress(s5p->compress->block_press, blk->buf, blk->len, &n);
+    if (!comp) {
+        SLOW5_ERROR("Compressing a block of '%" PRIu32 "' records failed.", blk->num_recs);
+        return slow5_errno = SLOW5_ERR_PRESS;
+    }
+    slow5_rec_size_t size = n;
+    if (fwrite(&size, sizeof size, 1, s5p->fp) != 1 || fwrite(comp, n, 1, s5p->fp) != 1) {
+        SLOW5_ERROR("Failed to write a block of '%" PRIu32 "' records to '%s'.", blk->num_recs, s5p->meta.pathname);
+        free(comp);
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+    free(comp);
+
+    struct slow5_idx *index = slow5_write_idx(s5p);
+    if (index) {
+        slow5_idx_block_done(index, blk->idx_first, offset, sizeof size + n);
+    }
+    blk->len = 0;
+    blk->num_recs = 0;
+    return 0;
+}
+
+/*
+ * add the blow5 record in mem of bytes (with its size first) to the block being written to s5p and insert it into the write index,
+ * with its read group and number of samples from rec if not NULL, otherwise from mem
+ * the block is written once it is full
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_block_add(struct slow5_file *s5p, const void *mem, size_t bytes, const struct slow5_rec *rec, uint64_t len_raw_signal) {
+    struct slow5_block *blk = s5p->meta.block;
+    struct slow5_idx *index = slow5_write_idx(s5p);
+    if (index) {
+        // the block is written there
+        off_t offset = ftello(s5p->fp);
+        if (offset == -1) {
+            return slow5_errno = SLOW5_ERR_IO;
+        }
+        uint64_t first = index->pool_size;
+        index->block_pos = blk->len;
+        if (rec && !index->num_cols ? slow5_idx_insert_read(index, rec->read_id, rec->read_group, len_raw_signal, offset, bytes) != 0
+                : slow5_idx_insert_mem(index, s5p, mem, bytes, offset) != 0) {
+            return slow5_errno < 0 ? slow5_errno : (slow5_errno = SLOW5_ERR_OTH);
+        }
+        if (!blk->num_recs) {
+            blk->idx_first = first;
+        }
+    }
+
+    if (slow5_buf_reserve((void **) &blk->buf, &blk->cap, blk->len + bytes) != 0) {
+        return slow5_errno;
+    }
+    memcpy(blk->buf + blk->len, mem, bytes);
+    blk->len += bytes;
+    ++ blk->num_recs;
+
+    if ((blk->max_recs && blk->num_recs >= blk->max_recs) || (blk->max_bytes && blk->len >= blk->max_bytes)) {
+        return slow5_block_flush(s5p);
+    }
+    return 0;
+}
+
 int slow5_write_bytes(void *mem, size_t bytes, slow5_file_t *s5p){
+    if (s5p->meta.block) {
+        return slow5_block_add(s5p, mem, bytes, NULL, 0) != 0 ? -1 : 0;
+    }
+    struct slow5_idx *index = slow5_write_idx(s5p);
+    if (index) {
+        off_t offset = ftello(s5p->fp);
+        if (offset == -1) {
+            return -1;
+        }
+        if (s5p->format == SLOW5_FORMAT_BINARY) {
+            if (slow5_idx_insert_mem(index, s5p, mem, bytes, offset) != 0) {
+                return -1;
+            }
+        } else {
+            if (slow5_idx_insert_line(index, (const char *) mem, offset, bytes) != 0) {
+                return -1;
+            }
+        }
+    }
     size_t n = fwrite(mem, bytes, 1, s5p->fp);
     int ret;
     if (n != 1) {
@@ -3769,6 +5847,43 @@ int slow5_write_bytes(void *mem, size_t bytes, slow5_file_t *s5p){
 }
 
 int slow5_write(slow5_rec_t *rec, slow5_file_t *s5p){
+    if (s5p->meta.block) {
+        void *mem;
+        size_t bytes;
+        if (!rec || !rec->read_id) {
+            return -1;
+        }
+        uint64_t len_raw_signal = rec->len_raw_signal; // changed by signal compression
+        if ((mem = slow5_rec_to_mem(rec, s5p->header->aux_meta, s5p->format, s5p->compress, &bytes)) == NULL) {
+            return -1;
+        }
+        int ret = slow5_block_add(s5p, mem, bytes, rec, len_raw_signal);
+        free(mem);
+        return ret != 0 ? -1 : (int) bytes;
+    }
+    struct slow5_idx *index = slow5_write_idx(s5p);
+    if (index) {
+        // index the record before writing it so that a duplicated read ID is not written
+        void *mem;
+        size_t bytes;
+        off_t offset = ftello(s5p->fp);
+        if (offset == -1 || !rec || !rec->read_id) {
+            return -1;
+        }
+        uint64_t len_raw_signal = rec->len_raw_signal; // changed by signal compression
+        if ((mem = slow5_rec_to_mem(rec, s5p->header->aux_meta, s5p->format, s5p->compress, &bytes)) == NULL) {
+            return -1;
+        }
+        // the values of the columns of an index are taken from the record as it is stored
+        int ret = index->num_cols ? slow5_idx_insert_mem(index, s5p, mem, bytes, offset)
+                : slow5_idx_insert_read(index, rec->read_id, rec->read_group, len_raw_signal, offset, bytes);
+        if (ret != 0 || fwrite(mem, bytes, 1, s5p->fp) != 1) {
+            free(mem);
+            return -1;
+        }
+        free(mem);
+        return bytes;
+    }
     int ret = slow5_rec_fwrite(s5p->fp, rec, s5p->header->aux_meta, s5p->format, s5p->compress);
     return ret;
 }
@@ -4058,11 +6173,16 @@ int slow5_encode(void **mem, size_t *bytes, slow5_rec_t *read, slow5_file_t *s5p
         //assert(sf->compress->signal_press!=NULL);
 
         slow5_press_method_t press_out = {s5p->compress->record_press->method, s5p->compress->signal_press->method};
-        press_ptr = slow5_press_init(press_out);
+        press_ptr = slow5_press_init_opt(press_out, &s5p->compress->opt);
         if(!press_ptr){
             SLOW5_ERROR("Could not initialize the slow5 compression method%s","");
             return -1;
         }
+        if(s5p->compress->record_press->dict && __slow5_press_set_dict(press_ptr->record_press, s5p->compress->record_press->dict) != 0){
+            SLOW5_ERROR("Could not use the zstd dictionary%s","");
+            slow5_press_free(press_ptr);
+            return -1;
+        }
     }
 
     *mem = slow5_rec_to_mem(read, s5p->header->aux_meta, s5p->format, press_ptr, bytes);
@@ -4103,11 +6223,15 @@ void slow5_rec_free(struct slow5_rec *read) {
  * @return  error codes described above
  */
 int slow5_idx_create(struct slow5_file *s5p) {
+    return slow5_idx_create_mt(s5p, slow5_idx_build_threads());
+}
+
+int slow5_idx_create_mt(struct slow5_file *s5p, int num_thread) {
     char *index_pathname;
     if (s5p == NULL || s5p->meta.pathname == NULL ||
         (index_pathname = slow5_get_idx_path(s5p->meta.pathname)) == NULL) {
         return -1;
-    } else if (slow5_idx_to(s5p, index_pathname) == -1) {
+    } else if (slow5_idx_to_mt(s5p, index_pathname, num_thread) == -1) {
         free(index_pathname);
         return -1;
     }
@@ -4116,6 +6240,241 @@ int slow5_idx_create(struct slow5_file *s5p) {
     return 0;
 }
 
+/*
+ * create the index file of blow5 file s5p with the values of the fields cols[0..num_cols-1] of each record as columns
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+int slow5_idx_create_cols(struct slow5_file *s5p, const char **cols, uint32_t num_cols) {
+    if (!s5p || !s5p->meta.pathname || (num_cols && !cols)) {
+        SLOW5_ERROR_EXIT("%s", "Invalid arguments to create an index with columns.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    char *index_pathname = slow5_get_idx_path(s5p->meta.pathname);
+    if (!index_pathname) {
+        SLOW5_EXIT_IF_ON_ERR();
+        return slow5_errno;
+    }
+    int ret = slow5_idx_to_cols(s5p, index_pathname, cols, num_cols);
+    free(index_pathname);
+    if (ret != 0) {
+        SLOW5_EXIT_IF_ON_ERR();
+    }
+    return ret;
+}
+
+/*
+ * get a pointer to the value of column col of the record with read_id from the loaded index of s5p
+ * returns NULL on error and sets slow5_errno
+ * SLOW5_ERR_ARG        read_id, col or s5p NULL
+ * SLOW5_ERR_NOIDX      the index has not been loaded
+ * errors of slow5_idx_col_get
+ */
+const void *slow5_get_idx_col(const char *read_id, const char *col, uint64_t *len, enum slow5_aux_type *type, const struct slow5_file *s5p) {
+    if (!read_id || !col || !s5p) {
+        SLOW5_ERROR_EXIT("%s", "Invalid arguments to get an index column.");
+        slow5_errno = SLOW5_ERR_ARG;
+        return NULL;
+    }
+    if (!s5p->index) {
+        SLOW5_ERROR_EXIT("%s", "No slow5 index has been loaded.");
+        slow5_errno = SLOW5_ERR_NOIDX;
+        return NULL;
+    }
+    const void *value = slow5_idx_col_get(s5p->index, read_id, col, len, type);
+    if (!value) {
+        SLOW5_EXIT_IF_ON_ERR();
+    }
+    return value;
+}
+
+/*
+ * get the statistics of the records of read_group (all of them if SLOW5_STATS_ALL) from the loaded index of s5p
+ * returns 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_ARG        s5p or stats NULL, or read_group not in the header
+ * SLOW5_ERR_NOIDX      the index has not been loaded, or has no statistics
+ */
+int slow5_get_stats(const struct slow5_file *s5p, int64_t read_group, struct slow5_stats *stats) {
+    if (!s5p || !stats || read_group < SLOW5_STATS_ALL ||
+            (read_group != SLOW5_STATS_ALL && (uint64_t) read_group >= s5p->header->num_read_groups)) {
+        SLOW5_ERROR_EXIT("%s", "Invalid arguments to get the statistics.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (!s5p->index) {
+        SLOW5_ERROR_EXIT("%s", "No slow5 index has been loaded.");
+        return slow5_errno = SLOW5_ERR_NOIDX;
+    }
+    int ret = slow5_idx_stats(s5p->index, read_group, stats);
+    if (ret != 0) {
+        SLOW5_EXIT_IF_ON_ERR();
+    }
+    return ret;
+}
+
+/*
+ * copy bytes from offset of fd to fp through buf of SLOW5_CAT_BUF_SIZE bytes
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_cat_copy(int fd, uint64_t offset, uint64_t bytes, FILE *fp, char *buf) {
+    while (bytes) {
+        size_t len = bytes < SLOW5_CAT_BUF_SIZE ? bytes : SLOW5_CAT_BUF_SIZE;
+        ssize_t ret = pread(fd, buf, len, offset);
+        if (ret <= 0) {
+            SLOW5_ERROR("Failed to read '%zu' bytes at offset '%" PRIu64 "': %s.", len, offset, ret ? strerror(errno) : "unexpected end of file");
+            return slow5_errno = SLOW5_ERR_IO;
+        }
+        if (fwrite(buf, ret, 1, fp) != 1) {
+            SLOW5_ERROR("Failed to write '%zd' bytes: %s.", ret, strerror(errno));
+            return slow5_errno = SLOW5_ERR_IO;
+        }
+        offset += ret;
+        bytes -= ret;
+    }
+    return 0;
+}
+
+/*
+ * concatenate the blow5 files in_pathnames[0..num_in-1] into a new blow5 file at pathname and write its index
+ * the inputs must have the same header (compression included), their records are copied byte for byte
+ * and the index is made from the indexes of the inputs (loaded, or created if missing) with their offsets shifted
+ * returns 0 on success, <0 on error and sets slow5_errno (the output is removed)
+ */
+int slow5_cat(const char *pathname, const char **in_pathnames, uint32_t num_in) {
+    if (!pathname || !in_pathnames || !num_in) {
+        SLOW5_ERROR_EXIT("%s", "Invalid arguments to concatenate slow5 files.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    int ret = 0;
+    char *hdr = NULL;
+    uint64_t hdr_size = 0;
+    char *buf = NULL;
+    struct slow5_version version = { 0 };
+    uint64_t offset = 0; // end of the output so far
+    struct slow5_idx *index = (struct slow5_idx *) calloc(1, sizeof *index);
+    FILE *fp = fopen(pathname, "w");
+    if (!fp) {
+        SLOW5_ERROR("Error opening file '%s': %s.", pathname, strerror(errno));
+        free(index);
+        SLOW5_EXIT_IF_ON_ERR();
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+    if (!index || !(buf = (char *) malloc(SLOW5_CAT_BUF_SIZE)) || !(index->pathname = slow5_get_idx_path(pathname))) {
+        SLOW5_MALLOC_ERROR();
+        ret = slow5_errno = SLOW5_ERR_MEM;
+        goto out;
+    }
+
+    for (uint32_t i = 0; i < num_in && !ret; ++ i) {
+        struct slow5_file *in = slow5_open(in_pathnames[i], "r");
+        if (!in) {
+            ret = slow5_errno;
+            break;
+        }
+        uint64_t start = in->meta.start_rec_offset;
+        uint64_t end = 0; // end of the records
+        struct stat st;
+        if (in->format != SLOW5_FORMAT_BINARY) {
+            SLOW5_ERROR("File '%s' should be in binary format (blow5).", in_pathnames[i]);
+            ret = slow5_errno = SLOW5_ERR_ARG;
+        } else if (fstat(in->meta.fd, &st) != 0) {
+            SLOW5_ERROR("Failed to get the size of slow5 file '%s': %s.", in_pathnames[i], strerror(errno));
+            ret = slow5_errno = SLOW5_ERR_IO;
+        } else {
+            // the records end at the index footer if there is one, otherwise at the end of file marker
+            int has_footer = slow5_idx_footer_offset(in->meta.fd, &end);
+            const char eof[] = SLOW5_BINARY_EOF;
+            if (has_footer < 0) {
+                ret = slow5_errno;
+            } else if (!has_footer) {
+                end = st.st_size - sizeof eof;
+            }
+        }
+
+        if (!ret && i == 0) {
+            hdr_size = start;
+            version = in->header->version;
+            if (!(hdr = (char *) malloc(hdr_size))) {
+                SLOW5_MALLOC_ERROR();
+                ret = slow5_errno = SLOW5_ERR_MEM;
+            } else if (pread(in->meta.fd, hdr, hdr_size, 0) != (ssize_t) hdr_size || fwrite(hdr, hdr_size, 1, fp) != 1) {
+                SLOW5_ERROR("Failed to copy the header of '%s'.", in_pathnames[i]);
+                ret = slow5_errno = SLOW5_ERR_IO;
+            }
+            offset = hdr_size;
+        } else if (!ret) {
+            // the whole header, compression included, is compared as it is stored but for its version (e.g. bumped by an index footer)
+            const char magic[] = SLOW5_BINARY_MAGIC_NUMBER;
+            uint64_t done = 0;
+            while (!ret && done < start) {
+                size_t len = start - done < SLOW5_CAT_BUF_SIZE ? start - done : SLOW5_CAT_BUF_SIZE;
+                if (pread(in->meta.fd, buf, len, done) != (ssize_t) len) {
+                    ret = slow5_errno = SLOW5_ERR_IO;
+                    break;
+                }
+                if (done == 0 && len >= sizeof magic + 3) {
+                    memcpy(buf + sizeof magic, hdr + sizeof magic, 3);
+                }
+                if (start != hdr_size || memcmp(buf, hdr + done, len) != 0) {
+                    SLOW5_ERROR("Header of '%s' differs to the header of '%s'.", in_pathnames[i], in_pathnames[0]);
+                    ret = slow5_errno = SLOW5_ERR_HDRPARSE;
+                }
+                done += len;
+            }
+            if (!ret && slow5_version_cmp(in->header->version, version) > 0) {
+                version = in->header->version;
+            }
+        }
+
+        if (!ret && (slow5_idx_load(in) != 0 || slow5_idx_merge(index, in->index, (int64_t) (offset - start)) != 0)) {
+            SLOW5_ERROR("Failed to add the index of '%s'.", in_pathnames[i]);
+            ret = slow5_errno < 0 ? slow5_errno : SLOW5_ERR_OTH;
+        }
+        if (!ret && (ret = slow5_cat_copy(in->meta.fd, start, end - start, fp, buf)) == 0) {
+            offset += end - start;
+        }
+        slow5_close(in);
+    }
+
+    if (!ret && slow5_eof_fwrite(fp) < 0) {
+        ret = slow5_errno;
+    }
+    // the newest version of the inputs
+    const char magic[] = SLOW5_BINARY_MAGIC_NUMBER;
+    const uint8_t version_buf[] = { version.major, version.minor, version.patch };
+    if (!ret && memcmp(hdr + sizeof magic, version_buf, sizeof version_buf) != 0 &&
+            (fseeko(fp, sizeof magic, SEEK_SET) != 0 || fwrite(version_buf, sizeof version_buf, 1, fp) != 1)) {
+        SLOW5_ERROR("Failed to write the version of slow5 file '%s': %s.", pathname, strerror(errno));
+        ret = slow5_errno = SLOW5_ERR_IO;
+    }
+
+out:
+    if (fclose(fp) == EOF && !ret) {
+        SLOW5_ERROR("Error closing slow5 file '%s': %s.", pathname, strerror(errno));
+        ret = slow5_errno = SLOW5_ERR_IO;
+    }
+    if (!ret) {
+        index->data_size = offset;
+        if ((ret = slow5_idx_write(index, version)) != 0) {
+            SLOW5_ERROR("Writing index file to '%s' failed.", index->pathname);
+            slow5_errno = ret;
+        }
+    }
+    if (ret) {
+        remove(pathname);
+        if (index && index->pathname) {
+            remove(index->pathname);
+        }
+    }
+
+    slow5_idx_free(index);
+    free(hdr);
+    free(buf);
+    if (ret) {
+        SLOW5_EXIT_IF_ON_ERR();
+    }
+    return ret;
+}
+
 /**
  * Loads the index file for slow5 file.
  * Creates the index if not found.
@@ -4127,6 +6486,10 @@ int slow5_idx_create(struct slow5_file *s5p) {
  * @return  error codes described above
  */
 int slow5_idx_load(struct slow5_file *s5p) {
+    // the records waiting in a block are indexed with the block
+    if (slow5_block_flush(s5p) != 0) {
+        return -1;
+    }
     s5p->index = slow5_idx_init(s5p);
     if (s5p->index) {
         return 0;
@@ -4241,6 +6604,9 @@ int slow5_convert(struct slow5_file *from, FILE *to_fp, enum slow5_fmt to_format
     if (from == NULL || to_fp == NULL || to_format == SLOW5_FORMAT_UNKNOWN) {
         return -1;
     }
+    if (to_compress.block_method != SLOW5_COMPRESS_NONE) { // blocks are only written through a slow5_file, see slow5_set_block
+        return -1;
+    }
 
     if (slow5_hdr_fwrite(to_fp, from->header, to_format, to_compress) == -1) {
         return -2;
@@ -4660,6 +7026,14 @@ int slow5_version_sanity(struct slow5_hdr *hdr){
 //bump the slow5 file version to a newer version if a compression method unavailable in the current file version was requested
 struct slow5_version slow5_press_version_bump(struct slow5_version current, slow5_press_method_t method){
 
+    struct slow5_version block_press_version = { .major = 0, .minor = 3, .patch = 0 }; //record blocks and zstd dictionaries were introduced in version 0.3.0
+    if(slow5_version_cmp(current,block_press_version) < 0 && (method.block_method != SLOW5_COMPRESS_NONE || method.record_dict)){
+        SLOW5_INFO("SLOW5 version updated to '" SLOW5_VERSION_STRING_FORMAT "' as the requested compression option is unavailable in the current fileversion '" SLOW5_VERSION_STRING_FORMAT "'",
+            block_press_version.major, block_press_version.minor, block_press_version.patch,
+            current.major, current.minor, current.patch);
+        return block_press_version;
+    }
+
     struct slow5_version signal_press_version = { .major = 0, .minor = 2, .patch = 0 };
     if(slow5_version_cmp(current,signal_press_version) < 0 &&
         (method.record_method == SLOW5_COMPRESS_SVB_ZD || method.record_method == SLOW5_COMPRESS_ZSTD ||
@@ -4676,6 +7050,47 @@ struct slow5_version slow5_press_version_bump(struct slow5_version current, slow
 
 }
 
+//bump the slow5 file version to the one where the index footer was introduced if the current file version is older
+//older slow5lib then refuse the file instead of reading the footer as a record or appending records after it
+struct slow5_version slow5_footer_version_bump(struct slow5_version current){
+
+    struct slow5_version footer_version = { .major = 0, .minor = 3, .patch = 0 }; //index footer was introduced in version 0.3.0
+    if(slow5_version_cmp(current,footer_version) < 0){
+        SLOW5_INFO("SLOW5 version updated to '" SLOW5_VERSION_STRING_FORMAT "' as the index footer is unavailable in the current fileversion '" SLOW5_VERSION_STRING_FORMAT "'",
+            footer_version.major, footer_version.minor, footer_version.patch,
+            current.major, current.minor, current.patch);
+        return footer_version;
+    }
+    else{
+        return current;
+    }
+
+}
+
+/*
+ * overwrite the version in the header already written to blow5 file s5p with version, which becomes the version of its header
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_hdr_version_rewrite(struct slow5_file *s5p, struct slow5_version version) {
+    const char magic[] = SLOW5_BINARY_MAGIC_NUMBER;
+    const uint8_t buf[] = { version.major, version.minor, version.patch };
+    if (fflush(s5p->fp) == EOF) {
+        SLOW5_ERROR("Failed to flush slow5 file '%s': %s.", s5p->meta.pathname, strerror(errno));
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+    off_t end = ftello(s5p->fp);
+    if (end == -1 || end < SLOW5_BINARY_HDR_SIZE_OFFSET) {
+        SLOW5_ERROR("No blow5 header written to '%s'.", s5p->meta.pathname);
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    if (pwrite(s5p->meta.fd, buf, sizeof buf, sizeof magic) != sizeof buf) {
+        SLOW5_ERROR("Failed to write the version of slow5 file '%s': %s.", s5p->meta.pathname, strerror(errno));
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+    s5p->header->version = version;
+    return 0;
+}
+
 //int main(void) {
 
 /*
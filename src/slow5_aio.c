@@ -0,0 +1,473 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <slow5/slow5.h>
+#include <slow5/slow5_error.h>
+#include "slow5_aio.h"
+#include "slow5_misc.h"
+
+#ifdef SLOW5_USE_IOURING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+extern enum slow5_log_level_opt  slow5_log_level;
+extern enum slow5_exit_condition_opt  slow5_exit_condition;
+
+#define SLOW5_AIO_MAX_READ (1UL << 30) // largest single read, the io_uring length is 32 bits
+
+/* a read in flight */
+struct slow5_aio_req {
+    char *buf;
+    size_t bytes;
+    uint64_t offset;
+    size_t done;                /* bytes read so far */
+    int err;                    /* errno of a failed read, 0 otherwise */
+    void *data;
+};
+
+#ifdef SLOW5_USE_IOURING
+/* an io_uring set up with raw system calls so that no extra library is needed */
+struct slow5_uring {
+    int fd;
+    uint32_t *sq_tail;
+    uint32_t sq_mask;
+    uint32_t *sq_array;
+    struct io_uring_sqe *sqes;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    uint32_t cq_mask;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;
+    size_t cq_size;
+    size_t sqes_size;
+    uint32_t to_submit;         /* queued sqes not yet passed to the kernel */
+};
+#endif
+
+struct slow5_aio {
+    enum slow5_aio_backend backend;
+    int fd;
+    uint32_t depth;
+    struct slow5_aio_req *reqs;
+    uint32_t *free_slots;       /* stack of unused reqs */
+    uint32_t num_free;
+
+#ifdef SLOW5_USE_IOURING
+    struct slow5_uring ring;
+#endif
+
+    /* thread backend, slots move from todo to done (both rings of depth entries) under lock */
+    pthread_t *tids;
+    int num_tids;
+    pthread_mutex_t lock;
+    pthread_cond_t todo_cond;
+    pthread_cond_t done_cond;
+    uint32_t *todo;
+    uint32_t todo_head;
+    uint32_t todo_len;
+    uint32_t *done;
+    uint32_t done_head;
+    uint32_t done_len;
+    int stop;
+};
+
+
+/* read what is left of req with pread, retrying short reads */
+static void slow5_aio_pread(int fd, struct slow5_aio_req *req) {
+    while (req->done < req->bytes) {
+        size_t left = req->bytes - req->done;
+        ssize_t ret = pread(fd, req->buf + req->done, left < SLOW5_AIO_MAX_READ ? left : SLOW5_AIO_MAX_READ, req->offset + req->done);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            req->err = ret < 0 ? errno : 0;
+            return;
+        }
+        req->done += ret;
+    }
+}
+
+static void *slow5_aio_thread(void *voidaio) {
+    struct slow5_aio *aio = (struct slow5_aio *) voidaio;
+
+    pthread_mutex_lock(&aio->lock);
+    for (;;) {
+        while (!aio->todo_len && !aio->stop) {
+            pthread_cond_wait(&aio->todo_cond, &aio->lock);
+        }
+        if (!aio->todo_len) {
+            break;
+        }
+        uint32_t slot = aio->todo[aio->todo_head];
+        aio->todo_head = (aio->todo_head + 1) % aio->depth;
+        -- aio->todo_len;
+        pthread_mutex_unlock(&aio->lock);
+
+        slow5_aio_pread(aio->fd, &aio->reqs[slot]);
+
+        pthread_mutex_lock(&aio->lock);
+        aio->done[(aio->done_head + aio->done_len) % aio->depth] = slot;
+        ++ aio->done_len;
+        pthread_cond_signal(&aio->done_cond);
+    }
+    pthread_mutex_unlock(&aio->lock);
+
+    return NULL;
+}
+
+static int slow5_aio_threads_init(struct slow5_aio *aio) {
+    aio->todo = (uint32_t *) malloc(aio->depth * sizeof *aio->todo);
+    aio->done = (uint32_t *) malloc(aio->depth * sizeof *aio->done);
+    int num_tids = aio->depth < SLOW5_AIO_MAX_THREADS ? aio->depth : SLOW5_AIO_MAX_THREADS;
+    aio->tids = (pthread_t *) malloc(num_tids * sizeof *aio->tids);
+    if (!aio->todo || !aio->done || !aio->tids) {
+        SLOW5_MALLOC_ERROR();
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+
+    pthread_mutex_init(&aio->lock, NULL);
+    pthread_cond_init(&aio->todo_cond, NULL);
+    pthread_cond_init(&aio->done_cond, NULL);
+    for (; aio->num_tids < num_tids; ++ aio->num_tids) {
+        if (pthread_create(&aio->tids[aio->num_tids], NULL, slow5_aio_thread, aio) != 0) {
+            break;
+        }
+    }
+    if (!aio->num_tids) {
+        SLOW5_ERROR("%s", "Failed to create any thread for reading.");
+        return slow5_errno = SLOW5_ERR_OTH;
+    }
+    aio->backend = SLOW5_AIO_THREADS;
+
+    return 0;
+}
+
+static void slow5_aio_threads_free(struct slow5_aio *aio) {
+    if (aio->num_tids) {
+        pthread_mutex_lock(&aio->lock);
+        aio->stop = 1;
+        pthread_cond_broadcast(&aio->todo_cond);
+        pthread_mutex_unlock(&aio->lock);
+        for (int t = 0; t < aio->num_tids; ++ t) {
+            pthread_join(aio->tids[t], NULL);
+        }
+        pthread_mutex_destroy(&aio->lock);
+        pthread_cond_destroy(&aio->todo_cond);
+        pthread_cond_destroy(&aio->done_cond);
+    }
+    free(aio->tids);
+    free(aio->todo);
+    free(aio->done);
+}
+
+
+#ifdef SLOW5_USE_IOURING
+
+/* returns 0 on success, -1 if io_uring is unavailable */
+static int slow5_uring_init(struct slow5_uring *ring, uint32_t depth) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof p);
+    ring->fd = syscall(__NR_io_uring_setup, depth, &p);
+    if (ring->fd < 0) {
+        SLOW5_LOG_DEBUG("io_uring_setup failed: %s", strerror(errno));
+        return -1;
+    }
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        /* older than linux 5.6 which added IORING_OP_READ */
+        SLOW5_LOG_DEBUG("%s", "io_uring does not support IORING_OP_READ");
+        close(ring->fd);
+        return -1;
+    }
+
+    ring->sq_size = p.sq_off.array + p.sq_entries * sizeof (uint32_t);
+    ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_size > ring->sq_size) {
+            ring->sq_size = ring->cq_size;
+        }
+        ring->cq_size = ring->sq_size;
+    }
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        close(ring->fd);
+        return -1;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            munmap(ring->sq_ptr, ring->sq_size);
+            close(ring->fd);
+            return -1;
+        }
+    }
+    ring->sqes_size = p.sq_entries * sizeof (struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *) mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (ring->cq_ptr != ring->sq_ptr) {
+            munmap(ring->cq_ptr, ring->cq_size);
+        }
+        munmap(ring->sq_ptr, ring->sq_size);
+        close(ring->fd);
+        return -1;
+    }
+
+    char *sq = (char *) ring->sq_ptr;
+    char *cq = (char *) ring->cq_ptr;
+    ring->sq_tail = (uint32_t *) (sq + p.sq_off.tail);
+    ring->sq_mask = *(uint32_t *) (sq + p.sq_off.ring_mask);
+    ring->sq_array = (uint32_t *) (sq + p.sq_off.array);
+    ring->cq_head = (uint32_t *) (cq + p.cq_off.head);
+    ring->cq_tail = (uint32_t *) (cq + p.cq_off.tail);
+    ring->cq_mask = *(uint32_t *) (cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+    ring->to_submit = 0;
+
+    return 0;
+}
+
+static void slow5_uring_free(struct slow5_uring *ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_size);
+    }
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+}
+
+/* queue a read of what is left of reqs[slot], the sq cannot be full as at most depth reads are outstanding */
+static void slow5_uring_queue(struct slow5_aio *aio, uint32_t slot) {
+    struct slow5_uring *ring = &aio->ring;
+    struct slow5_aio_req *req = &aio->reqs[slot];
+    size_t left = req->bytes - req->done;
+
+    uint32_t tail = *ring->sq_tail;
+    uint32_t idx = tail & ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[idx];
+    memset(sqe, 0, sizeof *sqe);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = aio->fd;
+    sqe->off = req->offset + req->done;
+    sqe->addr = (uint64_t) (uintptr_t) (req->buf + req->done);
+    sqe->len = left < SLOW5_AIO_MAX_READ ? left : SLOW5_AIO_MAX_READ;
+    sqe->user_data = slot;
+    ring->sq_array[idx] = idx;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++ ring->to_submit;
+}
+
+/* pass queued sqes to the kernel and wait for a cqe, returns the slot of a completed read or <0 on error */
+static int64_t slow5_uring_wait(struct slow5_aio *aio) {
+    struct slow5_uring *ring = &aio->ring;
+
+    for (;;) {
+        uint32_t head = *ring->cq_head;
+        if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+            uint32_t slot = (uint32_t) cqe->user_data;
+            int32_t res = cqe->res;
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+            struct slow5_aio_req *req = &aio->reqs[slot];
+            if (res == -EINTR || res == -EAGAIN) {
+                slow5_uring_queue(aio, slot);
+                continue;
+            } else if (res <= 0) {
+                req->err = -res;
+                return slot;
+            }
+            req->done += res;
+            if (req->done < req->bytes) {
+                slow5_uring_queue(aio, slot);
+                continue;
+            }
+            return slot;
+        }
+
+        int ret = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            SLOW5_ERROR("io_uring_enter failed: %s.", strerror(errno));
+            return slow5_errno = SLOW5_ERR_IO;
+        }
+        ring->to_submit -= ret;
+    }
+}
+
+#endif /* SLOW5_USE_IOURING */
+
+
+/*
+ * start an aio on fd with up to depth reads in flight
+ * returns NULL on error and sets slow5_errno
+ */
+struct slow5_aio *slow5_aio_init(int fd, uint32_t depth) {
+    if (fd < 0 || depth == 0) {
+        SLOW5_ERROR("%s", "Invalid arguments to start asynchronous reads.");
+        slow5_errno = SLOW5_ERR_ARG;
+        return NULL;
+    }
+
+    struct slow5_aio *aio = (struct slow5_aio *) calloc(1, sizeof *aio);
+    if (!aio) {
+        SLOW5_MALLOC_ERROR();
+        slow5_errno = SLOW5_ERR_MEM;
+        return NULL;
+    }
+    aio->fd = fd;
+    aio->depth = depth;
+    aio->reqs = (struct slow5_aio_req *) calloc(depth, sizeof *aio->reqs);
+    aio->free_slots = (uint32_t *) malloc(depth * sizeof *aio->free_slots);
+    if (!aio->reqs || !aio->free_slots) {
+        SLOW5_MALLOC_ERROR();
+        free(aio->reqs);
+        free(aio->free_slots);
+        free(aio);
+        slow5_errno = SLOW5_ERR_MEM;
+        return NULL;
+    }
+    for (uint32_t i = 0; i < depth; ++ i) {
+        aio->free_slots[i] = depth - 1 - i;
+    }
+    aio->num_free = depth;
+
+#ifdef SLOW5_USE_IOURING
+    if (slow5_uring_init(&aio->ring, depth) == 0) {
+        aio->backend = SLOW5_AIO_IOURING;
+        return aio;
+    }
+    SLOW5_LOG_DEBUG("%s", "io_uring is unavailable, falling back to threads");
+#endif
+
+    if (slow5_aio_threads_init(aio) != 0) {
+        slow5_aio_threads_free(aio);
+        free(aio->reqs);
+        free(aio->free_slots);
+        free(aio);
+        return NULL;
+    }
+
+    return aio;
+}
+
+enum slow5_aio_backend slow5_aio_backend(const struct slow5_aio *aio) {
+    return aio->backend;
+}
+
+/*
+ * queue a read of bytes at offset into buf, data is given back by slow5_aio_wait
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+int slow5_aio_submit(struct slow5_aio *aio, void *buf, size_t bytes, uint64_t offset, void *data) {
+    if (!aio->num_free) {
+        SLOW5_ERROR("Cannot have more than '%" PRIu32 "' reads in flight.", aio->depth);
+        return slow5_errno = SLOW5_ERR_OTH;
+    }
+
+    uint32_t slot = aio->free_slots[-- aio->num_free];
+    struct slow5_aio_req *req = &aio->reqs[slot];
+    req->buf = (char *) buf;
+    req->bytes = bytes;
+    req->offset = offset;
+    req->done = 0;
+    req->err = 0;
+    req->data = data;
+
+#ifdef SLOW5_USE_IOURING
+    if (aio->backend == SLOW5_AIO_IOURING) {
+        slow5_uring_queue(aio, slot);
+        return 0;
+    }
+#endif
+
+    pthread_mutex_lock(&aio->lock);
+    aio->todo[(aio->todo_head + aio->todo_len) % aio->depth] = slot;
+    ++ aio->todo_len;
+    pthread_cond_signal(&aio->todo_cond);
+    pthread_mutex_unlock(&aio->lock);
+
+    return 0;
+}
+
+/*
+ * wait for any outstanding read to complete and set *data to the data it was submitted with
+ * returns 0 if it was read in full
+ * SLOW5_ERR_IO if it failed or reached the end of the file (*data is still set)
+ * another <0 value if waiting failed or nothing is outstanding (*data is not set)
+ */
+int slow5_aio_wait(struct slow5_aio *aio, void **data) {
+    if (aio->num_free == aio->depth) {
+        SLOW5_ERROR("%s", "No read is in flight.");
+        return slow5_errno = SLOW5_ERR_OTH;
+    }
+
+    uint32_t slot;
+#ifdef SLOW5_USE_IOURING
+    if (aio->backend == SLOW5_AIO_IOURING) {
+        int64_t ret = slow5_uring_wait(aio);
+        if (ret < 0) {
+            return ret;
+        }
+        slot = ret;
+    } else
+#endif
+    {
+        pthread_mutex_lock(&aio->lock);
+        while (!aio->done_len) {
+            pthread_cond_wait(&aio->done_cond, &aio->lock);
+        }
+        slot = aio->done[aio->done_head];
+        aio->done_head = (aio->done_head + 1) % aio->depth;
+        -- aio->done_len;
+        pthread_mutex_unlock(&aio->lock);
+    }
+
+    struct slow5_aio_req *req = &aio->reqs[slot];
+    aio->free_slots[aio->num_free ++] = slot;
+    *data = req->data;
+    if (req->done < req->bytes) {
+        SLOW5_ERROR("Failed to read '%zu' bytes at offset '%" PRIu64 "': %s.", req->bytes, req->offset,
+                req->err ? strerror(req->err) : "unexpected end of file");
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+
+    return 0;
+}
+
+void slow5_aio_free(struct slow5_aio *aio) {
+    if (!aio) {
+        return;
+    }
+
+    /* the kernel or the threads may still be writing into the buffers */
+    while (aio->num_free < aio->depth) {
+        void *data;
+        if (slow5_aio_wait(aio, &data) != 0 && slow5_errno != SLOW5_ERR_IO) {
+            break;
+        }
+    }
+
+#ifdef SLOW5_USE_IOURING
+    if (aio->backend == SLOW5_AIO_IOURING) {
+        slow5_uring_free(&aio->ring);
+    } else
+#endif
+    {
+        slow5_aio_threads_free(aio);
+    }
+    free(aio->reqs);
+    free(aio->free_slots);
+    free(aio);
+}
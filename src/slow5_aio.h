@@ -0,0 +1,51 @@
+#ifndef SLOW5_AIO_H
+#define SLOW5_AIO_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+IMPORTANT: The low-level API is not yet finalised or documented and is only for internal use.
+Function prototypes can be changed without notice or completely removed. So do NOT use these functions in your code.
+*/
+
+/*
+ * Asynchronous positional reads from a file descriptor, used to keep many record reads in flight at once.
+ * With SLOW5_USE_IOURING (`make iouring=1`) reads are submitted to a Linux io_uring when the kernel supports it.
+ * Otherwise, or if setting up the ring fails, a pool of threads blocking in pread is used instead.
+ * An aio handle is used by a single thread: the one that submits is the one that waits.
+ */
+
+#define SLOW5_AIO_MAX_THREADS (32) // threads of the pread fallback
+
+enum slow5_aio_backend {
+    SLOW5_AIO_THREADS,
+    SLOW5_AIO_IOURING,
+};
+
+struct slow5_aio;
+
+// start an aio on fd with up to depth reads in flight, returns NULL on error and sets slow5_errno
+struct slow5_aio *slow5_aio_init(int fd, uint32_t depth);
+// the backend in use
+enum slow5_aio_backend slow5_aio_backend(const struct slow5_aio *aio);
+// queue a read of bytes at offset into buf, at most depth reads may be outstanding (submitted but not waited for)
+// data is returned by slow5_aio_wait when the read completes; short reads are retried internally
+// returns 0 on success, <0 on error and sets slow5_errno
+int slow5_aio_submit(struct slow5_aio *aio, void *buf, size_t bytes, uint64_t offset, void *data);
+// wait for any outstanding read to complete and set *data to its data
+// returns 0 if all bytes were read, SLOW5_ERR_IO if the read failed or hit the end of the file (*data is still set)
+// and another <0 value with *data unset if waiting itself failed
+int slow5_aio_wait(struct slow5_aio *aio, void **data);
+// wait for any outstanding reads and free aio
+void slow5_aio_free(struct slow5_aio *aio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
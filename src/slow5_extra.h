@@ -65,8 +65,18 @@ static inline int slow5_rec_set_string(slow5_rec_t *read, slow5_aux_meta_t *aux_
     return slow5_rec_set_array(read, aux_meta, attr, data, strlen(data));
 }
 int slow5_rec_depress_parse(char **mem, size_t *bytes, const char *read_id, slow5_rec_t **read, slow5_file_t *s5p);
+int slow5_rec_depress_parse_ctx(char *mem, size_t bytes, const char *read_id, slow5_rec_t **read, slow5_file_t *s5p, slow5_decode_ctx_t *ctx);
 int slow5_rec_parse(char *read_mem, size_t read_size, const char *read_id, slow5_rec_t **read, enum slow5_fmt format, slow5_aux_meta_t *aux_meta, enum slow5_press_method signal_method);
+int slow5_rec_parse_ctx(char *read_mem, size_t read_size, const char *read_id, slow5_rec_t **read, enum slow5_fmt format, slow5_aux_meta_t *aux_meta, enum slow5_press_method signal_method, slow5_decode_ctx_t *ctx);
 void slow5_rec_aux_free(khash_t(slow5_s2a) *aux_map);
+int slow5_rec_view_mem(const void *mem, size_t bytes, slow5_rec_view_t **view, const slow5_file_t *s5p);
+
+// batched random access (see slow5_get_many): records sorted by offset and grouped into single reads
+struct slow5_get_plan;
+struct slow5_get_plan *slow5_get_plan_init(char **read_ids, size_t n, const slow5_file_t *s5p);
+size_t slow5_get_plan_len(const struct slow5_get_plan *plan);
+int slow5_get_plan_fetch(const struct slow5_get_plan *plan, size_t group, slow5_rec_t **reads, slow5_file_t *s5p, slow5_decode_ctx_t *ctx);
+void slow5_get_plan_free(struct slow5_get_plan *plan);
 
 // slow5 extension parsing
 enum slow5_fmt slow5_name_get_fmt(const char *name);
@@ -1,6 +1,10 @@
 #define _XOPEN_SOURCE 700
+#include <ctype.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 //#include "klib/khash.h"
 #include "slow5_idx.h"
 //#include "slow5.h"
@@ -13,23 +17,106 @@ extern enum slow5_exit_condition_opt  slow5_exit_condition;
 
 #define BUF_INIT_CAP (20*1024*1024)
 #define SLOW5_INDEX_BUF_INIT_CAP (64) // 2^6 TODO is this too little?
+#define SLOW5_IDX_BUILD_CHUNK (4096) // blow5 records handed to an index build thread at a time
+#define SLOW5_IDX_BUILD_MAX_THREADS (16) // default upper limit of index build threads
+#define SLOW5_IDX_PART_LEN (256) // guess of the compressed bytes of a record that contain the read ID
+#define SLOW5_IDX_ZSTD_PART_LEN ((1 << 17) + 32) // largest zstd block and frame header
 
 static inline struct slow5_idx *slow5_idx_init_empty(void);
-static int slow5_idx_build(struct slow5_idx *index, struct slow5_file *s5p);
-static int slow5_idx_read(struct slow5_idx *index);
+static int slow5_idx_build(struct slow5_idx *index, struct slow5_file *s5p, uint64_t start, int num_thread);
+static int slow5_idx_build_binary(struct slow5_idx *index, struct slow5_file *s5p, uint64_t start, int num_thread);
+static int slow5_idx_read(struct slow5_idx *index, FILE *fp);
+static int slow5_idx_unmap(struct slow5_idx *index);
+static int slow5_idx_cols_init(struct slow5_idx *index, const struct slow5_file *s5p, const char **names, uint32_t num_cols);
+static int slow5_idx_cols_view(struct slow5_idx *index, uint64_t rec, const struct slow5_rec_view *view);
+static int slow5_idx_cols_fill(struct slow5_idx *index, struct slow5_file *s5p, uint64_t rec);
+static int slow5_idx_reserve(struct slow5_idx *index, uint64_t num_recs);
 
 static inline struct slow5_idx *slow5_idx_init_empty(void) {
 
     struct slow5_idx *index = (struct slow5_idx *) calloc(1, sizeof *index);
     SLOW5_MALLOC_CHK(index);
-    index->hash = kh_init(slow5_s2i);
 
     return index;
 }
 
+/*
+ * build the index of all the records of s5p, with the values of its columns if it has any, and write it to index->pathname
+ * return 0 on success, <0 on error
+ */
+static int slow5_idx_init_build(struct slow5_idx *index, struct slow5_file *s5p) {
+
+    if (slow5_idx_build(index, s5p, s5p->meta.start_rec_offset, slow5_idx_build_threads()) != 0 ||
+            slow5_idx_cols_fill(index, s5p, 0) != 0) {
+        return -1;
+    }
+    int ret = slow5_idx_write(index, s5p->header->version);
+    if (ret != 0) {
+        return slow5_errno = ret;
+    }
+
+    return 0;
+}
+
+/*
+ * index the records appended to s5p after the end of the records in index, and write the index back to its file
+ * return 0 if the index is up to date (or where it ends is unknown),
+ * 1 if it does not match s5p (e.g. s5p was rewritten) and has to be built again, <0 on error
+ */
+static int slow5_idx_catch_up(struct slow5_idx *index, struct slow5_file *s5p) {
+
+    if (!index->data_size) {
+        return 0;
+    }
+    struct stat st;
+    if (fstat(s5p->meta.fd, &st) != 0) {
+        SLOW5_ERROR("Failed to get the size of slow5 file '%s': %s.", s5p->meta.pathname, strerror(errno));
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+    const char eof[] = SLOW5_BINARY_EOF;
+    uint64_t end = st.st_size;
+    if (s5p->format == SLOW5_FORMAT_BINARY) {
+        end = end > sizeof eof ? end - sizeof eof : 0;
+    }
+    if (index->data_size == end) {
+        return 0;
+    }
+    if (index->data_size < s5p->meta.start_rec_offset || index->data_size > end) {
+        return 1;
+    }
+
+    uint64_t num_ids = index->num_ids;
+    if (index->map && slow5_idx_unmap(index) != 0) {
+        return slow5_errno;
+    }
+    uint64_t rec = index->pool_size; // the new records are added after it
+    if (slow5_idx_build(index, s5p, index->data_size, slow5_idx_build_threads()) != 0 ||
+            slow5_idx_cols_fill(index, s5p, rec) != 0) {
+        return 1;
+    }
+    SLOW5_INFO("Indexed '%" PRIu64 "' records appended to '%s' since its index was written.", index->num_ids - num_ids, s5p->meta.pathname);
+
+    if (slow5_idx_write(index, s5p->header->version) != 0) {
+        SLOW5_WARNING("Failed to update index file '%s'.", index->pathname);
+    }
+
+    return 0;
+}
+
 // TODO return NULL if idx_init fails
 struct slow5_idx *slow5_idx_init(struct slow5_file *s5p) {
 
+    // a blow5 file written with an index footer carries its own index
+    if (s5p->format == SLOW5_FORMAT_BINARY) {
+        uint64_t footer;
+        int ret = slow5_idx_footer_offset(s5p->meta.fd, &footer);
+        if (ret < 0) {
+            return NULL;
+        } else if (ret == 1) {
+            return slow5_idx_footer_init(s5p, footer, 0);
+        }
+    }
+
     struct slow5_idx *index = slow5_idx_init_empty();
     if (!index) {
         return NULL;
@@ -39,35 +126,25 @@ struct slow5_idx *slow5_idx_init(struct slow5_file *s5p) {
         slow5_idx_free(index);
         return NULL;
     }
+    index->v2 = s5p->meta.idx_v2;
 
     FILE *index_fp;
 
     // If file doesn't exist
-    if ((index_fp = fopen(index->pathname, "r+")) == NULL) {
+    if ((index_fp = fopen(index->pathname, "r")) == NULL) {
         SLOW5_INFO("Index file not found. Creating an index at '%s'.", index->pathname)
-        if (slow5_idx_build(index, s5p) != 0) {
+        if (slow5_idx_init_build(index, s5p) != 0) {
             slow5_idx_free(index);
             return NULL;
         }
-        index->fp = fopen(index->pathname, "w");
-        if (slow5_idx_write(index, s5p->header->version) != 0) {
-            slow5_idx_free(index);
-            return NULL;
-        }
-        fclose(index->fp);
-        index->fp = NULL;
     } else {
-        index->fp = index_fp;
-        int err;
-        if (slow5_filestamps_cmp(index->pathname, s5p->meta.pathname, &err) < 0.0) {
-            SLOW5_WARNING("Index file '%s' is older than slow5 file '%s'.",
-                    index->pathname, s5p->meta.pathname);
-        }
-        if (err == -1) {
-            slow5_idx_free(index);
-            return NULL;
+        // not kept open, changes are written to a new file (see slow5_idx_write)
+        int ret = slow5_idx_read(index, index_fp);
+        if (fclose(index_fp) == EOF && ret == 0) {
+            SLOW5_ERROR("Failure when closing index file: %s", strerror(errno));
+            ret = SLOW5_ERR_IO;
         }
-        if (slow5_idx_read(index) != 0) {
+        if (ret != 0) {
             slow5_idx_free(index);
             return NULL;
         }
@@ -80,6 +157,45 @@ struct slow5_idx *slow5_idx_init(struct slow5_file *s5p) {
             slow5_idx_free(index);
             return NULL;
         }
+
+        // records appended since the index was written
+        ret = slow5_idx_catch_up(index, s5p);
+        if (ret < 0) {
+            slow5_idx_free(index);
+            return NULL;
+        } else if (ret == 1) {
+            SLOW5_WARNING("Index file '%s' does not match slow5 file '%s'. Creating the index again.",
+                    index->pathname, s5p->meta.pathname);
+            struct slow5_idx *rebuilt = slow5_idx_init_empty();
+            if (!rebuilt) {
+                slow5_idx_free(index);
+                return NULL;
+            }
+            rebuilt->pathname = index->pathname;
+            rebuilt->v2 = index->v2;
+            index->pathname = NULL;
+            rebuilt->cols = index->cols; // kept with their values made again
+            rebuilt->num_cols = index->num_cols;
+            index->cols = NULL;
+            index->num_cols = 0;
+            slow5_idx_free(index);
+            index = rebuilt;
+            if (slow5_idx_init_build(index, s5p) != 0) {
+                slow5_idx_free(index);
+                return NULL;
+            }
+        } else if (!index->data_size) {
+            // an older index, which does not know where its records end
+            int err;
+            if (slow5_filestamps_cmp(index->pathname, s5p->meta.pathname, &err) < 0.0) {
+                SLOW5_WARNING("Index file '%s' is older than slow5 file '%s'.",
+                        index->pathname, s5p->meta.pathname);
+            }
+            if (err == -1) {
+                slow5_idx_free(index);
+                return NULL;
+            }
+        }
     }
 
     return index;
@@ -94,15 +210,28 @@ struct slow5_idx *slow5_idx_init(struct slow5_file *s5p) {
  * @return  -1 on error, 0 on success
  */
 int slow5_idx_to(struct slow5_file *s5p, const char *pathname) {
+    return slow5_idx_to_mt(s5p, pathname, slow5_idx_build_threads());
+}
+
+/**
+ * Same as slow5_idx_to but a blow5 file is indexed using num_thread threads.
+ *
+ * @param   s5p         slow5 file structure
+ * @param   pathname    pathname to write index to
+ * @param   num_thread  number of threads
+ * @return  -1 on error, 0 on success
+ */
+int slow5_idx_to_mt(struct slow5_file *s5p, const char *pathname, int num_thread) {
 
     struct slow5_idx *index = slow5_idx_init_empty();
-    if (slow5_idx_build(index, s5p) != 0) {
+    index->v2 = s5p->meta.idx_v2;
+    if (slow5_idx_build(index, s5p, s5p->meta.start_rec_offset, num_thread) != 0) {
         slow5_idx_free(index);
         return -1;
     }
 
-    index->fp = fopen(pathname, "w");
-    if (slow5_idx_write(index, s5p->header->version) != 0) {
+    index->pathname = strdup(pathname);
+    if (!index->pathname || slow5_idx_write(index, s5p->header->version) != 0) {
         slow5_idx_free(index);
         return -1;
     }
@@ -111,364 +240,2186 @@ int slow5_idx_to(struct slow5_file *s5p, const char *pathname) {
     return 0;
 }
 
-/*
- * return 0 on success
- * return <0 on failure
- * TODO fix error handling
+/**
+ * Same as slow5_idx_to but for a blow5 file, with the values of the fields cols[0..num_cols-1] of each record
+ * kept in the index as columns (see slow5_idx_col_get).
+ *
+ * @param   s5p         slow5 file structure
+ * @param   pathname    pathname to write index to
+ * @param   cols        names of primary or auxiliary fields
+ * @param   num_cols    number of columns
+ * @return  <0 on error and sets slow5_errno, 0 on success
  */
-static int slow5_idx_build(struct slow5_idx *index, struct slow5_file *s5p) {
+int slow5_idx_to_cols(struct slow5_file *s5p, const char *pathname, const char **cols, uint32_t num_cols) {
 
-    uint64_t curr_offset = ftello(s5p->fp);
-    if (fseeko(s5p->fp, s5p->meta.start_rec_offset, SEEK_SET != 0)) {
-        return -1;
+    struct slow5_idx *index = slow5_idx_init_empty();
+    if (!index) {
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+    index->v2 = 1; // columns are only kept in v2
+    if (slow5_idx_cols_init(index, s5p, cols, num_cols) != 0 ||
+            slow5_idx_build(index, s5p, s5p->meta.start_rec_offset, slow5_idx_build_threads()) != 0 ||
+            slow5_idx_cols_fill(index, s5p, 0) != 0) {
+        slow5_idx_free(index);
+        return slow5_errno < 0 ? slow5_errno : SLOW5_ERR_OTH;
     }
 
-    uint64_t offset = 0;
-    uint64_t size = 0;
-
-    if (s5p->format == SLOW5_FORMAT_ASCII) {
-        size_t cap = BUF_INIT_CAP;
-        char *buf = (char *) malloc(cap * sizeof *buf);
-        SLOW5_MALLOC_CHK(buf);
-        ssize_t buf_len;
-        char *bufp;
-
-        offset = ftello(s5p->fp);
-        while ((buf_len = getline(&buf, &cap, s5p->fp)) != -1) { // TODO this return is closer int64_t not unsigned
-            bufp = buf;
-            char *read_id = strdup(slow5_strsep(&bufp, SLOW5_SEP_COL));
-            size = buf_len;
-
-            if (slow5_idx_insert(index, read_id, offset, size) == -1) {
-                // TODO handle error and free
-                SLOW5_ERROR("Inserting '%s' to index failed", read_id);
-                return -1;
-            }
-            offset += buf_len;
-        }
+    if (!(index->pathname = strdup(pathname))) {
+        SLOW5_MALLOC_ERROR();
+        slow5_idx_free(index);
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+    int ret = slow5_idx_write(index, s5p->header->version);
+    if (ret != 0) {
+        slow5_errno = ret;
+    }
 
-        free(buf);
+    slow5_idx_free(index);
+    return ret;
+}
 
-    } else if (s5p->format == SLOW5_FORMAT_BINARY) {
+/* default number of threads to build an index with: the number of online processors up to SLOW5_IDX_BUILD_MAX_THREADS */
+int slow5_idx_build_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) {
+        return 1;
+    }
+    return n < SLOW5_IDX_BUILD_MAX_THREADS ? n : SLOW5_IDX_BUILD_MAX_THREADS;
+}
 
-        while (1) {
-            // Set start offset
-            offset = ftello(s5p->fp);
-
-            // Get record size
-            slow5_rec_size_t record_size;
-            size_t bytes_read;
-            if ((bytes_read = fread(&record_size, 1, sizeof record_size, s5p->fp)) != sizeof record_size) {
-                const char eof[] = SLOW5_BINARY_EOF;
-                int is_eof = 0;
-                if (bytes_read == sizeof eof) {
-                    /* check if eof */
-                    is_eof = slow5_is_eof(s5p->fp, eof, sizeof eof);
-                    if (is_eof == -1) { /* io/mem error */
-                        SLOW5_ERROR("%s", "Internal error while checking for blow5 eof marker.");
-                    } else if (is_eof == -2) {
-                        SLOW5_ERROR("%s", "Malformed blow5. End of file marker found, but end of file not reached.");
-                    } else if (is_eof == 1) {
-                        /* slow5_errno = SLOW5_ERR_EOF; */
-                        break;
-                    }
-                }
-                if (!is_eof) { /* catches the case when bytes_read != sizeof eof */
-                    SLOW5_ERROR("Malformed blow5 record. Failed to read the record size.%s", feof(s5p->fp) ? " Missing blow5 end of file marker." : "");
-                    if (feof(s5p->fp)) {
-                        slow5_errno = SLOW5_ERR_TRUNC;
-                    } else {
-                        slow5_errno = SLOW5_ERR_IO;
-                    }
-                }
-                return slow5_errno;
-            }
+/* what is indexed of a blow5 record */
+struct slow5_idx_rec_read {
+    char *read_id;
+    uint32_t read_group;
+    uint64_t len_raw_signal; // number of samples
+    uint64_t pos; // of the record in its block if the records are in blocks
+};
 
-            size = sizeof record_size + record_size;
+/*
+ * blow5 records (or blocks of records) found by walking the record sizes,
+ * with their read IDs (and what the statistics need) once a thread has got them
+ */
+struct slow5_idx_chunk {
+    size_t n;
+    uint64_t offset[SLOW5_IDX_BUILD_CHUNK];
+    uint64_t size[SLOW5_IDX_BUILD_CHUNK];
+    struct slow5_idx_rec_read read[SLOW5_IDX_BUILD_CHUNK];
+    struct slow5_idx_rec_read *block[SLOW5_IDX_BUILD_CHUNK]; // the records of each block instead of read, NULL if none
+    uint64_t num_block[SLOW5_IDX_BUILD_CHUNK];
+    struct slow5_idx_chunk *next;
+};
+
+/* shared state of slow5_idx_build_binary */
+struct slow5_idx_build_arg {
+    struct slow5_file *s5p;
+    uint64_t start;                         /* offset of the first record to index */
+    uint64_t end;                           /* offset the records end at, set by the scan */
+    uint64_t num_recs;                      /* records found by the scan */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct slow5_idx_chunk *head;           /* all chunks in file order */
+    struct slow5_idx_chunk *tail;
+    struct slow5_idx_chunk *todo;           /* next chunk without read IDs */
+    int scanning;                           /* 0 once no more chunks will be added */
+    int err;                                /* first error, 0 if none */
+};
 
-            uint8_t *read_comp = (uint8_t *) malloc(record_size);
-            SLOW5_MALLOC_CHK(read_comp);
-            if (fread(read_comp, record_size, 1, s5p->fp) != 1) {
-                free(read_comp);
-                return -1;
+/*
+ * parse the start of a decompressed blow5 record rec of n bytes into a copy of its read ID, its read group and number of samples
+ * the number of samples of a compressed signal is got from its first bytes (see slow5_ptr_depress_size) and never decompressed,
+ * it is SLOW5_IDX_LEN_UNKNOWN if they do not hold it (e.g. zlib)
+ * returns 0 on success, 1 if more than n bytes are needed and sets *want to how many (if known), <0 on error and sets slow5_errno
+ */
+static int slow5_idx_rec_parse(const uint8_t *rec, size_t n, enum slow5_press_method signal_method, struct slow5_idx_rec_read *read, size_t *want) {
+    slow5_rid_len_t read_id_len;
+    if (n < sizeof read_id_len) {
+        return 1;
+    }
+    memcpy(&read_id_len, rec, sizeof read_id_len);
+    // read_group, digitisation, offset, range, sampling_rate then len_raw_signal
+    size_t len_pos = sizeof read_id_len + read_id_len + sizeof read->read_group + 4 * sizeof (double);
+    size_t sig_pos = len_pos + sizeof read->len_raw_signal;
+    size_t need = sig_pos;
+    uint64_t len_raw_signal = 0;
+    if (n >= sig_pos) {
+        memcpy(&len_raw_signal, rec + len_pos, sizeof len_raw_signal);
+        if (signal_method == SLOW5_COMPRESS_SVB_ZD || signal_method == SLOW5_COMPRESS_ZSTD) {
+            // the start of the signal holding its size, no more than its compressed bytes
+            need += len_raw_signal < SLOW5_PRESS_SIZE_HDR_LEN ? len_raw_signal : SLOW5_PRESS_SIZE_HDR_LEN;
+            if (signal_method == SLOW5_COMPRESS_SVB_ZD && need < sig_pos + sizeof (uint32_t)) {
+                need = sig_pos + sizeof (uint32_t);
             }
+        }
+    }
+    if (n < need) {
+        *want = need;
+        return 1;
+    }
 
-            uint8_t *read_decomp = read_comp;
-            if (s5p->compress) {
-
-                int8_t full_depress=!(s5p->compress->record_press->method == SLOW5_COMPRESS_ZLIB);
-                if(!full_depress){
-                    size_t part_len = 256; //guess max value to contain the read ID
-                    part_len = part_len > record_size ? record_size : part_len;
-                    size_t n=0;
-                    read_decomp = (uint8_t *) slow5_ptr_depress(s5p->compress->record_press, read_comp, part_len, &n);
-                    if(read_decomp == NULL || n < sizeof(slow5_rid_len_t) ){
-                        SLOW5_WARNING("%s","Partial decompression failed. Falling back to the slower method. Open an issue on GitHub.");
-                        free(read_decomp);
-                        full_depress = 1;
-                    }
-                    else {
-                        slow5_rid_len_t read_id_len;
-                        memcpy(&read_id_len, read_decomp, sizeof read_id_len);
-                        if(n < read_id_len + sizeof(slow5_rid_len_t)){
-                            SLOW5_WARNING("%s","Partial decompression failed. Read ID too long. Falling back to the slower method. Open an issue on GitHub.");
-                            free(read_decomp);
-                            full_depress = 1;
-                        }
-                    }
-                }
+    if (signal_method != SLOW5_COMPRESS_NONE) {
+        size_t bytes;
+        int ret = slow5_ptr_depress_size(signal_method, rec + sig_pos, need - sig_pos, &bytes);
+        if (ret < 0) {
+            SLOW5_ERROR("%s", "Getting the size of the raw signal failed.");
+            return ret;
+        }
+        len_raw_signal = ret == 0 ? bytes / sizeof (int16_t) : SLOW5_IDX_LEN_UNKNOWN;
+    }
 
-                if(full_depress){
-                    read_decomp = (uint8_t *) slow5_ptr_depress(s5p->compress->record_press, read_comp, record_size, NULL);
+    read->read_id = (char *) malloc((read_id_len + 1) * sizeof *read->read_id); // +1 for '\0'
+    SLOW5_MALLOC_CHK(read->read_id);
+    if (!read->read_id) {
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+    memcpy(read->read_id, rec + sizeof read_id_len, read_id_len);
+    read->read_id[read_id_len] = '\0';
+    memcpy(&read->read_group, rec + sizeof read_id_len + read_id_len, sizeof read->read_group);
+    read->len_raw_signal = len_raw_signal;
+    return 0;
+}
 
-                    if (read_decomp == NULL) {
-                        free(read_comp);
-                        free(read_decomp);
-                        return -1;
-                    }
+/*
+ * get what is indexed of the blow5 record at offset of size bytes (including the record size)
+ * only the start of the record is read and decompressed, first SLOW5_IDX_PART_LEN bytes (or a zstd block), growing until it holds what is needed
+ * buf is grown to hold what is read, ctx holds what is decompressed
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_idx_rec_read(struct slow5_file *s5p, uint64_t offset, uint64_t size, uint8_t **buf, size_t *cap, struct slow5_decode_ctx *ctx, struct slow5_idx_rec_read *read) {
+    uint64_t body_offset = offset + sizeof (slow5_rec_size_t);
+    size_t body_size = size - sizeof (slow5_rec_size_t);
+    enum slow5_press_method method = s5p->compress ? s5p->compress->record_press->method : SLOW5_COMPRESS_NONE;
+    enum slow5_press_method signal_method = s5p->compress ? s5p->compress->signal_press->method : SLOW5_COMPRESS_NONE;
+    // zstd only outputs whole blocks so read the first one at once
+    size_t len = method == SLOW5_COMPRESS_ZSTD ? SLOW5_IDX_ZSTD_PART_LEN : SLOW5_IDX_PART_LEN;
+    size_t want = SLOW5_IDX_PART_LEN; // decompressed bytes holding what is needed
+    if (len > body_size) {
+        len = body_size;
+    }
 
+    while (1) {
+        const uint8_t *comp;
+        if (s5p->meta.mmap_addr && body_offset + len <= s5p->meta.mmap_size) {
+            comp = (const uint8_t *) s5p->meta.mmap_addr + body_offset;
+        } else {
+            if (slow5_buf_reserve((void **) buf, cap, len) != 0) {
+                return slow5_errno;
+            }
+            size_t done = 0;
+            while (done < len) {
+                ssize_t ret = pread(s5p->meta.fd, *buf + done, len - done, body_offset + done);
+                if (ret <= 0) {
+                    SLOW5_ERROR("Failed to read the blow5 record at offset '%" PRIu64 "'.", offset);
+                    return slow5_errno = SLOW5_ERR_IO;
                 }
-                free(read_comp);
-
+                done += ret;
             }
+            comp = *buf;
+        }
 
-            // Get read id length
-            uint64_t cur_len = 0;
-            slow5_rid_len_t read_id_len;
-            memcpy(&read_id_len, read_decomp + cur_len, sizeof read_id_len);
-            cur_len += sizeof read_id_len;
-
-            // Get read id
-            char *read_id = (char *) malloc((read_id_len + 1) * sizeof *read_id); // +1 for '\0'
-            SLOW5_MALLOC_CHK(read_id);
-            memcpy(read_id, read_decomp + cur_len, read_id_len * sizeof *read_id);
-            read_id[read_id_len] = '\0';
-
-            // Insert index record
-            if (slow5_idx_insert(index, read_id, offset, size) == -1) {
-                SLOW5_ERROR("Inserting '%s' to index failed", read_id);
-                // TODO handle error and free
-                return -1;
+        size_t n;
+        const uint8_t *rec = (const uint8_t *) slow5_rec_depress_part_ctx(ctx, s5p->compress ? s5p->compress->record_press : NULL, comp, len, want, &n);
+        if (rec) {
+            int ret = slow5_idx_rec_parse(rec, n, signal_method, read, &want);
+            if (ret <= 0) {
+                return ret;
             }
-
-            free(read_decomp);
         }
-    }
 
-    if (fseeko(s5p->fp, curr_offset, SEEK_SET != 0)) {
-        return -1;
+        if (len == body_size) {
+            SLOW5_ERROR("Malformed blow5 record at offset '%" PRIu64 "'. Failed to get the read ID.", offset);
+            return slow5_errno = SLOW5_ERR_RECPARSE;
+        }
+        SLOW5_LOG_DEBUG("Read ID of the blow5 record at offset '%" PRIu64 "' is not in its first %zu bytes.", offset, len);
+        len = body_size / 4 < len ? body_size : len * 4;
     }
-
-    return 0;
 }
 
 /*
- * write an index to its file
- * returns 0 on success, <0 on error
+ * read the compressed block of records at offset of size bytes (including its size) of s5p into buf (grown as needed)
+ * and decompress it with ctx
+ * returns the decompressed block of *n bytes, NULL on error and sets slow5_errno
  */
-int slow5_idx_write(struct slow5_idx *index, struct slow5_version version) {
-
-    const char magic[] = SLOW5_INDEX_MAGIC_NUMBER;
-    if (fwrite(magic, sizeof *magic, sizeof magic, index->fp) != sizeof magic) {
-        return SLOW5_ERR_IO;
+static const char *slow5_idx_block_depress(struct slow5_file *s5p, uint64_t offset, uint64_t size, uint8_t **buf, size_t *cap, struct slow5_decode_ctx *ctx, size_t *n) {
+    uint64_t body_offset = offset + sizeof (slow5_rec_size_t);
+    size_t body_size = size > sizeof (slow5_rec_size_t) ? size - sizeof (slow5_rec_size_t) : 0;
+    const uint8_t *comp;
+    if (s5p->meta.mmap_addr && body_offset + body_size <= s5p->meta.mmap_size) {
+        comp = (const uint8_t *) s5p->meta.mmap_addr + body_offset;
+    } else {
+        if (slow5_buf_reserve((void **) buf, cap, body_size ? body_size : 1) != 0) {
+            return NULL;
+        }
+        if (pread(s5p->meta.fd, *buf, body_size, body_offset) != (ssize_t) body_size) {
+            SLOW5_ERROR("Failed to read the blow5 block at offset '%" PRIu64 "'.", offset);
+            slow5_errno = SLOW5_ERR_IO;
+            return NULL;
+        }
+        comp = *buf;
     }
-
-    if (fwrite(&version.major, sizeof version.major, 1, index->fp) != 1 ||
-            fwrite(&version.minor, sizeof version.minor, 1, index->fp) != 1 ||
-            fwrite(&version.patch, sizeof version.patch, 1, index->fp) != 1) {
-        return SLOW5_ERR_IO;
+    const char *blk = (const char *) slow5_block_depress_ctx(ctx, s5p->compress->block_press->method, comp, body_size, n);
+    if (!blk) {
+        SLOW5_ERROR("Decompressing the blow5 block at offset '%" PRIu64 "' failed.", offset);
+        slow5_errno = SLOW5_ERR_PRESS;
     }
+    return blk;
+}
 
-    uint8_t padding = SLOW5_INDEX_HEADER_SIZE_OFFSET -
-            sizeof magic * sizeof *magic -
-            sizeof version.major -
-            sizeof version.minor -
-            sizeof version.patch;
-    uint8_t *zeroes = (uint8_t *) calloc(padding, sizeof *zeroes);
-    SLOW5_MALLOC_CHK(zeroes);
-    if (fwrite(zeroes, sizeof *zeroes, padding, index->fp) != padding) {
-        return SLOW5_ERR_IO;
+/*
+ * get what is indexed of the records of the compressed block at offset of size bytes (including its size) of s5p
+ * the whole block is decompressed, *reads is set to a malloced array of *num_reads
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_idx_block_read(struct slow5_file *s5p, uint64_t offset, uint64_t size, uint8_t **buf, size_t *cap, struct slow5_decode_ctx *ctx,
+        struct slow5_idx_rec_read **reads, uint64_t *num_reads) {
+    enum slow5_press_method signal_method = s5p->compress->signal_press->method;
+    size_t n;
+    const char *blk = slow5_idx_block_depress(s5p, offset, size, buf, cap, ctx, &n);
+    if (!blk) {
+        return slow5_errno;
     }
-    free(zeroes);
-
-    for (uint64_t i = 0; i < index->num_ids; ++ i) {
 
-        khint_t pos = kh_get(slow5_s2i, index->hash, index->ids[i]);
-        if (pos == kh_end(index->hash)) {
-            return SLOW5_ERR_NOTFOUND;
+    struct slow5_idx_rec_read *read = NULL;
+    uint64_t num_read = 0;
+    uint64_t cap_read = 0;
+    size_t pos = 0;
+    int ret = 0;
+    while (pos < n) {
+        slow5_rec_size_t rec_size;
+        size_t want;
+        if (n - pos < sizeof rec_size || (memcpy(&rec_size, blk + pos, sizeof rec_size), rec_size > n - pos - sizeof rec_size)) {
+            SLOW5_ERROR("Malformed blow5 block at offset '%" PRIu64 "'. Record at '%zu' is beyond the end of the block.", offset, pos);
+            ret = slow5_errno = SLOW5_ERR_RECPARSE;
+            break;
         }
-
-        struct slow5_rec_idx read_index = kh_value(index->hash, pos);
-
-        slow5_rid_len_t read_id_len = strlen(index->ids[i]);
-        if (fwrite(&read_id_len, sizeof read_id_len, 1, index->fp) != 1 ||
-                fwrite(index->ids[i], sizeof *index->ids[i], read_id_len, index->fp) != read_id_len ||
-                fwrite(&read_index.offset, sizeof read_index.offset, 1, index->fp) != 1 ||
-                fwrite(&read_index.size, sizeof read_index.size, 1, index->fp) != 1) {
-            return SLOW5_ERR_IO;
+        if (num_read == cap_read) {
+            cap_read = cap_read ? cap_read * 2 : 16;
+            struct slow5_idx_rec_read *tmp = (struct slow5_idx_rec_read *) realloc(read, cap_read * sizeof *read);
+            if (!tmp) {
+                SLOW5_MALLOC_ERROR();
+                ret = slow5_errno = SLOW5_ERR_MEM;
+                break;
+            }
+            read = tmp;
         }
+        int err = slow5_idx_rec_parse((const uint8_t *) blk + pos + sizeof rec_size, rec_size, signal_method, read + num_read, &want);
+        if (err == 1) {
+            SLOW5_ERROR("Malformed blow5 record in the block at offset '%" PRIu64 "'. Failed to get the read ID.", offset);
+            err = slow5_errno = SLOW5_ERR_RECPARSE;
+        }
+        if (err) {
+            ret = err;
+            break;
+        }
+        read[num_read ++].pos = pos;
+        pos += sizeof rec_size + rec_size;
     }
 
-    const char eof[] = SLOW5_INDEX_EOF;
-    if (fwrite(eof, sizeof *eof, sizeof eof, index->fp) != sizeof eof) {
-        return SLOW5_ERR_IO;
+    if (ret) {
+        for (uint64_t i = 0; i < num_read; ++ i) {
+            free(read[i].read_id);
+        }
+        free(read);
+        return ret;
     }
-
+    *reads = read;
+    *num_reads = num_read;
     return 0;
 }
 
-static int slow5_idx_read(struct slow5_idx *index) {
-
-    struct slow5_version max_supported = SLOW5_VERSION_ARRAY;
-    const char magic[] = SLOW5_INDEX_MAGIC_NUMBER;
-    char buf_magic[sizeof magic]; // TODO is this a vla?
-    if (fread(buf_magic, sizeof *magic, sizeof magic, index->fp) != sizeof magic) {
-        return SLOW5_ERR_IO;
-    }
-    if (memcmp(magic, buf_magic, sizeof *magic * sizeof magic) != 0) {
-        return SLOW5_ERR_MAGIC;
+/*
+ * insert the read ID of the blow5 record in mem of bytes (including the record size), which is at offset of s5p
+ * only the start of the record is decompressed with the decode buffers of s5p, all of it if the index has columns
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+int slow5_idx_insert_mem(struct slow5_idx *index, struct slow5_file *s5p, const void *mem, size_t bytes, uint64_t offset) {
+    if (!s5p->meta.decode_ctx && !(s5p->meta.decode_ctx = slow5_decode_ctx_init())) {
+        return slow5_errno;
     }
+    const struct __slow5_press *record_press = s5p->compress ? s5p->compress->record_press : NULL;
+    enum slow5_press_method signal_method = s5p->compress ? s5p->compress->signal_press->method : SLOW5_COMPRESS_NONE;
+    const uint8_t *comp = (const uint8_t *) mem + sizeof (slow5_rec_size_t);
+    size_t len = bytes > sizeof (slow5_rec_size_t) ? bytes - sizeof (slow5_rec_size_t) : 0;
+    size_t want = SLOW5_IDX_PART_LEN;
+
+    for (int i = 0; len && i < 3; ++ i) {
+        size_t n;
+        const uint8_t *rec = (const uint8_t *) slow5_rec_depress_part_ctx(s5p->meta.decode_ctx, record_press, comp, len, want, &n);
+        struct slow5_idx_rec_read read;
+        int ret = rec ? slow5_idx_rec_parse(rec, n, signal_method, &read, &want) : 1;
+        if (ret < 0) {
+            return ret;
+        } else if (ret == 1) {
+            continue;
+        }
 
-    if (fread(&index->version.major, sizeof index->version.major, 1, index->fp) != 1 ||
-        fread(&index->version.minor, sizeof index->version.minor, 1, index->fp) != 1 ||
-        fread(&index->version.patch, sizeof index->version.patch, 1, index->fp) != 1) {
-        return SLOW5_ERR_IO;
+        uint64_t pos = index->pool_size; // of the record added
+        ret = slow5_idx_insert_read(index, read.read_id, read.read_group, read.len_raw_signal, offset, bytes);
+        if (ret != 0) {
+            SLOW5_ERROR("Inserting '%s' to index failed", read.read_id);
+            slow5_errno = SLOW5_ERR_OTH;
+        } else if (index->num_cols) {
+            // the whole record is parsed for the values of the columns
+            ret = slow5_rec_view_mem(comp, len, &index->view, s5p) != 0 ||
+                    slow5_idx_cols_view(index, pos, index->view) != 0;
+        }
+        free(read.read_id);
+        return ret ? slow5_errno : 0;
     }
 
-    if (slow5_is_version_compatible(index->version, max_supported) == 0){
-        SLOW5_ERROR("Index file version '" SLOW5_VERSION_STRING_FORMAT "' is higher than the max slow5 version '" SLOW5_VERSION_STRING "' supported by this slow5lib! Please re-index or use a newer version of slow5lib.",
-                index->version.major, index->version.minor, index->version.patch);
-        return SLOW5_ERR_VERSION;
-    }
+    SLOW5_ERROR("Malformed blow5 record of '%zu' bytes. Failed to get the read ID.", bytes);
+    return slow5_errno = SLOW5_ERR_RECPARSE;
+}
 
-    if (fseek(index->fp, SLOW5_INDEX_HEADER_SIZE_OFFSET, SEEK_SET) == -1) {
-        return SLOW5_ERR_IO;
-    }
+static void *slow5_idx_build_worker(void *voidarg) {
+    struct slow5_idx_build_arg *arg = (struct slow5_idx_build_arg *) voidarg;
+    struct slow5_decode_ctx ctx = { 0 };
+    uint8_t *buf = NULL;
+    size_t cap = 0;
 
-    while (1) {
-        slow5_rid_len_t read_id_len;
-        if (fread(&read_id_len, sizeof read_id_len, 1, index->fp) != 1) {
-            SLOW5_ERROR("Malformed slow5 index. Failed to read the read ID length.%s", feof(index->fp) ? " Missing index end of file marker." : "");
-            if (feof(index->fp)) {
-                slow5_errno = SLOW5_ERR_TRUNC;
-            } else {
-                slow5_errno = SLOW5_ERR_IO;
-            }
-            return slow5_errno;
+    pthread_mutex_lock(&arg->lock);
+    for (;;) {
+        while (!arg->todo && arg->scanning && !arg->err) {
+            pthread_cond_wait(&arg->cond, &arg->lock);
         }
-        char *read_id = (char *) malloc((read_id_len + 1) * sizeof *read_id); // +1 for '\0'
-        SLOW5_MALLOC_CHK(read_id);
-
-        size_t bytes_read;
-        if ((bytes_read = fread(read_id, sizeof *read_id, read_id_len, index->fp)) != read_id_len) {
-            free(read_id);
-            bytes_read += sizeof read_id_len;
-            const char eof[] = SLOW5_INDEX_EOF;
-            if (bytes_read == sizeof eof) {
-                /* check if eof marker */
-                int is_eof = slow5_is_eof(index->fp, eof, sizeof eof);
-                if (is_eof == -1) { /* io/mem error */
-                    SLOW5_ERROR("%s", "Internal error while checking for index eof marker.");
-                } else if (is_eof == -2) {
-                    SLOW5_ERROR("%s", "Malformed index. End of file marker found, but end of file not reached.");
-                } else if (is_eof == 1) {
-                    /* slow5_errno = SLOW5_ERR_EOF; */
-                    break;
-                }
-            } else {
-                slow5_errno = SLOW5_ERR_IO;
-            }
-            return slow5_errno;
+        struct slow5_idx_chunk *chunk = arg->todo;
+        if (!chunk || arg->err) {
+            break;
         }
-        read_id[read_id_len] = '\0'; // Add null byte
-
-        uint64_t offset;
-        uint64_t size;
-
-        if (fread(&offset, sizeof offset, 1, index->fp) != 1 ||
-                fread(&size, sizeof size, 1, index->fp) != 1) {
-            return SLOW5_ERR_IO;
+        arg->todo = chunk->next;
+        pthread_mutex_unlock(&arg->lock);
+
+        int err = 0;
+        int block = arg->s5p->compress && arg->s5p->compress->block_press->method != SLOW5_COMPRESS_NONE;
+        for (size_t i = 0; i < chunk->n; ++ i) {
+            if ((err = block ? slow5_idx_block_read(arg->s5p, chunk->offset[i], chunk->size[i], &buf, &cap, &ctx, &chunk->block[i], &chunk->num_block[i])
+                        : slow5_idx_rec_read(arg->s5p, chunk->offset[i], chunk->size[i], &buf, &cap, &ctx, &chunk->read[i])) != 0) {
+                break;
+            }
         }
 
-        if (slow5_idx_insert(index, read_id, offset, size) == -1) {
-            SLOW5_ERROR("Inserting '%s' to index failed", read_id);
-            // TODO handle error and free
-            return -1;
+        pthread_mutex_lock(&arg->lock);
+        if (err && !arg->err) {
+            arg->err = err;
+            pthread_cond_broadcast(&arg->cond);
         }
     }
+    pthread_mutex_unlock(&arg->lock);
 
-    return 0;
+    free(buf);
+    __slow5_decode_ctx_free_bufs(&ctx);
+    return NULL;
 }
 
-int slow5_idx_insert(struct slow5_idx *index, char *read_id, uint64_t offset, uint64_t size) {
-
-    int absent;
-    khint_t k = kh_put(slow5_s2i, index->hash, read_id, &absent);
-    if (absent == -1 || absent == 0) {
-        // TODO error if read_id duplicated?
-        SLOW5_ERROR("Read ID '%s' is duplicated", read_id);
-        return -1;
+/* add a full or last chunk for the threads, returns the first error of the threads so far */
+static int slow5_idx_build_push(struct slow5_idx_build_arg *arg, struct slow5_idx_chunk *chunk) {
+    pthread_mutex_lock(&arg->lock);
+    if (arg->tail) {
+        arg->tail->next = chunk;
+    } else {
+        arg->head = chunk;
     }
-
-    struct slow5_rec_idx *read_index = &kh_value(index->hash, k);
-
-    if (index->num_ids == index->cap_ids) {
-        // Realloc ids array
-        index->cap_ids = index->cap_ids ? index->cap_ids << 1 : 16; // TODO possibly integer overflow
-
-        char **tmp = (char **) realloc(index->ids, index->cap_ids * sizeof *tmp);
-        SLOW5_MALLOC_CHK(tmp);
-
-        index->ids = tmp;
+    arg->tail = chunk;
+    if (!arg->todo) {
+        arg->todo = chunk;
     }
+    pthread_cond_signal(&arg->cond);
+    int err = arg->err;
+    pthread_mutex_unlock(&arg->lock);
 
-    index->ids[index->num_ids ++] = read_id;
-
-    read_index->offset = offset;
-    read_index->size = size;
-
-    return 0;
+    return err;
 }
 
 /*
- * index, read_id cannot be NULL
- * returns -1 if read_id not in the index hash map, 0 otherwise
+ * walk the chain of blow5 record sizes from arg->start to the end of file marker
+ * and hand the records in chunks to the threads
+ * returns 0 on success or if a thread failed, <0 on error and sets slow5_errno
  */
-int slow5_idx_get(struct slow5_idx *index, const char *read_id, struct slow5_rec_idx *read_index) {
+static int slow5_idx_build_scan(struct slow5_idx_build_arg *arg) {
+    struct slow5_file *s5p = arg->s5p;
+    struct stat st;
+    if (fstat(s5p->meta.fd, &st) != 0) {
+        SLOW5_ERROR("Failed to get the size of slow5 file '%s': %s.", s5p->meta.pathname, strerror(errno));
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+    uint64_t file_size = st.st_size;
+
+    uint64_t offset = arg->start;
+    struct slow5_idx_chunk *chunk = NULL;
     int ret = 0;
+    while (1) {
+        slow5_rec_size_t record_size;
+        uint64_t left = file_size - offset;
+        if (left < sizeof record_size) {
+            const char eof[] = SLOW5_BINARY_EOF;
+            char tail[sizeof record_size];
+            if (left == sizeof eof && pread(s5p->meta.fd, tail, sizeof eof, offset) == sizeof eof &&
+                    memcmp(tail, eof, sizeof eof) == 0) {
+                break;
+            }
+            SLOW5_ERROR("Malformed blow5 record. Failed to read the record size.%s", left == 0 ? " Missing blow5 end of file marker." : "");
+            ret = slow5_errno = SLOW5_ERR_TRUNC;
+            break;
+        }
+        if (pread(s5p->meta.fd, &record_size, sizeof record_size, offset) != sizeof record_size) {
+            SLOW5_ERROR("Failed to read the blow5 record size at offset '%" PRIu64 "'.", offset);
+            ret = slow5_errno = SLOW5_ERR_IO;
+            break;
+        }
+        const char footer[] = SLOW5_INDEX_FOOTER_MAGIC;
+        if (memcmp(&record_size, footer, sizeof footer) == 0) { // an index footer, which ends the records unless an older slow5lib appended after it
+            int skip = slow5_idx_footer_skip(s5p->meta.fd, offset, file_size, &offset);
+            if (skip < 0) {
+                ret = skip;
+                break;
+            } else if (skip == 1) {
+                break;
+            }
+            continue;
+        }
+        if (record_size > left - sizeof record_size) {
+            SLOW5_ERROR("Malformed blow5 record at offset '%" PRIu64 "'. Record size '%" PRIu64 "' is beyond the end of file.", offset, record_size);
+            ret = slow5_errno = SLOW5_ERR_TRUNC;
+            break;
+        }
 
-    khint_t pos = kh_get(slow5_s2i, index->hash, read_id);
-    if (pos == kh_end(index->hash)) {
-        SLOW5_ERROR("Read ID '%s' was not found.", read_id)
-        ret = -1;
-    } else if (read_index) {
-        *read_index = kh_value(index->hash, pos);
+        if (!chunk) {
+            chunk = (struct slow5_idx_chunk *) malloc(sizeof *chunk);
+            SLOW5_MALLOC_CHK(chunk);
+            if (!chunk) {
+                ret = slow5_errno = SLOW5_ERR_MEM;
+                break;
+            }
+            chunk->n = 0;
+            chunk->next = NULL;
+        }
+        chunk->offset[chunk->n] = offset;
+        chunk->size[chunk->n] = sizeof record_size + record_size;
+        chunk->read[chunk->n].read_id = NULL;
+        chunk->read[chunk->n].pos = 0;
+        chunk->block[chunk->n] = NULL;
+        chunk->num_block[chunk->n] = 0;
+        offset += sizeof record_size + record_size;
+        ++ arg->num_recs;
+        if (++ chunk->n == SLOW5_IDX_BUILD_CHUNK) {
+            int err = slow5_idx_build_push(arg, chunk);
+            chunk = NULL;
+            if (err) {
+                break;
+            }
+        }
     }
+    if (chunk) {
+        slow5_idx_build_push(arg, chunk);
+    }
+    arg->end = offset;
 
     return ret;
 }
 
 /*
- * SLOW5_ERR_IO - issue closing index file pointer, check errno for details
+ * index the records of a blow5 file from offset start using num_thread threads
+ * the calling thread walks the record sizes while the others read and decompress the start of each record to get its read ID
+ * return 0 on success
+ * return <0 on failure and sets slow5_errno
  */
-void slow5_idx_free(struct slow5_idx *index) {
-    if (index == NULL) {
-        return;
+static int slow5_idx_build_binary(struct slow5_idx *index, struct slow5_file *s5p, uint64_t start, int num_thread) {
+    struct slow5_idx_build_arg arg = { 0 };
+    arg.s5p = s5p;
+    arg.start = start;
+    arg.scanning = 1;
+    pthread_mutex_init(&arg.lock, NULL);
+    pthread_cond_init(&arg.cond, NULL);
+
+    int32_t num_tids = num_thread > 1 ? num_thread - 1 : 0;
+    pthread_t *tids = NULL;
+    int32_t started = 0;
+    if (num_tids > 0 && !(tids = (pthread_t *) malloc(num_tids * sizeof *tids))) {
+        SLOW5_MALLOC_ERROR();
+        num_tids = 0;
     }
-
-    if (index->fp != NULL) {
-        if (fclose(index->fp) == EOF) {
-            SLOW5_ERROR("Failure when closing index file: %s", strerror(errno));
-            slow5_errno = SLOW5_ERR_IO;
+    for (; started < num_tids; ++ started) {
+        if (pthread_create(&tids[started], NULL, slow5_idx_build_worker, &arg) != 0) {
+            SLOW5_WARNING("Failed to create thread %d of %d, continuing with fewer.", started + 1, num_tids);
+            break;
+        }
+    }
+
+    int ret = slow5_idx_build_scan(&arg);
+
+    /* the calling thread helps with what is left */
+    pthread_mutex_lock(&arg.lock);
+    if (ret && !arg.err) {
+        arg.err = ret;
+    }
+    arg.scanning = 0;
+    pthread_cond_broadcast(&arg.cond);
+    pthread_mutex_unlock(&arg.lock);
+    slow5_idx_build_worker(&arg);
+    for (int32_t t = 0; t < started; ++ t) {
+        pthread_join(tids[t], NULL);
+    }
+    free(tids);
+    pthread_mutex_destroy(&arg.lock);
+    pthread_cond_destroy(&arg.cond);
+
+    /* insert in file order, into a table sized for all the records at once */
+    ret = arg.err;
+    uint64_t num_recs = arg.num_recs;
+    for (struct slow5_idx_chunk *chunk = arg.head; chunk; chunk = chunk->next) {
+        for (size_t i = 0; i < chunk->n; ++ i) {
+            if (chunk->block[i]) {
+                num_recs += chunk->num_block[i] - 1;
+            }
+        }
+    }
+    if (!ret && slow5_idx_reserve(index, num_recs) != 0) {
+        ret = slow5_errno;
+    }
+    struct slow5_idx_chunk *chunk = arg.head;
+    while (chunk) {
+        for (size_t i = 0; i < chunk->n; ++ i) {
+            // a record on its own is a block of one
+            struct slow5_idx_rec_read *read = chunk->block[i] ? chunk->block[i] : chunk->read + i;
+            uint64_t num_read = chunk->block[i] ? chunk->num_block[i] : 1;
+            for (uint64_t j = 0; j < num_read; ++ j) {
+                index->block_pos = read[j].pos;
+                if (!ret && slow5_idx_insert_read(index, read[j].read_id, read[j].read_group, read[j].len_raw_signal,
+                            chunk->offset[i], chunk->size[i]) != 0) {
+                    ret = slow5_errno = SLOW5_ERR_OTH;
+                }
+                free(read[j].read_id);
+            }
+            free(chunk->block[i]);
+        }
+        struct slow5_idx_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    if (ret) {
+        slow5_errno = ret;
+    } else {
+        index->data_size = arg.end;
+    }
+    return ret;
+}
+
+/*
+ * index the records of s5p from offset start (s5p->meta.start_rec_offset for all of them)
+ * return 0 on success
+ * return <0 on failure
+ * TODO fix error handling
+ */
+static int slow5_idx_build(struct slow5_idx *index, struct slow5_file *s5p, uint64_t start, int num_thread) {
+
+    int block = s5p->compress && s5p->compress->block_press->method != SLOW5_COMPRESS_NONE;
+    if (!index->pool_size) {
+        index->block = block;
+    } else if (index->block != block) {
+        SLOW5_ERROR("%s", "Index of records in blocks does not match slow5 file.");
+        return -1;
+    }
+
+    uint64_t curr_offset = ftello(s5p->fp);
+    if (fseeko(s5p->fp, start, SEEK_SET) != 0) {
+        return -1;
+    }
+
+    uint64_t offset = 0;
+    uint64_t size = 0;
+
+    if (s5p->format == SLOW5_FORMAT_ASCII) {
+        size_t cap = BUF_INIT_CAP;
+        char *buf = (char *) malloc(cap * sizeof *buf);
+        SLOW5_MALLOC_CHK(buf);
+        ssize_t buf_len;
+
+        offset = ftello(s5p->fp);
+        while ((buf_len = getline(&buf, &cap, s5p->fp)) != -1) { // TODO this return is closer int64_t not unsigned
+            size = buf_len;
+
+            if (slow5_idx_insert_line(index, buf, offset, size) != 0) {
+                free(buf);
+                return -1;
+            }
+            offset += buf_len;
+        }
+        index->data_size = offset;
+
+        free(buf);
+
+    } else if (s5p->format == SLOW5_FORMAT_BINARY) {
+        if (slow5_idx_build_binary(index, s5p, start, num_thread) != 0) {
+            return -1;
+        }
+    }
+
+    if (fseeko(s5p->fp, curr_offset, SEEK_SET != 0)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* murmur3 finaliser */
+static inline uint64_t slow5_idx_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= UINT64_C(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+    return h;
+}
+
+/* 64-bit hash of a read ID, 8 bytes at a time, fixed as it is stored in v2 index files */
+static inline uint64_t slow5_idx_hash(const char *read_id, size_t len) {
+    const uint64_t m = UINT64_C(0x9e3779b97f4a7c15);
+    uint64_t h = len * m;
+    uint64_t w;
+    for (; len >= sizeof w; len -= sizeof w, read_id += sizeof w) {
+        memcpy(&w, read_id, sizeof w);
+        h = (h ^ w) * m;
+        h ^= h >> 29;
+    }
+    w = 0;
+    memcpy(&w, read_id, len);
+    h = (h ^ w) * m;
+    return slow5_idx_mix(h);
+}
+
+/* hash of a binary UUID, fixed as it is stored in v2 index files */
+static inline uint64_t slow5_idx_hash_uuid(const uint8_t *uuid) {
+    uint64_t lo;
+    uint64_t hi;
+    memcpy(&lo, uuid, sizeof lo);
+    memcpy(&hi, uuid + sizeof lo, sizeof hi);
+    return slow5_idx_mix(lo ^ slow5_idx_mix(hi));
+}
+
+/*
+ * parse a canonical UUID read ID of len bytes (lowercase 8-4-4-4-12 hex digits) into its 16 bytes
+ * returns 1 if it is one, 0 otherwise
+ */
+static int slow5_idx_uuid_parse(const char *read_id, size_t len, uint8_t *uuid) {
+    // positions of the hex digit pairs
+    static const uint8_t pos[16] = { 0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34 };
+    if (len != SLOW5_INDEX_UUID_LEN ||
+            read_id[8] != '-' || read_id[13] != '-' || read_id[18] != '-' || read_id[23] != '-') {
+        return 0;
+    }
+    // 0x10 | hex digit value, 0 if not a lowercase hex digit
+    static const uint8_t hex[256] = {
+        ['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13, ['4'] = 0x14,
+        ['5'] = 0x15, ['6'] = 0x16, ['7'] = 0x17, ['8'] = 0x18, ['9'] = 0x19,
+        ['a'] = 0x1a, ['b'] = 0x1b, ['c'] = 0x1c, ['d'] = 0x1d, ['e'] = 0x1e, ['f'] = 0x1f,
+    };
+    uint8_t str[SLOW5_INDEX_UUID_LEN];
+    memcpy(str, read_id, sizeof str);
+    uint8_t out[16];
+    unsigned ok = 0x10;
+    for (size_t j = 0; j < sizeof pos; ++ j) {
+        unsigned hi = hex[str[pos[j]]];
+        unsigned lo = hex[str[pos[j] + 1]];
+        ok &= hi & lo;
+        out[j] = (uint8_t) (hi << 4 | (lo & 0xf));
+    }
+    memcpy(uuid, out, sizeof out);
+    return ok != 0;
+}
+
+/* write the canonical read ID of a binary UUID to str of SLOW5_INDEX_UUID_LEN + 1 bytes */
+static void slow5_idx_uuid_str(const uint8_t *uuid, char *str) {
+    const char hex[] = "0123456789abcdef";
+    for (size_t i = 0, j = 0; i < SLOW5_INDEX_UUID_LEN; ++ i) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            str[i] = '-';
+        } else {
+            str[i] = hex[uuid[j] >> 4];
+            str[++ i] = hex[uuid[j ++] & 0xf];
+        }
+    }
+    str[SLOW5_INDEX_UUID_LEN] = '\0';
+}
+
+// a read ID to find or insert
+struct slow5_idx_key {
+    const char *read_id;
+    size_t len;
+    int is_uuid;
+    uint8_t uuid[16];
+    uint64_t hash;
+};
+
+static inline void slow5_idx_key_init(struct slow5_idx_key *key, const char *read_id) {
+    key->read_id = read_id;
+    key->len = strlen(read_id);
+    key->is_uuid = slow5_idx_uuid_parse(read_id, key->len, key->uuid);
+    key->hash = key->is_uuid ? slow5_idx_hash_uuid(key->uuid) : slow5_idx_hash(read_id, key->len);
+}
+
+/* number of hash buckets for num_ids read IDs: a power of 2 keeping the load under 3/4 */
+static inline uint64_t slow5_idx_num_buckets(uint64_t num_ids) {
+    uint64_t num_buckets = 8;
+    while (num_buckets - num_buckets / 4 <= num_ids) {
+        num_buckets <<= 1;
+    }
+    return num_buckets;
+}
+
+/* bytes of a record in the pool before its read ID: its entry, column values and position in its block */
+static inline uint64_t slow5_idx_rec_head(const struct slow5_idx *index) {
+    return sizeof (struct slow5_idx_entry) + (uint64_t) index->num_cols * SLOW5_INDEX_COL_SIZE +
+            (index->block ? sizeof index->block_pos : 0);
+}
+
+/* bytes of a record in the pool with a key */
+static inline uint64_t slow5_idx_rec_bytes(const struct slow5_idx *index, const struct slow5_idx_key *key) {
+    if (key->is_uuid) {
+        return slow5_idx_rec_head(index) + sizeof key->uuid;
+    }
+    return slow5_idx_rec_head(index) + ((key->len + 1 + 7) & ~(uint64_t) 7); // +1 for '\0'
+}
+
+/*
+ * set key to the read ID of the record at rec in the pool (without its hash)
+ * returns 0 on success, <0 on error (e.g. a malformed mapped index) and sets slow5_errno
+ */
+static int slow5_idx_rec_key(const struct slow5_idx *index, uint64_t rec, struct slow5_idx_key *key) {
+    struct slow5_idx_entry entry;
+    uint64_t id = rec + slow5_idx_rec_head(index);
+    if (id < rec || id >= index->pool_size) {
+        SLOW5_ERROR("Malformed slow5 index. Invalid record at offset '%" PRIu64 "'.", rec);
+        slow5_errno = SLOW5_ERR_RECPARSE;
+        return slow5_errno;
+    }
+    memcpy(&entry, index->pool + rec, sizeof entry);
+    key->read_id = (const char *) index->pool + id;
+    key->is_uuid = (entry.size & SLOW5_INDEX_UUID_FLAG) != 0;
+    if (key->is_uuid) {
+        key->len = SLOW5_INDEX_UUID_LEN;
+        if (index->pool_size - id < sizeof key->uuid) {
+            SLOW5_ERROR("Malformed slow5 index. Invalid record at offset '%" PRIu64 "'.", rec);
+            slow5_errno = SLOW5_ERR_RECPARSE;
+            return slow5_errno;
+        }
+        memcpy(key->uuid, key->read_id, sizeof key->uuid);
+    } else {
+        key->len = strnlen(key->read_id, index->pool_size - id);
+        if (key->len == index->pool_size - id) {
+            SLOW5_ERROR("Malformed slow5 index. Invalid record at offset '%" PRIu64 "'.", rec);
+            slow5_errno = SLOW5_ERR_RECPARSE;
+            return slow5_errno;
+        }
+    }
+    return 0;
+}
+
+/*
+ * find the bucket of key
+ * returns the bucket and sets *found to 1, or the empty bucket where it would go and *found to 0
+ * only the record of a bucket with the same hash is compared, bounds checked for a mapped index
+ */
+static uint64_t slow5_idx_find(const struct slow5_idx *index, const struct slow5_idx_key *key, int *found) {
+    uint64_t mask = index->num_buckets - 1;
+    uint64_t j = key->hash & mask;
+    uint64_t head = slow5_idx_rec_head(index);
+    *found = 0;
+    for (uint64_t probe = 0; probe < index->num_buckets; ++ probe) {
+        const struct slow5_idx_bucket *bucket = index->buckets + j;
+        if (!bucket->rec) {
+            return j;
+        }
+        if (bucket->hash == key->hash && index->pool_size >= head && bucket->rec - 1 <= index->pool_size - head) {
+            struct slow5_idx_entry entry;
+            memcpy(&entry, index->pool + bucket->rec - 1, sizeof entry);
+            uint64_t id = bucket->rec - 1 + head;
+            uint64_t left = index->pool_size - id;
+            if (key->is_uuid ? (entry.size & SLOW5_INDEX_UUID_FLAG) && left >= sizeof key->uuid &&
+                        memcmp(index->pool + id, key->uuid, sizeof key->uuid) == 0
+                    : !(entry.size & SLOW5_INDEX_UUID_FLAG) && left > key->len &&
+                        memcmp(index->pool + id, key->read_id, key->len + 1) == 0) {
+                *found = 1;
+                return j;
+            }
+        }
+        j = (j + 1) & mask;
+    }
+    return index->num_buckets; // full, only if a mapped index is malformed
+}
+
+/*
+ * move the read IDs to num_buckets buckets, using their cached hashes
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_idx_rehash(struct slow5_idx *index, uint64_t num_buckets) {
+    struct slow5_idx_bucket *buckets = (struct slow5_idx_bucket *) calloc(num_buckets, sizeof *buckets);
+    if (!buckets) {
+        SLOW5_MALLOC_ERROR();
+        slow5_errno = SLOW5_ERR_MEM;
+        return slow5_errno;
+    }
+    for (uint64_t i = 0; i < index->num_buckets; ++ i) {
+        if (index->buckets[i].rec) {
+            uint64_t j = index->buckets[i].hash & (num_buckets - 1);
+            while (buckets[j].rec) {
+                j = (j + 1) & (num_buckets - 1);
+            }
+            buckets[j] = index->buckets[i];
+        }
+    }
+    free(index->buckets);
+    index->buckets = buckets;
+    index->num_buckets = num_buckets;
+
+    return 0;
+}
+
+// primary fields that can be index columns, in the order of slow5_idx_view_prim
+static const struct {
+    const char *name;
+    enum slow5_aux_type type;
+} slow5_idx_prim_cols[] = {
+    { "read_group",     SLOW5_UINT32_T },
+    { "digitisation",   SLOW5_DOUBLE },
+    { "offset",         SLOW5_DOUBLE },
+    { "range",          SLOW5_DOUBLE },
+    { "sampling_rate",  SLOW5_DOUBLE },
+    { "len_raw_signal", SLOW5_UINT64_T },
+};
+#define SLOW5_IDX_NUM_PRIM_COLS (sizeof slow5_idx_prim_cols / sizeof *slow5_idx_prim_cols)
+
+/* position of primary field name in slow5_idx_prim_cols, -1 if it is not one */
+static int slow5_idx_prim_col(const char *name) {
+    for (size_t i = 0; i < SLOW5_IDX_NUM_PRIM_COLS; ++ i) {
+        if (strcmp(name, slow5_idx_prim_cols[i].name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* the value of primary field i of slow5_idx_prim_cols in view */
+static const void *slow5_idx_view_prim(const struct slow5_rec_view *view, int i) {
+    switch (i) {
+        case 0: return &view->read_group;
+        case 1: return &view->digitisation;
+        case 2: return &view->offset;
+        case 3: return &view->range;
+        case 4: return &view->sampling_rate;
+        default: return &view->len_raw_signal;
+    }
+}
+
+/* position of column name in index, -1 if it has no such column */
+static int64_t slow5_idx_col_find(const struct slow5_idx *index, const char *name) {
+    for (uint32_t i = 0; i < index->num_cols; ++ i) {
+        if (strcmp(name, index->cols[i].name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void slow5_idx_cols_free(struct slow5_idx_col *cols, uint32_t num_cols) {
+    if (cols) {
+        for (uint32_t i = 0; i < num_cols; ++ i) {
+            free(cols[i].name);
+        }
+        free(cols);
+    }
+}
+
+/*
+ * set the columns of an index without records to a copy of cols
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_idx_cols_set(struct slow5_idx *index, const struct slow5_idx_col *cols, uint32_t num_cols) {
+    struct slow5_idx_col *copy = (struct slow5_idx_col *) calloc(num_cols ? num_cols : 1, sizeof *copy);
+    if (!copy) {
+        SLOW5_MALLOC_ERROR();
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+    for (uint32_t i = 0; i < num_cols; ++ i) {
+        copy[i].type = cols[i].type;
+        if (!(copy[i].name = strdup(cols[i].name))) {
+            SLOW5_MALLOC_ERROR();
+            slow5_idx_cols_free(copy, i);
+            return slow5_errno = SLOW5_ERR_MEM;
+        }
+    }
+    slow5_idx_cols_free(index->cols, index->num_cols);
+    index->cols = copy;
+    index->num_cols = num_cols;
+    return 0;
+}
+
+/* 1 if indexes x and y have the same columns, 0 otherwise */
+static int slow5_idx_cols_same(const struct slow5_idx *x, const struct slow5_idx *y) {
+    if (x->num_cols != y->num_cols) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < x->num_cols; ++ i) {
+        if (x->cols[i].type != y->cols[i].type || strcmp(x->cols[i].name, y->cols[i].name) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* bytes of the columns in an index file, a multiple of 8 */
+static uint64_t slow5_idx_cols_size(const struct slow5_idx *index) {
+    uint64_t size = 0;
+    for (uint32_t i = 0; i < index->num_cols; ++ i) {
+        size += sizeof (uint8_t) + strlen(index->cols[i].name) + 1; // type, then name and '\0'
+    }
+    return (size + 7) & ~UINT64_C(7);
+}
+
+/*
+ * set the columns of an index without records to the fields names[0..num_cols-1] of blow5 file s5p
+ * a field is a primary field other than the read ID and raw signal, or an auxiliary field of a primitive type or a string
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_idx_cols_init(struct slow5_idx *index, const struct slow5_file *s5p, const char **names, uint32_t num_cols) {
+    if (s5p->format != SLOW5_FORMAT_BINARY) {
+        SLOW5_ERROR("Index columns are only available for BLOW5 files, not '%s'.", s5p->meta.pathname);
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    struct slow5_idx_col *cols = (struct slow5_idx_col *) calloc(num_cols ? num_cols : 1, sizeof *cols);
+    if (!cols) {
+        SLOW5_MALLOC_ERROR();
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+
+    const struct slow5_aux_meta *aux_meta = s5p->header->aux_meta;
+    int ret = 0;
+    for (uint32_t i = 0; i < num_cols; ++ i) {
+        if (!names[i]) {
+            SLOW5_ERROR("Index column '%" PRIu32 "' cannot be NULL.", i);
+            ret = slow5_errno = SLOW5_ERR_ARG;
+            break;
+        }
+        for (uint32_t j = 0; j < i; ++ j) {
+            if (strcmp(names[i], names[j]) == 0) {
+                SLOW5_ERROR("Index column '%s' is duplicated.", names[i]);
+                ret = slow5_errno = SLOW5_ERR_ARG;
+            }
+        }
+        if (ret) {
+            break;
+        }
+        cols[i].name = (char *) names[i];
+        int prim = slow5_idx_prim_col(names[i]);
+        if (prim >= 0) {
+            cols[i].type = slow5_idx_prim_cols[prim].type;
+            continue;
+        }
+        khint_t pos = aux_meta ? kh_get(slow5_s2ui32, aux_meta->attr_to_pos, names[i]) : 0;
+        if (!aux_meta || pos == kh_end(aux_meta->attr_to_pos)) {
+            SLOW5_ERROR("Field '%s' not found in slow5 file '%s'.", names[i], s5p->meta.pathname);
+            ret = slow5_errno = SLOW5_ERR_NOFLD;
+            break;
+        }
+        cols[i].type = aux_meta->types[kh_val(aux_meta->attr_to_pos, pos)];
+        if (SLOW5_IS_PTR(cols[i].type) && cols[i].type != SLOW5_STRING) {
+            SLOW5_ERROR("Field '%s' is an array which cannot be an index column.", names[i]);
+            ret = slow5_errno = SLOW5_ERR_TYPE;
+        }
+    }
+
+    if (!ret) {
+        ret = slow5_idx_cols_set(index, cols, num_cols);
+    }
+    free(cols); // the names were borrowed
+    return ret;
+}
+
+/*
+ * set the column values of the record at rec in the pool from a view of its blow5 record
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_idx_cols_view(struct slow5_idx *index, uint64_t rec, const struct slow5_rec_view *view) {
+    uint8_t *value = index->pool + rec + sizeof (struct slow5_idx_entry);
+    for (uint32_t i = 0; i < index->num_cols; ++ i, value += SLOW5_INDEX_COL_SIZE) {
+        const struct slow5_idx_col *col = index->cols + i;
+        uint64_t len = 1;
+        const void *data;
+        int prim = slow5_idx_prim_col(col->name);
+        if (prim >= 0) {
+            data = slow5_idx_view_prim(view, prim);
+        } else if (!(data = slow5_rec_view_aux_get(view, col->name, &len, NULL))) {
+            return slow5_errno;
+        }
+        uint64_t size = len * SLOW5_AUX_TYPE_META[col->type].size;
+        if (size > SLOW5_INDEX_COL_SIZE) {
+            SLOW5_ERROR("Value of index column '%s' of read ID '%.*s' is longer than %d bytes.",
+                    col->name, (int) view->read_id_len, view->read_id, SLOW5_INDEX_COL_SIZE);
+            return slow5_errno = SLOW5_ERR_TYPE;
+        }
+        memset(value, 0, SLOW5_INDEX_COL_SIZE);
+        memcpy(value, data, size);
+    }
+    return 0;
+}
+
+/*
+ * fill the column values of the records in the pool from rec on, reading their blow5 records from s5p
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_idx_cols_fill(struct slow5_idx *index, struct slow5_file *s5p, uint64_t rec) {
+    char *buf = NULL;
+    size_t cap = 0;
+    struct slow5_decode_ctx ctx = { 0 }; // the block of the last record, each block is decompressed once
+    const char *blk = NULL;
+    size_t blk_len = 0;
+    uint64_t blk_offset = 0;
+    int ret = 0;
+    while (index->num_cols && rec < index->pool_size) {
+        struct slow5_idx_key key;
+        if (slow5_idx_rec_key(index, rec, &key) != 0) {
+            ret = slow5_errno;
+            break;
+        }
+        struct slow5_idx_entry entry;
+        memcpy(&entry, index->pool + rec, sizeof entry);
+        uint64_t size = entry.size & ~SLOW5_INDEX_UUID_FLAG;
+        size_t bytes = size > sizeof (slow5_rec_size_t) ? size - sizeof (slow5_rec_size_t) : 0;
+        const char *mem;
+        if (index->block) {
+            if (!blk || entry.offset != blk_offset) {
+                if (!(blk = slow5_idx_block_depress(s5p, entry.offset, size, (uint8_t **) &buf, &cap, &ctx, &blk_len))) {
+                    ret = slow5_errno;
+                    break;
+                }
+                blk_offset = entry.offset;
+            }
+            uint64_t pos;
+            slow5_rec_size_t rec_size;
+            memcpy(&pos, index->pool + rec + slow5_idx_rec_head(index) - sizeof pos, sizeof pos);
+            if (pos > blk_len || blk_len - pos < sizeof rec_size ||
+                    (memcpy(&rec_size, blk + pos, sizeof rec_size), rec_size > blk_len - pos - sizeof rec_size)) {
+                SLOW5_ERROR("Malformed blow5 block at offset '%" PRIu64 "'. Record at '%" PRIu64 "' is beyond the end of the block.", entry.offset, pos);
+                ret = slow5_errno = SLOW5_ERR_RECPARSE;
+                break;
+            }
+            mem = blk + pos + sizeof rec_size;
+            bytes = rec_size;
+        } else {
+            if (slow5_buf_reserve((void **) &buf, &cap, bytes ? bytes : 1) != 0) {
+                ret = slow5_errno;
+                break;
+            }
+            if (pread(s5p->meta.fd, buf, bytes, entry.offset + sizeof (slow5_rec_size_t)) != (ssize_t) bytes) {
+                SLOW5_ERROR("Failed to read the blow5 record at offset '%" PRIu64 "'.", entry.offset);
+                ret = slow5_errno = SLOW5_ERR_IO;
+                break;
+            }
+            mem = buf;
+        }
+        if (slow5_rec_view_mem(mem, bytes, &index->view, s5p) != 0 || slow5_idx_cols_view(index, rec, index->view) != 0) {
+            ret = slow5_errno;
+            break;
+        }
+        rec += slow5_idx_rec_bytes(index, &key);
+    }
+    free(buf);
+    __slow5_decode_ctx_free_bufs(&ctx);
+    return ret;
+}
+
+/*
+ * write an index in the v2 layout to fp from its magic number to its end of file marker
+ * returns 0 on success, <0 on error
+ */
+static int slow5_idx_fwrite(struct slow5_idx *index, struct slow5_version version, FILE *fp) {
+
+    if (!index->num_buckets && slow5_idx_rehash(index, slow5_idx_num_buckets(0)) != 0) {
+        return slow5_errno;
+    }
+
+    const char magic[] = SLOW5_INDEX_MAGIC_NUMBER_V2;
+    if (fwrite(magic, sizeof *magic, sizeof magic, fp) != sizeof magic) {
+        return SLOW5_ERR_IO;
+    }
+
+    if (fwrite(&version.major, sizeof version.major, 1, fp) != 1 ||
+            fwrite(&version.minor, sizeof version.minor, 1, fp) != 1 ||
+            fwrite(&version.patch, sizeof version.patch, 1, fp) != 1) {
+        return SLOW5_ERR_IO;
+    }
+
+    const uint8_t zeroes[SLOW5_INDEX_HEADER_SIZE_OFFSET] = { 0 };
+    uint8_t padding = 16 -
+            sizeof magic * sizeof *magic -
+            sizeof version.major -
+            sizeof version.minor -
+            sizeof version.patch;
+    uint64_t num_cols = index->num_cols;
+    uint64_t cols_size = slow5_idx_cols_size(index);
+    uint64_t num_stats = index->num_stats;
+    uint64_t meta_size = cols_size + (index->no_stats ? 0 : sizeof num_stats + num_stats * sizeof *index->stats);
+    uint8_t padding_hdr = SLOW5_INDEX_HEADER_SIZE_OFFSET - 16 -
+            sizeof index->num_ids -
+            sizeof index->num_buckets -
+            sizeof index->pool_size -
+            sizeof index->data_size -
+            sizeof num_cols -
+            sizeof meta_size;
+    uint8_t flags = index->block ? SLOW5_INDEX_FLAG_BLOCK : 0;
+    if (fwrite(&flags, sizeof flags, 1, fp) != 1 ||
+            fwrite(zeroes, sizeof *zeroes, padding - sizeof flags, fp) != padding - sizeof flags ||
+            fwrite(&index->num_ids, sizeof index->num_ids, 1, fp) != 1 ||
+            fwrite(&index->num_buckets, sizeof index->num_buckets, 1, fp) != 1 ||
+            fwrite(&index->pool_size, sizeof index->pool_size, 1, fp) != 1 ||
+            fwrite(&index->data_size, sizeof index->data_size, 1, fp) != 1 ||
+            fwrite(&num_cols, sizeof num_cols, 1, fp) != 1 ||
+            fwrite(&meta_size, sizeof meta_size, 1, fp) != 1 ||
+            fwrite(zeroes, sizeof *zeroes, padding_hdr, fp) != padding_hdr) {
+        return SLOW5_ERR_IO;
+    }
+
+    uint64_t cols_written = 0;
+    for (uint32_t i = 0; i < index->num_cols; ++ i) {
+        uint8_t type = index->cols[i].type;
+        size_t len = strlen(index->cols[i].name) + 1; // +1 for '\0'
+        if (fwrite(&type, sizeof type, 1, fp) != 1 ||
+                fwrite(index->cols[i].name, 1, len, fp) != len) {
+            return SLOW5_ERR_IO;
+        }
+        cols_written += sizeof type + len;
+    }
+    if (fwrite(zeroes, sizeof *zeroes, cols_size - cols_written, fp) != cols_size - cols_written) {
+        return SLOW5_ERR_IO;
+    }
+    if (!index->no_stats &&
+            (fwrite(&num_stats, sizeof num_stats, 1, fp) != 1 ||
+             fwrite(index->stats, sizeof *index->stats, num_stats, fp) != num_stats)) {
+        return SLOW5_ERR_IO;
+    }
+
+    if (fwrite(index->buckets, sizeof *index->buckets, index->num_buckets, fp) != index->num_buckets ||
+            fwrite(index->pool, sizeof *index->pool, index->pool_size, fp) != index->pool_size) {
+        return SLOW5_ERR_IO;
+    }
+
+    const char eof[] = SLOW5_INDEX_EOF;
+    if (fwrite(eof, sizeof *eof, sizeof eof, fp) != sizeof eof) {
+        return SLOW5_ERR_IO;
+    }
+
+    return 0;
+}
+
+/*
+ * write an index in the v1 layout to fp, which has no columns, statistics or blocks
+ * returns 0 on success, <0 on error
+ */
+static int slow5_idx_fwrite_v1(struct slow5_idx *index, struct slow5_version version, FILE *fp) {
+
+    const char magic[] = SLOW5_INDEX_MAGIC_NUMBER;
+    if (fwrite(magic, sizeof *magic, sizeof magic, fp) != sizeof magic) {
+        return SLOW5_ERR_IO;
+    }
+
+    if (fwrite(&version.major, sizeof version.major, 1, fp) != 1 ||
+            fwrite(&version.minor, sizeof version.minor, 1, fp) != 1 ||
+            fwrite(&version.patch, sizeof version.patch, 1, fp) != 1) {
+        return SLOW5_ERR_IO;
+    }
+
+    const uint8_t zeroes[SLOW5_INDEX_HEADER_SIZE_OFFSET] = { 0 };
+    uint8_t padding = SLOW5_INDEX_HEADER_SIZE_OFFSET -
+            sizeof magic * sizeof *magic -
+            sizeof version.major -
+            sizeof version.minor -
+            sizeof version.patch;
+    if (fwrite(zeroes, sizeof *zeroes, padding, fp) != padding) {
+        return SLOW5_ERR_IO;
+    }
+
+    uint64_t rec = 0;
+    for (uint64_t i = 0; i < index->num_ids; ++ i) {
+        struct slow5_idx_key key;
+        if (slow5_idx_rec_key(index, rec, &key) != 0) {
+            return slow5_errno;
+        }
+        char uuid[SLOW5_INDEX_UUID_LEN + 1];
+        if (key.is_uuid) {
+            slow5_idx_uuid_str(key.uuid, uuid);
+        }
+        const char *read_id = key.is_uuid ? uuid : key.read_id;
+        struct slow5_idx_entry entry;
+        memcpy(&entry, index->pool + rec, sizeof entry);
+        uint64_t size = entry.size & ~SLOW5_INDEX_UUID_FLAG;
+
+        slow5_rid_len_t read_id_len = key.len;
+        if (fwrite(&read_id_len, sizeof read_id_len, 1, fp) != 1 ||
+                fwrite(read_id, sizeof *read_id, read_id_len, fp) != read_id_len ||
+                fwrite(&entry.offset, sizeof entry.offset, 1, fp) != 1 ||
+                fwrite(&size, sizeof size, 1, fp) != 1) {
+            return SLOW5_ERR_IO;
+        }
+        rec += slow5_idx_rec_bytes(index, &key);
+    }
+
+    const char eof[] = SLOW5_INDEX_EOF;
+    if (fwrite(eof, sizeof *eof, sizeof eof, fp) != sizeof eof) {
+        return SLOW5_ERR_IO;
+    }
+
+    return 0;
+}
+
+/*
+ * write an index to its file index->pathname, in the v2 format if index->v2 or it has columns or blocks, otherwise in v1
+ * it is written to a new file renamed over the old one, never in place,
+ * so that processes which have the old one mapped can keep using it
+ * returns 0 on success, <0 on error
+ */
+int slow5_idx_write(struct slow5_idx *index, struct slow5_version version) {
+
+    char *tmp_pathname = NULL;
+    if (slow5_asprintf(&tmp_pathname, "%s.%ld.tmp", index->pathname, (long) getpid()) == -1) {
+        SLOW5_MALLOC_ERROR();
+        return SLOW5_ERR_MEM;
+    }
+    FILE *fp = fopen(tmp_pathname, "w");
+    if (!fp) {
+        SLOW5_ERROR("Error opening index file '%s': %s.", tmp_pathname, strerror(errno));
+        free(tmp_pathname);
+        return SLOW5_ERR_IO;
+    }
+
+    int ret = index->v2 || index->num_cols || index->block ?
+            slow5_idx_fwrite(index, version, fp) : slow5_idx_fwrite_v1(index, version, fp);
+    if (fclose(fp) == EOF && ret == 0) {
+        ret = SLOW5_ERR_IO;
+    }
+    if (ret == 0 && rename(tmp_pathname, index->pathname) != 0) {
+        SLOW5_ERROR("Failed to rename '%s' to index file '%s': %s.", tmp_pathname, index->pathname, strerror(errno));
+        ret = SLOW5_ERR_IO;
+    }
+    if (ret != 0) {
+        remove(tmp_pathname);
+    }
+
+    free(tmp_pathname);
+    return ret;
+}
+
+/*
+ * map the v2 index of size bytes at offset start of fd, whose magic number and version have been read
+ * returns 0 on success, <0 on error
+ */
+static int slow5_idx_map(struct slow5_idx *index, int fd, uint64_t start, uint64_t size) {
+
+    uint64_t counts[6]; // num_ids, num_buckets, pool_size, data_size, num_cols, meta_size
+    const char eof[] = SLOW5_INDEX_EOF;
+    if (size < SLOW5_INDEX_HEADER_SIZE_OFFSET + sizeof eof) {
+        SLOW5_ERROR("Malformed slow5 index. Index size '%" PRIu64 "' is smaller than its header.", size);
+        return SLOW5_ERR_TRUNC;
+    }
+    uint8_t flags;
+    if (pread(fd, &flags, sizeof flags, start + 12) != sizeof flags ||
+            pread(fd, counts, sizeof counts, start + 16) != sizeof counts) {
+        return SLOW5_ERR_IO;
+    }
+    uint64_t num_ids = counts[0];
+    uint64_t num_buckets = counts[1];
+    uint64_t pool_size = counts[2];
+    index->data_size = counts[3];
+    uint64_t num_cols = counts[4];
+    uint64_t meta_size = counts[5];
+
+    if (num_buckets > size / sizeof *index->buckets ||
+            pool_size > size || meta_size > size ||
+            SLOW5_INDEX_HEADER_SIZE_OFFSET + meta_size + num_buckets * sizeof *index->buckets + pool_size + sizeof eof != size) {
+        SLOW5_ERROR("Malformed slow5 index. Index size '%" PRIu64 "' differs to the size in its header.", size);
+        return SLOW5_ERR_TRUNC;
+    }
+    if (num_cols > meta_size / 2 || meta_size % 8 != 0) {
+        SLOW5_ERROR("Malformed slow5 index. Invalid number of columns '%" PRIu64 "'.", num_cols);
+        return SLOW5_ERR_HDRPARSE;
+    }
+    if (num_buckets <= num_ids || (num_buckets & (num_buckets - 1)) != 0 ||
+            num_ids > pool_size / (sizeof (struct slow5_idx_entry) + num_cols * SLOW5_INDEX_COL_SIZE + 8)) {
+        SLOW5_ERROR("Malformed slow5 index. Invalid number of hash buckets '%" PRIu64 "'.", num_buckets);
+        return SLOW5_ERR_HDRPARSE;
+    }
+
+    // mmap offsets must be page aligned
+    uint64_t map_start = start - start % sysconf(_SC_PAGESIZE);
+    size_t map_size = size + (start - map_start);
+    void *map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, map_start);
+    if (map == MAP_FAILED) {
+        SLOW5_ERROR("Failed to mmap index file: %s.", strerror(errno));
+        return SLOW5_ERR_IO;
+    }
+
+    uint8_t *ptr = (uint8_t *) map + (start - map_start);
+    if (memcmp(ptr + size - sizeof eof, eof, sizeof eof) != 0) {
+        SLOW5_ERROR("%s", "Malformed slow5 index. Missing index end of file marker.");
+        munmap(map, map_size);
+        return SLOW5_ERR_TRUNC;
+    }
+
+    // columns, each a type then a '\0' terminated name
+    const uint8_t *col = ptr + SLOW5_INDEX_HEADER_SIZE_OFFSET;
+    const uint8_t *meta_end = col + meta_size;
+    struct slow5_idx_col *cols = (struct slow5_idx_col *) calloc(num_cols ? num_cols : 1, sizeof *cols);
+    if (!cols) {
+        SLOW5_MALLOC_ERROR();
+        munmap(map, map_size);
+        return SLOW5_ERR_MEM;
+    }
+    for (uint64_t i = 0; i < num_cols; ++ i) {
+        size_t len = col < meta_end ? strnlen((const char *) col + 1, meta_end - col - 1) : 0;
+        if (col + 1 + len >= meta_end || *col > SLOW5_ENUM_ARRAY || !(cols[i].name = strdup((const char *) col + 1))) {
+            SLOW5_ERROR("%s", "Malformed slow5 index. Invalid columns.");
+            slow5_idx_cols_free(cols, num_cols);
+            munmap(map, map_size);
+            return SLOW5_ERR_HDRPARSE;
+        }
+        cols[i].type = (enum slow5_aux_type) *col;
+        col += 1 + len + 1;
+    }
+
+    // then the statistics, absent if unknown
+    const uint8_t *meta = ptr + SLOW5_INDEX_HEADER_SIZE_OFFSET;
+    col = meta + (col - meta + 7) / 8 * 8;
+    uint64_t num_stats = 0;
+    struct slow5_stats *stats = NULL;
+    if (col < meta_end) {
+        if ((uint64_t) (meta_end - col) >= sizeof num_stats) {
+            memcpy(&num_stats, col, sizeof num_stats);
+            col += sizeof num_stats;
+        }
+        if (num_stats > UINT32_MAX || (uint64_t) (meta_end - col) != num_stats * sizeof *stats) {
+            SLOW5_ERROR("%s", "Malformed slow5 index. Invalid statistics.");
+            slow5_idx_cols_free(cols, num_cols);
+            munmap(map, map_size);
+            return SLOW5_ERR_HDRPARSE;
+        }
+        stats = (struct slow5_stats *) malloc(num_stats ? num_stats * sizeof *stats : 1);
+        if (!stats) {
+            SLOW5_MALLOC_ERROR();
+            slow5_idx_cols_free(cols, num_cols);
+            munmap(map, map_size);
+            return SLOW5_ERR_MEM;
+        }
+        memcpy(stats, col, num_stats * sizeof *stats);
+    }
+    free(index->stats);
+    index->stats = stats;
+    index->num_stats = num_stats;
+    index->no_stats = !stats;
+
+    slow5_idx_cols_free(index->cols, index->num_cols);
+    index->cols = cols;
+    index->num_cols = num_cols;
+
+    index->map = map;
+    index->map_size = map_size;
+    index->buckets = (struct slow5_idx_bucket *) (ptr + SLOW5_INDEX_HEADER_SIZE_OFFSET + meta_size);
+    index->num_buckets = num_buckets;
+    index->pool = (uint8_t *) (index->buckets + num_buckets);
+    index->pool_size = pool_size;
+    index->num_ids = num_ids;
+    index->block = (flags & SLOW5_INDEX_FLAG_BLOCK) != 0;
+    index->v2 = 1; // kept in v2 when written back
+    SLOW5_LOG_DEBUG("Memory-mapped index of '%" PRIu64 "' read IDs.", num_ids);
+
+    return 0;
+}
+
+/*
+ * copy a mapped index into memory so it can be changed
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_idx_unmap(struct slow5_idx *index) {
+
+    struct slow5_idx_bucket *buckets = (struct slow5_idx_bucket *) malloc(index->num_buckets * sizeof *buckets);
+    uint8_t *pool = (uint8_t *) malloc(index->pool_size ? index->pool_size : 1);
+    if (!buckets || !pool) {
+        SLOW5_MALLOC_ERROR();
+        free(buckets);
+        free(pool);
+        slow5_errno = SLOW5_ERR_MEM;
+        return slow5_errno;
+    }
+    memcpy(buckets, index->buckets, index->num_buckets * sizeof *buckets);
+    memcpy(pool, index->pool, index->pool_size);
+
+    munmap(index->map, index->map_size);
+    index->map = NULL;
+    index->map_size = 0;
+    index->buckets = buckets;
+    index->pool = pool;
+    index->pool_cap = index->pool_size ? index->pool_size : 1;
+    free(index->ids); // pointed into the map
+    free(index->uuids);
+    index->ids = NULL;
+    index->uuids = NULL;
+
+    return 0;
+}
+
+static int slow5_idx_read(struct slow5_idx *index, FILE *fp) {
+
+    struct slow5_version max_supported = SLOW5_VERSION_MAX_ARRAY;
+    const char magic[] = SLOW5_INDEX_MAGIC_NUMBER;
+    const char magic_v2[] = SLOW5_INDEX_MAGIC_NUMBER_V2;
+    char buf_magic[sizeof magic]; // TODO is this a vla?
+    if (fread(buf_magic, sizeof *magic, sizeof magic, fp) != sizeof magic) {
+        return SLOW5_ERR_IO;
+    }
+    int is_v2 = memcmp(magic_v2, buf_magic, sizeof *magic_v2 * sizeof magic_v2) == 0;
+    if (!is_v2 && memcmp(magic, buf_magic, sizeof *magic * sizeof magic) != 0) {
+        return SLOW5_ERR_MAGIC;
+    }
+
+    if (fread(&index->version.major, sizeof index->version.major, 1, fp) != 1 ||
+        fread(&index->version.minor, sizeof index->version.minor, 1, fp) != 1 ||
+        fread(&index->version.patch, sizeof index->version.patch, 1, fp) != 1) {
+        return SLOW5_ERR_IO;
+    }
+
+    if (slow5_is_version_compatible(index->version, max_supported) == 0){
+        SLOW5_ERROR("Index file version '" SLOW5_VERSION_STRING_FORMAT "' is higher than the max slow5 version '" SLOW5_VERSION_MAX_STRING "' supported by this slow5lib! Please re-index or use a newer version of slow5lib.",
+                index->version.major, index->version.minor, index->version.patch);
+        return SLOW5_ERR_VERSION;
+    }
+
+    if (is_v2) {
+        struct stat st;
+        if (fstat(fileno(fp), &st) == -1) {
+            SLOW5_ERROR("Failed to fstat index file: %s.", strerror(errno));
+            return SLOW5_ERR_IO;
+        }
+        return slow5_idx_map(index, fileno(fp), 0, st.st_size);
+    }
+
+    if (fseek(fp, SLOW5_INDEX_HEADER_SIZE_OFFSET, SEEK_SET) == -1) {
+        return SLOW5_ERR_IO;
+    }
+
+    char *read_id = NULL;
+    size_t read_id_cap = 0;
+    int ret = 0;
+    while (1) {
+        slow5_rid_len_t read_id_len;
+        if (fread(&read_id_len, sizeof read_id_len, 1, fp) != 1) {
+            SLOW5_ERROR("Malformed slow5 index. Failed to read the read ID length.%s", feof(fp) ? " Missing index end of file marker." : "");
+            if (feof(fp)) {
+                slow5_errno = SLOW5_ERR_TRUNC;
+            } else {
+                slow5_errno = SLOW5_ERR_IO;
+            }
+            ret = slow5_errno;
+            break;
+        }
+        if (slow5_buf_reserve((void **) &read_id, &read_id_cap, read_id_len + 1) != 0) { // +1 for '\0'
+            ret = slow5_errno;
+            break;
+        }
+
+        size_t bytes_read;
+        if ((bytes_read = fread(read_id, sizeof *read_id, read_id_len, fp)) != read_id_len) {
+            bytes_read += sizeof read_id_len;
+            const char eof[] = SLOW5_INDEX_EOF;
+            if (bytes_read == sizeof eof) {
+                /* check if eof marker */
+                int is_eof = slow5_is_eof(fp, eof, sizeof eof);
+                if (is_eof == -1) { /* io/mem error */
+                    SLOW5_ERROR("%s", "Internal error while checking for index eof marker.");
+                } else if (is_eof == -2) {
+                    SLOW5_ERROR("%s", "Malformed index. End of file marker found, but end of file not reached.");
+                } else if (is_eof == 1) {
+                    /* slow5_errno = SLOW5_ERR_EOF; */
+                    break;
+                }
+            } else {
+                slow5_errno = SLOW5_ERR_IO;
+            }
+            ret = slow5_errno;
+            break;
+        }
+        read_id[read_id_len] = '\0'; // Add null byte
+
+        uint64_t offset;
+        uint64_t size;
+
+        if (fread(&offset, sizeof offset, 1, fp) != 1 ||
+                fread(&size, sizeof size, 1, fp) != 1) {
+            ret = SLOW5_ERR_IO;
+            break;
+        }
+
+        if (slow5_idx_insert(index, read_id, offset, size) == -1) {
+            SLOW5_ERROR("Inserting '%s' to index failed", read_id);
+            ret = -1;
+            break;
         }
     }
 
-    for (uint64_t i = 0; i < index->num_ids; ++ i) {
-        free(index->ids[i]);
+    free(read_id);
+    return ret;
+}
+
+/* offset of the index image of a footer starting at offset, after the footer magic number and padding to 8 bytes */
+static inline uint64_t slow5_idx_footer_image(uint64_t offset) {
+    return (offset + sizeof (uint64_t) + 7) & ~UINT64_C(7);
+}
+
+/*
+ * write index as a footer at the current position of blow5 file fp, to be followed by the blow5 end of file marker
+ * returns 0 on success, <0 on error
+ */
+int slow5_idx_footer_write(struct slow5_idx *index, struct slow5_version version, FILE *fp) {
+
+    off_t offset = ftello(fp);
+    if (offset == -1) {
+        SLOW5_ERROR("Failed to get the position of the index footer: %s.", strerror(errno));
+        return SLOW5_ERR_IO;
+    }
+
+    const char magic[] = SLOW5_INDEX_FOOTER_MAGIC;
+    const uint8_t zeroes[8] = { 0 };
+    size_t padding = slow5_idx_footer_image(offset) - offset - sizeof magic;
+    if (fwrite(magic, sizeof *magic, sizeof magic, fp) != sizeof magic ||
+            fwrite(zeroes, sizeof *zeroes, padding, fp) != padding) {
+        return SLOW5_ERR_IO;
+    }
+
+    int ret = slow5_idx_fwrite(index, version, fp);
+    if (ret != 0) {
+        return ret;
+    }
+
+    uint64_t footer = offset;
+    if (fwrite(&footer, sizeof footer, 1, fp) != 1 ||
+            fwrite(magic, sizeof *magic, sizeof magic, fp) != sizeof magic) {
+        return SLOW5_ERR_IO;
+    }
+
+    return 0;
+}
+
+/*
+ * look for an index footer with one read of the trailer at the end of blow5 file fd
+ * returns 1 and sets *offset to the start of the footer if there is one, 0 if not, <0 on error and sets slow5_errno
+ */
+int slow5_idx_footer_offset(int fd, uint64_t *offset) {
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        SLOW5_ERROR("Failed to fstat blow5 file: %s.", strerror(errno));
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+
+    const char magic[] = SLOW5_INDEX_FOOTER_MAGIC;
+    const char eof[] = SLOW5_BINARY_EOF;
+    uint64_t footer;
+    uint8_t trailer[sizeof footer + sizeof magic + sizeof eof];
+    uint64_t file_size = st.st_size;
+    if (file_size < sizeof trailer) {
+        return 0;
+    }
+    if (pread(fd, trailer, sizeof trailer, file_size - sizeof trailer) != sizeof trailer) {
+        SLOW5_ERROR("Failed to read the end of blow5 file: %s.", strerror(errno));
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+    if (memcmp(trailer + sizeof footer, magic, sizeof magic) != 0 ||
+            memcmp(trailer + sizeof footer + sizeof magic, eof, sizeof eof) != 0) {
+        return 0;
+    }
+
+    memcpy(&footer, trailer, sizeof footer);
+    // records appended after an earlier footer (e.g. by an older slow5lib) are not in it, the index is then built again
+    uint64_t end;
+    if (slow5_idx_footer_end(fd, footer, &end) != 0 || end != file_size - sizeof eof) {
+        SLOW5_WARNING("%s", "Ignoring an index footer that does not end the blow5 file.");
+        return 0;
+    }
+    *offset = footer;
+    return 1;
+}
+
+/*
+ * get the end of the index footer starting at offset of blow5 file fd, after its trailer
+ * returns 0 on success, <0 if it is malformed and sets slow5_errno
+ */
+int slow5_idx_footer_end(int fd, uint64_t offset, uint64_t *end) {
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        SLOW5_ERROR("Failed to fstat blow5 file: %s.", strerror(errno));
+        return slow5_errno = SLOW5_ERR_IO;
+    }
+
+    const char magic[] = SLOW5_INDEX_FOOTER_MAGIC;
+    const char magic_v2[] = SLOW5_INDEX_MAGIC_NUMBER_V2;
+    const char eof[] = SLOW5_INDEX_EOF;
+    uint64_t file_size = st.st_size;
+    uint64_t start = slow5_idx_footer_image(offset);
+    char buf_magic[sizeof magic_v2];
+    uint64_t counts[6]; // num_ids, num_buckets, pool_size, data_size, num_cols, meta_size
+    if (pread(fd, buf_magic, sizeof buf_magic, start) != sizeof buf_magic ||
+            memcmp(buf_magic, magic_v2, sizeof magic_v2) != 0 ||
+            pread(fd, counts, sizeof counts, start + 16) != sizeof counts ||
+            counts[1] > file_size / sizeof (struct slow5_idx_bucket) || counts[2] > file_size || counts[5] > file_size) {
+        SLOW5_ERROR("Malformed index footer at offset '%" PRIu64 "'.", offset);
+        return slow5_errno = SLOW5_ERR_TRUNC;
+    }
+
+    // the index image then the trailer
+    uint64_t footer;
+    uint8_t trailer[sizeof footer + sizeof magic];
+    uint64_t trailer_start = start + SLOW5_INDEX_HEADER_SIZE_OFFSET + counts[5] + counts[1] * sizeof (struct slow5_idx_bucket) + counts[2] + sizeof eof;
+    if (pread(fd, trailer, sizeof trailer, trailer_start) != sizeof trailer ||
+            memcmp(trailer + sizeof footer, magic, sizeof magic) != 0 ||
+            memcmp(trailer, &offset, sizeof footer) != 0) {
+        SLOW5_ERROR("Malformed index footer at offset '%" PRIu64 "'. Missing its trailer.", offset);
+        return slow5_errno = SLOW5_ERR_TRUNC;
+    }
+
+    *end = trailer_start + sizeof trailer;
+    return 0;
+}
+
+/*
+ * skip the index footer starting at offset of blow5 file fd, which holds file_size bytes
+ * returns 1 if the records end at the footer (only the end of file marker follows it),
+ * 0 and sets *next to the offset after it if records follow it (e.g. appended by an older slow5lib), <0 on error and sets slow5_errno
+ */
+int slow5_idx_footer_skip(int fd, uint64_t offset, uint64_t file_size, uint64_t *next) {
+
+    const char eof[] = SLOW5_BINARY_EOF;
+    uint64_t end;
+    if (slow5_idx_footer_end(fd, offset, &end) != 0) {
+        return slow5_errno;
     }
+    if (end == file_size - sizeof eof) {
+        return 1;
+    }
+    SLOW5_WARNING("Records follow the index footer at offset '%" PRIu64 "' (e.g. appended by an older slow5lib), skipping it.", offset);
+    *next = end;
+    return 0;
+}
+
+/*
+ * load the index in the footer starting at offset of blow5 file s5p
+ * it is mapped read-only, or copied into memory if writable so that the footer can be overwritten
+ * returns NULL on error and sets slow5_errno
+ */
+struct slow5_idx *slow5_idx_footer_init(struct slow5_file *s5p, uint64_t offset, int writable) {
+
+    struct stat st;
+    if (fstat(s5p->meta.fd, &st) == -1) {
+        SLOW5_ERROR("Failed to fstat blow5 file '%s': %s.", s5p->meta.pathname, strerror(errno));
+        slow5_errno = SLOW5_ERR_IO;
+        return NULL;
+    }
+
+    const char magic[] = SLOW5_INDEX_FOOTER_MAGIC;
+    const char magic_v2[] = SLOW5_INDEX_MAGIC_NUMBER_V2;
+    const char eof[] = SLOW5_BINARY_EOF;
+    uint64_t trailer = sizeof offset + sizeof magic + sizeof eof;
+    uint64_t file_size = st.st_size;
+    uint64_t start = slow5_idx_footer_image(offset);
+    char buf_magic[sizeof magic];
+    uint8_t buf_hdr[16];
+    if (offset < s5p->meta.start_rec_offset || file_size < trailer || start > file_size - trailer ||
+            pread(s5p->meta.fd, buf_magic, sizeof buf_magic, offset) != sizeof buf_magic ||
+            memcmp(buf_magic, magic, sizeof magic) != 0 ||
+            pread(s5p->meta.fd, buf_hdr, sizeof buf_hdr, start) != sizeof buf_hdr ||
+            memcmp(buf_hdr, magic_v2, sizeof magic_v2) != 0) {
+        SLOW5_ERROR("Malformed index footer at offset '%" PRIu64 "' of blow5 file '%s'.", offset, s5p->meta.pathname);
+        slow5_errno = SLOW5_ERR_TRUNC;
+        return NULL;
+    }
+
+    struct slow5_idx *index = slow5_idx_init_empty();
+    if (!index) {
+        slow5_errno = SLOW5_ERR_MEM;
+        return NULL;
+    }
+    index->version.major = buf_hdr[sizeof magic_v2];
+    index->version.minor = buf_hdr[sizeof magic_v2 + 1];
+    index->version.patch = buf_hdr[sizeof magic_v2 + 2];
+
+    int ret = slow5_idx_map(index, s5p->meta.fd, start, file_size - trailer - start);
+    if (ret == 0 && writable) {
+        ret = slow5_idx_unmap(index);
+    }
+    if (ret != 0) {
+        slow5_idx_free(index);
+        slow5_errno = ret;
+        return NULL;
+    }
+    SLOW5_LOG_DEBUG("Loaded the index footer of blow5 file '%s'.", s5p->meta.pathname);
+
+    return index;
+}
+
+/*
+ * add the read ID of key (copied into the pool) with the offset and size of its record
+ * returns 0 on success, -1 on error (e.g. the read ID is duplicated)
+ */
+static int slow5_idx_insert_key(struct slow5_idx *index, const struct slow5_idx_key *key, uint64_t offset, uint64_t size) {
+
+    if (index->num_buckets - index->num_buckets / 4 <= index->num_ids &&
+            slow5_idx_rehash(index, slow5_idx_num_buckets(index->num_ids + 1)) != 0) {
+        return -1;
+    }
+
+    int found;
+    uint64_t j = slow5_idx_find(index, key, &found);
+    if (found) {
+        char uuid_str[SLOW5_INDEX_UUID_LEN + 1];
+        if (key->is_uuid) {
+            slow5_idx_uuid_str(key->uuid, uuid_str);
+        }
+        SLOW5_ERROR("Read ID '%s' is duplicated", key->is_uuid ? uuid_str : key->read_id);
+        return -1;
+    }
+
+    uint64_t bytes = slow5_idx_rec_bytes(index, key);
+    if (slow5_buf_reserve((void **) &index->pool, &index->pool_cap, index->pool_size + bytes) != 0) {
+        return -1;
+    }
+
+    uint8_t *rec = index->pool + index->pool_size;
+    uint64_t head = slow5_idx_rec_head(index);
+    struct slow5_idx_entry entry = { offset, size };
+    if (key->is_uuid) {
+        entry.size |= SLOW5_INDEX_UUID_FLAG;
+        memcpy(rec + head, key->uuid, sizeof key->uuid);
+    } else {
+        memcpy(rec + head, key->read_id, key->len);
+        memset(rec + head + key->len, '\0', bytes - head - key->len);
+    }
+    memcpy(rec, &entry, sizeof entry);
+    memset(rec + sizeof entry, 0, head - sizeof entry); // columns are filled afterwards
+    if (index->block) {
+        memcpy(rec + head - sizeof index->block_pos, &index->block_pos, sizeof index->block_pos);
+    }
+    index->buckets[j].hash = key->hash;
+    index->buckets[j].rec = index->pool_size + 1;
+    index->pool_size += bytes;
+    ++ index->num_ids;
+    if (offset + size > index->data_size) {
+        index->data_size = offset + size;
+    }
+
+    // the pool may have moved
     free(index->ids);
+    free(index->uuids);
+    index->ids = NULL;
+    index->uuids = NULL;
+
+    return 0;
+}
+
+/*
+ * set the offset and size of the block holding the records in the pool from rec on, inserted before it was written
+ */
+void slow5_idx_block_done(struct slow5_idx *index, uint64_t rec, uint64_t offset, uint64_t size) {
+    while (rec < index->pool_size) {
+        struct slow5_idx_key key;
+        if (slow5_idx_rec_key(index, rec, &key) != 0) {
+            break;
+        }
+        struct slow5_idx_entry entry;
+        memcpy(&entry, index->pool + rec, sizeof entry);
+        entry.offset = offset;
+        entry.size = size | (entry.size & SLOW5_INDEX_UUID_FLAG);
+        memcpy(index->pool + rec, &entry, sizeof entry);
+        rec += slow5_idx_rec_bytes(index, &key);
+    }
+    if (offset + size > index->data_size) {
+        index->data_size = offset + size;
+    }
+}
+
+/*
+ * add the statistics of a read of read_group with len_raw_signal samples
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_idx_stats_add(struct slow5_idx *index, uint32_t read_group, const struct slow5_stats *read) {
+    if (read_group >= index->num_stats) {
+        struct slow5_stats *stats = (struct slow5_stats *) realloc(index->stats, ((uint64_t) read_group + 1) * sizeof *stats);
+        if (!stats) {
+            SLOW5_MALLOC_ERROR();
+            return slow5_errno = SLOW5_ERR_MEM;
+        }
+        memset(stats + index->num_stats, 0, (read_group + 1 - index->num_stats) * sizeof *stats);
+        index->stats = stats;
+        index->num_stats = read_group + 1;
+    }
+    struct slow5_stats *stats = index->stats + read_group;
+    if (read->num_reads) {
+        if (!stats->num_reads || read->min_len_raw_signal < stats->min_len_raw_signal) {
+            stats->min_len_raw_signal = read->min_len_raw_signal;
+        }
+        if (read->max_len_raw_signal > stats->max_len_raw_signal) {
+            stats->max_len_raw_signal = read->max_len_raw_signal;
+        }
+    }
+    stats->num_reads += read->num_reads;
+    stats->num_samples += read->num_samples;
+    return 0;
+}
 
-    kh_destroy(slow5_s2i, index->hash);
+/*
+ * make room for num_recs more records, so that the hash table is not grown while they are inserted
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+static int slow5_idx_reserve(struct slow5_idx *index, uint64_t num_recs) {
+    if (index->map && slow5_idx_unmap(index) != 0) {
+        return slow5_errno;
+    }
+    uint64_t num_ids = index->num_ids + num_recs;
+    if (index->num_buckets - index->num_buckets / 4 <= num_ids &&
+            slow5_idx_rehash(index, slow5_idx_num_buckets(num_ids)) != 0) {
+        return slow5_errno;
+    }
+    // the smallest records are binary UUIDs
+    return slow5_buf_reserve((void **) &index->pool, &index->pool_cap,
+            index->pool_size + num_recs * (slow5_idx_rec_head(index) + 16));
+}
+
+/*
+ * add read_id (copied into the pool) with the offset and size of its record
+ * the statistics of the index are then unknown, see slow5_idx_insert_read
+ * returns 0 on success, -1 on error (e.g. read_id is duplicated)
+ */
+int slow5_idx_insert(struct slow5_idx *index, const char *read_id, uint64_t offset, uint64_t size) {
+
+    if (index->map && slow5_idx_unmap(index) != 0) {
+        return -1;
+    }
+
+    struct slow5_idx_key key;
+    slow5_idx_key_init(&key, read_id);
+    int ret = slow5_idx_insert_key(index, &key, offset, size);
+    if (ret == 0) {
+        index->no_stats = 1;
+    }
+    return ret;
+}
+
+/*
+ * same as slow5_idx_insert for a read of read_group with len_raw_signal samples, which are added to the statistics
+ * (unless len_raw_signal is SLOW5_IDX_LEN_UNKNOWN, the statistics of the index are then unknown)
+ * returns 0 on success, -1 on error (e.g. read_id is duplicated)
+ */
+int slow5_idx_insert_read(struct slow5_idx *index, const char *read_id, uint32_t read_group, uint64_t len_raw_signal, uint64_t offset, uint64_t size) {
+
+    if (index->map && slow5_idx_unmap(index) != 0) {
+        return -1;
+    }
+
+    struct slow5_idx_key key;
+    slow5_idx_key_init(&key, read_id);
+    if (slow5_idx_insert_key(index, &key, offset, size) != 0) {
+        return -1;
+    }
+    if (len_raw_signal == SLOW5_IDX_LEN_UNKNOWN) {
+        index->no_stats = 1;
+        return 0;
+    }
+    struct slow5_stats read = { 1, len_raw_signal, len_raw_signal, len_raw_signal };
+    return slow5_idx_stats_add(index, read_group, &read) != 0 ? -1 : 0;
+}
+
+/*
+ * insert the slow5 record in line of size bytes (not null terminated) at offset
+ * the read ID, read group and number of samples are its first, second and seventh columns
+ * a malformed record (whose error is left to parsing it) is inserted by its read ID without its statistics
+ * returns 0 on success, <0 on error and sets slow5_errno
+ */
+int slow5_idx_insert_line(struct slow5_idx *index, const char *line, uint64_t offset, uint64_t size) {
+
+    // start of the first seven columns, each ending with a separator
+    const char *col[7];
+    size_t num_cols = 0;
+    const char *p = line;
+    const char *end = line + size;
+    while (num_cols < sizeof col / sizeof *col && p) {
+        col[num_cols ++] = p;
+        if ((p = (const char *) memchr(p, SLOW5_SEP_COL_CHAR, end - p))) {
+            ++ p;
+        }
+    }
+
+    char *read_id = strndup(line, num_cols > 1 ? (size_t) (col[1] - line - 1) : size);
+    if (!read_id) {
+        SLOW5_MALLOC_ERROR();
+        return slow5_errno = SLOW5_ERR_MEM;
+    }
+    char *col_end;
+    uint32_t read_group = 0;
+    uint64_t len_raw_signal = 0;
+    int parsed = p && isdigit((unsigned char) *col[1]) && isdigit((unsigned char) *col[6]);
+    if (parsed) {
+        read_group = strtoul(col[1], &col_end, 10);
+        parsed = col_end == col[2] - 1;
+    }
+    if (parsed) {
+        len_raw_signal = strtoull(col[6], &col_end, 10);
+        parsed = col_end == p - 1;
+    }
+    int ret = parsed ? slow5_idx_insert_read(index, read_id, read_group, len_raw_signal, offset, size)
+            : slow5_idx_insert(index, read_id, offset, size);
+    if (ret != 0) {
+        SLOW5_ERROR("Inserting '%s' to index failed", read_id);
+        free(read_id);
+        return slow5_errno = SLOW5_ERR_OTH;
+    }
+    free(read_id);
+    return 0;
+}
+
+/*
+ * add the records of src to index in file order, with their offsets moved by shift bytes
+ * (e.g. the file of src is copied into the file of index at a different offset)
+ * the read IDs and column values are copied from the pool of src as they are, binary UUIDs included
+ * an empty index takes the columns of src, otherwise they must be the same
+ * returns 0 on success, <0 on error (e.g. a read ID is in both) and sets slow5_errno
+ */
+int slow5_idx_merge(struct slow5_idx *index, const struct slow5_idx *src, int64_t shift) {
+
+    if (index->map && slow5_idx_unmap(index) != 0) {
+        return slow5_errno;
+    }
+    if (!index->num_ids && !index->num_cols && src->num_cols &&
+            slow5_idx_cols_set(index, src->cols, src->num_cols) != 0) {
+        return slow5_errno;
+    }
+    if (!slow5_idx_cols_same(index, src)) {
+        SLOW5_ERROR("%s", "Indexes with different columns cannot be merged.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    index->v2 |= src->v2;
+    if (!index->num_ids) {
+        index->block = src->block;
+    } else if (index->block != src->block) {
+        SLOW5_ERROR("%s", "Indexes of records in blocks and of records on their own cannot be merged.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+    // grown once for all the records of src
+    uint64_t num_ids = index->num_ids + src->num_ids;
+    if (index->num_buckets - index->num_buckets / 4 <= num_ids &&
+            slow5_idx_rehash(index, slow5_idx_num_buckets(num_ids)) != 0) {
+        return slow5_errno;
+    }
+    if (slow5_buf_reserve((void **) &index->pool, &index->pool_cap, index->pool_size + src->pool_size) != 0) {
+        return slow5_errno;
+    }
+
+    uint64_t rec = 0;
+    for (uint64_t i = 0; i < src->num_ids; ++ i) {
+        struct slow5_idx_key key;
+        if (slow5_idx_rec_key(src, rec, &key) != 0) {
+            return slow5_errno;
+        }
+        key.hash = key.is_uuid ? slow5_idx_hash_uuid(key.uuid) : slow5_idx_hash(key.read_id, key.len);
+        struct slow5_idx_entry entry;
+        memcpy(&entry, src->pool + rec, sizeof entry);
+        uint64_t dst = index->pool_size;
+        if (slow5_idx_insert_key(index, &key, entry.offset + shift, entry.size & ~SLOW5_INDEX_UUID_FLAG) != 0) {
+            return slow5_errno = SLOW5_ERR_OTH;
+        }
+        // column values and position in its block
+        memcpy(index->pool + dst + sizeof entry, src->pool + rec + sizeof entry, slow5_idx_rec_head(src) - sizeof entry);
+        rec += slow5_idx_rec_bytes(src, &key);
+    }
+
+    if (src->no_stats) {
+        index->no_stats = 1;
+    }
+    for (uint32_t i = 0; i < src->num_stats; ++ i) {
+        if (src->stats[i].num_reads && slow5_idx_stats_add(index, i, src->stats + i) != 0) {
+            return slow5_errno;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * index, read_id cannot be NULL
+ * returns -1 if read_id not in the index, 0 otherwise
+ */
+int slow5_idx_get(struct slow5_idx *index, const char *read_id, struct slow5_rec_idx *read_index) {
+
+    int found = 0;
+    if (index->num_buckets) {
+        struct slow5_idx_key key;
+        slow5_idx_key_init(&key, read_id);
+        uint64_t j = slow5_idx_find(index, &key, &found);
+        if (found && read_index) {
+            struct slow5_idx_entry entry;
+            memcpy(&entry, index->pool + index->buckets[j].rec - 1, sizeof entry);
+            read_index->offset = entry.offset;
+            read_index->size = entry.size & ~SLOW5_INDEX_UUID_FLAG;
+            read_index->block_pos = 0;
+            if (index->block) {
+                memcpy(&read_index->block_pos, index->pool + index->buckets[j].rec - 1 + slow5_idx_rec_head(index) - sizeof read_index->block_pos,
+                        sizeof read_index->block_pos);
+            }
+        }
+    }
+    if (!found) {
+        SLOW5_ERROR("Read ID '%s' was not found.", read_id)
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * get a pointer to the value of column col of the record of read_id in the index
+ * *len is set to the number of elements (1, or the length of a string) and *type to the column type if not NULL
+ * valid until the next insert or the index is freed, strings are not null terminated
+ * returns NULL on error and sets slow5_errno
+ * SLOW5_ERR_NOFLD      the index has no column col
+ * SLOW5_ERR_NOTFOUND   read_id is not in the index
+ */
+const void *slow5_idx_col_get(const struct slow5_idx *index, const char *read_id, const char *col, uint64_t *len, enum slow5_aux_type *type) {
+
+    int64_t i = slow5_idx_col_find(index, col);
+    if (i < 0) {
+        SLOW5_ERROR("Column '%s' is not in the index.", col);
+        slow5_errno = SLOW5_ERR_NOFLD;
+        return NULL;
+    }
+
+    int found = 0;
+    uint64_t j = 0;
+    if (index->num_buckets) {
+        struct slow5_idx_key key;
+        slow5_idx_key_init(&key, read_id);
+        j = slow5_idx_find(index, &key, &found);
+    }
+    if (!found) {
+        SLOW5_ERROR("Read ID '%s' was not found.", read_id);
+        slow5_errno = SLOW5_ERR_NOTFOUND;
+        return NULL;
+    }
+
+    const uint8_t *value = index->pool + index->buckets[j].rec - 1 + sizeof (struct slow5_idx_entry) + i * SLOW5_INDEX_COL_SIZE;
+    if (len) {
+        *len = index->cols[i].type == SLOW5_STRING ? strnlen((const char *) value, SLOW5_INDEX_COL_SIZE) : 1;
+    }
+    if (type) {
+        *type = index->cols[i].type;
+    }
+    return value;
+}
+
+/*
+ * the read IDs of the index in file order, NULL if there are none
+ * made on the first call pointing into the pool, valid until the next insert or the index is freed
+ * returns NULL on error and sets slow5_errno
+ */
+char **slow5_idx_ids(struct slow5_idx *index) {
+
+    if (!index->ids && index->num_ids) {
+        // count the UUIDs whose strings are to be made
+        uint64_t num_uuids = 0;
+        uint64_t rec = 0;
+        struct slow5_idx_key key;
+        for (uint64_t i = 0; i < index->num_ids; ++ i) {
+            if (slow5_idx_rec_key(index, rec, &key) != 0) {
+                return NULL;
+            }
+            num_uuids += key.is_uuid;
+            rec += slow5_idx_rec_bytes(index, &key);
+        }
+
+        char **ids = (char **) malloc(index->num_ids * sizeof *ids);
+        char *uuids = (char *) malloc(num_uuids * (SLOW5_INDEX_UUID_LEN + 1) + 1);
+        if (!ids || !uuids) {
+            SLOW5_MALLOC_ERROR();
+            free(ids);
+            free(uuids);
+            slow5_errno = SLOW5_ERR_MEM;
+            return NULL;
+        }
+        char *str = uuids;
+        rec = 0;
+        for (uint64_t i = 0; i < index->num_ids; ++ i) {
+            (void) slow5_idx_rec_key(index, rec, &key);
+            if (key.is_uuid) {
+                slow5_idx_uuid_str(key.uuid, str);
+                ids[i] = str;
+                str += SLOW5_INDEX_UUID_LEN + 1;
+            } else {
+                ids[i] = (char *) key.read_id;
+            }
+            rec += slow5_idx_rec_bytes(index, &key);
+        }
+        index->ids = ids;
+        index->uuids = uuids;
+    }
+
+    return index->ids;
+}
+
+/*
+ * get the statistics of the records of read_group, or of all of them if read_group is negative
+ * a read group without records has zero statistics
+ * returns 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_NOIDX      the statistics are unknown (e.g. the index was read from a v1 file or some records were indexed without them)
+ */
+int slow5_idx_stats(const struct slow5_idx *index, int64_t read_group, struct slow5_stats *stats) {
+
+    if (index->no_stats) {
+        SLOW5_ERROR("%s", "Index has no statistics. Please re-index.");
+        return slow5_errno = SLOW5_ERR_NOIDX;
+    }
+
+    memset(stats, 0, sizeof *stats);
+    for (uint32_t i = 0; i < index->num_stats; ++ i) {
+        const struct slow5_stats *rg = index->stats + i;
+        if ((read_group >= 0 && i != read_group) || !rg->num_reads) {
+            continue;
+        }
+        if (!stats->num_reads || rg->min_len_raw_signal < stats->min_len_raw_signal) {
+            stats->min_len_raw_signal = rg->min_len_raw_signal;
+        }
+        if (rg->max_len_raw_signal > stats->max_len_raw_signal) {
+            stats->max_len_raw_signal = rg->max_len_raw_signal;
+        }
+        stats->num_reads += rg->num_reads;
+        stats->num_samples += rg->num_samples;
+    }
+
+    return 0;
+}
+
+/*
+ * free index, unmapping its index file if it is mapped
+ * the index file is not kept open, so nothing is closed here (see slow5_idx_write)
+ */
+void slow5_idx_free(struct slow5_idx *index) {
+    if (index == NULL) {
+        return;
+    }
+
+    if (index->map) {
+        munmap(index->map, index->map_size);
+    } else {
+        free(index->buckets);
+        free(index->pool);
+    }
+    free(index->ids);
+    free(index->uuids);
+    slow5_idx_cols_free(index->cols, index->num_cols);
+    slow5_rec_view_free(index->view);
+    free(index->stats);
 
     free(index->pathname);
     free(index);
@@ -20,31 +20,99 @@ these functions are used by slow5tools and pyslow5 - so any change to a function
 #define SLOW5_INDEX_EXTENSION             "." "idx"
 #define SLOW5_INDEX_VERSION               SLOW5_VERSION_ARRAY
 #define SLOW5_INDEX_MAGIC_NUMBER          { 'S', 'L', 'O', 'W', '5', 'I', 'D', 'X', '\1' }
+#define SLOW5_INDEX_MAGIC_NUMBER_V2       { 'S', 'L', 'O', 'W', '5', 'I', 'D', 'X', '\2' }
 #define SLOW5_INDEX_EOF                   { 'X', 'D', 'I', '5', 'W', 'O', 'L', 'S' }
 #define SLOW5_INDEX_HEADER_SIZE_OFFSET    (64L)
+#define SLOW5_INDEX_FOOTER_MAGIC          { 'B', 'L', 'O', 'W', '5', 'I', 'D', 'X' }
+#define SLOW5_IDX_LEN_UNKNOWN             (UINT64_MAX) // number of samples of a read that is not known (see slow5_idx_insert_read)
 
 // SLOW5 record index
 struct slow5_rec_idx {
     uint64_t offset;
     uint64_t size;
+    uint64_t block_pos; // of the record in its decompressed block if the records are in blocks, 0 otherwise
 };
 
-// Read id map: read id -> index data
-KHASH_MAP_INIT_STR(slow5_s2i, struct slow5_rec_idx)
+/*
+ * The records of an index are in one arena (the pool) in file order, each an entry then its '\0' terminated read ID padded to 8 bytes.
+ * A read ID that is a canonical UUID (lowercase 8-4-4-4-12 hex digits) is stored as its 16 bytes instead,
+ * marked by SLOW5_INDEX_UUID_FLAG in the size of its entry.
+ * An index may have columns of per-record values (see slow5_idx_to_cols), each record then holds one value
+ * of SLOW5_INDEX_COL_SIZE bytes per column between its entry and its read ID:
+ * a primitive value zero padded, or a string of up to SLOW5_INDEX_COL_SIZE characters zero padded.
+ * In the index of a block-compressed blow5 file (see slow5_set_block) the entry of a record has the offset and size of its block,
+ * and the record holds the position of its record size in the decompressed block, a uint64_t after its column values.
+ * An open-addressing hash table (linear probing) of buckets caching the 64-bit hash of a read ID leads to its record.
+ *
+ * Index file v1 (magic number ending with '\1'), the default, has only the read IDs with the offsets and sizes of their records:
+ * header of SLOW5_INDEX_HEADER_SIZE_OFFSET bytes: magic number, version, padding
+ * then for each record in file order slow5_rid_len_t length of its read ID, the read ID (not '\0' terminated), uint64_t offset and size
+ * SLOW5_INDEX_EOF
+ *
+ * Index file v2 (magic number ending with '\2', see slow5_set_idx_v2) is this layout as is, mapped into memory by slow5_idx_load
+ * header of SLOW5_INDEX_HEADER_SIZE_OFFSET bytes: magic number, version, uint8_t flags (SLOW5_INDEX_FLAG_*), padding to 16 bytes,
+ *      then uint64_t num_ids, num_buckets (a power of 2), pool_size, data_size, num_cols and meta_size
+ * meta_size bytes of
+ *      num_cols columns, each a uint8_t type then its '\0' terminated name, zero padded to 8 bytes
+ *      statistics if known: uint64_t num_stats, then num_reads, num_samples, min_len_raw_signal and max_len_raw_signal
+ *      of read groups 0 to num_stats - 1
+ * num_buckets buckets
+ * pool_size bytes of records
+ * SLOW5_INDEX_EOF
+ *
+ * A blow5 file may instead carry its index as a footer after its last record (see slow5_set_idx_footer):
+ * SLOW5_INDEX_FOOTER_MAGIC in place of the size of a record (larger than any record, so readers stop there),
+ *      zero padding to a multiple of 8 bytes from the start of the file,
+ * the index as in a v2 file, from its magic number to SLOW5_INDEX_EOF
+ * trailer: uint64_t offset of the footer, then SLOW5_INDEX_FOOTER_MAGIC
+ * SLOW5_BINARY_EOF
+ * slow5_idx_load finds the footer by reading the trailer at the end of the file.
+ */
+#define SLOW5_INDEX_FLAG_BLOCK (1) // the records are in compressed blocks
+#define SLOW5_INDEX_UUID_LEN  (36)
+#define SLOW5_INDEX_UUID_FLAG (UINT64_C(1) << 63)
+struct slow5_idx_entry {
+    uint64_t offset;
+    uint64_t size; // | SLOW5_INDEX_UUID_FLAG if the read ID is a binary UUID
+};
+#define SLOW5_INDEX_COL_SIZE (8)
+struct slow5_idx_col {
+    char *name; // a primary field or an auxiliary field
+    enum slow5_aux_type type;
+};
+struct slow5_idx_bucket {
+    uint64_t hash;
+    uint64_t rec; // offset of the record in the pool + 1, 0 if the bucket is empty
+};
 
 // SLOW5 index
 struct slow5_idx {
     struct slow5_version version;
-    FILE *fp;
-    char *pathname;
-    char **ids;
+    char *pathname; // of the index file written by slow5_idx_write, NULL if it has none (e.g. a footer)
+    char **ids; // pointers into the pool or uuids, made on the first slow5_idx_ids and dropped on insert
+    char *uuids; // read ID strings of the binary UUIDs, made with ids
     uint64_t num_ids;
-    uint64_t cap_ids;
-    khash_t(slow5_s2i) *hash;
     uint8_t dirty;
+    struct slow5_idx_bucket *buckets;
+    uint64_t num_buckets;
+    uint8_t *pool;
+    uint64_t pool_size;
+    size_t pool_cap;
+    uint64_t data_size; // offset the indexed records end at, records appended after it are indexed on load (0 if unknown)
+    struct slow5_idx_col *cols; // allocated even if the index is mapped
+    uint32_t num_cols;
+    struct slow5_rec_view *view; // the records whose columns are filled are parsed into, NULL until then
+    struct slow5_stats *stats; // of the records of each read group, allocated even if the index is mapped
+    uint32_t num_stats; // read groups in stats
+    uint8_t no_stats; // 1 if records were indexed without their statistics (e.g. by an older slow5lib), which are then unknown
+    uint8_t block; // 1 if the records are in compressed blocks
+    uint8_t v2; // 1 if written in the v2 format, which indexes with columns or blocks always are, 0 for v1
+    uint64_t block_pos; // position in its block given to the next record inserted into a block index
+    // memory-mapped v2 index file holding buckets and pool read-only, NULL if they are allocated
+    void *map;
+    size_t map_size;
 };
 
-
 struct slow5_idx *slow5_idx_init(struct slow5_file *s5p);
 /**
  * Create the index file for slow5 file.
@@ -54,10 +122,26 @@ struct slow5_idx *slow5_idx_init(struct slow5_file *s5p);
  * @param   pathname    pathname to write index to
  */
 int slow5_idx_to(struct slow5_file *s5p, const char *pathname);
+int slow5_idx_to_mt(struct slow5_file *s5p, const char *pathname, int num_thread);
+int slow5_idx_to_cols(struct slow5_file *s5p, const char *pathname, const char **cols, uint32_t num_cols);
+int slow5_idx_build_threads(void);
 void slow5_idx_free(struct slow5_idx *index);
 int slow5_idx_get(struct slow5_idx *index, const char *read_id, struct slow5_rec_idx *read_index);
-int slow5_idx_insert(struct slow5_idx *index, char *read_id, uint64_t offset, uint64_t size);
+char **slow5_idx_ids(struct slow5_idx *index);
+const void *slow5_idx_col_get(const struct slow5_idx *index, const char *read_id, const char *col, uint64_t *len, enum slow5_aux_type *type);
+int slow5_idx_insert(struct slow5_idx *index, const char *read_id, uint64_t offset, uint64_t size);
+int slow5_idx_insert_read(struct slow5_idx *index, const char *read_id, uint32_t read_group, uint64_t len_raw_signal, uint64_t offset, uint64_t size);
+void slow5_idx_block_done(struct slow5_idx *index, uint64_t rec, uint64_t offset, uint64_t size);
+int slow5_idx_insert_line(struct slow5_idx *index, const char *line, uint64_t offset, uint64_t size);
+int slow5_idx_stats(const struct slow5_idx *index, int64_t read_group, struct slow5_stats *stats);
+int slow5_idx_merge(struct slow5_idx *index, const struct slow5_idx *src, int64_t shift);
 int slow5_idx_write(struct slow5_idx *index, struct slow5_version version);
+int slow5_idx_footer_write(struct slow5_idx *index, struct slow5_version version, FILE *fp);
+int slow5_idx_footer_offset(int fd, uint64_t *offset);
+int slow5_idx_footer_end(int fd, uint64_t offset, uint64_t *end);
+int slow5_idx_footer_skip(int fd, uint64_t offset, uint64_t file_size, uint64_t *next);
+struct slow5_idx *slow5_idx_footer_init(struct slow5_file *s5p, uint64_t offset, int writable);
+int slow5_idx_insert_mem(struct slow5_idx *index, struct slow5_file *s5p, const void *mem, size_t bytes, uint64_t offset);
 void slow5_rec_idx_print(struct slow5_rec_idx read_index);
 
 #ifdef __cplusplus
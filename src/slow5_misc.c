@@ -72,6 +72,35 @@ int slow5_asprintf(char **strp, const char *fmt, ...) {
 }
 
 
+/*
+ * grow *buf of capacity *cap to hold at least size bytes, at least doubling to keep reallocs rare
+ * the contents are kept, *buf and *cap are only updated on success
+ * returns -1 on realloc error and sets slow5_errno to SLOW5_ERR_MEM, 0 on success
+ */
+int slow5_buf_reserve(void **buf, size_t *cap, size_t size) {
+    if (size <= *cap && *buf) {
+        return 0;
+    }
+
+    size_t new_cap = *cap << 1;
+    if (new_cap < size) {
+        new_cap = size;
+    }
+    if (new_cap == 0) {
+        new_cap = 1;
+    }
+    void *new_buf = realloc(*buf, new_cap);
+    if (!new_buf) {
+        SLOW5_MALLOC_ERROR();
+        slow5_errno = SLOW5_ERR_MEM;
+        return -1;
+    }
+
+    *buf = new_buf;
+    *cap = new_cap;
+    return 0;
+}
+
 /*
  * from https://code.woboq.org/userspace/glibc/string/strsep.c.html
  * strsep source code
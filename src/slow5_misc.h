@@ -105,6 +105,9 @@ static inline int slow5_is_big_endian(void)
 int slow5_asprintf(char **strp, const char *fmt, ...);
 int slow5_vasprintf(char **strp, const char *fmt, va_list ap);
 
+// grow *buf (of *cap bytes) to hold at least size bytes, keeping its contents
+int slow5_buf_reserve(void **buf, size_t *cap, size_t size);
+
 // From https://code.woboq.org/userspace/glibc/string/strsep.c.html
 char *slow5_strsep (char **stringp, const char *delim);
 
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
+#include <pthread.h>
 #include <slow5/slow5.h>
 #include <slow5/slow5_error.h>
 #include <slow5/slow5_press.h>
@@ -12,6 +13,7 @@
 #include <streamvbyte_zigzag.h>
 #ifdef SLOW5_USE_ZSTD
 #include <zstd.h>
+#include <zdict.h>
 #endif /* SLOW5_USE_ZSTD */
 #include "slow5_misc.h"
 
@@ -19,27 +21,38 @@ extern enum slow5_log_level_opt  slow5_log_level;
 extern enum slow5_exit_condition_opt  slow5_exit_condition;
 
 /* zlib */
-static int zlib_init_deflate(z_stream *strm);
+static int zlib_init_deflate(z_stream *strm, int level);
 static int zlib_init_inflate(z_stream *strm);
+static z_stream *zlib_inflate_reuse(z_stream **strm);
 static void *ptr_compress_zlib(struct slow5_zlib_stream *zlib, const void *ptr, size_t count, size_t *n);
 static void *ptr_compress_zlib_solo(const void *ptr, size_t count, size_t *n);
 static void *ptr_depress_zlib(struct slow5_zlib_stream *zlib, const void *ptr, size_t count, size_t *n);
 static void *ptr_depress_zlib_solo(const void *ptr, size_t count, size_t *n);
+static void *ptr_depress_zlib_ctx(struct slow5_decode_ctx *ctx, const void *ptr, size_t count, size_t *n);
+static void *ptr_depress_zlib_part_ctx(struct slow5_decode_ctx *ctx, const void *ptr, size_t count, size_t min_out, size_t *n);
 static ssize_t fwrite_compress_zlib(struct slow5_zlib_stream *zlib, const void *ptr, size_t size, size_t nmemb, FILE *fp);
 
 /* streamvbyte */
-static uint8_t *ptr_compress_svb(const uint32_t *ptr, size_t count, size_t *n);
 static uint8_t *ptr_compress_svb_zd(const int16_t *ptr, size_t count, size_t *n);
-static uint32_t *ptr_depress_svb(const uint8_t *ptr, size_t count, size_t *n);
 static int16_t *ptr_depress_svb_zd(const uint8_t *ptr, size_t count, size_t *n);
+static int16_t *ptr_depress_svb_zd_into(const uint8_t *ptr, size_t count, int16_t *sig, uint64_t cap, uint64_t *len);
 
 #ifdef SLOW5_USE_ZSTD
 /* zstd */
-static void *ptr_compress_zstd(const void *ptr, size_t count, size_t *n);
-static void *ptr_depress_zstd(const void *ptr, size_t count, size_t *n);
+static struct slow5_zstd_stream *zstd_stream_init(void);
+static int zstd_stream_set_opt(struct slow5_zstd_stream *zstd, const struct slow5_press_opt *opt);
+static void zstd_stream_free(struct slow5_zstd_stream *zstd);
+static struct slow5_zstd_stream *zstd_thread_stream(void);
+static void *ptr_compress_zstd(struct slow5_zstd_stream *zstd, const void *ptr, size_t count, size_t *n);
+static void *ptr_depress_zstd(struct slow5_zstd_stream *zstd, const void *ddict, const void *ptr, size_t count, size_t *n);
+static void *ptr_depress_zstd_ctx(struct slow5_decode_ctx *ctx, const void *ddict, const void *ptr, size_t count, size_t *n);
+static void *ptr_depress_zstd_part_ctx(struct slow5_decode_ctx *ctx, const void *ddict, const void *ptr, size_t count, size_t min_out, size_t *n);
 #endif /* SLOW5_USE_ZSTD */
 
 /* other */
+static struct slow5_decode_ctx *decode_ctx_thread(int i);
+static void *ptr_depress_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ddict, const void *ptr, size_t count, size_t *n);
+static void *ptr_depress_part_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ddict, const void *ptr, size_t count, size_t min_out, size_t *n);
 static int vfprintf_compress(struct __slow5_press *comp, FILE *fp, const char *format, va_list ap);
 
 
@@ -96,6 +109,61 @@ enum slow5_press_method slow5_decode_record_press(uint8_t method){
     return ret;
 }
 
+// convert the block compression method from library format to the spec format, which takes the place of the record compression
+uint8_t slow5_encode_block_press(enum slow5_press_method method){
+    uint8_t ret = 0;
+    switch(method){
+        case SLOW5_COMPRESS_ZLIB:
+            ret = 129;
+            break;
+        case SLOW5_COMPRESS_ZSTD:
+            ret = 130;
+            break;
+        default:
+            ret = 255;
+            SLOW5_WARNING("Unknown block compression method %d",method);
+            break;
+    }
+    return ret;
+}
+
+// convert the record compression from spec format to the block compression in library format, none if records are not in blocks
+enum slow5_press_method slow5_decode_block_press(uint8_t method){
+    switch(method){
+        case 129:
+            return SLOW5_COMPRESS_ZLIB;
+        case 130:
+            return SLOW5_COMPRESS_ZSTD;
+        default:
+            return SLOW5_COMPRESS_NONE;
+    }
+}
+
+// convert the record compression method with a dictionary from library format to the spec format, which takes the place of the record compression
+uint8_t slow5_encode_dict_press(enum slow5_press_method method){
+    uint8_t ret = 0;
+    switch(method){
+        case SLOW5_COMPRESS_ZSTD:
+            ret = 66;
+            break;
+        default:
+            ret = 255;
+            SLOW5_WARNING("Unknown record compression method with a dictionary %d",method);
+            break;
+    }
+    return ret;
+}
+
+// convert the record compression from spec format to the record compression method with a dictionary in library format, none if there is no dictionary
+enum slow5_press_method slow5_decode_dict_press(uint8_t method){
+    switch(method){
+        case 66:
+            return SLOW5_COMPRESS_ZSTD;
+        default:
+            return SLOW5_COMPRESS_NONE;
+    }
+}
+
 // convert the signal compression from library format to the spec format
 uint8_t slow5_encode_signal_press(enum slow5_press_method method){
     uint8_t ret = 0;
@@ -158,8 +226,13 @@ enum slow5_press_method slow5_decode_signal_press(uint8_t method){
  * SLOW5_ERR_PRESS  (de)compression failure
  */
 struct slow5_press *slow5_press_init(slow5_press_method_t method) {
+    return slow5_press_init_opt(method, NULL);
+}
+
+/* same as slow5_press_init with the options opt (if not NULL) for the record and block compression */
+struct slow5_press *slow5_press_init_opt(slow5_press_method_t method, const struct slow5_press_opt *opt) {
 
-    struct __slow5_press *record_comp = __slow5_press_init(method.record_method);
+    struct __slow5_press *record_comp = __slow5_press_init_opt(method.record_method, opt);
     if (!record_comp) {
         return NULL;
     }
@@ -170,16 +243,28 @@ struct slow5_press *slow5_press_init(slow5_press_method_t method) {
         return NULL;
     }
 
+    struct __slow5_press *block_comp = __slow5_press_init_opt(method.block_method, opt);
+    if (!block_comp) {
+        __slow5_press_free(record_comp);
+        __slow5_press_free(signal_comp);
+        return NULL;
+    }
+
     struct slow5_press *comp = (struct slow5_press *) calloc(1, sizeof *comp);
     if (!comp) {
         SLOW5_MALLOC_ERROR();
         __slow5_press_free(record_comp);
         __slow5_press_free(signal_comp);
+        __slow5_press_free(block_comp);
         slow5_errno = SLOW5_ERR_MEM;
         return NULL;
     }
     comp->record_press = record_comp;
     comp->signal_press = signal_comp;
+    comp->block_press = block_comp;
+    if (opt) {
+        comp->opt = *opt;
+    }
 
     return comp;
 }
@@ -189,6 +274,7 @@ void slow5_press_free(struct slow5_press *comp) {
     if (comp) {
         __slow5_press_free(comp->record_press);
         __slow5_press_free(comp->signal_press);
+        __slow5_press_free(comp->block_press);
         free(comp);
     }
 }
@@ -202,8 +288,26 @@ void slow5_press_free(struct slow5_press *comp) {
  * SLOW5_ERR_PRESS  (de)compression failure
  */
 struct __slow5_press *__slow5_press_init(enum slow5_press_method method) {
+    return __slow5_press_init_opt(method, NULL);
+}
+
+/*
+ * same as __slow5_press_init with the options opt (if not NULL) for zlib or zstd, which are ignored for other methods
+ * SLOW5_ERR_ARG    also if an option is out of range or not for method
+ */
+struct __slow5_press *__slow5_press_init_opt(enum slow5_press_method method, const struct slow5_press_opt *opt) {
 
     struct __slow5_press *comp = NULL;
+    const struct slow5_press_opt opt_default = { 0 };
+    if (!opt) {
+        opt = &opt_default;
+    }
+    if (method == SLOW5_COMPRESS_ZLIB && (opt->level < 0 || opt->level > 9 ||
+                opt->zstd_window_log || opt->zstd_long || opt->zstd_workers)) {
+        SLOW5_ERROR("Invalid zlib compression options: level '%d' should be 1 to 9 (0 for the default) and zstd options unset.", opt->level);
+        slow5_errno = SLOW5_ERR_ARG;
+        return NULL;
+    }
 
     comp = (struct __slow5_press *) calloc(1, sizeof *comp);
     if (!comp) {
@@ -227,7 +331,7 @@ struct __slow5_press *__slow5_press_init(enum slow5_press_method method) {
                 return NULL;
             }
 
-            if (zlib_init_deflate(&(zlib->strm_deflate)) != Z_OK) {
+            if (zlib_init_deflate(&(zlib->strm_deflate), opt->level ? opt->level : Z_DEFAULT_COMPRESSION) != Z_OK) {
                 SLOW5_ERROR("zlib deflate init failed: %s.", zlib->strm_deflate.msg);
                 free(zlib);
                 free(comp);
@@ -267,6 +371,22 @@ struct __slow5_press *__slow5_press_init(enum slow5_press_method method) {
         case SLOW5_COMPRESS_SVB_ZD: break;
         case SLOW5_COMPRESS_ZSTD:
 #ifdef SLOW5_USE_ZSTD
+            comp->stream = (union slow5_press_stream *) malloc(sizeof *comp->stream);
+            if (!comp->stream || !(comp->stream->zstd = zstd_stream_init())) {
+                if (!comp->stream) {
+                    SLOW5_MALLOC_ERROR();
+                    slow5_errno = SLOW5_ERR_MEM;
+                }
+                free(comp->stream);
+                free(comp);
+                return NULL;
+            }
+            if (zstd_stream_set_opt(comp->stream->zstd, opt) != 0) {
+                zstd_stream_free(comp->stream->zstd);
+                free(comp->stream);
+                free(comp);
+                return NULL;
+            }
             break;
 #else
             SLOW5_ERROR("%s","slow5lib has not been compiled with zstd support to read/write zstd compressed BLOW5 files.");
@@ -300,7 +420,11 @@ void __slow5_press_free(struct __slow5_press *comp) {
                 break;
             case SLOW5_COMPRESS_SVB_ZD: break;
 #ifdef SLOW5_USE_ZSTD
-            case SLOW5_COMPRESS_ZSTD: break;
+            case SLOW5_COMPRESS_ZSTD:
+                zstd_stream_free(comp->stream->zstd);
+                free(comp->stream);
+                slow5_press_dict_free(comp->dict);
+                break;
 #endif /* SLOW5_USE_ZSTD */
 
             default:
@@ -313,6 +437,185 @@ void __slow5_press_free(struct __slow5_press *comp) {
     }
 }
 
+/*
+ * init a zstd dictionary from a copy of the size bytes of buf, compressing at level (0 for the default)
+ * the dictionary has one reference, dropped by slow5_press_dict_free
+ * returns NULL on error and sets slow5_errno
+ * SLOW5_ERR_ARG    slow5lib has not been compiled with zstd
+ * SLOW5_ERR_PRESS  zstd could not make the dictionary
+ */
+struct slow5_press_dict *slow5_press_dict_init(const void *buf, size_t size, int level) {
+#ifdef SLOW5_USE_ZSTD
+    struct slow5_press_dict *dict = (struct slow5_press_dict *) calloc(1, sizeof *dict);
+    if (!dict || !(dict->buf = malloc(size ? size : 1))) {
+        SLOW5_MALLOC_ERROR();
+        free(dict);
+        slow5_errno = SLOW5_ERR_MEM;
+        return NULL;
+    }
+    memcpy(dict->buf, buf, size);
+    dict->size = size;
+    dict->refs = 1;
+    dict->cdict = ZSTD_createCDict(dict->buf, size, level ? level : SLOW5_ZSTD_COMPRESS_LEVEL);
+    dict->ddict = ZSTD_createDDict(dict->buf, size);
+    if (!dict->cdict || !dict->ddict) {
+        SLOW5_ERROR("zstd create dictionary of %zu bytes failed.", size);
+        slow5_press_dict_free(dict);
+        slow5_errno = SLOW5_ERR_PRESS;
+        return NULL;
+    }
+    return dict;
+#else
+    SLOW5_ERROR("%s","slow5lib has not been compiled with zstd support to use zstd dictionaries.");
+    slow5_errno = SLOW5_ERR_ARG;
+    return NULL;
+#endif /* SLOW5_USE_ZSTD */
+}
+
+/* drop a reference to dict, which is freed with the last one */
+void slow5_press_dict_free(struct slow5_press_dict *dict) {
+    if (dict && __sync_sub_and_fetch(&dict->refs, 1) == 0) {
+#ifdef SLOW5_USE_ZSTD
+        ZSTD_freeCDict((ZSTD_CDict *) dict->cdict);
+        ZSTD_freeDDict((ZSTD_DDict *) dict->ddict);
+#endif /* SLOW5_USE_ZSTD */
+        free(dict->buf);
+        free(dict);
+    }
+}
+
+/*
+ * make the zstd press comp compress and decompress with dict, or without a dictionary if dict is NULL
+ * comp takes a new reference to dict and drops the one to its previous dictionary
+ * returns 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_ARG    comp is NULL or not zstd
+ * SLOW5_ERR_PRESS  zstd failure
+ */
+int __slow5_press_set_dict(struct __slow5_press *comp, struct slow5_press_dict *dict) {
+    if (!comp || comp->method != SLOW5_COMPRESS_ZSTD) {
+        SLOW5_ERROR("%s", "A dictionary can only be used with zstd compression.");
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+#ifdef SLOW5_USE_ZSTD
+    size_t ret = ZSTD_CCtx_refCDict((ZSTD_CCtx *) comp->stream->zstd->cctx, dict ? (ZSTD_CDict *) dict->cdict : NULL);
+    if (ZSTD_isError(ret)) {
+        SLOW5_ERROR("zstd set the dictionary failed: %s.", ZSTD_getErrorName(ret));
+        return slow5_errno = SLOW5_ERR_PRESS;
+    }
+    if (dict) {
+        __sync_add_and_fetch(&dict->refs, 1);
+    }
+    slow5_press_dict_free(comp->dict);
+    comp->dict = dict;
+#endif /* SLOW5_USE_ZSTD */
+    return 0;
+}
+
+/*
+ * train a zstd dictionary of at most cap bytes into dict from num samples, the i-th of sizes[i] bytes, one after the other in buf
+ * returns the size of the dictionary, 0 on error and sets slow5_errno
+ * SLOW5_ERR_ARG    slow5lib has not been compiled with zstd
+ * SLOW5_ERR_PRESS  training failed, e.g. too few or too small samples
+ */
+size_t slow5_press_dict_train(void *dict, size_t cap, const void *buf, const size_t *sizes, uint32_t num) {
+#ifdef SLOW5_USE_ZSTD
+    size_t ret = ZDICT_trainFromBuffer(dict, cap, buf, sizes, num);
+    if (ZDICT_isError(ret)) {
+        SLOW5_ERROR("zstd train a dictionary from %u samples failed: %s.", (unsigned) num, ZDICT_getErrorName(ret));
+        slow5_errno = SLOW5_ERR_PRESS;
+        return 0;
+    }
+    return ret;
+#else
+    SLOW5_ERROR("%s","slow5lib has not been compiled with zstd support to use zstd dictionaries.");
+    slow5_errno = SLOW5_ERR_ARG;
+    return 0;
+#endif /* SLOW5_USE_ZSTD */
+}
+
+/*
+ * init a decode context with empty scratch buffers that grow on demand
+ * a context must not be used by more than one thread at a time
+ * returns NULL on malloc error and sets slow5_errno
+ */
+struct slow5_decode_ctx *slow5_decode_ctx_init(void) {
+    struct slow5_decode_ctx *ctx = (struct slow5_decode_ctx *) calloc(1, sizeof *ctx);
+    if (!ctx) {
+        SLOW5_MALLOC_ERROR();
+        slow5_errno = SLOW5_ERR_MEM;
+    }
+    return ctx;
+}
+
+void slow5_decode_ctx_free(struct slow5_decode_ctx *ctx) {
+    if (ctx) {
+        __slow5_decode_ctx_free_bufs(ctx);
+        free(ctx);
+    }
+}
+
+/* free the scratch buffers of ctx but not ctx itself (e.g. a zero-initialised one on the stack) */
+void __slow5_decode_ctx_free_bufs(struct slow5_decode_ctx *ctx) {
+    free(ctx->raw);
+    free(ctx->rec);
+    free(ctx->blk);
+    if (ctx->zlib_strm) {
+        (void) inflateEnd(ctx->zlib_strm);
+        free(ctx->zlib_strm);
+    }
+#ifdef SLOW5_USE_ZSTD
+    ZSTD_freeDStream((ZSTD_DStream *) ctx->zstd_dstream);
+#endif /* SLOW5_USE_ZSTD */
+    memset(ctx, 0, sizeof *ctx);
+}
+
+/* decode contexts of the calling thread, made on first use and freed when the thread exits */
+#define DECODE_CTX_GET (0)  /* of slow5_decode_ctx_thread */
+#define DECODE_CTX_SOLO (1) /* of the solo functions, which may be called while the other one is in use */
+static pthread_key_t decode_ctx_key[2];
+static pthread_once_t decode_ctx_once = PTHREAD_ONCE_INIT;
+static int decode_ctx_key_ret;
+
+static void decode_ctx_thread_free(void *ctx) {
+    slow5_decode_ctx_free((struct slow5_decode_ctx *) ctx);
+}
+
+static void decode_ctx_key_init(void) {
+    decode_ctx_key_ret = pthread_key_create(&decode_ctx_key[DECODE_CTX_GET], decode_ctx_thread_free) ||
+            pthread_key_create(&decode_ctx_key[DECODE_CTX_SOLO], decode_ctx_thread_free);
+}
+
+/* get the i-th decode context of the calling thread, returns NULL on error and sets slow5_errno */
+static struct slow5_decode_ctx *decode_ctx_thread(int i) {
+    if (pthread_once(&decode_ctx_once, decode_ctx_key_init) != 0 || decode_ctx_key_ret != 0) {
+        SLOW5_ERROR("%s", "Creating the key of the decode contexts of each thread failed.");
+        slow5_errno = SLOW5_ERR_OTH;
+        return NULL;
+    }
+    struct slow5_decode_ctx *ctx = (struct slow5_decode_ctx *) pthread_getspecific(decode_ctx_key[i]);
+    if (!ctx) {
+        if (!(ctx = slow5_decode_ctx_init())) {
+            return NULL;
+        }
+        if (pthread_setspecific(decode_ctx_key[i], ctx) != 0) {
+            SLOW5_ERROR("%s", "Keeping the decode context of the thread failed.");
+            slow5_decode_ctx_free(ctx);
+            slow5_errno = SLOW5_ERR_OTH;
+            return NULL;
+        }
+    }
+    return ctx;
+}
+
+/*
+ * get the decode context of the calling thread, so that its buffers and streams are reused by every call in the thread
+ * it must not be freed, and is freed when the thread exits
+ * returns NULL on error and sets slow5_errno
+ */
+struct slow5_decode_ctx *slow5_decode_ctx_thread(void) {
+    return decode_ctx_thread(DECODE_CTX_GET);
+}
+
 void *slow5_ptr_compress_solo(enum slow5_press_method method, const void *ptr, size_t count, size_t *n) {
     void *out = NULL;
     size_t n_tmp = 0;
@@ -344,7 +647,7 @@ void *slow5_ptr_compress_solo(enum slow5_press_method method, const void *ptr, s
 
 #ifdef SLOW5_USE_ZSTD
             case SLOW5_COMPRESS_ZSTD:
-                out = ptr_compress_zstd(ptr, count, &n_tmp);
+                out = ptr_compress_zstd(zstd_thread_stream(), ptr, count, &n_tmp);
                 break;
 #endif /* SLOW5_USE_ZSTD */
 
@@ -395,7 +698,7 @@ void *slow5_ptr_compress(struct __slow5_press *comp, const void *ptr, size_t cou
 
 #ifdef SLOW5_USE_ZSTD
             case SLOW5_COMPRESS_ZSTD:
-                out = ptr_compress_zstd(ptr, count, &n_tmp);
+                out = ptr_compress_zstd(comp->stream->zstd, ptr, count, &n_tmp);
                 break;
 #endif /* SLOW5_USE_ZSTD */
 
@@ -448,7 +751,7 @@ void *slow5_ptr_depress_solo(enum slow5_press_method method, const void *ptr, si
 
 #ifdef SLOW5_USE_ZSTD
             case SLOW5_COMPRESS_ZSTD:
-                out = ptr_depress_zstd(ptr, count, &n_tmp);
+                out = ptr_depress_zstd(zstd_thread_stream(), NULL, ptr, count, &n_tmp);
                 break;
 #endif /* SLOW5_USE_ZSTD */
 
@@ -466,6 +769,275 @@ void *slow5_ptr_depress_solo(enum slow5_press_method method, const void *ptr, si
     return out;
 }
 
+/*
+ * decompress count bytes of a ptr to compressed memory into the record buffer of ctx
+ * returns ctx->rec holding *n bytes, valid until the next call with ctx, not to be freed
+ * returns NULL on error and *n set to 0
+ */
+void *slow5_ptr_depress_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ptr, size_t count, size_t *n) {
+    return ptr_depress_ctx(ctx, method, NULL, ptr, count, n);
+}
+
+/* same as slow5_ptr_depress_ctx with the zstd dictionary ddict (a ZSTD_DDict, none if NULL) */
+static void *ptr_depress_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ddict, const void *ptr, size_t count, size_t *n) {
+    void *out = NULL;
+    size_t n_tmp = 0;
+
+    if (!ctx || !ptr) {
+        if (!ctx) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(ctx));
+        }
+        if (!ptr) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(ptr));
+        }
+        slow5_errno = SLOW5_ERR_ARG;
+    } else {
+
+        switch (method) {
+
+            case SLOW5_COMPRESS_NONE:
+                if (slow5_buf_reserve((void **) &ctx->rec, &ctx->rec_cap, count) == 0) {
+                    memcpy(ctx->rec, ptr, count);
+                    out = ctx->rec;
+                    n_tmp = count;
+                }
+                break;
+
+            case SLOW5_COMPRESS_ZLIB:
+                out = ptr_depress_zlib_ctx(ctx, ptr, count, &n_tmp);
+                break;
+
+#ifdef SLOW5_USE_ZSTD
+            case SLOW5_COMPRESS_ZSTD:
+                out = ptr_depress_zstd_ctx(ctx, ddict, ptr, count, &n_tmp);
+                break;
+#endif /* SLOW5_USE_ZSTD */
+
+            default:
+                SLOW5_ERROR("Invalid or unsupported record (de)compression method '%d'.", method);
+                slow5_errno = SLOW5_ERR_ARG;
+                break;
+        }
+    }
+
+    if (n) {
+        *n = out ? n_tmp : 0;
+    }
+
+    return out;
+}
+
+/*
+ * decompress count bytes of a ptr to a compressed block of records into the block buffer of ctx
+ * so that its records can then be decompressed and decoded with ctx without overwriting it
+ * returns ctx->blk holding *n bytes, valid until the next call with ctx, not to be freed
+ * returns NULL on error and *n set to 0
+ */
+void *slow5_block_depress_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ptr, size_t count, size_t *n) {
+    void *out = slow5_ptr_depress_ctx(ctx, method, ptr, count, n);
+    if (out) { /* swap the buffers instead of copying */
+        char *blk = ctx->blk;
+        size_t blk_cap = ctx->blk_cap;
+        ctx->blk = (char *) ctx->rec;
+        ctx->blk_cap = ctx->rec_cap;
+        ctx->rec = (uint8_t *) blk;
+        ctx->rec_cap = blk_cap;
+    }
+    return out;
+}
+
+/*
+ * decompress the start of compressed memory into the record buffer of ctx, e.g. to get a read ID without decompressing the signal
+ * ptr holds the first count bytes of the compressed memory, which may be all of it
+ * stops once at least min_out bytes are out (*n may be more), or fewer if the memory ends or more of it is needed
+ * only as much of the input as needed is decompressed (a whole block for zstd)
+ * returns ctx->rec holding *n bytes, valid until the next call with ctx, not to be freed
+ * returns NULL on error and *n set to 0
+ */
+void *slow5_ptr_depress_part_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ptr, size_t count, size_t min_out, size_t *n) {
+    return ptr_depress_part_ctx(ctx, method, NULL, ptr, count, min_out, n);
+}
+
+/* same as slow5_ptr_depress_part_ctx with the zstd dictionary ddict (a ZSTD_DDict, none if NULL) */
+static void *ptr_depress_part_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ddict, const void *ptr, size_t count, size_t min_out, size_t *n) {
+    void *out = NULL;
+    size_t n_tmp = 0;
+
+    if (!ctx || !ptr) {
+        if (!ctx) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(ctx));
+        }
+        if (!ptr) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(ptr));
+        }
+        slow5_errno = SLOW5_ERR_ARG;
+    } else {
+
+        switch (method) {
+
+            case SLOW5_COMPRESS_NONE:
+                n_tmp = count < min_out ? count : min_out;
+                if (slow5_buf_reserve((void **) &ctx->rec, &ctx->rec_cap, n_tmp) == 0) {
+                    memcpy(ctx->rec, ptr, n_tmp);
+                    out = ctx->rec;
+                }
+                break;
+
+            case SLOW5_COMPRESS_ZLIB:
+                out = ptr_depress_zlib_part_ctx(ctx, ptr, count, min_out, &n_tmp);
+                break;
+
+#ifdef SLOW5_USE_ZSTD
+            case SLOW5_COMPRESS_ZSTD:
+                out = ptr_depress_zstd_part_ctx(ctx, ddict, ptr, count, min_out, &n_tmp);
+                break;
+#endif /* SLOW5_USE_ZSTD */
+
+            default:
+                SLOW5_ERROR("Invalid or unsupported record (de)compression method '%d'.", method);
+                slow5_errno = SLOW5_ERR_ARG;
+                break;
+        }
+    }
+
+    if (n) {
+        *n = out ? n_tmp : 0;
+    }
+
+    return out;
+}
+
+/* the zstd dictionary of a record press for decompression, NULL if none */
+static inline const void *rec_ddict(const struct __slow5_press *comp) {
+    return comp && comp->dict ? comp->dict->ddict : NULL;
+}
+
+/* same as slow5_ptr_depress_solo with the method and zstd dictionary of the record press comp, no compression if comp is NULL */
+void *slow5_rec_depress_solo(const struct __slow5_press *comp, const void *ptr, size_t count, size_t *n) {
+#ifdef SLOW5_USE_ZSTD
+    if (rec_ddict(comp)) {
+        size_t n_tmp = 0;
+        void *out = ptr_depress_zstd(zstd_thread_stream(), rec_ddict(comp), ptr, count, &n_tmp);
+        if (n) {
+            *n = out ? n_tmp : 0;
+        }
+        return out;
+    }
+#endif /* SLOW5_USE_ZSTD */
+    return slow5_ptr_depress_solo(comp ? comp->method : SLOW5_COMPRESS_NONE, ptr, count, n);
+}
+
+/* same as slow5_ptr_depress_ctx with the method and zstd dictionary of the record press comp, no compression if comp is NULL */
+void *slow5_rec_depress_ctx(struct slow5_decode_ctx *ctx, const struct __slow5_press *comp, const void *ptr, size_t count, size_t *n) {
+    return ptr_depress_ctx(ctx, comp ? comp->method : SLOW5_COMPRESS_NONE, rec_ddict(comp), ptr, count, n);
+}
+
+/* same as slow5_ptr_depress_part_ctx with the method and zstd dictionary of the record press comp, no compression if comp is NULL */
+void *slow5_rec_depress_part_ctx(struct slow5_decode_ctx *ctx, const struct __slow5_press *comp, const void *ptr, size_t count, size_t min_out, size_t *n) {
+    return ptr_depress_part_ctx(ctx, comp ? comp->method : SLOW5_COMPRESS_NONE, rec_ddict(comp), ptr, count, min_out, n);
+}
+
+/*
+ * decompress count bytes of a compressed raw signal into sig, which holds cap samples
+ * sig is reallocated if it is too small (or allocated if NULL), the scratch buffers of ctx are used for the intermediate steps
+ * returns the possibly moved sig and sets *len to the number of samples
+ * returns NULL on error and sets slow5_errno, sig is then still valid and unchanged in size
+ */
+int16_t *slow5_sig_depress_ctx(struct slow5_decode_ctx *ctx, enum slow5_press_method method, const void *ptr, size_t count, int16_t *sig, uint64_t cap, uint64_t *len) {
+    if (!ctx || !ptr || !len) {
+        if (!ctx) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(ctx));
+        }
+        if (!ptr) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(ptr));
+        }
+        if (!len) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(len));
+        }
+        slow5_errno = SLOW5_ERR_ARG;
+        return NULL;
+    }
+
+    if (method == SLOW5_COMPRESS_SVB_ZD) {
+        return ptr_depress_svb_zd_into(ptr, count, sig, cap, len);
+    }
+
+    /* no specialised decoder */
+    size_t bytes;
+    int16_t *tmp = (int16_t *) slow5_ptr_depress_solo(method, ptr, count, &bytes);
+    if (!tmp) {
+        return NULL;
+    }
+    uint64_t len_tmp = bytes / sizeof *sig;
+    if (!sig || cap < len_tmp) {
+        int16_t *sig_tmp = (int16_t *) realloc(sig, bytes ? bytes : 1);
+        if (!sig_tmp) {
+            SLOW5_MALLOC_ERROR();
+            slow5_errno = SLOW5_ERR_MEM;
+            free(tmp);
+            return NULL;
+        }
+        sig = sig_tmp;
+    }
+    memcpy(sig, tmp, bytes);
+    free(tmp);
+
+    *len = len_tmp;
+    return sig;
+}
+
+/*
+ * get the decompressed size of a compressed raw signal from its first count bytes, without decompressing it
+ * at most SLOW5_PRESS_SIZE_HDR_LEN bytes are used (the number of samples of svb-zd, the frame header of zstd)
+ * returns 0 and sets *n, 1 if the size is not stored (e.g. zlib) or more bytes are needed, <0 on error and sets slow5_errno
+ */
+int slow5_ptr_depress_size(enum slow5_press_method method, const void *ptr, size_t count, size_t *n) {
+    if (!ptr || !n) {
+        if (!ptr) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(ptr));
+        }
+        if (!n) {
+            SLOW5_ERROR("Argument '%s' cannot be NULL.", SLOW5_TO_STR(n));
+        }
+        return slow5_errno = SLOW5_ERR_ARG;
+    }
+
+    switch (method) {
+
+        case SLOW5_COMPRESS_NONE:
+            *n = count;
+            return 0;
+
+        case SLOW5_COMPRESS_SVB_ZD: {
+            uint32_t length;
+            if (count < sizeof length) {
+                return 1;
+            }
+            memcpy(&length, ptr, sizeof length);
+            *n = length * sizeof (int16_t);
+            return 0;
+        }
+
+        case SLOW5_COMPRESS_ZLIB:
+            return 1;
+
+#ifdef SLOW5_USE_ZSTD
+        case SLOW5_COMPRESS_ZSTD: {
+            unsigned long long bytes = ZSTD_getFrameContentSize(ptr, count);
+            if (bytes == ZSTD_CONTENTSIZE_UNKNOWN || bytes == ZSTD_CONTENTSIZE_ERROR) {
+                return 1;
+            }
+            *n = bytes;
+            return 0;
+        }
+#endif /* SLOW5_USE_ZSTD */
+
+        default:
+            SLOW5_ERROR("Invalid or unsupported (de)compression method '%d'.", method);
+            return slow5_errno = SLOW5_ERR_ARG;
+    }
+}
+
 /*
  * decompress count bytes of a ptr to compressed memory
  * returns pointer to decompressed memory of size *n bytes to be later freed
@@ -524,7 +1096,7 @@ void *slow5_ptr_depress(struct __slow5_press *comp, const void *ptr, size_t coun
 
 #ifdef SLOW5_USE_ZSTD
             case SLOW5_COMPRESS_ZSTD:
-                out = ptr_depress_zstd(ptr, count, &n_tmp);
+                out = ptr_depress_zstd(comp->stream->zstd, comp->dict ? comp->dict->ddict : NULL, ptr, count, &n_tmp);
                 break;
 #endif /* SLOW5_USE_ZSTD */
 
@@ -582,7 +1154,7 @@ ssize_t slow5_fwrite_compress(struct __slow5_press *comp, const void *ptr, size_
 
 #ifdef SLOW5_USE_ZSTD
             case SLOW5_COMPRESS_ZSTD:
-                out = ptr_compress_zstd(ptr, size * nmemb, &bytes_tmp);
+                out = ptr_compress_zstd(comp->stream->zstd, ptr, size * nmemb, &bytes_tmp);
                 if (!out) {
                     return -1;
                 }
@@ -785,19 +1357,47 @@ void slow5_compress_footer_next(struct __slow5_press *comp) {
  * ZLIB *
  ********/
 
-static int zlib_init_deflate(z_stream *strm) {
+static int zlib_init_deflate(z_stream *strm, int level) {
     strm->zalloc = Z_NULL;
     strm->zfree = Z_NULL;
     strm->opaque = Z_NULL;
 
     return deflateInit2(strm,
-            Z_DEFAULT_COMPRESSION,
+            level,
             Z_DEFLATED,
             MAX_WBITS,
             SLOW5_ZLIB_MEM_DEFAULT,
             Z_DEFAULT_STRATEGY);
 }
 
+/*
+ * get the inflate stream *strm ready for a new stream: made on first use, then reset instead of ended and made again
+ * returns NULL on error and sets slow5_errno
+ */
+static z_stream *zlib_inflate_reuse(z_stream **strm) {
+    if (*strm) {
+        if (inflateReset(*strm) != Z_OK) {
+            SLOW5_ERROR("%s", "zlib inflate reset failed.");
+            slow5_errno = SLOW5_ERR_PRESS;
+            return NULL;
+        }
+        return *strm;
+    }
+    z_stream *strm_new = (z_stream *) malloc(sizeof *strm_new);
+    if (!strm_new) {
+        SLOW5_MALLOC_ERROR();
+        slow5_errno = SLOW5_ERR_MEM;
+        return NULL;
+    }
+    if (zlib_init_inflate(strm_new) != Z_OK) {
+        SLOW5_ERROR("zlib inflate init failed: %s.", strm_new->msg);
+        free(strm_new);
+        slow5_errno = SLOW5_ERR_PRESS;
+        return NULL;
+    }
+    return *strm = strm_new;
+}
+
 static int zlib_init_inflate(z_stream *strm) {
     strm->zalloc = Z_NULL;
     strm->zfree = Z_NULL;
@@ -851,7 +1451,7 @@ static void *ptr_compress_zlib_solo(const void *ptr, size_t count, size_t *n) {
     size_t n_cur = 0;
 
     z_stream strm_local;
-    zlib_init_deflate(&strm_local);
+    zlib_init_deflate(&strm_local, Z_DEFAULT_COMPRESSION);
     z_stream *strm = &strm_local;
 
     strm->avail_in = count;
@@ -879,7 +1479,7 @@ static void *ptr_compress_zlib_solo(const void *ptr, size_t count, size_t *n) {
 
     *n = n_cur;
 
-    (void) inflateEnd(strm);
+    (void) deflateEnd(strm);
 
     return out;
 }
@@ -942,43 +1542,87 @@ static void *ptr_depress_zlib(struct slow5_zlib_stream *zlib, const void *ptr, s
     return out;
 }
 
+/* decompress with the inflate stream and buffer of the solo decode context of the calling thread into memory of the exact size */
 static void *ptr_depress_zlib_solo(const void *ptr, size_t count, size_t *n) {
-    uint8_t *out = NULL;
+    struct slow5_decode_ctx *ctx = decode_ctx_thread(DECODE_CTX_SOLO);
+    size_t n_cur = 0;
+    void *rec = ctx ? ptr_depress_zlib_ctx(ctx, ptr, count, &n_cur) : NULL;
 
+    void *out = rec ? malloc(n_cur ? n_cur : 1) : NULL;
+    if (rec && !out) {
+        SLOW5_MALLOC_ERROR();
+        slow5_errno = SLOW5_ERR_MEM;
+    }
+    if (out) {
+        memcpy(out, rec, n_cur);
+    }
+
+    *n = out ? n_cur : 0;
+    return out;
+}
+
+/* same as ptr_depress_zlib_solo but inflates into ctx->rec */
+static void *ptr_depress_zlib_ctx(struct slow5_decode_ctx *ctx, const void *ptr, size_t count, size_t *n) {
     size_t n_cur = 0;
 
-    z_stream strm_local;
-    zlib_init_inflate(&strm_local);
-    z_stream *strm = &strm_local;
+    z_stream *strm = zlib_inflate_reuse(&ctx->zlib_strm);
+    if (!strm) {
+        return NULL;
+    }
 
     strm->avail_in = count;
     strm->next_in = (Bytef *) ptr;
 
+    int ret;
     do {
-        out = (uint8_t *) realloc(out, n_cur + SLOW5_ZLIB_DEPRESS_CHUNK);
-        SLOW5_MALLOC_CHK(out);
+        if (slow5_buf_reserve((void **) &ctx->rec, &ctx->rec_cap, n_cur + SLOW5_ZLIB_DEPRESS_CHUNK) != 0) {
+            return NULL;
+        }
 
-        strm->avail_out = SLOW5_ZLIB_DEPRESS_CHUNK;
-        strm->next_out = out + n_cur;
+        strm->avail_out = ctx->rec_cap - n_cur;
+        strm->next_out = ctx->rec + n_cur;
 
-        int ret = inflate(strm, Z_NO_FLUSH);
+        ret = inflate(strm, Z_NO_FLUSH);
         if (ret == Z_STREAM_ERROR || ret == Z_DATA_ERROR || ret == Z_NEED_DICT || ret == Z_MEM_ERROR) {
-            SLOW5_ERROR("%s","inflate failed");
-            free(out);
-            out = NULL;
-            n_cur = 0;
-            break;
+            SLOW5_ERROR("zlib inflate failed with error code %d.", ret);
+            slow5_errno = SLOW5_ERR_PRESS;
+            return NULL;
         }
 
-        n_cur += SLOW5_ZLIB_DEPRESS_CHUNK- strm->avail_out;
+        n_cur = ctx->rec_cap - strm->avail_out;
 
-    } while (strm->avail_out == 0);
+    } while (strm->avail_out == 0 && ret != Z_STREAM_END);
 
     *n = n_cur;
 
-    (void) inflateEnd(strm);
+    return ctx->rec;
+}
 
-    return out;
+/* same as ptr_depress_zlib_ctx but inflates only until min_out bytes are out or the input runs out */
+static void *ptr_depress_zlib_part_ctx(struct slow5_decode_ctx *ctx, const void *ptr, size_t count, size_t min_out, size_t *n) {
+    z_stream *strm = zlib_inflate_reuse(&ctx->zlib_strm);
+    if (!strm || slow5_buf_reserve((void **) &ctx->rec, &ctx->rec_cap, min_out) != 0) {
+        return NULL;
+    }
+
+    strm->avail_in = count;
+    strm->next_in = (Bytef *) ptr;
+    strm->avail_out = min_out;
+    strm->next_out = ctx->rec;
+
+    int ret;
+    do {
+        ret = inflate(strm, Z_SYNC_FLUSH);
+        if (ret == Z_STREAM_ERROR || ret == Z_DATA_ERROR || ret == Z_NEED_DICT || ret == Z_MEM_ERROR) {
+            SLOW5_ERROR("zlib inflate failed with error code %d.", ret);
+            slow5_errno = SLOW5_ERR_PRESS;
+            return NULL;
+        }
+    } while (strm->avail_out != 0 && ret == Z_OK); /* Z_BUF_ERROR once no progress is possible */
+
+    *n = min_out - strm->avail_out;
+
+    return ctx->rec;
 }
 
 static ssize_t fwrite_compress_zlib(struct slow5_zlib_stream *zlib, const void *ptr, size_t size, size_t nmemb, FILE *fp) {
@@ -1031,7 +1675,7 @@ static ssize_t fwrite_compress_zlib(struct slow5_zlib_stream *zlib, const void *
  ***************/
 
 /* return NULL on malloc error, n cannot be NULL */
-static uint8_t *ptr_compress_svb(const uint32_t *ptr, size_t count, size_t *n) {
+static uint8_t *ptr_compress_svb_zd(const int16_t *ptr, size_t count, size_t *n) {
     uint32_t length = count / sizeof *ptr;
 
     size_t max_n = __slow5_streamvbyte_max_compressedbytes(length);
@@ -1042,108 +1686,213 @@ static uint8_t *ptr_compress_svb(const uint32_t *ptr, size_t count, size_t *n) {
         return NULL;
     }
 
-    *n = __slow5_streamvbyte_encode(ptr, length, out + sizeof length);
+    *n = __slow5_streamvbyte_zigzag_delta_encode(ptr, length, out + sizeof length, 0);
     memcpy(out, &length, sizeof length); /* copy original length of ptr (needed for depress) */
     *n = *n + sizeof length;
-    SLOW5_LOG_DEBUG("max svb bytes=%zu\nsvb bytes=%zu\n",
-            max_n, *n); /* TESTING */
+    SLOW5_LOG_DEBUG("orig bytes=%zu\nmax svb bytes=%zu\nsvb bytes=%zu\n",
+            count, max_n, *n); /* TESTING */
     return out;
 }
 
+/*
+ * decode the svb-zd encoded signal ptr of count bytes into sig of at least as many samples as encoded
+ * returns 0 on success, -1 on error and sets slow5_errno
+ */
+static int svb_zd_decode(const uint8_t *ptr, size_t count, int16_t *sig, uint32_t length) {
+    size_t bytes_read = __slow5_streamvbyte_zigzag_delta_decode(ptr + sizeof length, count - sizeof length, sig, length, 0);
+    if (bytes_read == SIZE_MAX) {
+        SLOW5_ERROR("Streamvbyte encoded signal of '%zu' bytes is truncated.", count);
+        slow5_errno = SLOW5_ERR_PRESS;
+        return -1;
+    } else if (bytes_read != count - sizeof length) {
+        SLOW5_ERROR("Expected streamvbyte_decode to read '%zu' bytes, instead read '%zu' bytes.",
+                count - sizeof length, bytes_read);
+        slow5_errno = SLOW5_ERR_PRESS;
+        return -1;
+    }
+    return 0;
+}
+
 /* return NULL on malloc error, n cannot be NULL */
-static uint8_t *ptr_compress_svb_zd(const int16_t *ptr, size_t count, size_t *n) {
-    uint32_t length = count / sizeof *ptr;
-    int32_t *in = (int32_t *) malloc(length * sizeof *in);
-    if (!in) {
-        SLOW5_MALLOC_ERROR();
-        slow5_errno = SLOW5_ERR_MEM;
+static int16_t *ptr_depress_svb_zd(const uint8_t *ptr, size_t count, size_t *n) {
+    uint32_t length;
+    if (count < sizeof length) {
+        SLOW5_ERROR("Streamvbyte encoded signal of '%zu' bytes is too short.", count);
+        slow5_errno = SLOW5_ERR_PRESS;
         return NULL;
     }
-    for (int64_t i = 0; i < length; ++ i) {
-        in[i] = ptr[i];
-    }
+    memcpy(&length, ptr, sizeof length); /* get original array length */
 
-    uint32_t *diff = (uint32_t *) malloc(length * sizeof *diff);
-    if (!diff) {
+    int16_t *orig = (int16_t *) malloc(length * sizeof *orig);
+    if (!orig) {
         SLOW5_MALLOC_ERROR();
-        free(in);
         slow5_errno = SLOW5_ERR_MEM;
         return NULL;
     }
-    __slow5_zigzag_delta_encode(in, diff, length, 0);
-
-
-    SLOW5_LOG_DEBUG("orig bytes=%zu\n", count); /* TESTING */
-    uint8_t *out = ptr_compress_svb(diff, length * sizeof *diff, n);
+    if (svb_zd_decode(ptr, count, orig, length) != 0) {
+        free(orig);
+        return NULL;
+    }
 
-    free(in);
-    free(diff);
-    return out;
+    *n = length * sizeof *orig;
+    return orig;
 }
 
-/* return NULL on malloc error, n cannot be NULL */
-static uint32_t *ptr_depress_svb(const uint8_t *ptr, size_t count, size_t *n) {
+/*
+ * same as ptr_depress_svb_zd but decodes into sig of cap samples (reallocated if too small)
+ * returns NULL on error and sets slow5_errno, sig is then unchanged
+ */
+static int16_t *ptr_depress_svb_zd_into(const uint8_t *ptr, size_t count, int16_t *sig, uint64_t cap, uint64_t *len) {
     uint32_t length;
-    memcpy(&length, ptr, sizeof length); /* get original array length */
-
-    uint32_t *out = (uint32_t *) malloc(length * sizeof *out);
-    if (!out) {
-        SLOW5_MALLOC_ERROR();
-        slow5_errno = SLOW5_ERR_MEM;
+    if (count < sizeof length) {
+        SLOW5_ERROR("Streamvbyte encoded signal of '%zu' bytes is too short.", count);
+        slow5_errno = SLOW5_ERR_PRESS;
         return NULL;
     }
+    memcpy(&length, ptr, sizeof length); /* get original array length */
 
-    size_t bytes_read;
-    if ((bytes_read = __slow5_streamvbyte_decode(ptr + sizeof length, out, length)) != count - sizeof length) {
-        SLOW5_ERROR("Expected streamvbyte_decode to read '%zu' bytes, instead read '%zu' bytes.",
-                count - sizeof length, bytes_read);
-        slow5_errno = SLOW5_ERR_PRESS;
-        free(out);
+    int16_t *sig_new = sig;
+    if (!sig || cap < length) {
+        sig_new = (int16_t *) malloc(length ? length * sizeof *sig : 1);
+        if (!sig_new) {
+            SLOW5_MALLOC_ERROR();
+            slow5_errno = SLOW5_ERR_MEM;
+            return NULL;
+        }
+    }
+    if (svb_zd_decode(ptr, count, sig_new, length) != 0) {
+        if (sig_new != sig) {
+            free(sig_new);
+        }
         return NULL;
     }
+    if (sig_new != sig) {
+        free(sig);
+    }
 
-    *n = length * sizeof *out;
-    return out;
+    *len = length;
+    return sig_new;
 }
 
-/* return NULL on malloc error, n cannot be NULL */
-static int16_t *ptr_depress_svb_zd(const uint8_t *ptr, size_t count, size_t *n) {
 
-    uint32_t *diff = ptr_depress_svb(ptr, count, n);
-    if (!diff) {
-        return NULL;
-    }
-    uint32_t length = *n / sizeof *diff;
 
-    int16_t *orig = (int16_t *) malloc(length * sizeof *orig);
-    if (!orig) {
+#ifdef SLOW5_USE_ZSTD
+/********
+ * ZSTD *
+ ********/
+
+/*
+ * init zstd compression and decompression contexts
+ * returns NULL on error and sets slow5_errno
+ */
+static struct slow5_zstd_stream *zstd_stream_init(void) {
+    struct slow5_zstd_stream *zstd = (struct slow5_zstd_stream *) malloc(sizeof *zstd);
+    if (!zstd) {
         SLOW5_MALLOC_ERROR();
-        free(diff);
         slow5_errno = SLOW5_ERR_MEM;
         return NULL;
     }
-    __slow5_zigzag_delta_decode(diff, orig, length, 0);
+    zstd->cctx = ZSTD_createCCtx();
+    zstd->dctx = ZSTD_createDCtx();
+    if (!zstd->cctx || !zstd->dctx) {
+        SLOW5_ERROR("%s", "zstd create (de)compression context failed.");
+        zstd_stream_free(zstd);
+        slow5_errno = SLOW5_ERR_MEM;
+        return NULL;
+    }
+    size_t ret = ZSTD_CCtx_setParameter((ZSTD_CCtx *) zstd->cctx, ZSTD_c_compressionLevel, SLOW5_ZSTD_COMPRESS_LEVEL);
+    if (!ZSTD_isError(ret)) { /* records written with any window size can be read */
+        ret = ZSTD_DCtx_setParameter((ZSTD_DCtx *) zstd->dctx, ZSTD_d_windowLogMax, ZSTD_dParam_getBounds(ZSTD_d_windowLogMax).upperBound);
+    }
+    if (ZSTD_isError(ret)) {
+        SLOW5_ERROR("zstd set the default parameters failed: %s.", ZSTD_getErrorName(ret));
+        zstd_stream_free(zstd);
+        slow5_errno = SLOW5_ERR_PRESS;
+        return NULL;
+    }
+    return zstd;
+}
 
-    // int16_t *orig = (int16_t *) malloc(length * sizeof *orig);
-    // for (int64_t i = 0; i < length; ++ i) {
-    //     orig[i] = out[i];
-    // }
+/*
+ * set the compression options opt of the compression context of zstd
+ * returns 0 on success, <0 on error and sets slow5_errno
+ * SLOW5_ERR_ARG    an option is out of range (or workers without libzstd threads)
+ */
+static int zstd_stream_set_opt(struct slow5_zstd_stream *zstd, const struct slow5_press_opt *opt) {
+    struct {
+        ZSTD_cParameter param;
+        int value;
+        const char *name;
+    } params[] = {
+        { ZSTD_c_compressionLevel, opt->level, "level" },
+        { ZSTD_c_windowLog, opt->zstd_window_log, "window log" },
+        { ZSTD_c_enableLongDistanceMatching, opt->zstd_long != 0, "long distance matching" },
+        { ZSTD_c_nbWorkers, opt->zstd_workers, "workers" },
+    };
+    for (size_t i = 0; i < sizeof params / sizeof *params; ++ i) {
+        if (!params[i].value) {
+            continue;
+        }
+        size_t ret = ZSTD_CCtx_setParameter((ZSTD_CCtx *) zstd->cctx, params[i].param, params[i].value);
+        if (ZSTD_isError(ret)) {
+            SLOW5_ERROR("Invalid zstd compression option %s '%d': %s.", params[i].name, params[i].value, ZSTD_getErrorName(ret));
+            return slow5_errno = SLOW5_ERR_ARG;
+        }
+    }
+    return 0;
+}
 
-    *n = length * sizeof *orig;
-    free(diff);
-    //free(out);
-    return orig;
+static void zstd_stream_free(struct slow5_zstd_stream *zstd) {
+    if (zstd) {
+        ZSTD_freeCCtx((ZSTD_CCtx *) zstd->cctx);
+        ZSTD_freeDCtx((ZSTD_DCtx *) zstd->dctx);
+        free(zstd);
+    }
 }
 
+/* contexts of the solo functions, one per thread, freed when the thread exits */
+static pthread_key_t zstd_thread_key;
+static pthread_once_t zstd_thread_once = PTHREAD_ONCE_INIT;
+static int zstd_thread_key_ret;
 
+static void zstd_thread_stream_free(void *zstd) {
+    zstd_stream_free((struct slow5_zstd_stream *) zstd);
+}
 
-#ifdef SLOW5_USE_ZSTD
-/********
- * ZSTD *
- ********/
+static void zstd_thread_key_init(void) {
+    zstd_thread_key_ret = pthread_key_create(&zstd_thread_key, zstd_thread_stream_free);
+}
 
-/* return NULL on error */
-static void *ptr_compress_zstd(const void *ptr, size_t count, size_t *n) {
+/*
+ * get the zstd contexts of the calling thread, made on first use
+ * returns NULL on error and sets slow5_errno
+ */
+static struct slow5_zstd_stream *zstd_thread_stream(void) {
+    if (pthread_once(&zstd_thread_once, zstd_thread_key_init) != 0 || zstd_thread_key_ret != 0) {
+        SLOW5_ERROR("%s", "Creating the key of the zstd contexts of each thread failed.");
+        slow5_errno = SLOW5_ERR_OTH;
+        return NULL;
+    }
+    struct slow5_zstd_stream *zstd = (struct slow5_zstd_stream *) pthread_getspecific(zstd_thread_key);
+    if (!zstd) {
+        if (!(zstd = zstd_stream_init())) {
+            return NULL;
+        }
+        if (pthread_setspecific(zstd_thread_key, zstd) != 0) {
+            SLOW5_ERROR("%s", "Keeping the zstd contexts of the thread failed.");
+            zstd_stream_free(zstd);
+            slow5_errno = SLOW5_ERR_OTH;
+            return NULL;
+        }
+    }
+    return zstd;
+}
+
+/* compress with the context of zstd, return NULL on error */
+static void *ptr_compress_zstd(struct slow5_zstd_stream *zstd, const void *ptr, size_t count, size_t *n) {
+    if (!zstd) {
+        return NULL;
+    }
     size_t max_bytes = ZSTD_compressBound(count);
 
     void *out = malloc(max_bytes);
@@ -1153,7 +1902,7 @@ static void *ptr_compress_zstd(const void *ptr, size_t count, size_t *n) {
         return NULL;
     }
 
-    *n = ZSTD_compress(out, max_bytes, ptr, count, SLOW5_ZSTD_COMPRESS_LEVEL);
+    *n = ZSTD_compress2((ZSTD_CCtx *) zstd->cctx, out, max_bytes, ptr, count);
     if (ZSTD_isError(*n)) {
         SLOW5_ERROR("zstd compress failed with error code %zu.", *n);
         free(out);
@@ -1164,8 +1913,21 @@ static void *ptr_compress_zstd(const void *ptr, size_t count, size_t *n) {
     return out;
 }
 
-/* return NULL on error */
-static void *ptr_depress_zstd(const void *ptr, size_t count, size_t *n) {
+/* make dctx decompress with the dictionary ddict, or without one if NULL, returns 0 or a zstd error code */
+static size_t zstd_ref_ddict(ZSTD_DCtx *dctx, const void *ddict) {
+    size_t ret = ZSTD_DCtx_refDDict(dctx, (const ZSTD_DDict *) ddict);
+    if (ZSTD_isError(ret)) {
+        SLOW5_ERROR("zstd set the dictionary failed: %s.", ZSTD_getErrorName(ret));
+        slow5_errno = SLOW5_ERR_PRESS;
+    }
+    return ret;
+}
+
+/* decompress with the context of zstd and the dictionary ddict (none if NULL), return NULL on error */
+static void *ptr_depress_zstd(struct slow5_zstd_stream *zstd, const void *ddict, const void *ptr, size_t count, size_t *n) {
+    if (!zstd || ZSTD_isError(zstd_ref_ddict((ZSTD_DCtx *) zstd->dctx, ddict))) {
+        return NULL;
+    }
     unsigned long long depress_bytes = ZSTD_getFrameContentSize(ptr, count);
     if (depress_bytes == ZSTD_CONTENTSIZE_UNKNOWN ||
             depress_bytes == ZSTD_CONTENTSIZE_ERROR) {
@@ -1181,7 +1943,7 @@ static void *ptr_depress_zstd(const void *ptr, size_t count, size_t *n) {
         return NULL;
     }
 
-    *n = ZSTD_decompress(out, depress_bytes, ptr, count);
+    *n = ZSTD_decompressDCtx((ZSTD_DCtx *) zstd->dctx, out, depress_bytes, ptr, count);
     if (ZSTD_isError(*n)) {
         SLOW5_ERROR("zstd decompress failed with error code %zu.", *n);
         free(out);
@@ -1191,6 +1953,92 @@ static void *ptr_depress_zstd(const void *ptr, size_t count, size_t *n) {
 
     return out;
 }
+
+/* a decompression stream reading any window size, returns NULL on error and sets slow5_errno */
+static ZSTD_DStream *zstd_dstream_init(void) {
+    ZSTD_DStream *ds = ZSTD_createDStream();
+    if (!ds) {
+        SLOW5_ERROR("%s", "zstd create decompression stream failed.");
+        slow5_errno = SLOW5_ERR_MEM;
+        return NULL;
+    }
+    size_t ret = ZSTD_DCtx_setParameter(ds, ZSTD_d_windowLogMax, ZSTD_dParam_getBounds(ZSTD_d_windowLogMax).upperBound);
+    if (ZSTD_isError(ret)) {
+        SLOW5_ERROR("zstd set the window size limit failed: %s.", ZSTD_getErrorName(ret));
+        ZSTD_freeDStream(ds);
+        slow5_errno = SLOW5_ERR_PRESS;
+        return NULL;
+    }
+    return ds;
+}
+
+/* same as ptr_depress_zstd but decompresses into ctx->rec with the dstream of ctx */
+static void *ptr_depress_zstd_ctx(struct slow5_decode_ctx *ctx, const void *ddict, const void *ptr, size_t count, size_t *n) {
+    if (!ctx->zstd_dstream && !(ctx->zstd_dstream = zstd_dstream_init())) {
+        return NULL;
+    }
+    if (ZSTD_isError(zstd_ref_ddict((ZSTD_DCtx *) ctx->zstd_dstream, ddict))) {
+        return NULL;
+    }
+    unsigned long long depress_bytes = ZSTD_getFrameContentSize(ptr, count);
+    if (depress_bytes == ZSTD_CONTENTSIZE_UNKNOWN ||
+            depress_bytes == ZSTD_CONTENTSIZE_ERROR) {
+        SLOW5_ERROR("zstd get decompressed size failed with error code %llu\n", depress_bytes);
+        slow5_errno = SLOW5_ERR_PRESS;
+        return NULL;
+    }
+
+    if (slow5_buf_reserve((void **) &ctx->rec, &ctx->rec_cap, depress_bytes) != 0) {
+        return NULL;
+    }
+
+    *n = ZSTD_decompressDCtx((ZSTD_DCtx *) ctx->zstd_dstream, ctx->rec, depress_bytes, ptr, count);
+    if (ZSTD_isError(*n)) {
+        SLOW5_ERROR("zstd decompress failed with error code %zu.", *n);
+        slow5_errno = SLOW5_ERR_PRESS;
+        return NULL;
+    }
+
+    return ctx->rec;
+}
+
+/* same as ptr_depress_zstd_ctx but streams only until min_out bytes are out or the input runs out, with the dstream of ctx */
+static void *ptr_depress_zstd_part_ctx(struct slow5_decode_ctx *ctx, const void *ddict, const void *ptr, size_t count, size_t min_out, size_t *n) {
+    if (!ctx->zstd_dstream && !(ctx->zstd_dstream = zstd_dstream_init())) {
+        return NULL;
+    }
+    ZSTD_DStream *ds = (ZSTD_DStream *) ctx->zstd_dstream;
+    size_t ret = ZSTD_initDStream(ds); /* also drops the dictionary */
+    if (ZSTD_isError(ret)) {
+        SLOW5_ERROR("zstd init decompression stream failed with error code %zu.", ret);
+        slow5_errno = SLOW5_ERR_PRESS;
+        return NULL;
+    }
+    if (ZSTD_isError(zstd_ref_ddict(ds, ddict))) {
+        return NULL;
+    }
+    if (slow5_buf_reserve((void **) &ctx->rec, &ctx->rec_cap, min_out) != 0) {
+        return NULL;
+    }
+
+    ZSTD_inBuffer in = { ptr, count, 0 };
+    ZSTD_outBuffer out = { ctx->rec, min_out, 0 };
+    while (out.pos < out.size) {
+        ret = ZSTD_decompressStream(ds, &out, &in);
+        if (ZSTD_isError(ret)) {
+            SLOW5_ERROR("zstd decompress failed with error code %zu.", ret);
+            slow5_errno = SLOW5_ERR_PRESS;
+            return NULL;
+        }
+        if (ret == 0 || (in.pos == in.size && out.pos < out.size)) {
+            /* end of frame, or everything that could be was flushed and more input is needed */
+            break;
+        }
+    }
+    *n = out.pos;
+
+    return ctx->rec;
+}
 #endif /* SLOW5_USE_ZSTD */
 
 
@@ -49,13 +49,14 @@ int main(int argc, char *argv[]) {
        perror("perr: ");
        exit(EXIT_FAILURE);
     }
+    slow5_mt_t *mt = slow5_init_mt(num_thread,sp);
 
     tot_time += realtime() - t0;
 
     while(ret > 0){
 
         t0 = realtime();
-        ret = slow5_get_next_batch(&rec,sp,batch_size,num_thread);
+        ret = slow5_get_next_batch(&rec,mt,batch_size);
         tot_time += realtime() - t0;
         fprintf(stderr,"batch loaded with %d reads\n",ret);
 
@@ -73,6 +74,7 @@ int main(int argc, char *argv[]) {
     }
 
     t0 = realtime();
+    slow5_free_mt(mt);
     slow5_close(sp);
     tot_time += realtime() - t0;
 
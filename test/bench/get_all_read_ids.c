@@ -1,11 +1,17 @@
 //get all the read ids and print them to stdout
+//from the index, or with -s by a sequential scan that only decompresses the start of each record (no index needed)
 //make zstd=1
 //gcc -Wall -O2 -I include/ -o get_all_read_ids test/bench/get_all_read_ids.c lib/libslow5.a -lm -lz -lzstd
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <slow5/slow5.h>
 #include <sys/time.h>
+#include "../../src/slow5_extra.h"
+
+#define ID_PART_LEN (256) //decompressed bytes to get the read ID at first, doubled until it is all there
 
 static inline double realtime(void) {
     struct timeval tp;
@@ -15,23 +21,100 @@ static inline double realtime(void) {
 }
 
 
+//write the read ID of every record of sp to fp, decompressing only the start of each record
+static uint64_t scan_read_ids(slow5_file_t *sp, FILE *fp, double *tot_time) {
+
+    struct slow5_decode_ctx *ctx = slow5_decode_ctx_init();
+    if(ctx==NULL){
+        fprintf(stderr,"Error in creating the decode context\n");
+        exit(EXIT_FAILURE);
+    }
+    const struct __slow5_press *comp = sp->compress ? sp->compress->record_press : NULL;
+
+    uint64_t num_reads = 0;
+    char *mem;
+    size_t bytes;
+    double t0 = realtime();
+    while((mem = (char *)slow5_get_next_mem(&bytes, sp)) != NULL) {
+        size_t want = ID_PART_LEN;
+        size_t n = 0;
+        char *rec = NULL;
+        slow5_rid_len_t len = 0;
+        while(1) {
+            rec = (char *)slow5_rec_depress_part_ctx(ctx, comp, mem, bytes, want, &n);
+            if(rec==NULL){
+                fprintf(stderr,"Error in decompressing record %" PRIu64 "\n", num_reads);
+                exit(EXIT_FAILURE);
+            }
+            if(n >= sizeof len){
+                memcpy(&len, rec, sizeof len);
+                if(n >= sizeof len + len){
+                    break;
+                }
+            }
+            if(n < want){ //the whole record is out
+                fprintf(stderr,"Record %" PRIu64 " is truncated\n", num_reads);
+                exit(EXIT_FAILURE);
+            }
+            want *= 2;
+        }
+        *tot_time += realtime() - t0;
+
+        fwrite(rec + sizeof len, 1, len, fp);
+        fputc('\n',fp);
+        free(mem);
+        num_reads++;
+        t0 = realtime();
+    }
+    if(slow5_errno != SLOW5_ERR_EOF){
+        fprintf(stderr,"Error in reading record %" PRIu64 "\n", num_reads);
+        exit(EXIT_FAILURE);
+    }
+    *tot_time += realtime() - t0;
+
+    slow5_decode_ctx_free(ctx);
+    return num_reads;
+}
+
 int main(int argc, char *argv[]) {
 
-    if(argc != 3) {
-        fprintf(stderr, "Usage: %s in_file.blow5 out_file.csv\n", argv[0]);
+    int scan = argc == 4 && strcmp(argv[1], "-s") == 0;
+    if(argc != 3 && !scan) {
+        fprintf(stderr, "Usage: %s [-s] in_file.blow5 out_file.csv\n", argv[0]);
         return EXIT_FAILURE;
     }
+    const char *in_path = argv[argc - 2];
+    const char *out_path = argv[argc - 1];
 
     double tot_time = 0;
     double t0 = realtime();
 
-    slow5_file_t *sp = slow5_open(argv[1],"r");
+    slow5_file_t *sp = slow5_open(in_path,"r");
     if(sp==NULL){
        fprintf(stderr,"Error in opening file\n");
        perror("perr: ");
        exit(EXIT_FAILURE);
     }
 
+    if(scan) {
+        FILE *fp = fopen(out_path,"w");
+        if(fp==NULL){
+            fprintf(stderr,"Error in opening file %s for writing\n",out_path);
+            perror("perr: ");
+            exit(EXIT_FAILURE);
+        }
+        fputs("read_id\n", fp);
+        uint64_t num_reads = scan_read_ids(sp, fp, &tot_time);
+        fclose(fp);
+
+        t0 = realtime();
+        slow5_close(sp);
+        tot_time += realtime() - t0;
+
+        fprintf(stderr,"Time taken for scanning %" PRIu64 " read IDs: %f\n", num_reads, tot_time);
+        return 0;
+    }
+
     int ret=0;
     ret = slow5_idx_load(sp);
     if(ret<0){
@@ -45,9 +128,9 @@ int main(int argc, char *argv[]) {
     tot_time += realtime() - t0;
 
 
-    FILE *fp = fopen(argv[2],"w");
+    FILE *fp = fopen(out_path,"w");
     if(fp==NULL){
-        fprintf(stderr,"Error in opening file %s for writing\n",argv[2]);
+        fprintf(stderr,"Error in opening file %s for writing\n",out_path);
         perror("perr: ");
         exit(EXIT_FAILURE);
     }
@@ -1,13 +1,12 @@
 //get all the samples and sum them to stdout
 //make zstd=1
-//gcc -Wall -O2 -I include/ -o get_selected_read_ids_sample_count test/bench/get_selected_read_ids_sample_count.c lib/libslow5.a python/slow5threads.c -lm -lz -lzstd -lpthread
+//gcc -Wall -O2 -I include/ -o get_selected_read_ids_sample_count test/bench/get_selected_read_ids_sample_count.c lib/libslow5.a -lm -lz -lzstd -lpthread
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <slow5/slow5.h>
 #include <omp.h>
 #include <sys/time.h>
-#include "../../python/slow5threads.h"
 
 static inline double realtime(void) {
     struct timeval tp;
@@ -19,10 +18,12 @@ static inline double realtime(void) {
 
 int main(int argc, char *argv[]) {
 
-    if(argc != 6) {
-        fprintf(stderr, "Usage: %s in_file.blow5 inread_id.csv out_file.csv num_thread batch_size\n", argv[0]);
+    if(argc != 6 && argc != 7) {
+        fprintf(stderr, "Usage: %s in_file.blow5 inread_id.csv out_file.csv num_thread batch_size [idx_col]\n", argv[0]);
+        fprintf(stderr, "idx_col: get the sample counts from an index made with the len_raw_signal column (see slow5_idx_create_cols)\n");
         return EXIT_FAILURE;
     }
+    int idx_col = argc == 7 && strcmp(argv[6], "idx_col") == 0;
 
     int ret=0;
     int batch_size = atoi(argv[5]);
@@ -54,7 +55,7 @@ int main(int argc, char *argv[]) {
     double tot_time = 0;
     double t0 = realtime();
 
-    slow5_rec_t **rec = NULL;
+    slow5_rec_t **rec = calloc(batch_size, sizeof(slow5_rec_t *));
     slow5_file_t *sp = slow5_open(argv[1],"r");
     if(sp==NULL){
        fprintf(stderr,"Error in opening file\n");
@@ -83,14 +84,39 @@ int main(int argc, char *argv[]) {
         }
         int num_rid = i;
 
+        if(idx_col){
+            //no record is read
+            t0 = realtime();
+            for(int i=0;i<num_rid;i++){
+                const void *len = slow5_get_idx_col(rid[i], "len_raw_signal", NULL, NULL, sp);
+                if(len==NULL){
+                    fprintf(stderr,"Error in getting the sample count of %s from the index\n",rid[i]);
+                    exit(EXIT_FAILURE);
+                }
+                memcpy(&sums[i], len, sizeof sums[i]);
+            }
+            tot_time += realtime() - t0;
+            for(int i=0;i<num_rid;i++){
+                fprintf(fpw,"%s,%ld\n",rid[i],sums[i]);
+            }
+            for(int i=0; i<num_rid; i++){
+                free(rid[i]);
+            }
+            if(num_rid<batch_size){
+                break;
+            }
+            continue;
+        }
+
         t0 = realtime();
-        ret = slow5_get_batch(&rec, sp, rid, num_rid, num_thread);
+        ret = slow5_get_many(rid, num_rid, rec, num_thread, sp);
         tot_time += realtime() - t0;
 
-        if(ret!=num_rid){
+        if(ret<0){
             fprintf(stderr,"Error in getting batch\n");
             exit(EXIT_FAILURE);
         }
+        ret = num_rid;
         fprintf(stderr,"batch loaded with %d reads\n",ret);
 
         for(int i=0;i<ret;i++){
@@ -98,10 +124,6 @@ int main(int argc, char *argv[]) {
         }
         fprintf(stderr,"batch printed with %d reads\n",ret);
 
-        t0 = realtime();
-        slow5_free_batch(&rec,ret);
-        tot_time += realtime() - t0;
-
         for(int i=0; i<num_rid; i++){
             free(rid[i]);
         }
@@ -113,6 +135,10 @@ int main(int argc, char *argv[]) {
     }
 
     t0 = realtime();
+    for(int i=0; i<batch_size; i++){
+        slow5_rec_free(rec[i]);
+    }
+    free(rec);
     slow5_idx_unload(sp);
     slow5_close(sp);
     tot_time += realtime() - t0;
@@ -1,13 +1,12 @@
 //get all the samples and sum them to stdout
 //make zstd=1
-//gcc -Wall -O2 -I include/ -o get_selected_read_ids_samples test/bench/get_selected_read_ids_samples.c lib/libslow5.a python/slow5threads.c -lm -lz -lzstd -lpthread  -fopenmp
+//gcc -Wall -O2 -I include/ -o get_selected_read_ids_samples test/bench/get_selected_read_ids_samples.c lib/libslow5.a -lm -lz -lzstd -lpthread  -fopenmp
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <slow5/slow5.h>
 #include <omp.h>
 #include <sys/time.h>
-#include "../../python/slow5threads.h"
 
 static inline double realtime(void) {
     struct timeval tp;
@@ -55,7 +54,7 @@ int main(int argc, char *argv[]) {
     double tot_time = 0;
     double t0 = realtime();
 
-    slow5_rec_t **rec = NULL;
+    slow5_rec_t **rec = calloc(batch_size, sizeof(slow5_rec_t *));
     slow5_file_t *sp = slow5_open(argv[1],"r");
     if(sp==NULL){
        fprintf(stderr,"Error in opening file\n");
@@ -85,13 +84,14 @@ int main(int argc, char *argv[]) {
         int num_rid = i;
 
         t0 = realtime();
-        ret = slow5_get_batch(&rec, sp, rid, num_rid, num_thread);
+        ret = slow5_get_many(rid, num_rid, rec, num_thread, sp);
         tot_time += realtime() - t0;
 
-        if(ret!=num_rid){
+        if(ret<0){
             fprintf(stderr,"Error in getting batch\n");
             exit(EXIT_FAILURE);
         }
+        ret = num_rid;
         fprintf(stderr,"batch loaded with %d reads\n",ret);
 
         #pragma omp parallel for
@@ -109,10 +109,6 @@ int main(int argc, char *argv[]) {
         }
         fprintf(stderr,"batch printed with %d reads\n",ret);
 
-        t0 = realtime();
-        slow5_free_batch(&rec,ret);
-        tot_time += realtime() - t0;
-
         for(int i=0; i<num_rid; i++){
             free(rid[i]);
         }
@@ -124,6 +120,10 @@ int main(int argc, char *argv[]) {
     }
 
     t0 = realtime();
+    for(int i=0; i<batch_size; i++){
+        slow5_rec_free(rec[i]);
+    }
+    free(rec);
     slow5_idx_unload(sp);
     slow5_close(sp);
     tot_time += realtime() - t0;
@@ -959,6 +959,41 @@ int slow5_add_rec_valid(void) {
     return EXIT_SUCCESS;
 }
 
+// adding to a mapped index moves it to memory, then it is written back on close
+int slow5_add_rec_idx_mapped(void) {
+    remove("test/data/out/exp_1_default_add_idx.slow5.idx");
+    struct slow5_file *s5p = slow5_open("test/data/out/exp_1_default_add_idx.slow5", "r+");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_set_idx_v2(s5p, 1) == 0);
+    ASSERT(slow5_idx_create(s5p) == 0);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->map != NULL);
+
+    struct slow5_rec *read = slow5_rec_init();
+    ASSERT(slow5_get_next(&read, s5p) == 0);
+    char *read_id = strdup(read->read_id);
+    ASSERT(read_id);
+    read->read_id[strlen(read->read_id) - 1] = '\0';
+    ASSERT(slow5_add_rec(read, s5p) == 0);
+    ASSERT(s5p->index->map == NULL);
+    ASSERT(s5p->index->num_ids == 2);
+    ASSERT(slow5_close(s5p) == 0);
+
+    s5p = slow5_open("test/data/out/exp_1_default_add_idx.slow5", "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->map != NULL);
+    ASSERT(s5p->index->num_ids == 2);
+    struct slow5_rec_idx read_idx;
+    ASSERT(slow5_idx_get(s5p->index, read_id, &read_idx) == 0);
+    ASSERT(slow5_idx_get(s5p->index, read->read_id, &read_idx) == 0);
+    ASSERT(slow5_close(s5p) == 0);
+
+    free(read_id);
+    slow5_rec_free(read);
+    return EXIT_SUCCESS;
+}
+
 int slow5_add_rec_duplicate(void) {
     remove("test/data/out/exp_1_default_add_duplicate.slow5.idx");
     struct slow5_file *s5p = slow5_open("test/data/out/exp_1_default_add_duplicate.slow5", "r+");
@@ -1046,6 +1081,7 @@ int main(void) {
         CMD(slow5_add_rec_null)
         CMD(slow5_add_rec_valid)
         CMD(slow5_add_rec_duplicate)
+        CMD(slow5_add_rec_idx_mapped)
 
         CMD(slow5_skip_load_index)
         CMD(slow5_record_parsing_check)
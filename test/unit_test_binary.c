@@ -3,6 +3,8 @@
 #include <limits.h>
 #include <float.h>
 #include <math.h> // TODO need this?
+#include <sys/stat.h>
+#include <unistd.h>
 #include "unit_test.h"
 #include <slow5/slow5.h>
 #include "slow5_extra.h"
@@ -309,6 +311,1602 @@ int slow5_rec_to_mem_zlib(void) {
 }
 
 
+static int readahead_same_as_get_next(const char *pathname) {
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    struct slow5_file *s5p_ra = slow5_open(pathname, "r");
+    ASSERT(s5p_ra != NULL);
+    ASSERT(slow5_set_readahead(s5p_ra, 4) == 0);
+    ASSERT(slow5_set_readahead(s5p_ra, 4) == SLOW5_ERR_ARG);
+
+    struct slow5_rec *read = NULL;
+    struct slow5_rec *read_ra = NULL;
+    int ret;
+    int n = 0;
+    while ((ret = slow5_get_next(&read, s5p)) >= 0) {
+        ASSERT(slow5_get_next(&read_ra, s5p_ra) >= 0);
+        ASSERT(strcmp(read->read_id, read_ra->read_id) == 0);
+        ASSERT(read->len_raw_signal == read_ra->len_raw_signal);
+        ASSERT(memcmp(read->raw_signal, read_ra->raw_signal, read->len_raw_signal * sizeof *read->raw_signal) == 0);
+        if (++ n == 3) {
+            // records already read ahead must still come out in order
+            ASSERT(slow5_set_readahead(s5p_ra, 0) == 0);
+        } else if (n == 6) {
+            ASSERT(slow5_set_readahead(s5p_ra, 2) == 0);
+        }
+    }
+    ASSERT(ret == SLOW5_ERR_EOF);
+    ASSERT(n > 6);
+    ASSERT(slow5_get_next(&read_ra, s5p_ra) == SLOW5_ERR_EOF);
+    ASSERT(slow5_get_next(&read_ra, s5p_ra) == SLOW5_ERR_EOF);
+
+    slow5_rec_free(read);
+    slow5_rec_free(read_ra);
+    ASSERT(slow5_close(s5p) == 0);
+    ASSERT(slow5_close(s5p_ra) == 0);
+
+    // closing while the thread is still reading ahead
+    s5p_ra = slow5_open(pathname, "r");
+    ASSERT(s5p_ra != NULL);
+    ASSERT(slow5_set_readahead(s5p_ra, 1) == 0);
+    read_ra = NULL;
+    ASSERT(slow5_get_next(&read_ra, s5p_ra) >= 0);
+    slow5_rec_free(read_ra);
+    ASSERT(slow5_close(s5p_ra) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+// multi-record blow5 with compressed records and signal
+static int same_diff_ids_to_zlib(void) {
+    struct slow5_file *from = slow5_open("test/data/test/same_diff_ids.slow5", "r");
+    ASSERT(from != NULL);
+    FILE *to = fopen("test/data/out/same_diff_ids_zlib.blow5", "w");
+    ASSERT(to != NULL);
+    slow5_press_method_t method = {SLOW5_COMPRESS_ZLIB, SLOW5_COMPRESS_SVB_ZD};
+    ASSERT(slow5_convert(from, to, SLOW5_FORMAT_BINARY, method) == 0);
+    ASSERT(slow5_close(from) == 0);
+    ASSERT(fclose(to) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_get_next_readahead(void) {
+    ASSERT(same_diff_ids_to_zlib() == EXIT_SUCCESS);
+
+    ASSERT(readahead_same_as_get_next("test/data/out/same_diff_ids_zlib.blow5") == EXIT_SUCCESS);
+    ASSERT(readahead_same_as_get_next("test/data/test/same_diff_ids.slow5") == EXIT_SUCCESS);
+
+    ASSERT(slow5_set_readahead(NULL, 1) == SLOW5_ERR_ARG);
+
+    return EXIT_SUCCESS;
+}
+
+static int mmap_same_as_pread(const char *pathname) {
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    uint64_t num_ids;
+    char **ids = slow5_get_rids(s5p, &num_ids);
+    ASSERT(ids != NULL);
+    ASSERT(num_ids > 0);
+    struct slow5_file *s5p_map = slow5_open(pathname, "rm");
+    ASSERT(s5p_map != NULL);
+    ASSERT(s5p_map->meta.mmap_addr != NULL);
+    ASSERT(slow5_get_mem_map(ids[0], NULL, s5p_map) == NULL);
+    ASSERT(slow5_errno == SLOW5_ERR_NOIDX);
+    ASSERT(slow5_idx_load(s5p_map) == 0);
+
+    struct slow5_rec *read = NULL;
+    struct slow5_rec *read_map = NULL;
+    struct slow5_rec *read_ctx = NULL;
+    struct slow5_decode_ctx *ctx = slow5_decode_ctx_init();
+    ASSERT(ctx != NULL);
+    for (uint64_t i = 0; i < num_ids; ++ i) {
+        ASSERT(slow5_get(ids[i], &read, s5p) == 0);
+        ASSERT(slow5_get(ids[i], &read_map, s5p_map) == 0);
+        ASSERT(strcmp(read->read_id, read_map->read_id) == 0);
+        ASSERT(read->len_raw_signal == read_map->len_raw_signal);
+        ASSERT(memcmp(read->raw_signal, read_map->raw_signal, read->len_raw_signal * sizeof *read->raw_signal) == 0);
+        // same context for both files and all records
+        for (int j = 0; j < 2; ++ j) {
+            ASSERT(slow5_get_ctx(ids[i], &read_ctx, j ? s5p_map : s5p, ctx) == 0);
+            ASSERT(strcmp(read->read_id, read_ctx->read_id) == 0);
+            ASSERT(read->len_raw_signal == read_ctx->len_raw_signal);
+            ASSERT(memcmp(read->raw_signal, read_ctx->raw_signal, read->len_raw_signal * sizeof *read->raw_signal) == 0);
+        }
+
+        size_t n;
+        size_t n_map;
+        void *mem = slow5_get_mem(ids[i], &n, s5p);
+        ASSERT(mem != NULL);
+        const void *mem_map = slow5_get_mem_map(ids[i], &n_map, s5p_map);
+        ASSERT(mem_map != NULL);
+        ASSERT(n == n_map);
+        ASSERT(memcmp(mem, mem_map, n) == 0);
+        free(mem);
+    }
+
+    size_t n = 1;
+    ASSERT(slow5_get_mem_map("doesnt_exist", &n, s5p_map) == NULL);
+    ASSERT(slow5_errno == SLOW5_ERR_NOTFOUND);
+    ASSERT(n == 0);
+    ASSERT(slow5_get_mem_map(ids[0], &n, s5p) == NULL);
+    ASSERT(slow5_errno == SLOW5_ERR_ARG);
+
+    ASSERT(slow5_get_ctx(ids[0], &read_ctx, s5p, NULL) == SLOW5_ERR_ARG);
+
+    slow5_rec_free(read);
+    slow5_rec_free(read_map);
+    slow5_rec_free(read_ctx);
+    slow5_decode_ctx_free(ctx);
+    ASSERT(slow5_close(s5p) == 0);
+    ASSERT(slow5_close(s5p_map) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_get_mmap(void) {
+    ASSERT(same_diff_ids_to_zlib() == EXIT_SUCCESS);
+
+    ASSERT(mmap_same_as_pread("test/data/exp/one_fast5/exp_1_default.blow5") == EXIT_SUCCESS);
+    ASSERT(mmap_same_as_pread("test/data/out/same_diff_ids_zlib.blow5") == EXIT_SUCCESS);
+    ASSERT(mmap_same_as_pread("test/data/test/same_diff_ids.slow5") == EXIT_SUCCESS);
+
+    return EXIT_SUCCESS;
+}
+
+static int view_same_as_rec(const struct slow5_rec_view *view, const struct slow5_rec *read) {
+    ASSERT(view->read_id_len == read->read_id_len);
+    ASSERT(strncmp(view->read_id, read->read_id, view->read_id_len) == 0);
+    ASSERT(view->read_group == read->read_group);
+    ASSERT(view->digitisation == read->digitisation);
+    ASSERT(view->offset == read->offset);
+    ASSERT(view->range == read->range);
+    ASSERT(view->sampling_rate == read->sampling_rate);
+    ASSERT(view->len_raw_signal == read->len_raw_signal);
+    ASSERT(memcmp(view->raw_signal, read->raw_signal, read->len_raw_signal * sizeof *read->raw_signal) == 0);
+
+    const struct slow5_aux_meta *aux_meta = view->aux_meta;
+    for (uint32_t i = 0; aux_meta && i < aux_meta->num; ++ i) {
+        uint64_t len;
+        enum slow5_aux_type type;
+        const void *data = slow5_rec_view_aux_get(view, aux_meta->attrs[i], &len, &type);
+        ASSERT(data != NULL);
+        ASSERT(type == aux_meta->types[i]);
+
+        khint_t pos = kh_get(slow5_s2a, read->aux_map, aux_meta->attrs[i]);
+        ASSERT(pos != kh_end(read->aux_map));
+        struct slow5_rec_aux_data *aux_data = &kh_value(read->aux_map, pos);
+        ASSERT(len == aux_data->len);
+        ASSERT(memcmp(data, aux_data->data, aux_data->bytes) == 0);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int view_same_as_get(const char *pathname, const char *mode) {
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    struct slow5_file *s5p_view = slow5_open(pathname, mode);
+    ASSERT(s5p_view != NULL);
+    ASSERT(slow5_idx_load(s5p_view) == 0);
+
+    struct slow5_rec *read = NULL;
+    struct slow5_rec_view *view = NULL;
+    struct slow5_rec_view *view_get = NULL;
+    int ret;
+    int n = 0;
+    while ((ret = slow5_get_next(&read, s5p)) >= 0) {
+        ASSERT(slow5_get_next_view(&view, s5p_view) == 0);
+        ASSERT(view_same_as_rec(view, read) == EXIT_SUCCESS);
+        ASSERT(slow5_get_view(read->read_id, &view_get, s5p_view) == 0);
+        ASSERT(view_same_as_rec(view_get, read) == EXIT_SUCCESS);
+        ++ n;
+    }
+    ASSERT(ret == SLOW5_ERR_EOF);
+    ASSERT(n > 0);
+    ASSERT(slow5_get_next_view(&view, s5p_view) == SLOW5_ERR_EOF);
+    ASSERT(slow5_get_view("doesnt_exist", &view_get, s5p_view) == SLOW5_ERR_NOTFOUND);
+    ASSERT(slow5_rec_view_aux_get(view_get, "doesnt_exist", NULL, NULL) == NULL);
+    ASSERT(slow5_errno == (view_get->aux_meta ? SLOW5_ERR_NOFLD : SLOW5_ERR_NOAUX));
+
+    slow5_rec_free(read);
+    slow5_rec_view_free(view);
+    slow5_rec_view_free(view_get);
+    ASSERT(slow5_close(s5p) == 0);
+    ASSERT(slow5_close(s5p_view) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_get_view_valid(void) {
+    ASSERT(same_diff_ids_to_zlib() == EXIT_SUCCESS);
+
+    const char *pathnames[] = {
+        "test/data/exp/one_fast5/exp_1_default.blow5",
+        "test/data/exp/one_fast5/exp_1_lossless_gzip.blow5",
+        "test/data/exp/aux_array/exp_lossless.blow5",
+        "test/data/exp/aux_array/exp_lossless_gzip.blow5",
+        "test/data/out/same_diff_ids_zlib.blow5",
+    };
+    for (size_t i = 0; i < sizeof pathnames / sizeof *pathnames; ++ i) {
+        ASSERT(view_same_as_get(pathnames[i], "r") == EXIT_SUCCESS);
+        ASSERT(view_same_as_get(pathnames[i], "rm") == EXIT_SUCCESS);
+    }
+
+    struct slow5_rec_view *view = NULL;
+    struct slow5_file *s5p = slow5_open("test/data/test/same_diff_ids.slow5", "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_get_next_view(&view, s5p) == SLOW5_ERR_ARG);
+    ASSERT(slow5_get_next_view(NULL, s5p) == SLOW5_ERR_ARG);
+    ASSERT(view == NULL);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+static int many_same_as_get(const char *pathname, const char *mode, int num_thread) {
+    struct slow5_file *s5p = slow5_open(pathname, mode);
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+
+    uint64_t num_ids;
+    char **ids = slow5_get_rids(s5p, &num_ids);
+    ASSERT(ids != NULL);
+    ASSERT(num_ids > 0);
+
+    // reverse order with the last read ID repeated
+    size_t n = num_ids + 1;
+    char **read_ids = malloc(n * sizeof *read_ids);
+    ASSERT(read_ids);
+    for (uint64_t i = 0; i < num_ids; ++ i) {
+        read_ids[i] = ids[num_ids - 1 - i];
+    }
+    read_ids[num_ids] = ids[num_ids - 1];
+
+    struct slow5_rec **reads = calloc(n, sizeof *reads);
+    ASSERT(reads);
+    ASSERT(slow5_get_many(read_ids, n, reads, num_thread, s5p) == 0);
+    // again into the same records
+    ASSERT(slow5_get_many(read_ids, n, reads, num_thread, s5p) == 0);
+
+    struct slow5_rec *read = NULL;
+    for (size_t i = 0; i < n; ++ i) {
+        ASSERT(slow5_get(read_ids[i], &read, s5p) == 0);
+        ASSERT(strcmp(reads[i]->read_id, read_ids[i]) == 0);
+        size_t size, size_many;
+        void *mem = slow5_rec_to_mem(read, s5p->header->aux_meta, SLOW5_FORMAT_BINARY, NULL, &size);
+        void *mem_many = slow5_rec_to_mem(reads[i], s5p->header->aux_meta, SLOW5_FORMAT_BINARY, NULL, &size_many);
+        ASSERT(mem && mem_many);
+        ASSERT(size == size_many);
+        ASSERT(memcmp(mem, mem_many, size) == 0);
+        free(mem);
+        free(mem_many);
+    }
+    slow5_rec_free(read);
+
+    read_ids[0] = "doesnt_exist";
+    ASSERT(slow5_get_many(read_ids, n, reads, num_thread, s5p) == SLOW5_ERR_NOTFOUND);
+    ASSERT(slow5_get_many(read_ids, 0, reads, num_thread, s5p) == 0);
+
+    for (size_t i = 0; i < n; ++ i) {
+        slow5_rec_free(reads[i]);
+    }
+    free(reads);
+    free(read_ids);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+// num_reads reads of num_samples random samples
+static int random_reads_to_blow5(const char *pathname, int num_reads, uint64_t num_samples) {
+    char *idx_pathname = slow5_get_idx_path(pathname);
+    ASSERT(idx_pathname);
+    remove(idx_pathname);
+    free(idx_pathname);
+
+    struct slow5_file *s5p = slow5_open(pathname, "w");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_hdr_add("run_id", s5p->header) == 0);
+    ASSERT(slow5_hdr_set("run_id", "run_0", 0, s5p->header) == 0);
+    ASSERT(slow5_hdr_write(s5p) > 0);
+
+    srand(9);
+    struct slow5_rec *read = slow5_rec_init();
+    ASSERT(read);
+    char read_id[32];
+    for (int i = 0; i < num_reads; ++ i) {
+        // slow5_write replaces raw_signal with the compressed signal
+        read->len_raw_signal = num_samples;
+        read->raw_signal = realloc(read->raw_signal, read->len_raw_signal * sizeof *read->raw_signal);
+        ASSERT(read->raw_signal);
+        sprintf(read_id, "read_%d", i);
+        read->read_id = read_id;
+        read->read_id_len = strlen(read_id);
+        read->digitisation = 4096;
+        read->offset = 3;
+        read->range = 10;
+        read->sampling_rate = 4000;
+        for (uint64_t j = 0; j < read->len_raw_signal; ++ j) {
+            read->raw_signal[j] = rand() % 65536 - 32768;
+        }
+        ASSERT(slow5_write(read, s5p) >= 0);
+    }
+    read->read_id = NULL;
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_get_many_valid(void) {
+    ASSERT(same_diff_ids_to_zlib() == EXIT_SUCCESS);
+
+    const char *pathnames[] = {
+        "test/data/exp/one_fast5/exp_1_default.blow5",
+        "test/data/exp/one_fast5/exp_1_lossless_gzip.blow5",
+        "test/data/exp/one_fast5/exp_1_default.slow5",
+        "test/data/exp/aux_array/exp_lossless.blow5",
+        "test/data/out/same_diff_ids_zlib.blow5",
+        "test/data/test/same_diff_ids.slow5",
+    };
+    for (size_t i = 0; i < sizeof pathnames / sizeof *pathnames; ++ i) {
+        ASSERT(many_same_as_get(pathnames[i], "r", 1) == EXIT_SUCCESS);
+        ASSERT(many_same_as_get(pathnames[i], "r", 4) == EXIT_SUCCESS);
+        ASSERT(many_same_as_get(pathnames[i], "rm", 4) == EXIT_SUCCESS);
+    }
+
+    // reads large enough that slow5_get_many needs several groups
+    ASSERT(random_reads_to_blow5("test/data/out/get_many_big.blow5", 48, 100000) == EXIT_SUCCESS);
+    ASSERT(many_same_as_get("test/data/out/get_many_big.blow5", "r", 1) == EXIT_SUCCESS);
+    ASSERT(many_same_as_get("test/data/out/get_many_big.blow5", "r", 4) == EXIT_SUCCESS);
+    ASSERT(many_same_as_get("test/data/out/get_many_big.blow5", "rm", 4) == EXIT_SUCCESS);
+
+    char *read_id = "read_0";
+    struct slow5_rec *read = NULL;
+    struct slow5_file *s5p = slow5_open("test/data/exp/one_fast5/exp_1_default.blow5", "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_get_many(&read_id, 1, &read, 1, s5p) == SLOW5_ERR_NOIDX);
+    ASSERT(slow5_get_many(&read_id, 1, NULL, 1, s5p) == SLOW5_ERR_ARG);
+    ASSERT(slow5_get_many(NULL, 1, &read, 1, s5p) == SLOW5_ERR_ARG);
+    ASSERT(read == NULL);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+static int same_file(const char *pathname1, const char *pathname2) {
+    FILE *fp1 = fopen(pathname1, "r");
+    ASSERT(fp1);
+    FILE *fp2 = fopen(pathname2, "r");
+    ASSERT(fp2);
+    int c;
+    while ((c = fgetc(fp1)) != EOF) {
+        ASSERT(c == fgetc(fp2));
+    }
+    ASSERT(fgetc(fp2) == EOF);
+    fclose(fp1);
+    fclose(fp2);
+
+    return EXIT_SUCCESS;
+}
+
+static int idx_mt_same_as_single(const char *pathname, const char *mode) {
+    struct slow5_file *s5p = slow5_open(pathname, mode);
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_to_mt(s5p, "test/data/out/idx_1.idx", 1) == 0);
+    ASSERT(slow5_idx_to_mt(s5p, "test/data/out/idx_4.idx", 4) == 0);
+    ASSERT(slow5_idx_to_mt(s5p, "test/data/out/idx_64.idx", 64) == 0);
+    ASSERT(slow5_close(s5p) == 0);
+
+    ASSERT(same_file("test/data/out/idx_1.idx", "test/data/out/idx_4.idx") == EXIT_SUCCESS);
+    ASSERT(same_file("test/data/out/idx_1.idx", "test/data/out/idx_64.idx") == EXIT_SUCCESS);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_idx_create_mt_valid(void) {
+    ASSERT(same_diff_ids_to_zlib() == EXIT_SUCCESS);
+    // more records than a thread is handed at a time
+    ASSERT(random_reads_to_blow5("test/data/out/idx_many.blow5", 5000, 20) == EXIT_SUCCESS);
+
+    const char *pathnames[] = {
+        "test/data/exp/one_fast5/exp_1_default.blow5",
+        "test/data/exp/one_fast5/exp_1_default_gzip.blow5",
+        "test/data/exp/one_fast5/exp_1_lossless_gzip.blow5",
+        "test/data/exp/aux_array/exp_lossless.blow5",
+        "test/data/exp/one_fast5/exp_1_default.slow5",
+        "test/data/out/same_diff_ids_zlib.blow5",
+        "test/data/out/idx_many.blow5",
+    };
+    for (size_t i = 0; i < sizeof pathnames / sizeof *pathnames; ++ i) {
+        ASSERT(idx_mt_same_as_single(pathnames[i], "r") == EXIT_SUCCESS);
+        ASSERT(idx_mt_same_as_single(pathnames[i], "rm") == EXIT_SUCCESS);
+    }
+
+    struct slow5_file *s5p = slow5_open("test/data/out/idx_many.blow5", "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_create_mt(s5p, 4) == 0);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    uint64_t num_ids;
+    char **ids = slow5_get_rids(s5p, &num_ids);
+    ASSERT(num_ids == 5000);
+    ASSERT(strcmp(ids[4999], "read_4999") == 0);
+    struct slow5_rec *read = NULL;
+    ASSERT(slow5_get("read_4097", &read, s5p) == 0);
+    ASSERT(strcmp(read->read_id, "read_4097") == 0);
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+
+    s5p = slow5_open("test/data/err/no_eof.blow5", "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_create_mt(s5p, 4) == -1);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_idx_insert_valid(void) {
+    struct slow5_idx *index = (struct slow5_idx *) calloc(1, sizeof *index);
+    ASSERT(index);
+    struct slow5_rec_idx read_idx;
+    ASSERT(slow5_idx_get(index, "read_0", &read_idx) == -1);
+    ASSERT(slow5_idx_ids(index) == NULL);
+
+    // read IDs of many lengths, the table and pool grow many times
+    char read_id[512];
+    const uint64_t num_ids = 100000;
+    for (uint64_t i = 0; i < num_ids; ++ i) {
+        int len = sprintf(read_id, "read_%" PRIu64, i);
+        memset(read_id + len, 'x', i % 300);
+        read_id[len + i % 300] = '\0';
+        ASSERT(slow5_idx_insert(index, read_id, i, 2 * i) == 0);
+        ASSERT(slow5_idx_insert(index, read_id, i, 2 * i) == -1);
+    }
+    ASSERT(slow5_idx_insert(index, "", 7, 8) == 0);
+    ASSERT(index->num_ids == num_ids + 1);
+    ASSERT(index->num_ids < index->num_buckets - index->num_buckets / 4);
+
+    char **ids = slow5_idx_ids(index);
+    ASSERT(ids);
+    for (uint64_t i = 0; i < num_ids; ++ i) {
+        ASSERT(strncmp(ids[i], "read_", 5) == 0);
+        ASSERT(strtoull(ids[i] + 5, NULL, 10) == i);
+        ASSERT(slow5_idx_get(index, ids[i], &read_idx) == 0);
+        ASSERT(read_idx.offset == i);
+        ASSERT(read_idx.size == 2 * i);
+    }
+    ASSERT(strcmp(ids[num_ids], "") == 0);
+    ASSERT(slow5_idx_get(index, "", &read_idx) == 0);
+    ASSERT(read_idx.offset == 7);
+    ASSERT(slow5_idx_get(index, "read_1", NULL) == -1); // has an 'x'
+    ASSERT(slow5_idx_get(index, "read_0", NULL) == 0);
+
+    // the read IDs list is made again after an insert
+    ASSERT(slow5_idx_insert(index, "last", 1, 1) == 0);
+    ids = slow5_idx_ids(index);
+    ASSERT(ids);
+    ASSERT(strcmp(ids[num_ids + 1], "last") == 0);
+
+    slow5_idx_free(index);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_idx_insert_uuid(void) {
+    struct slow5_idx *index = (struct slow5_idx *) calloc(1, sizeof *index);
+    ASSERT(index);
+
+    const char *read_ids[] = {
+        "a649a4ae-c43d-492a-b6a1-a5b8b8076be4", // stored as 16 bytes
+        "A649A4AE-C43D-492A-B6A1-A5B8B8076BE4", // the rest are not canonical
+        "a649a4aec43d492ab6a1a5b8b8076be4",
+        "a649a4ae-c43d-492a-b6a1-a5b8b8076be",
+        "a649a4ae-c43d-492a-b6a1-a5b8b8076beg",
+        "a649a4ae-c43d-492a-b6a1+a5b8b8076be4",
+        "00000000-0000-0000-0000-000000000000",
+    };
+    const uint64_t pool_sizes[] = { 32, 32 + 56, 32 + 56 + 56, 32 + 56 * 3, 32 + 56 * 4, 32 + 56 * 5, 32 * 2 + 56 * 5 };
+    for (size_t i = 0; i < sizeof read_ids / sizeof *read_ids; ++ i) {
+        ASSERT(slow5_idx_insert(index, read_ids[i], i, 100 + i) == 0);
+        ASSERT(index->pool_size == pool_sizes[i]);
+    }
+    ASSERT(slow5_idx_insert(index, "a649a4ae-c43d-492a-b6a1-a5b8b8076be4", 0, 0) == -1);
+
+    char **ids = slow5_idx_ids(index);
+    ASSERT(ids);
+    for (size_t i = 0; i < sizeof read_ids / sizeof *read_ids; ++ i) {
+        ASSERT(strcmp(ids[i], read_ids[i]) == 0);
+        struct slow5_rec_idx read_idx;
+        ASSERT(slow5_idx_get(index, read_ids[i], &read_idx) == 0);
+        ASSERT(read_idx.offset == i);
+        ASSERT(read_idx.size == 100 + i);
+    }
+    ASSERT(slow5_idx_get(index, "a649a4ae-c43d-492a-b6a1-a5b8b8076be5", NULL) == -1);
+
+    slow5_idx_free(index);
+
+    return EXIT_SUCCESS;
+}
+
+// write the loaded index of s5p to pathname in the v1 format
+static int idx_write_v1(struct slow5_file *s5p, const char *pathname) {
+    FILE *fp = fopen(pathname, "w");
+    ASSERT(fp);
+    const char magic[] = SLOW5_INDEX_MAGIC_NUMBER;
+    uint8_t header[SLOW5_INDEX_HEADER_SIZE_OFFSET] = { 0 };
+    memcpy(header, magic, sizeof magic);
+    header[sizeof magic] = s5p->header->version.major;
+    header[sizeof magic + 1] = s5p->header->version.minor;
+    header[sizeof magic + 2] = s5p->header->version.patch;
+    ASSERT(fwrite(header, sizeof header, 1, fp) == 1);
+
+    uint64_t num_ids;
+    char **ids = slow5_get_rids(s5p, &num_ids);
+    ASSERT(ids);
+    for (uint64_t i = 0; i < num_ids; ++ i) {
+        struct slow5_rec_idx read_idx;
+        ASSERT(slow5_idx_get(s5p->index, ids[i], &read_idx) == 0);
+        slow5_rid_len_t len = strlen(ids[i]);
+        ASSERT(fwrite(&len, sizeof len, 1, fp) == 1);
+        ASSERT(fwrite(ids[i], 1, len, fp) == len);
+        ASSERT(fwrite(&read_idx.offset, sizeof read_idx.offset, 1, fp) == 1);
+        ASSERT(fwrite(&read_idx.size, sizeof read_idx.size, 1, fp) == 1);
+    }
+    const char eof[] = SLOW5_INDEX_EOF;
+    ASSERT(fwrite(eof, sizeof eof, 1, fp) == 1);
+    ASSERT(fclose(fp) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+static int idx_same(struct slow5_file *s5p, struct slow5_file *s5p_other) {
+    uint64_t num_ids;
+    char **ids = slow5_get_rids(s5p, &num_ids);
+    ASSERT(ids);
+    uint64_t num_ids_other;
+    char **ids_other = slow5_get_rids(s5p_other, &num_ids_other);
+    ASSERT(ids_other);
+    ASSERT(num_ids == num_ids_other);
+    for (uint64_t i = 0; i < num_ids; ++ i) {
+        ASSERT(strcmp(ids[i], ids_other[i]) == 0);
+        struct slow5_rec_idx read_idx;
+        struct slow5_rec_idx read_idx_other;
+        ASSERT(slow5_idx_get(s5p->index, ids[i], &read_idx) == 0);
+        ASSERT(slow5_idx_get(s5p_other->index, ids[i], &read_idx_other) == 0);
+        ASSERT(read_idx.offset == read_idx_other.offset);
+        ASSERT(read_idx.size == read_idx_other.size);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_idx_v2_valid(void) {
+    ASSERT(random_reads_to_blow5("test/data/out/idx_v2.blow5", 1000, 20) == EXIT_SUCCESS);
+    const char *idx_pathname = "test/data/out/idx_v2.blow5.idx";
+
+    // written in v1 by default, which is read into memory
+    remove(idx_pathname);
+    struct slow5_file *s5p = slow5_open("test/data/out/idx_v2.blow5", "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->map == NULL);
+    ASSERT(slow5_close(s5p) == 0);
+    const char magic_v1[] = SLOW5_INDEX_MAGIC_NUMBER;
+    char buf_magic[sizeof magic_v1];
+    FILE *fp = fopen(idx_pathname, "r");
+    ASSERT(fp != NULL);
+    ASSERT(fread(buf_magic, 1, sizeof buf_magic, fp) == sizeof buf_magic);
+    ASSERT(memcmp(buf_magic, magic_v1, sizeof magic_v1) == 0);
+    ASSERT(fclose(fp) == 0);
+    s5p = slow5_open("test/data/out/idx_v2.blow5", "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->map == NULL);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // built in memory then written in v2
+    remove(idx_pathname);
+    s5p = slow5_open("test/data/out/idx_v2.blow5", "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_set_idx_v2(s5p, 1) == 0);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->map == NULL);
+
+    // mapped
+    struct slow5_file *s5p_map = slow5_open("test/data/out/idx_v2.blow5", "r");
+    ASSERT(s5p_map != NULL);
+    ASSERT(slow5_idx_load(s5p_map) == 0);
+    ASSERT(s5p_map->index->map != NULL);
+    ASSERT(idx_same(s5p, s5p_map) == EXIT_SUCCESS);
+    ASSERT(slow5_idx_get(s5p_map->index, "read_1000", NULL) == -1);
+    ASSERT(slow5_idx_get(s5p_map->index, "read_99", NULL) == 0);
+    ASSERT(slow5_idx_get(s5p_map->index, "read_9", NULL) == 0);
+    ASSERT(slow5_idx_get(s5p_map->index, "read_", NULL) == -1);
+    struct slow5_rec *read = NULL;
+    ASSERT(slow5_get("read_512", &read, s5p_map) == 0);
+    ASSERT(strcmp(read->read_id, "read_512") == 0);
+    ASSERT(slow5_get("read_1000", &read, s5p_map) == SLOW5_ERR_NOTFOUND);
+
+    // rewriting the index makes a new file, the mapped one stays as it was
+    struct stat st;
+    ASSERT(stat(idx_pathname, &st) == 0);
+    ino_t ino = st.st_ino;
+    ASSERT(slow5_idx_create(s5p) == 0);
+    ASSERT(stat(idx_pathname, &st) == 0);
+    ASSERT(st.st_ino != ino);
+    ASSERT(slow5_get("read_512", &read, s5p_map) == 0);
+    ASSERT(strcmp(read->read_id, "read_512") == 0);
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p_map) == 0);
+
+    // v1 is still read, into memory
+    ASSERT(idx_write_v1(s5p, idx_pathname) == EXIT_SUCCESS);
+    struct slow5_file *s5p_v1 = slow5_open("test/data/out/idx_v2.blow5", "r");
+    ASSERT(s5p_v1 != NULL);
+    ASSERT(slow5_idx_load(s5p_v1) == 0);
+    ASSERT(s5p_v1->index->map == NULL);
+    ASSERT(idx_same(s5p, s5p_v1) == EXIT_SUCCESS);
+    ASSERT(slow5_close(s5p_v1) == 0);
+
+    // v2 replacing the longer v1 has its own size
+    ASSERT(slow5_idx_create(s5p) == 0);
+    ASSERT(stat(idx_pathname, &st) == 0);
+    s5p_map = slow5_open("test/data/out/idx_v2.blow5", "r");
+    ASSERT(s5p_map != NULL);
+    ASSERT(slow5_idx_load(s5p_map) == 0);
+    ASSERT(s5p_map->index->map_size == (size_t) st.st_size);
+    ASSERT(slow5_close(s5p_map) == 0);
+
+    ASSERT(truncate(idx_pathname, st.st_size - 1) == 0);
+    s5p_map = slow5_open("test/data/out/idx_v2.blow5", "r");
+    ASSERT(s5p_map != NULL);
+    ASSERT(slow5_idx_load(s5p_map) == -1);
+    ASSERT(slow5_close(s5p_map) == 0);
+    ASSERT(remove(idx_pathname) == 0);
+
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+// write num_reads reads to a blow5 file with an index footer, every other one with slow5_write_bytes
+// in blocks of block_recs records if not 0
+static int reads_to_blow5_block(const char *pathname, const char *mode, int first, int num_reads, uint32_t block_recs) {
+    struct slow5_file *s5p = slow5_open(pathname, mode);
+    ASSERT(s5p != NULL);
+    if (strcmp(mode, "w") == 0) {
+        ASSERT(slow5_set_press(s5p, SLOW5_COMPRESS_ZLIB, SLOW5_COMPRESS_SVB_ZD) == 0);
+        ASSERT(slow5_set_idx_footer(s5p, 1) == 0);
+        if (block_recs) {
+            ASSERT(slow5_set_block(s5p, block_recs, 0) == 0);
+        }
+        ASSERT(slow5_hdr_add("run_id", s5p->header) == 0);
+        ASSERT(slow5_hdr_set("run_id", "run_0", 0, s5p->header) == 0);
+        ASSERT(slow5_hdr_write(s5p) > 0);
+    } else {
+        ASSERT(s5p->meta.idx_footer != NULL);
+    }
+
+    struct slow5_rec *read = slow5_rec_init();
+    ASSERT(read);
+    char read_id[32];
+    for (int i = first; i < first + num_reads; ++ i) {
+        read->len_raw_signal = 100 + i;
+        read->raw_signal = realloc(read->raw_signal, read->len_raw_signal * sizeof *read->raw_signal);
+        ASSERT(read->raw_signal);
+        sprintf(read_id, "read_%d", i);
+        read->read_id = read_id;
+        read->read_id_len = strlen(read_id);
+        read->digitisation = 4096;
+        read->range = 10;
+        read->sampling_rate = 4000;
+        for (uint64_t j = 0; j < read->len_raw_signal; ++ j) {
+            read->raw_signal[j] = j + i;
+        }
+        if (i % 2) {
+            void *mem;
+            size_t bytes;
+            ASSERT(slow5_encode(&mem, &bytes, read, s5p) == 0);
+            ASSERT(slow5_write_bytes(mem, bytes, s5p) == 0);
+            free(mem);
+        } else {
+            ASSERT(slow5_write(read, s5p) >= 0);
+        }
+    }
+    // a duplicated read ID is not written
+    ASSERT(slow5_write(read, s5p) == -1);
+    read->read_id = NULL;
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+static int reads_to_blow5_footer(const char *pathname, const char *mode, int first, int num_reads) {
+    return reads_to_blow5_block(pathname, mode, first, num_reads, 0);
+}
+
+// the reads written by reads_to_blow5_footer are all found by slow5_get and slow5_get_next
+static int blow5_reads_same(const char *pathname, int num_reads) {
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->map != NULL);
+    ASSERT(s5p->index->num_ids == (uint64_t) num_reads);
+
+    struct slow5_rec *read = NULL;
+    char read_id[32];
+    for (int i = 0; i < num_reads; ++ i) {
+        sprintf(read_id, "read_%d", i);
+        ASSERT(slow5_get(read_id, &read, s5p) == 0);
+        ASSERT(strcmp(read->read_id, read_id) == 0);
+        ASSERT(read->len_raw_signal == (uint64_t) (100 + i));
+        ASSERT(read->raw_signal[99] == 99 + i);
+    }
+    sprintf(read_id, "read_%d", num_reads);
+    ASSERT(slow5_get(read_id, &read, s5p) == SLOW5_ERR_NOTFOUND);
+
+    // sequential reads stop at the footer
+    int i = 0;
+    int ret;
+    while ((ret = slow5_get_next(&read, s5p)) >= 0) {
+        sprintf(read_id, "read_%d", i ++);
+        ASSERT(strcmp(read->read_id, read_id) == 0);
+    }
+    ASSERT(ret == SLOW5_ERR_EOF);
+    ASSERT(i == num_reads);
+
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+// write pathname as the blow5 file with_footer followed by the records of more (both with an index footer), as an older slow5lib appends
+static int append_after_footer(const char *pathname, const char *with_footer, const char *more) {
+    const char eof[] = SLOW5_BINARY_EOF;
+    struct stat st;
+    ASSERT(stat(with_footer, &st) == 0);
+    FILE *fp = fopen(pathname, "w");
+    ASSERT(fp != NULL);
+    FILE *in = fopen(with_footer, "r");
+    ASSERT(in != NULL);
+    char *buf = malloc(st.st_size);
+    ASSERT(buf != NULL);
+    ASSERT(fread(buf, st.st_size - sizeof eof, 1, in) == 1);
+    ASSERT(fwrite(buf, st.st_size - sizeof eof, 1, fp) == 1);
+    ASSERT(fclose(in) == 0);
+
+    struct slow5_file *s5p = slow5_open(more, "r");
+    ASSERT(s5p != NULL);
+    uint64_t footer;
+    ASSERT(slow5_idx_footer_offset(s5p->meta.fd, &footer) == 1);
+    uint64_t start = s5p->meta.start_rec_offset;
+    buf = realloc(buf, footer - start);
+    ASSERT(buf != NULL);
+    ASSERT(pread(s5p->meta.fd, buf, footer - start, start) == (ssize_t) (footer - start));
+    ASSERT(fwrite(buf, footer - start, 1, fp) == 1);
+    ASSERT(fwrite(eof, sizeof eof, 1, fp) == 1);
+    ASSERT(slow5_close(s5p) == 0);
+    ASSERT(fclose(fp) == 0);
+    free(buf);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_idx_footer_valid(void) {
+    const char *pathname = "test/data/out/idx_footer.blow5";
+    const char *idx_pathname = "test/data/out/idx_footer.blow5.idx";
+    remove(idx_pathname);
+
+    ASSERT(reads_to_blow5_footer(pathname, "w", 0, 50) == EXIT_SUCCESS);
+    ASSERT(blow5_reads_same(pathname, 50) == EXIT_SUCCESS);
+    struct stat st;
+    ASSERT(stat(idx_pathname, &st) == -1);
+
+    // appending keeps the footer
+    ASSERT(reads_to_blow5_footer(pathname, "a", 50, 7) == EXIT_SUCCESS);
+    ASSERT(blow5_reads_same(pathname, 57) == EXIT_SUCCESS);
+    ASSERT(stat(idx_pathname, &st) == -1);
+
+    // an index file built by scanning stops at the footer too
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_create(s5p) == 0);
+    ASSERT(slow5_close(s5p) == 0);
+    ASSERT(remove(idx_pathname) == 0);
+
+    // only for blow5 files being written
+    s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_set_idx_footer(s5p, 1) == SLOW5_ERR_ARG);
+    // written with the version of the index footer, which older slow5lib refuse
+    struct slow5_version footer_version = { .major = 0, .minor = 3, .patch = 0 };
+    ASSERT(slow5_version_cmp(s5p->header->version, footer_version) == 0);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // records appended after the footer (as an older slow5lib would) are read past it
+    const char *old_pathname = "test/data/out/idx_footer_old.blow5";
+    ASSERT(reads_to_blow5_footer("test/data/out/idx_footer_more.blow5", "w", 57, 3) == EXIT_SUCCESS);
+    ASSERT(append_after_footer(old_pathname, pathname, "test/data/out/idx_footer_more.blow5") == EXIT_SUCCESS);
+    remove("test/data/out/idx_footer_old.blow5.idx");
+    s5p = slow5_open(old_pathname, "r");
+    ASSERT(s5p != NULL);
+    uint64_t footer;
+    ASSERT(slow5_idx_footer_offset(s5p->meta.fd, &footer) == 0);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->map == NULL);
+    ASSERT(s5p->index->num_ids == 60);
+    struct slow5_rec *read = NULL;
+    ASSERT(slow5_get("read_58", &read, s5p) == 0);
+    ASSERT(read->len_raw_signal == 158);
+    int i = 0;
+    int ret;
+    char read_id[32];
+    while ((ret = slow5_get_next(&read, s5p)) >= 0) {
+        sprintf(read_id, "read_%d", i ++);
+        ASSERT(strcmp(read->read_id, read_id) == 0);
+    }
+    ASSERT(ret == SLOW5_ERR_EOF);
+    ASSERT(i == 60);
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+    ASSERT(remove("test/data/out/idx_footer_old.blow5.idx") == 0);
+
+    return EXIT_SUCCESS;
+}
+
+// append reads first to first + num_reads - 1 to a blow5 file, loading its index first if load_idx
+static int append_reads(const char *pathname, int first, int num_reads, int load_idx) {
+    struct slow5_file *s5p = slow5_open(pathname, "a");
+    ASSERT(s5p != NULL);
+    if (load_idx) {
+        ASSERT(slow5_idx_load(s5p) == 0);
+    }
+
+    struct slow5_rec *read = slow5_rec_init();
+    ASSERT(read);
+    char read_id[32];
+    read->read_id = read_id;
+    for (int i = first; i < first + num_reads; ++ i) {
+        // slow5_write replaces raw_signal with the compressed signal
+        read->len_raw_signal = 10;
+        read->raw_signal = realloc(read->raw_signal, read->len_raw_signal * sizeof *read->raw_signal);
+        ASSERT(read->raw_signal);
+        memset(read->raw_signal, 0, read->len_raw_signal * sizeof *read->raw_signal);
+        sprintf(read_id, "read_%d", i);
+        read->read_id_len = strlen(read_id);
+        ASSERT(slow5_write(read, s5p) >= 0);
+    }
+    read->read_id = NULL;
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_idx_catch_up_valid(void) {
+    const char *pathname = "test/data/out/idx_append.blow5";
+    const char *idx_pathname = "test/data/out/idx_append.blow5.idx";
+    ASSERT(random_reads_to_blow5(pathname, 20, 50) == EXIT_SUCCESS);
+    remove(idx_pathname);
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_set_idx_v2(s5p, 1) == 0);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // appended without the index, only the new records are indexed on load
+    ASSERT(append_reads(pathname, 20, 5, 0) == EXIT_SUCCESS);
+    s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->num_ids == 25);
+    struct slow5_rec *read = NULL;
+    ASSERT(slow5_get("read_24", &read, s5p) == 0);
+    ASSERT(read->len_raw_signal == 10);
+    ASSERT(slow5_get("read_19", &read, s5p) == 0);
+    ASSERT(read->len_raw_signal == 50);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // the index file was updated
+    s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->map != NULL);
+    ASSERT(s5p->index->num_ids == 25);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // appended with the index loaded, which is written back on close
+    ASSERT(append_reads(pathname, 25, 3, 1) == EXIT_SUCCESS);
+    s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->map != NULL);
+    ASSERT(s5p->index->num_ids == 28);
+    ASSERT(slow5_get("read_27", &read, s5p) == 0);
+    ASSERT(strcmp(read->read_id, "read_27") == 0);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // a duplicated read ID is not appended
+    s5p = slow5_open(pathname, "a");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(slow5_write(read, s5p) == -1);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // a file rewritten since it was indexed is indexed again
+    ASSERT(rename(idx_pathname, "test/data/out/idx_append.idx.old") == 0);
+    ASSERT(random_reads_to_blow5(pathname, 10, 50) == EXIT_SUCCESS);
+    ASSERT(rename("test/data/out/idx_append.idx.old", idx_pathname) == 0);
+    s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->num_ids == 10);
+    ASSERT(slow5_get("read_10", &read, s5p) == SLOW5_ERR_NOTFOUND);
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_cat_valid(void) {
+    const char *in_pathnames[] = {
+        "test/data/out/cat_1.blow5",
+        "test/data/out/cat_2.blow5",
+        "test/data/out/cat_3.blow5",
+    };
+    const char *pathname = "test/data/out/cat.blow5";
+    ASSERT(reads_to_blow5_footer(in_pathnames[0], "w", 0, 10) == EXIT_SUCCESS);
+    ASSERT(reads_to_blow5_footer(in_pathnames[1], "w", 10, 20) == EXIT_SUCCESS);
+    ASSERT(reads_to_blow5_footer(in_pathnames[2], "w", 30, 5) == EXIT_SUCCESS);
+
+    // an input without an index footer
+    ASSERT(slow5_cat("test/data/out/cat_1_idx.blow5", in_pathnames, 1) == 0);
+    ASSERT(blow5_reads_same("test/data/out/cat_1_idx.blow5", 10) == EXIT_SUCCESS);
+    in_pathnames[0] = "test/data/out/cat_1_idx.blow5";
+
+    ASSERT(slow5_cat(pathname, in_pathnames, 3) == 0);
+    ASSERT(blow5_reads_same(pathname, 35) == EXIT_SUCCESS);
+
+    // the merged index is the one made by indexing the output
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(remove("test/data/out/cat.blow5.idx") == 0);
+    struct slow5_file *s5p_built = slow5_open(pathname, "r");
+    ASSERT(s5p_built != NULL);
+    ASSERT(slow5_idx_load(s5p_built) == 0);
+    ASSERT(idx_same(s5p, s5p_built) == EXIT_SUCCESS);
+    ASSERT(slow5_close(s5p_built) == 0);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // binary UUIDs are merged as they are
+    struct slow5_idx *index = calloc(1, sizeof *index);
+    struct slow5_idx *src = calloc(1, sizeof *src);
+    ASSERT(index && src);
+    ASSERT(slow5_idx_insert(src, "0a1b2c3d-4e5f-6789-abcd-ef0123456789", 10, 5) == 0);
+    ASSERT(slow5_idx_insert(src, "read", 15, 5) == 0);
+    ASSERT(slow5_idx_insert(index, "read_0", 0, 10) == 0);
+    ASSERT(slow5_idx_merge(index, src, 100) == 0);
+    struct slow5_rec_idx read_idx;
+    ASSERT(slow5_idx_get(index, "0a1b2c3d-4e5f-6789-abcd-ef0123456789", &read_idx) == 0);
+    ASSERT(read_idx.offset == 110 && read_idx.size == 5);
+    ASSERT(slow5_idx_get(index, "read", &read_idx) == 0);
+    ASSERT(read_idx.offset == 115 && read_idx.size == 5);
+    ASSERT(index->num_ids == 3 && index->data_size == 120);
+    ASSERT(slow5_idx_merge(index, src, 200) == SLOW5_ERR_OTH); // duplicated
+    slow5_idx_free(src);
+    slow5_idx_free(index);
+
+    // headers must be the same
+    const char *diff_pathnames[] = { in_pathnames[1], "test/data/exp/one_fast5/exp_1_default.blow5" };
+    struct stat st;
+    ASSERT(slow5_cat(pathname, diff_pathnames, 2) == SLOW5_ERR_HDRPARSE);
+    ASSERT(stat(pathname, &st) == -1);
+    // read IDs must be unique
+    const char *dup_pathnames[] = { in_pathnames[1], in_pathnames[1] };
+    ASSERT(slow5_cat(pathname, dup_pathnames, 2) < 0);
+    ASSERT(stat(pathname, &st) == -1);
+    ASSERT(stat("test/data/out/cat.blow5.idx", &st) == -1);
+
+    return EXIT_SUCCESS;
+}
+
+// the index columns of read_id in pathname are len_raw_signal, channel_number and start_time
+static int idx_cols_same(const char *pathname, const char *read_id, uint64_t len_raw_signal, const char *channel_number, uint64_t start_time) {
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+
+    uint64_t len;
+    enum slow5_aux_type type;
+    const void *value = slow5_get_idx_col(read_id, "len_raw_signal", &len, &type, s5p);
+    ASSERT(value != NULL && len == 1 && type == SLOW5_UINT64_T);
+    ASSERT(*(const uint64_t *) value == len_raw_signal);
+    value = slow5_get_idx_col(read_id, "channel_number", &len, &type, s5p);
+    ASSERT(value != NULL && len == strlen(channel_number) && type == SLOW5_STRING);
+    ASSERT(memcmp(value, channel_number, len) == 0);
+    value = slow5_get_idx_col(read_id, "start_time", &len, &type, s5p);
+    ASSERT(value != NULL && len == 1 && type == SLOW5_UINT64_T);
+    ASSERT(*(const uint64_t *) value == start_time);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_idx_cols_valid(void) {
+    const char *in_pathname = "test/data/exp/one_fast5/exp_1_lossless_gzip.blow5";
+    const char *pathname = "test/data/out/idx_cols.blow5";
+    const char *read_id = "a649a4ae-c43d-492a-b6a1-a5b8b8076be4";
+    ASSERT(slow5_cat(pathname, &in_pathname, 1) == 0);
+
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    // only scalar fields, each once
+    const char *bad_cols[] = { "raw_signal" };
+    ASSERT(slow5_idx_create_cols(s5p, bad_cols, 1) == SLOW5_ERR_NOFLD);
+    const char *dup_cols[] = { "read_group", "read_group" };
+    ASSERT(slow5_idx_create_cols(s5p, dup_cols, 2) == SLOW5_ERR_ARG);
+    const char *cols[] = { "len_raw_signal", "read_group", "channel_number", "start_time" };
+    ASSERT(slow5_idx_create_cols(s5p, cols, 4) == 0);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(s5p->index->num_cols == 4);
+    uint64_t len;
+    const void *value = slow5_get_idx_col(read_id, "read_group", &len, NULL, s5p);
+    ASSERT(value != NULL && len == 1 && *(const uint32_t *) value == 0);
+    ASSERT(slow5_get_idx_col(read_id, "median_before", NULL, NULL, s5p) == NULL && slow5_errno == SLOW5_ERR_NOFLD);
+    ASSERT(slow5_get_idx_col("read_0", "start_time", NULL, NULL, s5p) == NULL && slow5_errno == SLOW5_ERR_NOTFOUND);
+    ASSERT(slow5_close(s5p) == 0);
+    ASSERT(idx_cols_same(pathname, read_id, 59676, "115", 2817564) == EXIT_SUCCESS);
+
+    // appended records get their values, with the index loaded or on the next load
+    for (int i = 0; i < 2; ++ i) {
+        s5p = slow5_open(pathname, "a");
+        ASSERT(s5p != NULL);
+        if (i == 0) {
+            ASSERT(slow5_idx_load(s5p) == 0);
+        }
+        struct slow5_rec *read = slow5_rec_init();
+        ASSERT(read);
+        char appended_id[32];
+        sprintf(appended_id, "read_%d", i);
+        read->read_id = appended_id;
+        read->read_id_len = strlen(appended_id);
+        read->len_raw_signal = 10 + i;
+        read->raw_signal = calloc(read->len_raw_signal, sizeof *read->raw_signal);
+        ASSERT(read->raw_signal);
+        uint64_t start_time = 100 + i;
+        ASSERT(slow5_aux_set_string(read, "channel_number", i ? "12345678" : "7", s5p->header) == 0);
+        ASSERT(slow5_aux_set(read, "start_time", &start_time, s5p->header) == 0);
+        ASSERT(slow5_write(read, s5p) >= 0);
+        read->read_id = NULL;
+        slow5_rec_free(read);
+        ASSERT(slow5_close(s5p) == 0);
+    }
+    ASSERT(idx_cols_same(pathname, "read_0", 10, "7", 100) == EXIT_SUCCESS);
+    ASSERT(idx_cols_same(pathname, "read_1", 11, "12345678", 101) == EXIT_SUCCESS);
+    ASSERT(idx_cols_same(pathname, read_id, 59676, "115", 2817564) == EXIT_SUCCESS);
+
+    // kept by slow5_cat
+    const char *cat_pathname = "test/data/out/idx_cols_cat.blow5";
+    ASSERT(slow5_cat(cat_pathname, &pathname, 1) == 0);
+    ASSERT(idx_cols_same(cat_pathname, "read_1", 11, "12345678", 101) == EXIT_SUCCESS);
+
+    return EXIT_SUCCESS;
+}
+
+// the statistics of all the read groups of pathname from its index
+static int stats_same(const char *pathname, uint64_t num_reads, uint64_t num_samples, uint64_t min_len, uint64_t max_len) {
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    struct slow5_stats stats;
+    ASSERT(slow5_get_stats(s5p, SLOW5_STATS_ALL, &stats) == 0);
+    ASSERT(stats.num_reads == num_reads);
+    ASSERT(stats.num_samples == num_samples);
+    ASSERT(stats.min_len_raw_signal == min_len);
+    ASSERT(stats.max_len_raw_signal == max_len);
+    ASSERT(slow5_get_stats(s5p, 0, &stats) == 0);
+    ASSERT(stats.num_reads == num_reads);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_get_stats_valid(void) {
+    // read i has 100 + i samples, written with the index footer
+    const char *in_pathnames[] = { "test/data/out/stats_1.blow5", "test/data/out/stats_2.blow5" };
+    ASSERT(reads_to_blow5_footer(in_pathnames[0], "w", 0, 10) == EXIT_SUCCESS);
+    ASSERT(stats_same(in_pathnames[0], 10, 1045, 100, 109) == EXIT_SUCCESS);
+    ASSERT(reads_to_blow5_footer(in_pathnames[1], "w", 10, 5) == EXIT_SUCCESS);
+    ASSERT(reads_to_blow5_footer(in_pathnames[1], "a", 15, 1) == EXIT_SUCCESS);
+    ASSERT(stats_same(in_pathnames[1], 6, 675, 110, 115) == EXIT_SUCCESS);
+
+    // merged by slow5_cat, then added to by appended reads of 10 samples
+    const char *pathname = "test/data/out/stats.blow5";
+    ASSERT(slow5_cat(pathname, in_pathnames, 2) == 0);
+    ASSERT(stats_same(pathname, 16, 1720, 100, 115) == EXIT_SUCCESS);
+    ASSERT(append_reads(pathname, 16, 2, 0) == EXIT_SUCCESS);
+    ASSERT(stats_same(pathname, 18, 1740, 10, 115) == EXIT_SUCCESS);
+    ASSERT(append_reads(pathname, 18, 1, 1) == EXIT_SUCCESS);
+    ASSERT(stats_same(pathname, 19, 1750, 10, 115) == EXIT_SUCCESS);
+
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    struct slow5_stats stats;
+    ASSERT(slow5_get_stats(s5p, SLOW5_STATS_ALL, &stats) == SLOW5_ERR_NOIDX);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(slow5_get_stats(s5p, 1, &stats) == SLOW5_ERR_ARG);
+    ASSERT(slow5_get_stats(s5p, 0, NULL) == SLOW5_ERR_ARG);
+    // an index without statistics (e.g. v1), renamed over the mapped one
+    ASSERT(idx_write_v1(s5p, "test/data/out/stats.idx.v1") == EXIT_SUCCESS);
+    ASSERT(rename("test/data/out/stats.idx.v1", "test/data/out/stats.blow5.idx") == 0);
+    ASSERT(slow5_close(s5p) == 0);
+    s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(slow5_get_stats(s5p, SLOW5_STATS_ALL, &stats) == SLOW5_ERR_NOIDX);
+    // they are made again by indexing in v2
+    ASSERT(slow5_set_idx_v2(s5p, 1) == 0);
+    ASSERT(slow5_idx_create(s5p) == 0);
+    ASSERT(slow5_close(s5p) == 0);
+    ASSERT(stats_same(pathname, 19, 1750, 10, 115) == EXIT_SUCCESS);
+
+    // an uncompressed signal, and a slow5 file
+    const char *from_pathname = "test/data/exp/one_fast5/exp_1_default.slow5";
+    const char *none_pathname = "test/data/out/stats_none.blow5";
+    struct slow5_file *from = slow5_open(from_pathname, "r");
+    ASSERT(from != NULL);
+    FILE *to = fopen(none_pathname, "w");
+    ASSERT(to != NULL);
+    slow5_press_method_t method = {SLOW5_COMPRESS_ZLIB, SLOW5_COMPRESS_NONE};
+    ASSERT(slow5_convert(from, to, SLOW5_FORMAT_BINARY, method) == 0);
+    ASSERT(fclose(to) == 0);
+    ASSERT(slow5_close(from) == 0);
+    from = slow5_open(from_pathname, "r");
+    ASSERT(from != NULL);
+    to = fopen("test/data/out/stats.slow5", "w");
+    ASSERT(to != NULL);
+    ASSERT(slow5_convert(from, to, SLOW5_FORMAT_ASCII, method) == 0);
+    ASSERT(fclose(to) == 0);
+    ASSERT(slow5_close(from) == 0);
+    remove("test/data/out/stats_none.blow5.idx");
+    remove("test/data/out/stats.slow5.idx");
+    ASSERT(stats_same(none_pathname, 1, 59676, 59676, 59676) == EXIT_SUCCESS);
+    ASSERT(stats_same("test/data/out/stats.slow5", 1, 59676, 59676, 59676) == EXIT_SUCCESS);
+
+    // a zlib signal does not store its number of samples, which is not decompressed to get it
+    const char *zlib_pathname = "test/data/out/stats_zlib.blow5";
+    from = slow5_open(pathname, "r");
+    ASSERT(from != NULL);
+    to = fopen(zlib_pathname, "w");
+    ASSERT(to != NULL);
+    method.signal_method = SLOW5_COMPRESS_ZLIB;
+    ASSERT(slow5_convert(from, to, SLOW5_FORMAT_BINARY, method) == 0);
+    ASSERT(fclose(to) == 0);
+    ASSERT(slow5_close(from) == 0);
+    remove("test/data/out/stats_zlib.blow5.idx");
+    s5p = slow5_open(zlib_pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(slow5_get_stats(s5p, SLOW5_STATS_ALL, &stats) == SLOW5_ERR_NOIDX);
+    struct slow5_rec *read = NULL;
+    ASSERT(slow5_get("read_18", &read, s5p) == 0);
+    ASSERT(read->len_raw_signal == 10);
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+
+#ifdef SLOW5_USE_ZSTD
+    // a zstd signal does, in its frame header
+    const char *zstd_pathname = "test/data/out/stats_zstd.blow5";
+    from = slow5_open(pathname, "r");
+    ASSERT(from != NULL);
+    to = fopen(zstd_pathname, "w");
+    ASSERT(to != NULL);
+    method.signal_method = SLOW5_COMPRESS_ZSTD;
+    ASSERT(slow5_convert(from, to, SLOW5_FORMAT_BINARY, method) == 0);
+    ASSERT(fclose(to) == 0);
+    ASSERT(slow5_close(from) == 0);
+    remove("test/data/out/stats_zstd.blow5.idx");
+    ASSERT(stats_same(zstd_pathname, 19, 1750, 10, 115) == EXIT_SUCCESS);
+#endif /* SLOW5_USE_ZSTD */
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_set_block_valid(void) {
+    const char *pathname = "test/data/out/block.blow5";
+    ASSERT(reads_to_blow5_block(pathname, "w", 0, 30, 8) == EXIT_SUCCESS);
+    ASSERT(blow5_reads_same(pathname, 30) == EXIT_SUCCESS);
+    // appended records go into new blocks, the last one is written on close
+    ASSERT(reads_to_blow5_block(pathname, "a", 30, 5, 0) == EXIT_SUCCESS);
+    ASSERT(blow5_reads_same(pathname, 35) == EXIT_SUCCESS);
+
+    ASSERT(readahead_same_as_get_next(pathname) == EXIT_SUCCESS);
+    ASSERT(view_same_as_get(pathname, "r") == EXIT_SUCCESS);
+    ASSERT(view_same_as_get(pathname, "rm") == EXIT_SUCCESS);
+    ASSERT(many_same_as_get(pathname, "r", 4) == EXIT_SUCCESS);
+    ASSERT(many_same_as_get(pathname, "rm", 1) == EXIT_SUCCESS);
+
+    // a record is only stored compressed within its block
+    struct slow5_file *s5p = slow5_open(pathname, "rm");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(slow5_get_mem_map("read_3", NULL, s5p) == NULL);
+    ASSERT(slow5_errno == SLOW5_ERR_ARG);
+    size_t bytes;
+    void *mem = slow5_get_mem("read_3", &bytes, s5p);
+    ASSERT(mem != NULL);
+    struct slow5_rec *read = NULL;
+    ASSERT(slow_decode(&mem, &bytes, &read, s5p) == 0);
+    ASSERT(strcmp(read->read_id, "read_3") == 0);
+    free(mem);
+    ASSERT(slow5_set_block(s5p, 8, 0) == SLOW5_ERR_ARG);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // concatenated blocks are indexed the same when scanned
+    const char *in_pathnames[] = { pathname, "test/data/out/block_2.blow5" };
+    const char *cat_pathname = "test/data/out/block_cat.blow5";
+    ASSERT(reads_to_blow5_block(in_pathnames[1], "w", 35, 10, 3) == EXIT_SUCCESS);
+    ASSERT(slow5_cat(cat_pathname, in_pathnames, 2) == 0);
+    ASSERT(blow5_reads_same(cat_pathname, 45) == EXIT_SUCCESS);
+    s5p = slow5_open(cat_pathname, "r");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    ASSERT(slow5_idx_create_mt(s5p, 4) == 0);
+    struct slow5_file *s5p_built = slow5_open(cat_pathname, "r");
+    ASSERT(s5p_built != NULL);
+    ASSERT(slow5_idx_load(s5p_built) == 0);
+    ASSERT(idx_same(s5p, s5p_built) == EXIT_SUCCESS);
+    ASSERT(slow5_get("read_41", &read, s5p_built) == 0);
+    ASSERT(read->len_raw_signal == 141);
+    ASSERT(slow5_close(s5p_built) == 0);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // columns are read from the records in the blocks
+    s5p = slow5_open(cat_pathname, "r");
+    ASSERT(s5p != NULL);
+    const char *cols[] = { "len_raw_signal" };
+    ASSERT(slow5_idx_create_cols(s5p, cols, 1) == 0);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    const void *value = slow5_get_idx_col("read_37", "len_raw_signal", NULL, NULL, s5p);
+    ASSERT(value != NULL && *(const uint64_t *) value == 137);
+    ASSERT(slow5_close(s5p) == 0);
+
+    // blocks are compressed with the record compression method
+    s5p = slow5_open("test/data/out/block_none.blow5", "w");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_set_block(s5p, 0, 0) == SLOW5_ERR_ARG);
+    ASSERT(slow5_set_press(s5p, SLOW5_COMPRESS_NONE, SLOW5_COMPRESS_NONE) == 0);
+    ASSERT(slow5_set_block(s5p, 8, 0) == SLOW5_ERR_ARG);
+    ASSERT(slow5_close(s5p) == 0);
+
+    slow5_rec_free(read);
+
+    return EXIT_SUCCESS;
+}
+
+// write 20 reads with the record compression rec_press and its options opt (in blocks of block_recs records if not 0),
+// read them back and set *size to the size of the file
+static int reads_to_blow5_opt(const char *pathname, enum slow5_press_method rec_press, const slow5_press_opt_t *opt, uint32_t block_recs, off_t *size) {
+    struct slow5_file *s5p = slow5_open(pathname, "w");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_set_press_opt(s5p, rec_press, SLOW5_COMPRESS_NONE, opt) == 0);
+    if (block_recs) {
+        ASSERT(slow5_set_block(s5p, block_recs, 0) == 0);
+        ASSERT(s5p->compress->opt.level == opt->level);
+    }
+    ASSERT(slow5_hdr_write(s5p) > 0);
+
+    struct slow5_rec *read = slow5_rec_init();
+    ASSERT(read);
+    char read_id[32];
+    read->read_id = read_id;
+    for (int i = 0; i < 20; ++ i) {
+        read->len_raw_signal = 5000;
+        read->raw_signal = realloc(read->raw_signal, read->len_raw_signal * sizeof *read->raw_signal);
+        ASSERT(read->raw_signal);
+        for (uint64_t j = 0; j < read->len_raw_signal; ++ j) {
+            read->raw_signal[j] = j % 97 + i;
+        }
+        sprintf(read_id, "read_%d", i);
+        read->read_id_len = strlen(read_id);
+        ASSERT(slow5_write(read, s5p) >= 0);
+    }
+    read->read_id = NULL;
+    ASSERT(slow5_close(s5p) == 0);
+
+    s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    // blocks are only read by slow5lib supporting file version 0.3.0
+    struct slow5_version version = block_recs ? (struct slow5_version) { .major = 0, .minor = 3, .patch = 0 } : SLOW5_VERSION_STRUCT;
+    ASSERT(slow5_version_cmp(s5p->header->version, version) == 0);
+    int i = 0;
+    int ret;
+    while ((ret = slow5_get_next(&read, s5p)) >= 0) {
+        sprintf(read_id, "read_%d", i);
+        ASSERT(strcmp(read->read_id, read_id) == 0);
+        ASSERT(read->len_raw_signal == 5000);
+        ASSERT(read->raw_signal[4999] == 4999 % 97 + i);
+        ++ i;
+    }
+    ASSERT(ret == SLOW5_ERR_EOF);
+    ASSERT(i == 20);
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+
+    struct stat st;
+    ASSERT(stat(pathname, &st) == 0);
+    *size = st.st_size;
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_set_press_opt_valid(void) {
+    const char *pathname = "test/data/out/press_opt.blow5";
+    off_t size_fast;
+    off_t size_best;
+    slow5_press_opt_t opt = { 0 };
+    opt.level = 1;
+    ASSERT(reads_to_blow5_opt(pathname, SLOW5_COMPRESS_ZLIB, &opt, 0, &size_fast) == EXIT_SUCCESS);
+    opt.level = 9;
+    ASSERT(reads_to_blow5_opt(pathname, SLOW5_COMPRESS_ZLIB, &opt, 0, &size_best) == EXIT_SUCCESS);
+    ASSERT(size_best < size_fast);
+    // blocks keep the options
+    ASSERT(reads_to_blow5_opt(pathname, SLOW5_COMPRESS_ZLIB, &opt, 5, &size_best) == EXIT_SUCCESS);
+
+#ifdef SLOW5_USE_ZSTD
+    opt.level = 19;
+    opt.zstd_window_log = 20;
+    opt.zstd_long = 1;
+    ASSERT(reads_to_blow5_opt(pathname, SLOW5_COMPRESS_ZSTD, &opt, 0, &size_best) == EXIT_SUCCESS);
+    opt.level = -5;
+    opt.zstd_window_log = 0;
+    opt.zstd_long = 0;
+    ASSERT(reads_to_blow5_opt(pathname, SLOW5_COMPRESS_ZSTD, &opt, 0, &size_fast) == EXIT_SUCCESS);
+    ASSERT(size_best < size_fast);
+#endif /* SLOW5_USE_ZSTD */
+
+    struct slow5_file *s5p = slow5_open(pathname, "w");
+    ASSERT(s5p != NULL);
+    opt.level = 10;
+    ASSERT(slow5_set_press_opt(s5p, SLOW5_COMPRESS_ZLIB, SLOW5_COMPRESS_SVB_ZD, &opt) == -1);
+    ASSERT(slow5_errno == SLOW5_ERR_ARG);
+    opt.level = 0;
+    opt.zstd_long = 1;
+    ASSERT(slow5_set_press_opt(s5p, SLOW5_COMPRESS_ZLIB, SLOW5_COMPRESS_SVB_ZD, &opt) == -1);
+    ASSERT(slow5_errno == SLOW5_ERR_ARG);
+    ASSERT(slow5_set_press_opt(s5p, SLOW5_COMPRESS_NONE, SLOW5_COMPRESS_SVB_ZD, &opt) == -1);
+    ASSERT(slow5_errno == SLOW5_ERR_ARG);
+#ifdef SLOW5_USE_ZSTD
+    opt.zstd_long = 0;
+    opt.zstd_window_log = 5;
+    ASSERT(slow5_set_press_opt(s5p, SLOW5_COMPRESS_ZSTD, SLOW5_COMPRESS_SVB_ZD, &opt) == -1);
+    ASSERT(slow5_errno == SLOW5_ERR_ARG);
+#endif /* SLOW5_USE_ZSTD */
+    ASSERT(slow5_set_press_opt(s5p, SLOW5_COMPRESS_ZLIB, SLOW5_COMPRESS_SVB_ZD, NULL) == 0);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+#ifdef SLOW5_USE_ZSTD
+// small records as they are at the start of a run: one per read, sharing the read ID prefix and most fields
+static struct slow5_rec *dict_rec(int i) {
+    struct slow5_rec *read = slow5_rec_init();
+    if (!read) {
+        return NULL;
+    }
+    read->read_id = malloc(64);
+    sprintf(read->read_id, "a8f4c3e2-5b1d-4c7e-9f0a-%012d", i * 7919);
+    read->read_id_len = strlen(read->read_id);
+    read->digitisation = 8192;
+    read->offset = 23 + i % 5;
+    read->range = 1467.61;
+    read->sampling_rate = 4000;
+    read->len_raw_signal = 8;
+    read->raw_signal = malloc(read->len_raw_signal * sizeof *read->raw_signal);
+    for (uint64_t j = 0; j < read->len_raw_signal; ++ j) {
+        read->raw_signal[j] = 400 + (i * 31 + j * 17) % 50;
+    }
+    return read;
+}
+
+// write n records to pathname with the dictionary trained from the first num_train ones (none if 0)
+static int dict_to_blow5(const char *pathname, struct slow5_rec **recs, int n, uint32_t num_train, off_t *size) {
+    struct slow5_file *s5p = slow5_open(pathname, "w");
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_set_press(s5p, SLOW5_COMPRESS_ZSTD, SLOW5_COMPRESS_SVB_ZD) == 0);
+    if (num_train) {
+        ASSERT(slow5_train_press_dict(s5p, recs, num_train, 4096) == 0);
+    }
+    ASSERT(slow5_hdr_write(s5p) > 0);
+    for (int i = 0; i < n; ++ i) {
+        struct slow5_rec *read = dict_rec(i); // slow5_write compresses the signal in place
+        ASSERT(read);
+        ASSERT(slow5_write(read, s5p) > 0);
+        slow5_rec_free(read);
+    }
+    ASSERT(slow5_close(s5p) == 0);
+
+    struct stat st;
+    ASSERT(stat(pathname, &st) == 0);
+    *size = st.st_size;
+    return EXIT_SUCCESS;
+}
+
+// the records of pathname are the n first dict_rec ones
+static int dict_blow5_same(const char *pathname, int n) {
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    struct slow5_rec *read = NULL;
+    int i = 0;
+    int ret;
+    while ((ret = slow5_get_next(&read, s5p)) >= 0) {
+        struct slow5_rec *expect = dict_rec(i);
+        ASSERT(strcmp(read->read_id, expect->read_id) == 0);
+        ASSERT(read->offset == expect->offset);
+        ASSERT(read->len_raw_signal == expect->len_raw_signal);
+        ASSERT(memcmp(read->raw_signal, expect->raw_signal, read->len_raw_signal * sizeof *read->raw_signal) == 0);
+        slow5_rec_free(expect);
+        ++ i;
+    }
+    ASSERT(ret == SLOW5_ERR_EOF);
+    ASSERT(i == n);
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+    return EXIT_SUCCESS;
+}
+#endif /* SLOW5_USE_ZSTD */
+
+int slow5_press_dict_valid(void) {
+
+#ifdef SLOW5_USE_ZSTD
+    const char *pathname = "test/data/out/press_dict.blow5";
+    const int num_recs = 2000;
+    struct slow5_rec *recs[500];
+    for (int i = 0; i < 500; ++ i) {
+        ASSERT(recs[i] = dict_rec(i));
+    }
+
+    off_t size_plain;
+    off_t size_dict;
+    ASSERT(dict_to_blow5("test/data/out/press_no_dict.blow5", recs, num_recs, 0, &size_plain) == EXIT_SUCCESS);
+    ASSERT(dict_to_blow5(pathname, recs, num_recs, 500, &size_dict) == EXIT_SUCCESS);
+    ASSERT(recs[0]->len_raw_signal == 8); // training leaves the records unchanged
+    ASSERT(size_dict < size_plain);
+    ASSERT(dict_blow5_same(pathname, num_recs) == EXIT_SUCCESS);
+
+    // the dictionary is loaded on open, and used by the index and by appends
+    struct slow5_file *s5p = slow5_open(pathname, "r");
+    ASSERT(s5p != NULL);
+    size_t dict_size;
+    const void *dict = slow5_get_press_dict(s5p, &dict_size);
+    ASSERT(dict && dict_size > 0 && dict_size <= 4096);
+    // only read by slow5lib supporting file version 0.3.0, unlike without the dictionary
+    struct slow5_version dict_version = { .major = 0, .minor = 3, .patch = 0 };
+    ASSERT(slow5_version_cmp(s5p->header->version, dict_version) == 0);
+    struct slow5_file *no_dict = slow5_open("test/data/out/press_no_dict.blow5", "r");
+    ASSERT(no_dict != NULL);
+    ASSERT(slow5_version_cmp(no_dict->header->version, SLOW5_VERSION_STRUCT) == 0);
+    ASSERT(slow5_close(no_dict) == 0);
+    ASSERT(slow5_idx_create(s5p) == 0);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    struct slow5_rec *read = NULL;
+    ASSERT(slow5_get(recs[123]->read_id, &read, s5p) == 0);
+    ASSERT(read->offset == recs[123]->offset);
+    slow5_rec_free(read);
+
+    // reuse the dictionary of a file
+    struct slow5_file *copy = slow5_open("test/data/out/press_dict_copy.blow5", "w");
+    ASSERT(copy != NULL);
+    ASSERT(slow5_set_press(copy, SLOW5_COMPRESS_ZSTD, SLOW5_COMPRESS_SVB_ZD) == 0);
+    ASSERT(slow5_set_press_dict(copy, dict, dict_size) == 0);
+    ASSERT(slow5_set_block(copy, 10, 0) == SLOW5_ERR_ARG);
+    ASSERT(slow5_hdr_write(copy) > 0);
+    ASSERT(slow5_set_press_dict(copy, dict, dict_size) == SLOW5_ERR_ARG);
+    read = dict_rec(0);
+    ASSERT(slow5_write(read, copy) > 0);
+    slow5_rec_free(read);
+    ASSERT(slow5_close(copy) == 0);
+    ASSERT(slow5_close(s5p) == 0);
+    ASSERT(dict_blow5_same("test/data/out/press_dict_copy.blow5", 1) == EXIT_SUCCESS);
+
+    s5p = slow5_open(pathname, "a");
+    ASSERT(s5p != NULL);
+    read = dict_rec(num_recs);
+    ASSERT(slow5_write(read, s5p) > 0);
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+    ASSERT(dict_blow5_same(pathname, num_recs + 1) == EXIT_SUCCESS);
+
+    for (int i = 0; i < 500; ++ i) {
+        slow5_rec_free(recs[i]);
+    }
+#endif /* SLOW5_USE_ZSTD */
+
+    struct slow5_file *s5p_err = slow5_open("test/data/out/press_dict_err.blow5", "w");
+    ASSERT(s5p_err != NULL);
+    const char fake_dict[] = "not a trained dictionary but raw content";
+    ASSERT(slow5_set_press_dict(s5p_err, fake_dict, sizeof fake_dict) == SLOW5_ERR_ARG); // zlib
+    ASSERT(slow5_get_press_dict(s5p_err, NULL) == NULL);
+#ifdef SLOW5_USE_ZSTD
+    ASSERT(slow5_set_press(s5p_err, SLOW5_COMPRESS_ZSTD, SLOW5_COMPRESS_SVB_ZD) == 0);
+    ASSERT(slow5_train_press_dict(s5p_err, NULL, 0, 4096) == SLOW5_ERR_ARG);
+    ASSERT(slow5_set_press_dict(s5p_err, fake_dict, 0) == SLOW5_ERR_ARG);
+    ASSERT(slow5_set_press_dict(s5p_err, fake_dict, sizeof fake_dict) == 0);
+    ASSERT(slow5_get_press_dict(s5p_err, NULL) != NULL);
+    ASSERT(slow5_set_press(s5p_err, SLOW5_COMPRESS_ZSTD, SLOW5_COMPRESS_SVB_ZD) == 0); // drops the dictionary
+    ASSERT(slow5_get_press_dict(s5p_err, NULL) == NULL);
+#endif /* SLOW5_USE_ZSTD */
+    ASSERT(slow5_close(s5p_err) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+#ifdef SLOW5_USE_ZSTD
+static int to_zstd(const char *from_pathname, const char *to_pathname) {
+    struct slow5_file *from = slow5_open(from_pathname, "r");
+    ASSERT(from != NULL);
+    FILE *to = fopen(to_pathname, "w");
+    ASSERT(to != NULL);
+    slow5_press_method_t method = {SLOW5_COMPRESS_ZSTD, SLOW5_COMPRESS_SVB_ZD};
+    ASSERT(slow5_convert(from, to, SLOW5_FORMAT_BINARY, method) == 0);
+    ASSERT(slow5_close(from) == 0);
+    ASSERT(fclose(to) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+// the index read IDs are the ones of the records in order
+static int idx_same_as_get_next(const char *pathname, const char *mode) {
+    char *idx_pathname = slow5_get_idx_path(pathname);
+    ASSERT(idx_pathname);
+    remove(idx_pathname);
+    free(idx_pathname);
+
+    struct slow5_file *s5p = slow5_open(pathname, mode);
+    ASSERT(s5p != NULL);
+    ASSERT(slow5_idx_create_mt(s5p, 4) == 0);
+    ASSERT(slow5_idx_load(s5p) == 0);
+    uint64_t num_ids;
+    char **ids = slow5_get_rids(s5p, &num_ids);
+    ASSERT(ids);
+    struct slow5_rec *read = NULL;
+    uint64_t i = 0;
+    int ret;
+    while ((ret = slow5_get_next(&read, s5p)) >= 0) {
+        ASSERT(i < num_ids);
+        ASSERT(strcmp(read->read_id, ids[i]) == 0);
+        ++ i;
+    }
+    ASSERT(ret == SLOW5_ERR_EOF);
+    ASSERT(i == num_ids);
+    slow5_rec_free(read);
+    ASSERT(slow5_close(s5p) == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int slow5_idx_create_zstd(void) {
+    ASSERT(to_zstd("test/data/test/same_diff_ids.slow5", "test/data/out/same_diff_ids_zstd.blow5") == EXIT_SUCCESS);
+    // records spanning more than one zstd block
+    ASSERT(random_reads_to_blow5("test/data/out/idx_big.blow5", 6, 200000) == EXIT_SUCCESS);
+    ASSERT(to_zstd("test/data/out/idx_big.blow5", "test/data/out/idx_big_zstd.blow5") == EXIT_SUCCESS);
+
+    ASSERT(idx_same_as_get_next("test/data/out/same_diff_ids_zstd.blow5", "r") == EXIT_SUCCESS);
+    ASSERT(idx_same_as_get_next("test/data/out/idx_big_zstd.blow5", "r") == EXIT_SUCCESS);
+    ASSERT(idx_same_as_get_next("test/data/out/idx_big_zstd.blow5", "rm") == EXIT_SUCCESS);
+    ASSERT(idx_mt_same_as_single("test/data/out/idx_big_zstd.blow5", "r") == EXIT_SUCCESS);
+
+    return EXIT_SUCCESS;
+}
+#endif /* SLOW5_USE_ZSTD */
+
 int main(void) {
 
     slow5_set_log_level(SLOW5_LOG_OFF);
@@ -320,6 +1918,21 @@ int main(void) {
         CMD(slow5_idx_valid)
         CMD(slow5_idx_null)
         CMD(slow5_idx_invalid)
+        CMD(slow5_idx_create_mt_valid)
+        CMD(slow5_idx_insert_valid)
+        CMD(slow5_idx_insert_uuid)
+        CMD(slow5_idx_v2_valid)
+        CMD(slow5_idx_footer_valid)
+        CMD(slow5_idx_catch_up_valid)
+        CMD(slow5_cat_valid)
+        CMD(slow5_idx_cols_valid)
+        CMD(slow5_get_stats_valid)
+        CMD(slow5_set_block_valid)
+        CMD(slow5_set_press_opt_valid)
+        CMD(slow5_press_dict_valid)
+#ifdef SLOW5_USE_ZSTD
+        CMD(slow5_idx_create_zstd)
+#endif /* SLOW5_USE_ZSTD */
 
         CMD(slow5_open_valid)
 
@@ -340,6 +1953,11 @@ int main(void) {
 
         CMD(slow5_open_zlib)
         CMD(slow5_rec_to_mem_zlib)
+
+        CMD(slow5_get_next_readahead)
+        CMD(slow5_get_mmap)
+        CMD(slow5_get_view_valid)
+        CMD(slow5_get_many_valid)
     };
 
     return RUN_TESTS(tests);
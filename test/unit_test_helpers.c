@@ -6,7 +6,10 @@
 #include "unit_test.h"
 #include <slow5/slow5.h>
 #include "slow5_extra.h"
+#include "slow5_aio.h"
 #include "slow5_misc.h"
+#include <fcntl.h>
+#include <unistd.h>
 
 char double_overflow[] = "11189731495357231765021263853030970205169063322294624200440323733891737005522970722616410290336528882853545697807495577314427443153670288434198125573853743678673593200706973263201915918282961524365529510646791086614311790632169778838896134786560600399148753433211454911160088679845154866512852340149773037600009125479393966223151383622417838542743917838138717805889487540575168226347659235576974805113725649020884855222494791399377585026011773549180099796226026859508558883608159846900235645132346594476384939859276456284579661772930407806609229102715046085388087959327781622986827547830768080040150694942303411728957777100335714010559775242124057347007386251660110828379119623008469277200965153500208474470792443848545912886723000619085126472111951361467527633519562927597957250278002980795904193139603021470997035276467445530922022679656280991498232083329641241038509239184734786121921697210543484287048353408113042573002216421348917347174234800714880751002064390517234247656004721768096486107994943415703476320643558624207443504424380566136017608837478165389027809576975977286860071487028287955567141404632615832623602762896316173978484254486860609948270867968048078702511858930838546584223040908805996294594586201903766048446790926002225410530775901065760671347200125846406957030257138960983757998926954553052368560758683179223113639519468850880771872104705203957587480013143131444254943919940175753169339392366881856189129931729104252921236835159922322050998001677102784035360140829296398115122877768135706045789343535451696539561254048846447169786893211671087229088082778350518228857646062218739702851655083720992349483334435228984751232753726636066213902281264706234075352071724058665079518217303463782631353393706774901950197841690441824738063162828586857741432581165364040218402724913393320949219498422442730427019873044536620350262386957804682003601447291997123095530057206141866974852846856186514832715974481203121946751686379343096189615107330065552421485195201762858595091051839472502863871632494167613804996319791441870254302706758495192008837915169401581740046711477877201459644461175204059453504764721807975761111720846273639279600339670470037613374509553184150073796412605047923251661354841291884211340823015473304754067072818763503617332908005951896325207071673904547777129682265206225651439919376804400292380903112437912614776255964694221981375146967079446870358004392507659451618379811859392049544036114915310782251072691486979809240946772142727012404377187409216756613634938900451232351668146089322400697993176017805338191849981933008410985993938760292601390911414526003720284872132411955424282101831204216104467404621635336900583664606591156298764745525068145003932941404131495400677602951005962253022823003631473824681059648442441324864573137437595096416168048024129351876204668135636877532814675538798871771836512893947195335061885003267607354388673368002074387849657014576090349857571243045102038730494854256702479339322809110526041538528994849203991091946129912491633289917998094380337879522093131466946149705939664152375949285890960489916121944989986384837022486672249148924678410206183364627416969576307632480235587975245253737035433882960862753427740016333434055083537048507374544819754722228975281083020898682633020285259923084168054539687911418297629988964576482765287504562854924265165217750799516259669229114977788962356670956627138482018191348321687995863652637620978285070099337294396784639879024914514222742527006363942327998483976739987154418554201562244154926653014515504685489258620276085761837129763358761215382565129633538141663949516556000264159186554850057052611431952919918807954522394649627635630178580896692226406235382898535867595990647008385687123810329591926494846250768992258419305480763620215089022149220528069842018350840586938493815498909445461977893029113576516775406232278298314033473276603952231603422824717528181818844304880921321933550869873395861276073670866652375555675803171490108477320096424318780070008797346032906278943553743564448851907191616455141155761939399690767415156402826543664026760095087523945507341556135867933066031744720924446513532366647649735400851967040771103640538150073486891798364049570606189535005089840913826869535090066783324472578712196604415284924840041850932811908963634175739897166596000759487800619164094854338758520657116541072260996288150123144377944008749301944744330784388995701842710004808305012177123560622895076269042856800047718893158089358515593863176652948089031267747029662545110861548958395087796755464137944895960527975209874813839762578592105756284401759349324162148339565350189196811389091843795734703269406342890087805846940352453479398080674273236297887100867175802531561302356064878709259865288416350972529537091114317204887747405539054009425375424119317944175137064689643861517718849867010341532542385911089624710885385808688837777258648564145934262121086647588489260031762345960769508849149662444156604419552086811989770240.000000";
 
@@ -493,6 +496,81 @@ int float_to_str_valid(void) {
     return EXIT_SUCCESS;
 }
 
+int aio_valid(void) {
+
+    const char *path = "test/data/exp/one_fast5/exp_1_default.slow5";
+    FILE *fp = fopen(path, "r");
+    ASSERT(fp);
+    ASSERT(fseek(fp, 0, SEEK_END) == 0);
+    size_t size = ftell(fp);
+    rewind(fp);
+    char *exp = (char *) malloc(size);
+    ASSERT(fread(exp, 1, size, fp) == size);
+    fclose(fp);
+
+    int fd = open(path, O_RDONLY);
+    ASSERT(fd >= 0);
+    ASSERT(!slow5_aio_init(fd, 0));
+    ASSERT(slow5_errno == SLOW5_ERR_ARG);
+
+    // read the file in chunks of increasing size, in reverse order, with up to 4 in flight
+    const uint32_t depth = 4;
+    struct slow5_aio *aio = slow5_aio_init(fd, depth);
+    ASSERT(aio);
+    ASSERT(slow5_aio_backend(aio) == SLOW5_AIO_THREADS || slow5_aio_backend(aio) == SLOW5_AIO_IOURING);
+    char *got = (char *) calloc(size, 1);
+    size_t chunk = 1;
+    size_t end = size;
+    uint32_t inflight = 0;
+    size_t done = 0;
+    while (end || inflight) {
+        if (end && inflight < depth) {
+            size_t bytes = chunk < end ? chunk : end;
+            end -= bytes;
+            ASSERT(slow5_aio_submit(aio, got + end, bytes, end, got + end) == 0);
+            ++ inflight;
+            chunk += 37;
+            continue;
+        }
+        void *data = NULL;
+        ASSERT(slow5_aio_wait(aio, &data) == 0);
+        ASSERT((char *) data >= got && (char *) data < got + size);
+        -- inflight;
+        ++ done;
+    }
+    ASSERT(done > depth);
+    ASSERT(memcmp(got, exp, size) == 0);
+
+    // too many in flight
+    for (uint32_t i = 0; i < depth; ++ i) {
+        ASSERT(slow5_aio_submit(aio, got, 1, i, NULL) == 0);
+    }
+    ASSERT(slow5_aio_submit(aio, got, 1, 0, NULL) == SLOW5_ERR_OTH);
+    for (uint32_t i = 0; i < depth; ++ i) {
+        void *data = got;
+        ASSERT(slow5_aio_wait(aio, &data) == 0);
+        ASSERT(!data);
+    }
+    void *data = NULL;
+    ASSERT(slow5_aio_wait(aio, &data) == SLOW5_ERR_OTH);
+
+    // reading past the end of the file
+    ASSERT(slow5_aio_submit(aio, got, 16, size - 8, got) == 0);
+    ASSERT(slow5_aio_wait(aio, &data) == SLOW5_ERR_IO);
+    ASSERT(data == got);
+
+    // freed with reads in flight
+    ASSERT(slow5_aio_submit(aio, got, size, 0, NULL) == 0);
+    slow5_aio_free(aio);
+    slow5_aio_free(NULL);
+
+    close(fd);
+    free(got);
+    free(exp);
+
+    return EXIT_SUCCESS;
+}
+
 int main(void) {
 
     struct command tests[] = {
@@ -513,6 +591,8 @@ int main(void) {
 
         CMD(double_to_str_valid)
         CMD(float_to_str_valid)
+
+        CMD(aio_valid)
     };
 
     return RUN_TESTS(tests);
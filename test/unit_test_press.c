@@ -1,6 +1,8 @@
 #include "unit_test.h"
 #include <slow5/slow5.h>
+#include <streamvbyte.h>
 #include <string.h>
+#include <pthread.h>
 
 int press_init_valid(void) {
     struct __slow5_press *comp = __slow5_press_init(SLOW5_COMPRESS_NONE);
@@ -173,6 +175,311 @@ int press_svb_exp_valid(void) {
     return EXIT_SUCCESS;
 }
 
+int press_svb_format_valid(void) {
+
+    // encoded bytes must not depend on the encoder used
+    const int16_t sig[] = { 1039, 588, 588, 593, 586, 574, 570, 585, 588, 586, -32768, 32767, 0 };
+    const uint8_t sig_svb[] = {
+        13, 0, 0, 0,
+        5, 0, 160, 1,
+        30, 8, 133, 3, 0, 10, 13, 23, 7, 30, 6, 3, 147, 4, 1, 254, 255, 1, 253, 255
+    };
+    size_t bytes_svb = 0;
+    uint8_t *out = slow5_ptr_compress_solo(SLOW5_COMPRESS_SVB_ZD, sig, sizeof sig, &bytes_svb);
+    ASSERT(out);
+    ASSERT(bytes_svb == sizeof sig_svb);
+    ASSERT(memcmp(out, sig_svb, sizeof sig_svb) == 0);
+
+    free(out);
+
+    return EXIT_SUCCESS;
+}
+
+int press_svb_lens_valid(void) {
+
+    // lengths around the 8 sample simd blocks, full int16 range so deltas take 1 to 3 bytes
+    const size_t lens[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 1001, 65537 };
+    srand(5);
+    for (size_t i = 0; i < LENGTH(lens); ++ i) {
+        int16_t *orig = malloc(lens[i] * sizeof *orig);
+        ASSERT(orig);
+        for (size_t j = 0; j < lens[i]; ++ j) {
+            orig[j] = (j % 5 == 0) ? (int16_t) (rand() % 65536 - 32768) : (int16_t) (500 + rand() % 40);
+        }
+
+        size_t bytes_svb = 0;
+        uint8_t *orig_svb = slow5_ptr_compress_solo(SLOW5_COMPRESS_SVB_ZD, orig, lens[i] * sizeof *orig, &bytes_svb);
+        ASSERT(orig_svb);
+
+        size_t bytes_orig = 0;
+        int16_t *orig_depress = slow5_ptr_depress_solo(SLOW5_COMPRESS_SVB_ZD, orig_svb, bytes_svb, &bytes_orig);
+        ASSERT(orig_depress);
+        ASSERT(bytes_orig == lens[i] * sizeof *orig);
+        ASSERT(memcmp(orig, orig_depress, bytes_orig) == 0);
+        free(orig_depress);
+
+        // truncated input is detected rather than read past
+        ASSERT(slow5_ptr_depress_solo(SLOW5_COMPRESS_SVB_ZD, orig_svb, bytes_svb - 1, &bytes_orig) == NULL);
+        ASSERT(slow5_errno == SLOW5_ERR_PRESS);
+
+        free(orig_svb);
+        free(orig);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// the svb-zd simd kernels picked at runtime give the same results as the scalar ones
+int press_svb_simd_valid(void) {
+
+    if (!__slow5_streamvbyte_simd(1)) {
+        return EXIT_SUCCESS; // no simd kernels to compare in this build or on this processor
+    }
+
+    const uint32_t lens[] = { 1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 1001, 65537 };
+    // the first delta from prev takes 1, 3 or 4 bytes
+    const int32_t prevs[] = { 0, -70000, 1 << 28 };
+    srand(8);
+    for (size_t i = 0; i < LENGTH(lens); ++ i) {
+        int16_t *orig = malloc(lens[i] * sizeof *orig);
+        int16_t *out = malloc(lens[i] * sizeof *out);
+        size_t max_bytes = __slow5_streamvbyte_max_compressedbytes(lens[i]);
+        uint8_t *svb_simd = malloc(max_bytes);
+        uint8_t *svb_scalar = malloc(max_bytes);
+        ASSERT(orig && out && svb_simd && svb_scalar);
+        for (size_t j = 0; j < lens[i]; ++ j) {
+            orig[j] = (j % 7 == 0) ? (int16_t) (rand() % 65536 - 32768) : (int16_t) (500 + rand() % 40);
+        }
+
+        for (size_t k = 0; k < LENGTH(prevs); ++ k) {
+            __slow5_streamvbyte_simd(1);
+            size_t bytes = __slow5_streamvbyte_zigzag_delta_encode(orig, lens[i], svb_simd, prevs[k]);
+            __slow5_streamvbyte_simd(0);
+            ASSERT(__slow5_streamvbyte_zigzag_delta_encode(orig, lens[i], svb_scalar, prevs[k]) == bytes);
+            ASSERT(memcmp(svb_simd, svb_scalar, bytes) == 0);
+
+            for (int simd = 0; simd <= 1; ++ simd) {
+                __slow5_streamvbyte_simd(simd);
+                memset(out, 0, lens[i] * sizeof *out);
+                ASSERT(__slow5_streamvbyte_zigzag_delta_decode(svb_simd, bytes, out, lens[i], prevs[k]) == bytes);
+                ASSERT(memcmp(orig, out, lens[i] * sizeof *out) == 0);
+                ASSERT(__slow5_streamvbyte_zigzag_delta_decode(svb_simd, bytes - 1, out, lens[i], prevs[k]) == SIZE_MAX);
+            }
+        }
+
+        free(svb_scalar);
+        free(svb_simd);
+        free(out);
+        free(orig);
+    }
+    __slow5_streamvbyte_simd(1);
+
+    return EXIT_SUCCESS;
+}
+
+int press_depress_ctx_valid(void) {
+
+    struct slow5_decode_ctx *ctx = slow5_decode_ctx_init();
+    ASSERT(ctx);
+
+    enum slow5_press_method methods[] = {
+        SLOW5_COMPRESS_NONE,
+        SLOW5_COMPRESS_ZLIB,
+#ifdef SLOW5_USE_ZSTD
+        SLOW5_COMPRESS_ZSTD,
+#endif /* SLOW5_USE_ZSTD */
+    };
+
+    // grow, shrink then grow again to exercise reuse of the scratch buffers
+    const size_t lens[] = { 100000, 10, 1, 300000 };
+    int16_t *sig = NULL;
+    uint64_t cap = 0;
+    for (size_t i = 0; i < LENGTH(lens); ++ i) {
+        int16_t *orig = malloc(lens[i] * sizeof *orig);
+        ASSERT(orig);
+        for (size_t j = 0; j < lens[i]; ++ j) {
+            orig[j] = 400 + (j * 7919) % 200 - (j % 3) * 50;
+        }
+
+        size_t bytes_svb = 0;
+        uint8_t *orig_svb = slow5_ptr_compress_solo(SLOW5_COMPRESS_SVB_ZD, orig, lens[i] * sizeof *orig, &bytes_svb);
+        ASSERT(orig_svb);
+        uint64_t len = 0;
+        int16_t *prev_sig = sig;
+        sig = slow5_sig_depress_ctx(ctx, SLOW5_COMPRESS_SVB_ZD, orig_svb, bytes_svb, sig, cap, &len);
+        ASSERT(sig);
+        ASSERT(len == lens[i]);
+        ASSERT(memcmp(sig, orig, lens[i] * sizeof *orig) == 0);
+        if (cap >= len) {
+            ASSERT(sig == prev_sig);
+        } else {
+            cap = len;
+        }
+        free(orig_svb);
+
+        for (size_t k = 0; k < LENGTH(methods); ++ k) {
+            size_t bytes_press = 0;
+            void *orig_press = slow5_ptr_compress_solo(methods[k], orig, lens[i] * sizeof *orig, &bytes_press);
+            ASSERT(orig_press);
+            size_t bytes = 0;
+            void *depress = slow5_ptr_depress_ctx(ctx, methods[k], orig_press, bytes_press, &bytes);
+            ASSERT(depress == ctx->rec);
+            ASSERT(bytes == lens[i] * sizeof *orig);
+            ASSERT(memcmp(depress, orig, bytes) == 0);
+            free(orig_press);
+        }
+
+        free(orig);
+    }
+
+    uint64_t len = 1;
+    const uint8_t short_svb[] = { 1, 0 };
+    ASSERT(slow5_sig_depress_ctx(ctx, SLOW5_COMPRESS_SVB_ZD, short_svb, sizeof short_svb, sig, cap, &len) == NULL);
+    ASSERT(len == 1);
+    size_t bytes = 1;
+    ASSERT(slow5_ptr_depress_ctx(ctx, SLOW5_COMPRESS_ZLIB, short_svb, sizeof short_svb, &bytes) == NULL);
+    ASSERT(bytes == 0);
+    ASSERT(slow5_ptr_depress_ctx(NULL, SLOW5_COMPRESS_ZLIB, short_svb, sizeof short_svb, &bytes) == NULL);
+
+    free(sig);
+    slow5_decode_ctx_free(ctx);
+
+    return EXIT_SUCCESS;
+}
+
+int press_depress_part_ctx_valid(void) {
+
+    struct slow5_decode_ctx *ctx = slow5_decode_ctx_init();
+    ASSERT(ctx);
+
+    enum slow5_press_method methods[] = {
+        SLOW5_COMPRESS_NONE,
+        SLOW5_COMPRESS_ZLIB,
+#ifdef SLOW5_USE_ZSTD
+        SLOW5_COMPRESS_ZSTD,
+#endif /* SLOW5_USE_ZSTD */
+    };
+
+    const size_t len = 300000; // more than one zstd block
+    int16_t *orig = malloc(len * sizeof *orig);
+    ASSERT(orig);
+    for (size_t j = 0; j < len; ++ j) {
+        orig[j] = 400 + (j * 7919) % 200 - (j % 3) * 50;
+    }
+
+    for (size_t k = 0; k < LENGTH(methods); ++ k) {
+        size_t bytes_press = 0;
+        uint8_t *orig_press = slow5_ptr_compress_solo(methods[k], orig, len * sizeof *orig, &bytes_press);
+        ASSERT(orig_press);
+
+        // all of the input, stop early
+        size_t bytes = 0;
+        void *depress = slow5_ptr_depress_part_ctx(ctx, methods[k], orig_press, bytes_press, 100, &bytes);
+        ASSERT(depress == ctx->rec);
+        ASSERT(bytes >= 100);
+        ASSERT(bytes < len * sizeof *orig);
+        ASSERT(memcmp(depress, orig, bytes) == 0);
+
+        // more wanted than there is
+        depress = slow5_ptr_depress_part_ctx(ctx, methods[k], orig_press, bytes_press, 2 * len * sizeof *orig, &bytes);
+        ASSERT(depress);
+        ASSERT(bytes == len * sizeof *orig);
+        ASSERT(memcmp(depress, orig, bytes) == 0);
+
+        // only the start of the input
+        depress = slow5_ptr_depress_part_ctx(ctx, methods[k], orig_press, bytes_press / 2, len * sizeof *orig, &bytes);
+        ASSERT(depress);
+        ASSERT(bytes < len * sizeof *orig);
+        ASSERT(memcmp(depress, orig, bytes) == 0);
+
+        free(orig_press);
+    }
+
+    size_t bytes = 1;
+    const uint8_t bad[] = { 1, 0, 2, 3 };
+    ASSERT(slow5_ptr_depress_part_ctx(ctx, SLOW5_COMPRESS_ZLIB, bad, sizeof bad, 10, &bytes) == NULL);
+    ASSERT(bytes == 0);
+    ASSERT(slow5_ptr_depress_part_ctx(NULL, SLOW5_COMPRESS_ZLIB, bad, sizeof bad, 10, &bytes) == NULL);
+
+    free(orig);
+    slow5_decode_ctx_free(ctx);
+
+    return EXIT_SUCCESS;
+}
+
+// the decode context of a thread and its inflate stream are made once then reused
+static void *press_zlib_reuse_run(void *arg) {
+    const char *str = (const char *) arg;
+    struct slow5_decode_ctx *ctx = slow5_decode_ctx_thread();
+    if (!ctx || slow5_decode_ctx_thread() != ctx) {
+        return arg;
+    }
+    for (int i = 0; i < 100; ++ i) {
+        size_t size_zlib;
+        void *str_zlib = slow5_ptr_compress_solo(SLOW5_COMPRESS_ZLIB, str, strlen(str) + 1, &size_zlib);
+        size_t size_copy;
+        char *str_copy = str_zlib ? slow5_ptr_depress_solo(SLOW5_COMPRESS_ZLIB, str_zlib, size_zlib, &size_copy) : NULL;
+        int same = str_copy && size_copy == strlen(str) + 1 && strcmp(str_copy, str) == 0;
+        free(str_copy);
+        str_copy = str_zlib ? slow5_ptr_depress_ctx(ctx, SLOW5_COMPRESS_ZLIB, str_zlib, size_zlib, &size_copy) : NULL;
+        same = same && str_copy && strcmp(str_copy, str) == 0;
+        free(str_zlib);
+        if (!same) {
+            return arg;
+        }
+    }
+    return ctx;
+}
+
+int press_zlib_reuse_valid(void) {
+
+    struct slow5_decode_ctx *ctx = slow5_decode_ctx_init();
+    ASSERT(ctx);
+    ASSERT(ctx->zlib_strm == NULL);
+
+    const char *strs[] = {
+        "1234567890123456789012345678901234567890",
+        "abcdefghijabcdefghijabcdefghijabcdefghij",
+    };
+    size_t bytes;
+    const uint8_t bad[] = { 1, 0, 2, 3 };
+    z_stream *strm = NULL;
+    for (int i = 0; i < 2; ++ i) {
+        size_t size_zlib;
+        void *str_zlib = slow5_ptr_compress_solo(SLOW5_COMPRESS_ZLIB, strs[i], strlen(strs[i]) + 1, &size_zlib);
+        ASSERT(str_zlib);
+        char *str_copy = slow5_ptr_depress_ctx(ctx, SLOW5_COMPRESS_ZLIB, str_zlib, size_zlib, &bytes);
+        ASSERT(str_copy);
+        ASSERT(strcmp(str_copy, strs[i]) == 0);
+        if (!strm) {
+            strm = ctx->zlib_strm;
+            ASSERT(strm);
+        }
+        ASSERT(ctx->zlib_strm == strm);
+        // an error leaves the stream usable
+        ASSERT(slow5_ptr_depress_ctx(ctx, SLOW5_COMPRESS_ZLIB, bad, sizeof bad, &bytes) == NULL);
+        free(str_zlib);
+    }
+    slow5_decode_ctx_free(ctx);
+
+    // one context per thread
+    void *ctx_main = press_zlib_reuse_run((void *) strs[0]);
+    ASSERT(ctx_main != strs[0]);
+    ASSERT(ctx_main == slow5_decode_ctx_thread());
+    pthread_t tids[2];
+    for (int i = 0; i < 2; ++ i) {
+        ASSERT(pthread_create(&tids[i], NULL, press_zlib_reuse_run, (void *) strs[i]) == 0);
+    }
+    void *ctxs[2];
+    for (int i = 0; i < 2; ++ i) {
+        ASSERT(pthread_join(tids[i], &ctxs[i]) == 0);
+        ASSERT(ctxs[i] != strs[i]);
+        ASSERT(ctxs[i] != ctx_main);
+    }
+
+    return EXIT_SUCCESS;
+}
+
 #ifdef SLOW5_USE_ZSTD
 int press_zstd_buf_valid(void) {
 
@@ -196,6 +503,45 @@ int press_zstd_buf_valid(void) {
     return EXIT_SUCCESS;
 }
 
+// compress and decompress with the zstd contexts of the calling thread many times
+static void *press_zstd_solo_run(void *arg) {
+    const char *str = (const char *) arg;
+    for (int i = 0; i < 100; ++ i) {
+        size_t size_zstd;
+        void *str_zstd = slow5_ptr_compress_solo(SLOW5_COMPRESS_ZSTD, str, strlen(str) + 1, &size_zstd);
+        size_t size_copy;
+        char *str_copy = str_zstd ? slow5_ptr_depress_solo(SLOW5_COMPRESS_ZSTD, str_zstd, size_zstd, &size_copy) : NULL;
+        int same = str_copy && strcmp(str_copy, str) == 0;
+        free(str_zstd);
+        free(str_copy);
+        if (!same) {
+            return arg;
+        }
+    }
+    return NULL;
+}
+
+int press_zstd_solo_threads(void) {
+    const char *strs[] = {
+        "1234567890123456789012345678901234567890",
+        "abcdefghijabcdefghijabcdefghijabcdefghij",
+        "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+        "",
+    };
+    pthread_t tids[4];
+    for (int i = 0; i < 4; ++ i) {
+        ASSERT(pthread_create(&tids[i], NULL, press_zstd_solo_run, (void *) strs[i]) == 0);
+    }
+    for (int i = 0; i < 4; ++ i) {
+        void *ret;
+        ASSERT(pthread_join(tids[i], &ret) == 0);
+        ASSERT(ret == NULL);
+    }
+    ASSERT(press_zstd_solo_run((void *) strs[0]) == NULL);
+
+    return EXIT_SUCCESS;
+}
+
 int slow5_press_valid(void) {
 
     slow5_press_method_t method = {SLOW5_COMPRESS_ZSTD, SLOW5_COMPRESS_SVB_ZD};
@@ -203,10 +549,11 @@ int slow5_press_valid(void) {
     ASSERT(comp);
     ASSERT(comp->record_press);
     ASSERT(comp->record_press->method == SLOW5_COMPRESS_ZSTD);
-    /*ASSERT(comp->record_press->stream);*/ /* TODO implement zstd with stream/context */
+    ASSERT(comp->record_press->stream);
+    ASSERT(comp->record_press->stream->zstd->cctx && comp->record_press->stream->zstd->dctx);
     ASSERT(comp->signal_press);
     ASSERT(comp->signal_press->method == SLOW5_COMPRESS_SVB_ZD);
-    ASSERT(!comp->record_press->stream);
+    ASSERT(!comp->signal_press->stream);
 
     slow5_press_free(comp);
 
@@ -229,9 +576,16 @@ int main(void) {
         CMD(press_svb_one_valid)
         CMD(press_svb_big_valid)
         CMD(press_svb_exp_valid)
+        CMD(press_svb_format_valid)
+        CMD(press_svb_lens_valid)
+        CMD(press_svb_simd_valid)
+        CMD(press_depress_ctx_valid)
+        CMD(press_depress_part_ctx_valid)
+        CMD(press_zlib_reuse_valid)
 
 #ifdef SLOW5_USE_ZSTD
         CMD(press_zstd_buf_valid)
+        CMD(press_zstd_solo_threads)
 
         CMD(slow5_press_valid)
 #endif /* SLOW5_USE_ZSTD */
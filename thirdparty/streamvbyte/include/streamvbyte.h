@@ -23,6 +23,13 @@ extern "C" {
 // Uses 1,2,3 or 4 bytes per value + the decoding keys.
 size_t __slow5_streamvbyte_encode(const uint32_t *in, uint32_t length, uint8_t *out);
 
+// Encode "length" int16_t values read from in as zigzag deltas (starting from prev) to out in varint format.
+// Returns the number of bytes written.
+// This is equivalent to widening in to int32_t, __slow5_zigzag_delta_encode and then __slow5_streamvbyte_encode
+// but done in a single pass without the intermediate arrays.
+// For safety, the out pointer should point to at least streamvbyte_max_compressedbyte(length) bytes.
+size_t __slow5_streamvbyte_zigzag_delta_encode(const int16_t *in, uint32_t length, uint8_t *out, int32_t prev);
+
 // same as streamvbyte_encode but 0,1,2 or 4 bytes per value (plus decoding keys) instead of using 1,2,3 or 4
 // bytes. This might be useful when there's a lot of zeroes in the input array.
 // size_t streamvbyte_encode_0124(const uint32_t *in, uint32_t length, uint8_t *out);
@@ -47,6 +54,21 @@ static inline size_t __slow5_streamvbyte_max_compressedbytes(const uint32_t leng
 // The out pointer should point to length * sizeof(uint32_t) bytes.
 size_t __slow5_streamvbyte_decode(const uint8_t *in, uint32_t *out, uint32_t length);
 
+// Read "length" zigzag delta encoded values (see __slow5_zigzag_delta_encode) in varint format
+// from in of in_len bytes, storing the running sums starting from prev in out.
+// Returns the number of bytes read, or SIZE_MAX if in is shorter than the encoded values.
+// This is equivalent to __slow5_streamvbyte_decode followed by __slow5_zigzag_delta_decode
+// but done in a single pass without the uint32_t intermediate. in need not be padded.
+// The out pointer should point to length * sizeof(int16_t) bytes.
+size_t __slow5_streamvbyte_zigzag_delta_decode(const uint8_t *in, size_t in_len, int16_t *out,
+                                               uint32_t length, int32_t prev);
+
+// NOTE: specific to slow5
+// Use the x86 simd kernels when the processor has them (enable != 0, the default) or the scalar kernels only (enable == 0),
+// e.g. to check that they give the same results. Not thread-safe: call it before encoding or decoding.
+// Returns 1 if this build has x86 simd kernels and the processor supports them, 0 otherwise.
+int __slow5_streamvbyte_simd(int enable);
+
 // Same as streamvbyte_decode but is meant to be used for streams encoded with
 // streamvbyte_encode_0124.
 // size_t streamvbyte_decode_0124(const uint8_t *in, uint32_t *out, uint32_t length);
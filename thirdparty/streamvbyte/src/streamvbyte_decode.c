@@ -23,6 +23,7 @@
 
 #include <string.h> // for memcpy
 #include "streamvbyte_shuffle_tables_decode.h"
+#include "streamvbyte_isadetection.h"
 
 
 #ifdef __ARM_NEON__
@@ -89,10 +90,12 @@ size_t __slow5_streamvbyte_decode(const uint8_t *in, uint32_t *out, uint32_t cou
   const uint8_t *dataPtr = keyPtr + keyLen; // data starts at end of keys
 
 #ifdef STREAMVBYTE_SSSE3
-  dataPtr = svb_decode_avx_simple(out, keyPtr, dataPtr, count);
-  out += count & ~ 31;
-  keyPtr += (count/4) & ~ 7;
-  count &= 31;
+  if (svb_has_ssse3()) {
+    dataPtr = svb_decode_avx_simple(out, keyPtr, dataPtr, count);
+    out += count & ~ 31;
+    keyPtr += (count/4) & ~ 7;
+    count &= 31;
+  }
 #elif defined(__ARM_NEON__)
   dataPtr = svb_decode_vector(out, keyPtr, dataPtr, count);
   out += count - (count & 3);
@@ -103,3 +106,155 @@ size_t __slow5_streamvbyte_decode(const uint8_t *in, uint32_t *out, uint32_t cou
   return svb_decode_scalar(out, keyPtr, dataPtr, count) - in;
 
 }
+
+// NOTE: the following fused zigzag delta decoder is specific to slow5 and not part of the original library.
+// The streamvbyte decode, the zigzag decode and the prefix sum are done in a single pass
+// writing int16_t directly, rather than decoding to uint32_t and then calling __slow5_zigzag_delta_decode.
+// Differences are accumulated modulo 2^16 which gives the same int16_t output.
+
+static const uint8_t *svb_zd_decode_scalar(int16_t *outPtr, const uint8_t *keyPtr,
+                                           const uint8_t *dataPtr, const uint8_t *dataEnd,
+                                           uint32_t count, uint32_t prev) {
+  if (count == 0)
+    return dataPtr;
+
+  uint8_t shift = 0;
+  uint32_t key = *keyPtr++;
+  for (uint32_t c = 0; c < count; c++) {
+    if (shift == 8) {
+      shift = 0;
+      key = *keyPtr++;
+    }
+    uint8_t code = (key >> shift) & 0x3;
+    if (dataEnd - dataPtr <= code)
+      return NULL; // truncated input
+    uint32_t val = _decode_data(&dataPtr, code);
+    prev += (val >> 1) ^ -(val & 1);
+    *outPtr++ = (int16_t) prev;
+    shift += 2;
+  }
+
+  return dataPtr;
+}
+
+#ifdef STREAMVBYTE_SSSE3
+// decode 4 values and zigzag decode them, the low 16 bits are kept in the lower (hi == 0) or upper (hi == 1) half
+SVB_TARGET("ssse3") static inline __m128i _zd_decode_quad_ssse3(uint8_t key, const uint8_t *__restrict__ *dataPtrPtr, int hi) {
+  static const int8_t lo16[2][16] = {
+    { 0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1 },
+    { -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 4, 5, 8, 9, 12, 13 },
+  };
+  __m128i z = _decode_avx(key, dataPtrPtr);
+  __m128i d = _mm_xor_si128(_mm_srli_epi32(z, 1),
+                            _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z, _mm_set1_epi32(1))));
+  return _mm_shuffle_epi8(d, _mm_loadu_si128((const __m128i *) lo16[hi]));
+}
+
+SVB_TARGET("ssse3") static const uint8_t *svb_zd_decode_vector(int16_t **outPtr, const uint8_t **keyPtrPtr,
+                                           const uint8_t *dataPtr, const uint8_t *dataEnd,
+                                           uint32_t *countPtr, uint32_t *prevPtr) {
+  const uint8_t *__restrict__ data = dataPtr;
+  const uint8_t *keyPtr = *keyPtrPtr;
+  int16_t *out = *outPtr;
+  uint32_t count = *countPtr;
+  const __m128i last = _mm_set1_epi16(0x0F0E);
+  __m128i prev = _mm_set1_epi16((int16_t) *prevPtr);
+
+  // each quad loads 16 bytes, so stop while two loads are still within the input
+  while (count >= 8 && dataEnd - data >= 32) {
+    __m128i v = _zd_decode_quad_ssse3(keyPtr[0], &data, 0);
+    v = _mm_or_si128(v, _zd_decode_quad_ssse3(keyPtr[1], &data, 1));
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+    v = _mm_add_epi16(v, prev);
+    prev = _mm_shuffle_epi8(v, last);
+    _mm_storeu_si128((__m128i *) out, v);
+    keyPtr += 2;
+    out += 8;
+    count -= 8;
+  }
+
+  if (count != *countPtr)
+    *prevPtr = (uint32_t) out[-1];
+  *outPtr = out;
+  *keyPtrPtr = keyPtr;
+  *countPtr = count;
+  return data;
+}
+#elif defined(__ARM_NEON__)
+static inline uint16x4_t _zd_decode_quad_neon(uint8_t key, const uint8_t * restrict *dataPtrPtr) {
+  decode_t data = _decode_neon(key, dataPtrPtr);
+#ifdef __aarch64__
+  uint32x4_t z = vreinterpretq_u32_u8(data);
+#else
+  uint32x4_t z = vreinterpretq_u32_u8(vcombine_u8(data.val[0], data.val[1]));
+#endif
+  uint32x4_t sign = vreinterpretq_u32_s32(vnegq_s32(vreinterpretq_s32_u32(vandq_u32(z, vdupq_n_u32(1)))));
+  return vmovn_u32(veorq_u32(vshrq_n_u32(z, 1), sign));
+}
+
+static const uint8_t *svb_zd_decode_vector(int16_t **outPtr, const uint8_t **keyPtrPtr,
+                                           const uint8_t *dataPtr, const uint8_t *dataEnd,
+                                           uint32_t *countPtr, uint32_t *prevPtr) {
+  const uint8_t * restrict data = dataPtr;
+  const uint8_t *keyPtr = *keyPtrPtr;
+  int16_t *out = *outPtr;
+  uint32_t count = *countPtr;
+  const uint16x8_t zero = vdupq_n_u16(0);
+  uint16x8_t prev = vdupq_n_u16((uint16_t) *prevPtr);
+
+  // each quad loads 16 bytes, so stop while two loads are still within the input
+  while (count >= 8 && dataEnd - data >= 32) {
+    uint16x4_t lo = _zd_decode_quad_neon(keyPtr[0], &data);
+    uint16x4_t hi = _zd_decode_quad_neon(keyPtr[1], &data);
+    uint16x8_t v = vcombine_u16(lo, hi);
+    v = vaddq_u16(v, vextq_u16(zero, v, 7));
+    v = vaddq_u16(v, vextq_u16(zero, v, 6));
+    v = vaddq_u16(v, vextq_u16(zero, v, 4));
+    v = vaddq_u16(v, prev);
+    prev = vdupq_n_u16(vgetq_lane_u16(v, 7));
+    vst1q_u16((uint16_t *) out, v);
+    keyPtr += 2;
+    out += 8;
+    count -= 8;
+  }
+
+  if (count != *countPtr)
+    *prevPtr = (uint32_t) out[-1];
+  *outPtr = out;
+  *keyPtrPtr = keyPtr;
+  *countPtr = count;
+  return data;
+}
+#endif
+
+// Read count zigzag delta encoded values in streamvbyte format from in of in_len bytes,
+// storing the int16_t sums starting from prev in out.
+// Returns the number of bytes read, or SIZE_MAX if in is too short.
+// Unlike __slow5_streamvbyte_decode, this never reads past in + in_len so in need not be padded.
+size_t __slow5_streamvbyte_zigzag_delta_decode(const uint8_t *in, size_t in_len, int16_t *out,
+                                               uint32_t count, int32_t prev) {
+  if (count == 0)
+    return 0;
+
+  const uint8_t *keyPtr = in;
+  uint32_t keyLen = ((count + 3) / 4);
+  if (keyLen > in_len)
+    return SIZE_MAX;
+  const uint8_t *dataPtr = keyPtr + keyLen;
+  const uint8_t *dataEnd = in + in_len;
+  uint32_t acc = (uint32_t) prev;
+
+#ifdef STREAMVBYTE_SSSE3
+  if (svb_has_ssse3())
+    dataPtr = svb_zd_decode_vector(&out, &keyPtr, dataPtr, dataEnd, &count, &acc);
+#elif defined(__ARM_NEON__)
+  dataPtr = svb_zd_decode_vector(&out, &keyPtr, dataPtr, dataEnd, &count, &acc);
+#endif
+
+  dataPtr = svb_zd_decode_scalar(out, keyPtr, dataPtr, dataEnd, count, acc);
+  if (!dataPtr)
+    return SIZE_MAX;
+  return dataPtr - in;
+}
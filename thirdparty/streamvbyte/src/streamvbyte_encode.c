@@ -23,10 +23,20 @@
 
 #include <string.h> // for memcpy
 #include "streamvbyte_shuffle_tables_encode.h"
+#include "streamvbyte_isadetection.h"
 
+// NOTE: the scalar encoder is always compiled as the SSSE3 one is picked at runtime
 #ifdef STREAMVBYTE_SSSE3
 #include "streamvbyte_x64_encode.c"
-#else
+#endif
+
+// NOTE: specific to slow5, see streamvbyte_isadetection.h
+int __slow5_svb_simd = 1;
+
+int __slow5_streamvbyte_simd(int enable) {
+  __slow5_svb_simd = enable != 0;
+  return svb_cpu_ssse3() != 0;
+}
 
 static uint8_t _encode_data(uint32_t val, uint8_t *__restrict__ *dataPtrPtr) {
   uint8_t *dataPtr = *dataPtrPtr;
@@ -77,7 +87,6 @@ static uint8_t *svb_encode_scalar(const uint32_t *in,
   *keyPtr = key;  // write last key (no increment needed)
   return dataPtr; // pointer to first unused data byte
 }
-#endif
 
 
 #ifdef __ARM_NEON__
@@ -91,8 +100,9 @@ static uint8_t *svb_encode_scalar(const uint32_t *in,
 // Note: I am appending a __slow5_ to prevent any name collision with the original library
 size_t __slow5_streamvbyte_encode(const uint32_t *in, uint32_t count, uint8_t *out) {
 #ifdef STREAMVBYTE_SSSE3
-return streamvbyte_encode_SSSE3(in,count,out);
-#else
+  if (svb_has_ssse3())
+    return streamvbyte_encode_SSSE3(in,count,out);
+#endif
   uint8_t *keyPtr = out;
   uint32_t keyLen = (count + 3) / 4;  // 2-bits rounded to full byte
   uint8_t *dataPtr = keyPtr + keyLen; // variable byte data after all keys
@@ -111,5 +121,90 @@ return streamvbyte_encode_SSSE3(in,count,out);
 #endif
 
   return svb_encode_scalar(in, keyPtr, dataPtr, count) - out;
-#endif// no AVX
+}
+
+// NOTE: the following fused zigzag delta encoder is specific to slow5 and not part of the original library.
+// The delta, the zigzag encode and the streamvbyte encode are done in a single pass
+// reading int16_t directly, rather than widening to int32_t and calling __slow5_zigzag_delta_encode first.
+
+static inline uint32_t _zigzag_delta_encode_16(int16_t val, int32_t prev) {
+  int32_t diff = (int32_t) val - prev;
+  return ((uint32_t) diff << 1) ^ (uint32_t) (diff >> 31);
+}
+
+static uint8_t *svb_zd_encode_scalar(const int16_t *in, uint8_t *keyPtr, uint8_t *dataPtr,
+                                     uint32_t count, int32_t prev) {
+  uint8_t shift = 0;
+  uint8_t key = 0;
+  for (uint32_t c = 0; c < count; c++) {
+    uint32_t val = _zigzag_delta_encode_16(in[c], prev);
+    uint8_t code = (val > 0x000000FF) + (val > 0x0000FFFF) + (val > 0x00FFFFFF);
+    memcpy(dataPtr, &val, sizeof val); // assumes little endian, only the first 1 + code bytes are kept
+    dataPtr += 1 + code;
+    prev = in[c];
+    key |= code << shift;
+    shift += 2;
+    if (shift == 8) {
+      *keyPtr++ = key;
+      key = 0;
+      shift = 0;
+    }
+  }
+  if (shift != 0)
+    *keyPtr = key; // write last partial key
+
+  return dataPtr;
+}
+
+#ifdef STREAMVBYTE_SSSE3
+// encode count & ~7 values, returns the pointer to the first value not encoded
+SVB_TARGET("ssse3") static const int16_t *svb_zd_encode_SSSE3(const int16_t *in, uint32_t count,
+                                                            uint8_t *__restrict__ *keyPtrPtr,
+                                                            uint8_t *__restrict__ *dataPtrPtr, int32_t *prevPtr) {
+  __m128i last = _mm_set1_epi32(*prevPtr); // 32 bits as prev need not fit in int16_t
+  for (const int16_t *end = in + (count & ~7); in != end; in += 8) {
+    __m128i cur = _mm_loadu_si128((const __m128i *) in);
+    // sign extend to 32 bits
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(cur, cur), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(cur, cur), 16);
+    __m128i d0 = _mm_sub_epi32(lo, _mm_alignr_epi8(lo, last, 12)); // in[0..3] - (prev, in[0], in[1], in[2])
+    __m128i d1 = _mm_sub_epi32(hi, _mm_alignr_epi8(hi, lo, 12));
+    last = hi;
+    d0 = _mm_xor_si128(_mm_slli_epi32(d0, 1), _mm_srai_epi32(d0, 31));
+    d1 = _mm_xor_si128(_mm_slli_epi32(d1, 1), _mm_srai_epi32(d1, 31));
+    _encode_octet_SSSE3(d0, d1, keyPtrPtr, dataPtrPtr);
+    *prevPtr = in[7];
+  }
+  return in;
+}
+#endif
+
+// Encode count int16_t values read from in as zigzag deltas (starting from prev) to out in streamvbyte format.
+// Returns the number of bytes written.
+size_t __slow5_streamvbyte_zigzag_delta_encode(const int16_t *in, uint32_t count, uint8_t *out, int32_t prev) {
+  uint8_t *__restrict__ keyPtr = out;
+  uint32_t keyLen = (count + 3) / 4;  // 2-bits rounded to full byte
+  uint8_t *__restrict__ dataPtr = keyPtr + keyLen; // variable byte data after all keys
+
+#ifdef STREAMVBYTE_SSSE3
+  if (svb_has_ssse3()) {
+    in = svb_zd_encode_SSSE3(in, count, &keyPtr, &dataPtr, &prev);
+    count &= 7;
+  }
+#elif defined(__ARM_NEON__)
+  int32x4_t last = vdupq_n_s32(prev);
+  for (const int16_t *end = in + (count & ~3); in != end; in += 4) {
+    int32x4_t cur = vmovl_s16(vld1_s16(in));
+    int32x4_t diff = vsubq_s32(cur, vextq_s32(last, cur, 3)); // in[i] - in[i - 1]
+    last = cur;
+    uint32x4_t zz = veorq_u32(vshlq_n_u32(vreinterpretq_u32_s32(diff), 1),
+                              vreinterpretq_u32_s32(vshrq_n_s32(diff, 31)));
+    dataPtr += streamvbyte_encode4(zz, dataPtr, keyPtr);
+    keyPtr++;
+    prev = in[3];
+  }
+  count &= 3;
+#endif
+
+  return svb_zd_encode_scalar(in, keyPtr, dataPtr, count, prev) - out;
 }
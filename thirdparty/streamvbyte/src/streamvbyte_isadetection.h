@@ -0,0 +1,30 @@
+// NOTE: this file is specific to slow5 and not part of the original library.
+// The x86 simd kernels are compiled for their instruction set with SVB_TARGET rather than with -mssse3
+// and are picked at runtime, so that a single build runs on any x86_64 processor.
+// __slow5_streamvbyte_simd(0) turns them off to compare them with the scalar kernels.
+
+#ifndef SLOW5_STREAMVBYTE_ISADETECTION_H_
+#define SLOW5_STREAMVBYTE_ISADETECTION_H_
+
+extern int __slow5_svb_simd; // 0 to use the scalar kernels only, see __slow5_streamvbyte_simd
+
+#if defined(STREAMVBYTE_SSSE3) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#define SVB_TARGET(isa) __attribute__((target(isa)))
+static inline int svb_cpu_ssse3(void) { return __builtin_cpu_supports("ssse3"); }
+
+#else
+
+// no runtime detection, the kernels compiled in are assumed to be supported
+#define SVB_TARGET(isa)
+#ifdef STREAMVBYTE_SSSE3
+static inline int svb_cpu_ssse3(void) { return 1; }
+#else
+static inline int svb_cpu_ssse3(void) { return 0; }
+#endif
+
+#endif
+
+static inline int svb_has_ssse3(void) { return __slow5_svb_simd && svb_cpu_ssse3(); }
+
+#endif /* SLOW5_STREAMVBYTE_ISADETECTION_H_ */
@@ -1,5 +1,5 @@
 
-static inline __m128i _decode_avx(uint32_t key,
+SVB_TARGET("ssse3") static inline __m128i _decode_avx(uint32_t key,
                                   const uint8_t *__restrict__ *dataPtrPtr) {
   uint8_t len;
   __m128i Data = _mm_loadu_si128((__m128i *)*dataPtrPtr);
@@ -17,14 +17,14 @@ static inline __m128i _decode_avx(uint32_t key,
   return Data;
 }
 
-static inline void _write_avx(uint32_t *out, __m128i Vec) {
+SVB_TARGET("ssse3") static inline void _write_avx(uint32_t *out, __m128i Vec) {
   _mm_storeu_si128((__m128i *)out, Vec);
 }
 
 
 
 // Note: I make this static to prevent name collisions
-static const uint8_t *svb_decode_avx_simple(uint32_t *out,
+SVB_TARGET("ssse3") static const uint8_t *svb_decode_avx_simple(uint32_t *out,
                                      const uint8_t *__restrict__ keyPtr,
                                      const uint8_t *__restrict__ dataPtr,
                                      uint64_t count) {